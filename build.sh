@@ -36,13 +36,40 @@ printf '%s\n' "${HEADERS[@]}"
 echo "      .cpp:"
 printf '%s\n' "${SOURCES[@]}"
 
-# Компиляция и линковка одной командой
-g++ -std=c++17 \
-    -I"$INCLUDE_DIR" \
-    -o "$BIN_DIR/RegEnterprise" \
-    "${SOURCES[@]}" \
-    -lodbc
-
-echo "✅ Сборка завершена. Исполняемый файл: $BIN_DIR/RegEnterprise"
+# Необязательные зависимости
+EXTRA_FLAGS=()   # Флаги компиляции
+EXTRA_LIBS=()    # Библиотеки для компоновки
+if echo '#include <zlib.h>' | g++ -E -x c++ - >/dev/null 2>&1; then
+    echo "zlib найден: выгрузки можно сжимать (--gzip)"
+    EXTRA_FLAGS+=(-DREGENT_HAVE_ZLIB)
+    EXTRA_LIBS+=(-lz)
+fi
+for PQ_INCLUDE in /usr/include /usr/include/postgresql /usr/include/pgsql; do
+    if [ -f "$PQ_INCLUDE/libpq-fe.h" ]; then
+        echo "libpq найден: импорт и выгрузка CSV через COPY"
+        EXTRA_FLAGS+=(-DREGENT_HAVE_LIBPQ -I"$PQ_INCLUDE")
+        EXTRA_LIBS+=(-lpq)
+        break
+    fi
+done
+
+# Общие исходники компилируются один раз, затем компонуются с каждой точкой входа
+mkdir -p "$BUILD_DIR"
+OBJECTS=()
+for SRC in "${SOURCES[@]}"; do
+    case "$(basename "$SRC")" in
+        main.cpp|server_main.cpp) continue ;;
+    esac
+    OBJ="$BUILD_DIR/$(basename "${SRC%.cpp}").o"
+    g++ -std=c++17 -I"$INCLUDE_DIR" -c "$SRC" -o "$OBJ" "${EXTRA_FLAGS[@]}"
+    OBJECTS+=("$OBJ")
+done
+
+g++ -std=c++17 -I"$INCLUDE_DIR" "${EXTRA_FLAGS[@]}" -o "$BIN_DIR/RegEnterprise" \
+    "$SRC_DIR/main.cpp" "${OBJECTS[@]}" -lodbc -pthread "${EXTRA_LIBS[@]}"
+g++ -std=c++17 -I"$INCLUDE_DIR" "${EXTRA_FLAGS[@]}" -o "$BIN_DIR/RegEnterpriseServer" \
+    "$SRC_DIR/server_main.cpp" "${OBJECTS[@]}" -lodbc -pthread "${EXTRA_LIBS[@]}"
+
+echo "✅ Сборка завершена. Исполняемые файлы: $BIN_DIR/RegEnterprise, $BIN_DIR/RegEnterpriseServer"
 echo "Запуск (пример):"
 echo "  ODBCINI=\"./.odbc.ini\" ./bin/RegEnterprise"
\ No newline at end of file
@@ -0,0 +1,87 @@
+#ifndef BATCH_SCRIPT_H
+#define BATCH_SCRIPT_H
+
+#include "ExportWriter.h"
+#include "RegistryService.h"
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// ==========================================
+// Пакетный сценарий правок
+// ==========================================
+// Сценарий — по команде на строку: имя команды и аргументы вида поле=значение
+// (значение с пробелами — в двойных кавычках, \" и \\ внутри кавычек).
+// Пустые строки и строки, начинающиеся с '#', пропускаются.
+//
+//   add-enterprise name="ООО Ромашка" inn=7707083893 legal_form_id=1 ownership_form_id=2
+//   set-price enterprise=12 product=40 price=129.90
+//
+// На каждую команду выводится строка результата: номер строки сценария,
+// команда, состояние (ok, not_found, error), ID созданной записи или число
+// строк, сообщение. Подряд идущие правки ассортимента одного вида
+// (add-assortment, set-price, remove-assortment) собираются в пакет и
+// выполняются одной транзакцией (RegistryService::applyAssortmentChanges);
+// остальные команды выполняются по одной.
+//
+// Сценарий можно подавать по конвейеру от другой программы: перед тем как
+// ждать следующую строку, накопленный пакет выполняется, а результаты
+// выводятся — отправитель получает ответы на всё, что уже передал.
+
+struct BatchOptions {
+    size_t groupSize = 1000;    // Наибольший пакет правок ассортимента
+    bool stopOnError = false;   // Остановиться после первой неудачной команды
+};
+
+struct BatchStats {
+    long long commands = 0;
+    long long succeeded = 0;
+    long long failed = 0;       // error и not_found
+};
+
+class BatchScript {
+private:
+    struct Command {
+        long long line;
+        std::string name;
+        std::vector<std::pair<std::string, std::string>> args;
+    };
+
+    // Правка ассортимента, ожидающая выполнения в пакете
+    struct Pending {
+        long long line;
+        std::string name;
+        EnterpriseProduct item;
+    };
+
+    RegistryService& service;
+    ExportWriter& out;
+    BatchOptions options;
+    BatchStats stats;
+
+    AssortmentChange pendingKind;
+    std::vector<Pending> pending;
+    std::unordered_set<int64_t> pendingKeys;   // (предприятие, товар) правок пакета
+
+    static bool tokenize(const std::string& text, Command& cmd, std::string& error);
+
+    void result(long long line, const std::string& command, const char* status,
+                long long id, const std::string& message);
+
+    bool execute(const Command& cmd);       // false — команда не выполнена
+    bool queueAssortment(const Command& cmd, AssortmentChange kind);
+    bool flushPending();
+
+public:
+    BatchScript(RegistryService& registry, ExportWriter& output, const BatchOptions& opts = BatchOptions());
+
+    // Выполняет сценарий из дескриптора (файл, канал, stdin) до конца
+    // данных или до первой ошибки при stopOnError
+    const BatchStats& run(int fd);
+
+    // Колонки вывода результатов
+    static const std::vector<std::string>& columns();
+};
+
+#endif
\ No newline at end of file
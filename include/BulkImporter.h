@@ -0,0 +1,81 @@
+#ifndef BULK_IMPORTER_H
+#define BULK_IMPORTER_H
+
+#include "TaskExecutor.h"
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+// ==========================================
+// Массовый импорт из CSV
+// ==========================================
+
+enum class ImportEntity {
+    Enterprises,  // Колонки: name, legal_form, ownership_form, postal_address, inn
+    Products,     // Колонки: name, category, shelf_life_days, delivery_terms, retail_price, purchase_price
+    Assortment    // Колонки: inn, product, wholesale_price (товар — по названию или ID)
+};
+
+struct ImportOptions {
+    std::string rejectPath;    // Файл отбракованных строк; пусто — "<входной файл>.rejects.csv"
+    char delimiter = ',';
+    size_t batchSize = 5000;   // Строк в одном пакетном INSERT
+    unsigned workers = 0;      // Потоков разбора и загрузки; 0 — все потоки пула задач
+    bool upsert = false;       // Обновлять существующие записи (предприятия — по ИНН, ассортимент — цену)
+    bool useCopy = true;       // Загружать через COPY (libpq), если доступно; иначе — пакетные INSERT
+};
+
+struct ImportResult {
+    bool success = false;
+    long long rowsRead = 0;
+    long long rowsLoaded = 0;    // Вставлено или обновлено
+    long long rowsSkipped = 0;   // Уже были в БД (без upsert)
+    long long rowsRejected = 0;  // Не прошли проверку — записаны в файл отказов
+    long long batchesViaCopy = 0;   // Пакетов, загруженных через COPY
+    long long batchesViaInsert = 0; // Пакетов, загруженных пакетными INSERT через ODBC
+};
+
+// Ключи уже существующих записей для проверок импорта — копия индексов кэша
+// сервиса. Импорт работает с копией, а не с кэшем: его задачи берут соединения
+// из пула, а держать блокировку кэша, пока ждёшь соединения, нельзя.
+struct ImportKeys {
+    bool hasProducts = false;       // false — товары проверяются выборкой из БД
+    bool hasEnterprises = false;    // false — ИНН проверяются выборкой из БД
+    std::unordered_map<std::string, int> productIdByName;
+    std::unordered_set<int> productIds;
+    std::unordered_map<std::string, int> enterpriseIdByInn;
+};
+
+// Проверка ИНН: 10 цифр (юр. лицо) или 12 цифр (ИП) с контрольными разрядами
+bool isValidInn(const std::string& inn);
+
+// Конвейер импорта: основной поток читает файл и режет его на пакеты,
+// задачи пула проверяют строки (формат ИНН, справочники по названию,
+// дубликаты) и загружают пакеты, каждый — в своей транзакции. Очередь пакетов
+// ограничена, поэтому память не растёт с размером файла. run() нельзя
+// вызывать из задачи того же пула: чтение файла ждёт свободных загрузчиков.
+//
+// Загрузка пакета: если задан copyConninfo и доступен libpq, у каждой задачи
+// открывается свой канал COPY (через временную таблицу, когда нужен
+// ON CONFLICT); иначе или при ошибке COPY — пакетный INSERT через соединение
+// рабочего потока.
+class BulkImporter {
+private:
+    TaskExecutor& executor;
+    ImportOptions options;
+    std::string copyConninfo;
+    ImportKeys existing;
+
+public:
+    // existingKeys — существующие товары и ИНН предприятий из кэша сервиса:
+    // по ним строки проверяются вместо предварительной выборки из БД
+    BulkImporter(TaskExecutor& taskExecutor, const ImportOptions& importOptions,
+                 const std::string& copyConnectionInfo = std::string(),
+                 ImportKeys existingKeys = ImportKeys())
+        : executor(taskExecutor), options(importOptions), copyConninfo(copyConnectionInfo),
+          existing(std::move(existingKeys)) {}
+
+    ImportResult run(ImportEntity entity, const std::string& path);
+};
+
+#endif
\ No newline at end of file
@@ -21,6 +21,7 @@ private:
 
     // Меню и навигация
     void showMainMenu();
+    void menuLoop();
     
     // Подменю сущностей
     void manageEnterprises();
@@ -36,6 +37,23 @@ private:
     void listSalesDepartments(int initialPage = 1, int pageSize = 10);
     void listBankDetails(int initialPage = 1, int pageSize = 10);
 
+    // Вся выборка списка с его фильтром и сортировкой — потоком, через $PAGER
+    void viewEnterprises(const Criteria& criteria);
+    void viewProducts(const Criteria& criteria);
+
+    // Ввод фильтра (filter = true) или сортировки для списка; false, если ввод неверен
+    bool editCriteria(Criteria& criteria, bool filter, const std::vector<CriteriaField>& fields);
+
+    // Нечёткий поиск
+    void findEnterprises();
+    void findProducts();
+
+    // Предприятия с товаром в ассортименте, от самой низкой оптовой цены
+    void showBestOffers();
+
+    // Досье предприятия: карточка, отдел сбыта, реквизиты и ассортимент одним экраном
+    void showEnterpriseDossier();
+
     // Операции добавления (CRUD)
     void addEnterprise();
     void addProduct();
@@ -57,14 +75,38 @@ private:
     void deleteBankDetail();
     void removeProductFromEnterprise(int enterpriseId); // Для ассортимента
 
+    // Отчёты по ассортименту
+    void manageReports();
+    void printMarginReport(const std::string& title, const std::vector<MarginSummary>& report);
+    void reportPriceOutliers();
+    void listAssortmentSummaries(int pageSize = 10);
+
+    // Групповые операции
+    void copyAssortmentToEnterprises(int enterpriseId); // Копирование ассортимента
+
+    // Неинтерактивные команды (подкоманды командной строки); import, export,
+    // offers и changes — общие с клиентом демона, см. CLIInterface.cpp
+    int commandSnapshot(const std::vector<std::string>& args);
+    // Сценарий правок (см. BatchScript.h) с построчным выводом результатов
+    int commandBatch(const std::vector<std::string>& args);
+    // Демон на Unix-сокете: сервис остаётся инициализированным между заданиями
+    int commandDaemon(const std::vector<std::string>& args);
+    // Команда "--socket <путь> import ..." выполняется демоном, а не этим процессом
+    int commandRemote(const std::vector<std::string>& args);
+
     // Утилиты ввода
     int getIntegerInput(const std::string& prompt);
     std::string getStringInput(const std::string& prompt);
+    Money getMoneyInput(const std::string& prompt);
     void pause();
 
 public:
     CLIInterface(); 
     void run();
+
+    // Выполнение подкоманды вида "RegEnterprise import enterprises file.csv".
+    // Возвращает код завершения процесса.
+    int runCommand(const std::vector<std::string>& args);
 };
 
 #endif
\ No newline at end of file
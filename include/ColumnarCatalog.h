@@ -0,0 +1,137 @@
+#ifndef COLUMNAR_CATALOG_H
+#define COLUMNAR_CATALOG_H
+
+#include "Criteria.h"
+#include "DomainEntities.h"
+#include "Gateways.h"
+#include "Snapshot.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// ==========================================
+// Словарь строк
+// ==========================================
+// Каждая различная строка хранится один раз, столбцы хранят её 32-битный код.
+// Категорий и условий поставки единицы, поэтому условие по такому столбцу
+// вычисляется один раз на код, а не на строку таблицы.
+class StringDictionary {
+private:
+    std::vector<std::string> values;
+    std::unordered_map<std::string, uint32_t> codes;
+
+public:
+    uint32_t encode(std::string_view value);
+    const std::string& decode(uint32_t code) const { return values[code]; }
+    size_t size() const { return values.size(); }
+    size_t bytes() const;
+    void clear();
+};
+
+struct CatalogStats {
+    size_t enterprises = 0;
+    size_t products = 0;
+    size_t assortment = 0;
+    size_t strings = 0;     // Различных строк в словаре
+    size_t bytes = 0;       // Объём столбцов и словаря
+};
+
+// ==========================================
+// Колоночный каталог для аналитики
+// ==========================================
+// Предприятия, товары и ассортимент в виде структуры массивов: каждый атрибут —
+// отдельный непрерывный массив, строки закодированы словарём. Отчёт о марже
+// читает только нужные столбцы (цены и номера строк), а не целые объекты
+// со встроенными std::string, поэтому проход по десяткам миллионов позиций
+// ассортимента упирается в пропускную способность памяти.
+//
+// Позиция ассортимента хранит номера строк предприятия и товара в их столбцах,
+// а не ID: связь разрешается один раз при загрузке. Каталог — копия данных
+// только для чтения; после изменений в БД его нужно загрузить заново.
+//
+// Вместо NULL в столбце цены лежит ноль, а признак «цена указана» — в
+// отдельном столбце-маске. Ноль не меняет сумм, поэтому суммы считаются без
+// маски; сравнения и фильтры по цене смотрят маску и, как SQL, пропускают
+// позиции без цены.
+class ColumnarCatalog {
+public:
+    struct EnterpriseColumns {
+        std::vector<int32_t> id;
+        std::vector<uint32_t> name;
+    };
+
+    struct ProductColumns {
+        std::vector<int32_t> id;
+        std::vector<int32_t> categoryId;
+        std::vector<int32_t> shelfLifeDays;
+        std::vector<int32_t> deliveryTermsId;
+        std::vector<int64_t> retailPrice;       // Копейки (без цены — ноль)
+        std::vector<int64_t> purchasePrice;     // Копейки (без цены — ноль)
+        std::vector<uint8_t> hasRetailPrice;    // 0 — цена не указана (NULL)
+        std::vector<uint8_t> hasPurchasePrice;
+        std::vector<uint32_t> name;
+        std::vector<uint32_t> categoryName;
+        std::vector<uint32_t> deliveryTerms;
+    };
+
+    struct AssortmentColumns {
+        std::vector<uint32_t> enterpriseRow;    // Номер строки в EnterpriseColumns
+        std::vector<uint32_t> productRow;       // Номер строки в ProductColumns
+        std::vector<int64_t> wholesalePrice;    // Копейки (без цены — ноль)
+        std::vector<uint8_t> hasWholesalePrice; // 0 — цена не указана (NULL)
+    };
+
+private:
+    StringDictionary strings;
+    EnterpriseColumns enterpriseCols;
+    ProductColumns productCols;
+    AssortmentColumns assortmentCols;
+    std::unordered_map<int, uint32_t> enterpriseRowById;
+    std::unordered_map<int, uint32_t> productRowById;
+    bool loaded;
+
+    void addEnterprise(int id, std::string_view name);
+    void addProduct(const Product& p);
+    bool addAssortment(int enterpriseId, int productId, int64_t wholesale, bool hasWholesale);
+
+public:
+    ColumnarCatalog() : loaded(false) {}
+
+    // Загрузка потоковым чтением через шлюзы (строки сразу раскладываются
+    // по столбцам, без промежуточных векторов объектов)
+    bool load(EnterpriseGateway& enterprises, ProductGateway& products, EnterpriseProductGateway& assortment);
+    // Загрузка из снимка: строки берутся прямо из отображённого файла
+    bool load(const Snapshot& snap);
+
+    void clear();
+    bool isLoaded() const { return loaded; }
+    CatalogStats stats() const;
+
+    const EnterpriseColumns& enterprises() const { return enterpriseCols; }
+    const ProductColumns& products() const { return productCols; }
+    const AssortmentColumns& assortment() const { return assortmentCols; }
+    const std::string& str(uint32_t code) const { return strings.decode(code); }
+
+    Product productAt(uint32_t row) const;
+
+    // Отчёты — те же, что у AnalyticsGateway, и в том же порядке строк
+    // (позиции и товары без цены учитываются так же, как в SQL)
+    std::vector<MarginSummary> marginByEnterprise(size_t limit) const;
+    std::vector<MarginSummary> marginByCategory() const;
+    std::vector<PriceOutlier> priceOutliers(size_t limit, long long* total) const;
+    // Как EnterpriseProductGateway::findBestOffers (позиции без цены пропускаются):
+    // один проход по ассортименту на весь список
+    std::vector<ProductOffer> bestOffers(const std::vector<int>& productIds, size_t topN) const;
+
+    // Фильтр, сортировка и страница по полям ProductGateway::criteriaFields().
+    // rows — номера строк товаров текущей страницы; total — число строк,
+    // прошедших фильтр. Текст сравнивается побайтно, ~ и ^ — без учёта регистра
+    // (латиница и кириллица). Товар без цены не проходит ни одно условие по
+    // ней и при сортировке идёт после всех (по убыванию — перед всеми), как
+    // NULL в PostgreSQL. false (с сообщением) при неверных критериях.
+    bool selectProducts(const Criteria& criteria, std::vector<uint32_t>& rows, long long* total) const;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,68 @@
+#ifndef CONNECTION_POOL_H
+#define CONNECTION_POOL_H
+
+#include "DatabaseConnection.h"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// ==========================================
+// Пул ODBC-соединений
+// ==========================================
+// Соединения открываются лениво (не больше maxSize) с одними и теми же параметрами DSN
+// и выдаются во временное владение через Lease. Когда все соединения заняты,
+// acquire() ждёт, пока какое-нибудь из них вернут.
+class ConnectionPool {
+public:
+    // Аренда соединения: возвращает его в пул при разрушении
+    class Lease {
+    private:
+        ConnectionPool* pool;
+        DatabaseConnection* conn;
+
+    public:
+        Lease() : pool(nullptr), conn(nullptr) {}
+        Lease(ConnectionPool* p, DatabaseConnection* c) : pool(p), conn(c) {}
+        Lease(Lease&& other) noexcept : pool(other.pool), conn(other.conn) { other.conn = nullptr; }
+        Lease& operator=(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease() { release(); }
+
+        DatabaseConnection* get() const { return conn; }
+        DatabaseConnection* operator->() const { return conn; }
+        explicit operator bool() const { return conn != nullptr; }
+
+        void release();
+    };
+
+private:
+    std::string dsn;
+    std::string user;
+    std::string password;
+    size_t maxSize;
+
+    std::mutex mutex;
+    std::condition_variable available;
+    std::vector<std::unique_ptr<DatabaseConnection>> connections; // Все открытые соединения
+    std::vector<DatabaseConnection*> idle;                         // Свободные соединения
+
+    void giveBack(DatabaseConnection* conn);
+
+public:
+    ConnectionPool(const std::string& dsn, const std::string& user, const std::string& password, size_t maxSize);
+    ~ConnectionPool() = default;
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    // Берёт свободное соединение (открывая новое, если лимит не исчерпан).
+    // Возвращает пустую аренду, если подключиться не удалось.
+    Lease acquire();
+
+    size_t capacity() const { return maxSize; }
+};
+
+#endif
\ No newline at end of file
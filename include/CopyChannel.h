@@ -0,0 +1,67 @@
+#ifndef COPY_CHANNEL_H
+#define COPY_CHANNEL_H
+
+#include "Money.h"
+#include <functional>
+#include <string>
+
+struct pg_conn; // PGconn из libpq — заголовки libpq нужны только в CopyChannel.cpp
+
+// ==========================================
+// Быстрый канал COPY (libpq)
+// ==========================================
+// Отдельное соединение libpq к той же базе, что и ODBC-соединение приложения,
+// для массовой загрузки (COPY ... FROM STDIN) и выгрузки (COPY ... TO STDOUT).
+// Если приложение собрано без libpq (нет REGENT_HAVE_LIBPQ) или сервер недоступен,
+// open() возвращает false, и вызывающий код использует пакетные INSERT через ODBC.
+class CopyChannel {
+private:
+    pg_conn* conn;
+    std::string buffer;   // Строки COPY в текстовом формате, отправляются блоками
+    size_t column;        // Номер поля в текущей строке
+    std::string error;
+
+    static const size_t FLUSH_SIZE = 1 << 20;
+
+    bool flush();
+    void beginField();
+
+public:
+    CopyChannel();
+    ~CopyChannel();
+
+    CopyChannel(const CopyChannel&) = delete;
+    CopyChannel& operator=(const CopyChannel&) = delete;
+
+    static bool isSupported();
+
+    // Строка подключения libpq из строки подключения ODBC
+    // (DATABASE/SERVER/PORT/UID/PWD, которые драйвер PostgreSQL берёт из DSN)
+    static std::string conninfoFromOdbc(const std::string& odbcConnectionString);
+
+    bool open(const std::string& conninfo);
+    bool isOpen() const { return conn != nullptr; }
+    void close();
+
+    // Выполняет команду; affected — число затронутых строк (для INSERT/UPDATE/DELETE)
+    bool execute(const std::string& sql, long long* affected = nullptr);
+
+    // Загрузка: beginCopyIn("COPY t (a, b) FROM STDIN"), затем строки
+    // через beginRow/field/endRow и в конце endCopyIn
+    bool beginCopyIn(const std::string& copySql);
+    void beginRow() { column = 0; }
+    void field(const std::string& value);
+    void field(long long value);
+    void field(int value) { field(static_cast<long long>(value)); }
+    void field(Money value);
+    bool endRow();
+    bool endCopyIn(long long* rows = nullptr);
+
+    // Выгрузка: выполняет "COPY (...) TO STDOUT ..." и передаёт данные блоками
+    // в sink по мере получения. Возвращает число строк или -1.
+    long long copyOut(const std::string& copySql, const std::function<bool(const char*, size_t)>& sink);
+
+    const std::string& lastError() const { return error; }
+};
+
+#endif
\ No newline at end of file
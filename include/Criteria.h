@@ -0,0 +1,133 @@
+#ifndef CRITERIA_H
+#define CRITERIA_H
+
+#include "DatabaseConnection.h"
+#include "Money.h"
+#include <string>
+#include <variant>
+#include <vector>
+
+// ==========================================
+// Критерии выборки (фильтр, сортировка, страница)
+// ==========================================
+// Criteria описывает выборку в терминах полей сущности ("name", "retail_price"),
+// а шлюз компилирует её в параметризованные WHERE / ORDER BY / LIMIT своего
+// запроса. Значения передаются параметрами ('?'), имена полей проверяются по
+// списку полей шлюза — в текст SQL попадают только известные выражения, поэтому
+// фильтрация и постраничный вывод выполняются сервером и по сети идут лишь
+// нужные строки.
+
+enum class CriteriaOp {
+    Eq,
+    Ne,
+    Lt,
+    Le,
+    Gt,
+    Ge,
+    Contains,   // Подстрока без учёта регистра (только текстовые поля)
+    StartsWith  // Начало строки без учёта регистра (только текстовые поля)
+};
+
+// Timestamp — момент времени (TIMESTAMPTZ); значение задаётся текстом ISO 8601
+// ("2024-05-01", "2024-05-01T12:00:00Z") и разбирается сервером
+enum class FieldType { Int, Text, Money, Timestamp };
+
+// Поле, доступное для фильтрации и сортировки
+struct CriteriaField {
+    const char* name;   // Имя в Criteria и в строке фильтра
+    const char* sql;    // Выражение SQL в запросе шлюза
+    FieldType type;
+};
+
+class Criteria {
+public:
+    // Текстовое значение допустимо для любого поля: для числовых и денежных
+    // полей оно разбирается при компиляции (так задаются фильтры из строки)
+    using Value = std::variant<long long, std::string, Money>;
+
+    struct Predicate {
+        std::string field;
+        CriteriaOp op;
+        Value value;
+    };
+
+    struct Order {
+        std::string field;
+        bool descending;
+    };
+
+private:
+    std::vector<Predicate> predicates;  // Объединяются через AND
+    std::vector<Order> ordering;
+    long long limitRows;                // -1 — без ограничения
+    long long offsetRows;
+
+public:
+    Criteria() : limitRows(-1), offsetRows(0) {}
+
+    Criteria& where(const std::string& field, CriteriaOp op, Value value);
+    Criteria& eq(const std::string& field, Value value) { return where(field, CriteriaOp::Eq, std::move(value)); }
+    Criteria& contains(const std::string& field, const std::string& text) { return where(field, CriteriaOp::Contains, text); }
+    // Диапазон [from, to] включительно
+    Criteria& between(const std::string& field, Value from, Value to);
+
+    Criteria& orderBy(const std::string& field, bool descending = false);
+    Criteria& limit(long long rows) { limitRows = rows; return *this; }
+    Criteria& offset(long long rows) { offsetRows = rows; return *this; }
+
+    // Разбор фильтра из строки: условия через ';', каждое — "поле оп значение",
+    // где оп — один из = != < <= > >= ~ (содержит) ^ (начинается с).
+    // Пример: "legal_form = ООО; retail_price <= 150; name ~ молоко".
+    // Условия добавляются к уже заданным; false (с сообщением) при ошибке разбора.
+    bool parseFilter(const std::string& text);
+    // Разбор сортировки: поля через запятую, "-" перед полем или "desc" после — по убыванию.
+    // Пример: "-retail_price, name". Заменяет прежнюю сортировку.
+    bool parseOrder(const std::string& text);
+
+    void clearFilter() { predicates.clear(); }
+    void clearOrder() { ordering.clear(); }
+
+    const std::vector<Predicate>& getPredicates() const { return predicates; }
+    const std::vector<Order>& getOrdering() const { return ordering; }
+    long long getLimit() const { return limitRows; }
+    long long getOffset() const { return offsetRows; }
+    bool hasFilter() const { return !predicates.empty(); }
+    bool isDefault() const { return predicates.empty() && ordering.empty(); }
+
+    // Поле по имени; nullptr (с сообщением и списком полей), если такого нет
+    static const CriteriaField* findField(const std::vector<CriteriaField>& fields, const std::string& name);
+    // Значение для числового поля: целое или копейки для Money; false (с сообщением),
+    // если значение не подходит к типу поля
+    static bool numericValue(const CriteriaField& field, const Value& value, long long& out);
+    static std::string textValue(const Value& value);
+
+    // Краткое описание для заголовков ("legal_form = ООО; сортировка: -retail_price")
+    std::string describe() const;
+};
+
+// Критерии, скомпилированные для конкретного запроса: фрагменты SQL
+// и значения параметров в порядке знаков '?'
+class CompiledCriteria {
+private:
+    struct Param {
+        FieldType type;     // Text — строка, иначе BIGINT (деньги — в копейках)
+        long long number;
+        std::string text;
+        SQLLEN length;
+    };
+    std::vector<Param> params;
+
+public:
+    std::string where;      // " WHERE ..." или пусто
+    std::string orderBy;    // " ORDER BY ..." (всегда с ключом в конце — порядок страниц устойчив)
+    std::string limit;      // " LIMIT n OFFSET m" или пусто
+
+    // Проверяет поля и типы значений; false (с сообщением) при ошибке.
+    // keyOrder — выражение первичного ключа для сортировки по умолчанию.
+    bool compile(const Criteria& criteria, const std::vector<CriteriaField>& fields, const std::string& keyOrder);
+
+    // Привязывает параметры к оператору; буферы живут до следующего compile()
+    bool bind(SQLHSTMT hStmt);
+};
+
+#endif
\ No newline at end of file
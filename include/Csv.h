@@ -0,0 +1,43 @@
+#ifndef CSV_H
+#define CSV_H
+
+#include <istream>
+#include <string>
+#include <vector>
+
+// ==========================================
+// Потоковое чтение CSV (RFC 4180)
+// ==========================================
+// Читает файл блоками и отдаёт по одной записи, не загружая файл целиком.
+// Поддерживает кавычки, удвоенные кавычки внутри поля, переводы строк внутри
+// кавычек, окончания строк CRLF и UTF-8 BOM в начале файла.
+class CsvReader {
+private:
+    std::istream& in;
+    char delimiter;
+    std::vector<char> buffer;
+    size_t pos;
+    size_t end;
+    size_t line;        // Номер текущей физической строки файла
+    size_t recordLine;  // Строка, с которой началась последняя прочитанная запись
+    bool eof;
+
+    bool fill();
+    int peekChar();
+    int getChar();
+
+public:
+    explicit CsvReader(std::istream& input, char delim = ',', size_t bufferSize = 1 << 20);
+
+    // Читает следующую запись. Возвращает false, когда данные закончились.
+    bool next(std::vector<std::string>& fields);
+
+    // Номер строки файла (с 1), где началась последняя запись — для сообщений об ошибках
+    size_t lineNumber() const { return recordLine; }
+};
+
+// Дописывает поле CSV в строку, заключая его в кавычки только при необходимости
+// (разделитель, кавычка или перевод строки внутри значения)
+void appendCsvField(std::string& out, const std::string& field, char delimiter = ',');
+
+#endif
\ No newline at end of file
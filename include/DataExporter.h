@@ -0,0 +1,63 @@
+#ifndef DATA_EXPORTER_H
+#define DATA_EXPORTER_H
+
+#include "CopyChannel.h"
+#include "DatabaseConnection.h"
+#include "ExportWriter.h"
+#include <string>
+
+// ==========================================
+// Выгрузка таблиц реестра
+// ==========================================
+
+enum class ExportDataset {
+    Enterprises,
+    Products,
+    Assortment,
+    SalesDepartments,
+    BankDetails,
+    Deletions       // Отметки об удалённых строках: таблица, ключ, время удаления
+};
+
+struct ExportOptions {
+    ExportFormat format = ExportFormat::Csv;
+    bool gzip = false;
+    bool useCopy = true;   // CSV: выгружать через COPY (libpq), если доступно
+    // Отметка времени (ISO 8601): только строки с updated_at не раньше неё,
+    // а для Deletions — удаления с этого момента. Пусто — все строки.
+    std::string since;
+};
+
+// Читает строки через потоковые методы шлюзов (streamAll) и сразу передаёт их
+// в ExportWriter — таблица целиком в памяти не собирается. Для постоянного
+// расхода памяти соединение должно выбирать строки курсором
+// (UseDeclareFetch у драйвера PostgreSQL), иначе драйвер сам буферизует результат.
+class DataExporter {
+private:
+    DatabaseConnection* db;
+
+public:
+    explicit DataExporter(DatabaseConnection* conn) : db(conn) {}
+
+    // Возвращает число выгруженных строк или -1 при ошибке; since — см. ExportOptions
+    long long exportDataset(ExportDataset dataset, ExportWriter& out, const std::string& since = "");
+
+    // Быстрый путь для CSV: сервер сам форматирует строки (COPY ... TO STDOUT),
+    // колонки и порядок строк те же, что у exportDataset. Не использует db.
+    static long long exportDatasetViaCopy(ExportDataset dataset, CopyChannel& channel, ExportWriter& out,
+                                          const std::string& since = "");
+    static bool supportsCopy(ExportDataset dataset);
+
+    // Отметка since для следующей выгрузки (UTC, ISO 8601); берётся до начала
+    // текущей. Пустая строка при ошибке.
+    std::string watermark();
+
+    // Строка состоит только из цифр и разделителей даты и времени
+    static bool isTimestamp(const std::string& text);
+
+    // Имя набора в командной строке и в именах файлов: "enterprises", "bank-details" и т.д.
+    static const char* datasetName(ExportDataset dataset);
+    static bool parseDataset(const std::string& name, ExportDataset& dataset);
+};
+
+#endif
\ No newline at end of file
@@ -12,20 +12,38 @@ private:
     SQLHENV hEnv;
     SQLHDBC hDbc;
     bool connected;
+    bool verbose; // Печатать ли сообщения о подключении/отключении
+    std::string connectionString; // Полная строка подключения, дополненная драйвером из DSN
 
 public:
     DatabaseConnection();
     ~DatabaseConnection();
 
+    // options — дополнительные параметры строки подключения драйвера
+    // (например, "UseDeclareFetch=1;Fetch=10000" для построчной выборки курсором)
     bool connect(const std::string& dsn = "rab_dsn", 
                  const std::string& user = "rab", 
-                 const std::string& password = "1111");
+                 const std::string& password = "1111",
+                 const std::string& options = "");
 
     bool isConnected() const { return connected; }
+    void setVerbose(bool value) { verbose = value; }
     SQLHDBC getHandle() const { return hDbc; }
 
+    // Строка подключения, которую вернул драйвер (с параметрами из DSN: сервер, порт, база).
+    // Нужна, чтобы открыть к той же базе соединение в обход ODBC (см. CopyChannel).
+    const std::string& getConnectionString() const { return connectionString; }
+
     void disconnect();
     bool executeQuery(const std::string& sql);
+
+    // Выполняет INSERT/UPDATE/DELETE и возвращает число затронутых строк (-1 при ошибке)
+    long executeUpdate(const std::string& sql);
+
+    // Управление транзакциями (по умолчанию соединение работает в режиме autocommit)
+    bool beginTransaction();
+    bool commit();
+    bool rollback();
 };
 
 #endif
\ No newline at end of file
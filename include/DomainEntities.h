@@ -2,6 +2,21 @@
 #define DOMAIN_ENTITIES_H
 
 #include <string>
+#include "Money.h"
+
+// Справочники (организационно-правовые формы, формы собственности,
+// категории товаров, условия поставки)
+enum class Dictionary {
+    LegalForm,
+    OwnershipForm,
+    ProductCategory,
+    DeliveryTerms
+};
+
+struct DictionaryEntry {
+    int id;
+    std::string name;
+};
 
 struct Enterprise {
     int id;
@@ -20,16 +35,107 @@ struct Product {
     std::string name;
     int shelf_life_days;
     int delivery_terms_id;
-    double retail_price;
-    double purchase_price;
+    Money retail_price;
+    Money purchase_price;
     std::string category_name;
     std::string delivery_terms_description;
+    // false — цена не указана (NULL в БД), в поле цены тогда ноль
+    bool has_retail_price = true;
+    bool has_purchase_price = true;
 };
 
 struct EnterpriseProduct {
     int enterprise_id;
     int product_id;
-    double wholesale_price;
+    Money wholesale_price;
+    bool has_wholesale_price = true;    // false — цена не указана, в wholesale_price ноль
+};
+
+// Позиция ассортимента предприятия: товар целиком и его оптовая цена
+struct AssortmentLine {
+    Product product;
+    Money wholesale_price;
+    bool has_wholesale_price = true;
+};
+
+// Что делать, если копируемый товар уже есть в ассортименте целевого предприятия
+enum class AssortmentConflictPolicy {
+    Skip,       // Оставить существующую оптовую цену
+    Overwrite   // Заменить цену на скопированную
+};
+
+// Вид правки в пакетном изменении ассортимента
+enum class AssortmentChange {
+    Add,        // Добавить позицию (если её нет, а предприятие и товар существуют)
+    SetPrice,   // Изменить оптовую цену существующей позиции
+    Remove      // Удалить позицию
+};
+
+// Строка отчёта о марже: оптовые цены ассортимента против закупочных цен товаров,
+// сгруппированные по предприятию или по категории товара
+struct MarginSummary {
+    int id;                     // ID предприятия или категории
+    std::string name;
+    long long lines;            // Позиций ассортимента в группе
+    Money wholesale_total;      // Сумма оптовых цен
+    Money purchase_total;       // Сумма закупочных цен тех же позиций
+    long long below_purchase;   // Позиций с оптовой ценой ниже закупочной
+    double margin_share;        // Доля группы в общей марже (0..1)
+};
+
+// Позиция ассортимента, проданная оптом дешевле закупки
+struct PriceOutlier {
+    int enterprise_id;
+    std::string enterprise_name;
+    int product_id;
+    std::string product_name;
+    Money wholesale_price;
+    Money purchase_price;
+};
+
+// Предложение товара предприятием: место в рейтинге по оптовой цене (1 — дешевле всех)
+struct ProductOffer {
+    int product_id;
+    int rank;
+    int enterprise_id;
+    std::string enterprise_name;
+    Money wholesale_price;
+};
+
+// Сводка ассортимента предприятия (таблица enterprise_assortment_summary).
+// Средняя цена — по позициям с указанной ценой, с округлением до копеек.
+struct AssortmentSummary {
+    int enterprise_id = 0;
+    std::string enterprise_name;
+    long long lines = 0;
+    int categories = 0;
+    Money min_price;
+    Money avg_price;
+    Money max_price;
+};
+
+// Позиция в журнале изменений: записи упорядочены по транзакции-автору,
+// затем по номеру записи. {0, 0} — начало журнала.
+struct ChangeCursor {
+    long long txid = 0;
+    long long seq = 0;
+};
+
+// Запись журнала изменений (таблица change_log)
+struct ChangeRecord {
+    ChangeCursor position;
+    std::string changed_at;     // UTC, ISO 8601
+    std::string table;          // enterprise, product, enterprise_product, ...
+    char operation;             // I — вставка, U — изменение, D — удаление, T — очистка таблицы
+    std::string key;            // Значение ключа; составной — через ':'
+    std::string data;           // Строка после изменения в JSON; пусто для D и T
+};
+
+// Отметка об удалённой строке (таблица deleted_row) для выгрузки изменений
+struct Tombstone {
+    std::string table;
+    std::string key;            // Как в ChangeRecord::key
+    std::string deleted_at;     // UTC, ISO 8601
 };
 
 struct SalesDepartment {
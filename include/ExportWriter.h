@@ -0,0 +1,82 @@
+#ifndef EXPORT_WRITER_H
+#define EXPORT_WRITER_H
+
+#include "Money.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ==========================================
+// Буферизованная запись выгрузок (CSV / JSON Lines)
+// ==========================================
+
+enum class ExportFormat {
+    Csv,        // Заголовок + строки, RFC 4180
+    JsonLines   // Один JSON-объект на строку
+};
+
+// Записи формируются в буфере фиксированного размера и сбрасываются в файл
+// крупными последовательными блоками (write(2) или gzwrite), поэтому объём
+// памяти не зависит от размера выгрузки.
+class ExportWriter {
+public:
+    // Приёмник байтов (файл, stdout или gzip) — реализации в ExportWriter.cpp
+    class Sink;
+
+private:
+    std::unique_ptr<Sink> sink;
+    ExportFormat format;
+    std::string buffer;
+    std::vector<std::string> columns;
+    size_t column;      // Номер текущего поля в строке
+    bool failed;
+
+    static const size_t BUFFER_SIZE = 1 << 20;
+
+    ExportWriter(std::unique_ptr<Sink> out, ExportFormat fmt);
+
+    void beginField();
+    void rawField(const char* text, size_t len);
+    void flushIfFull();
+
+public:
+    ~ExportWriter();
+
+    // Открывает файл для записи ("-" — стандартный вывод).
+    // gzip = true сжимает поток (если приложение собрано с zlib).
+    // Возвращает nullptr при ошибке.
+    static std::unique_ptr<ExportWriter> open(const std::string& path, ExportFormat fmt, bool gzip);
+
+    static bool gzipSupported();
+
+    // Имена колонок: заголовок CSV и ключи объектов JSON
+    void begin(const std::vector<std::string>& columnNames);
+
+    void beginRow();
+    void field(const std::string& value);
+    void field(long long value);
+    void field(int value) { field(static_cast<long long>(value)); }
+    void field(Money value);
+    // Готовый JSON (объект, массив): в JSON Lines вкладывается как есть, в CSV —
+    // строкой. Пустая строка — null (в CSV — пустое поле).
+    void jsonField(const std::string& json);
+    void endRow();
+
+    // Готовые байты выгрузки (например, поток COPY ... TO STDOUT в формате CSV),
+    // минуя форматирование полей
+    void writeRaw(const char* data, size_t len);
+
+    // Передаёт накопленные строки приёмнику, не дожидаясь заполнения буфера
+    // (для вывода, который читают по мере появления; gzip может задержать их у себя)
+    bool flush();
+
+    // Сбрасывает буфер и закрывает файл. Возвращает false, если запись не удалась.
+    bool close();
+
+    // false после первой ошибки записи: дальнейшие строки пропадут, чтение
+    // выборки для выгрузки пора прекращать
+    bool good() const { return !failed; }
+};
+
+#endif
\ No newline at end of file
@@ -3,8 +3,15 @@
 
 #include "DatabaseConnection.h"
 #include "DomainEntities.h"
+#include "Criteria.h"
 #include <vector>
 #include <string>
+#include <functional>
+
+// Обработчик строк потокового чтения: вызывается для каждой строки результата
+// по мере выборки. Вернуть false — прекратить чтение досрочно.
+template <class T>
+using RowCallback = std::function<bool(const T&)>;
 
 // ==========================================
 // Базовый класс TableGateway
@@ -13,6 +20,16 @@ class TableGateway {
 protected:
     DatabaseConnection* db;
 
+    // Выполняет select + условия criteria (поля проверяются по fields, порядок
+    // по умолчанию — keyOrder). Возвращает оператор, готовый к SQLFetch
+    // (освобождает вызывающий), или SQL_NULL_HSTMT при ошибке.
+    SQLHSTMT openQuery(const std::string& select, const Criteria& criteria,
+                       const std::vector<CriteriaField>& fields, const std::string& keyOrder);
+
+    // SELECT COUNT(*) с условиями criteria (сортировка и страница не учитываются); -1 при ошибке
+    long long countQuery(const std::string& from, const Criteria& criteria,
+                         const std::vector<CriteriaField>& fields);
+
 public:
     TableGateway(DatabaseConnection* conn) : db(conn) {}
     virtual ~TableGateway() = default;
@@ -36,6 +53,25 @@ public:
         }
         return escaped;
     }
+
+    // Код, на котором закончился цикл SQLFetch: SQL_NO_DATA — выборка
+    // дочитана, успешный — цикл прерван вызывающим. Иначе (обрыв соединения,
+    // ошибка сервера) пишет диагностику и возвращает false: прочитана не вся
+    // выборка, и выдавать её за полную нельзя.
+    static bool fetchCompleted(SQLHSTMT hStmt, SQLRETURN rc);
+};
+
+// ==========================================
+// Шлюз: Справочники (Dictionary)
+// ==========================================
+class DictionaryGateway : public TableGateway {
+public:
+    using TableGateway::TableGateway;
+
+    // Создаёт все четыре таблицы справочников
+    void createTableIfNotExists() override;
+
+    std::vector<DictionaryEntry> findAll(Dictionary dict);
 };
 
 // ==========================================
@@ -49,6 +85,20 @@ public:
 
     // Основной CRUD
     std::vector<Enterprise> findAll();
+
+    // Потоковое чтение всех предприятий без накопления в памяти.
+    // Возвращает число прочитанных строк или -1 при ошибке.
+    long long streamAll(const RowCallback<Enterprise>& callback) { return streamWhere(Criteria(), callback); }
+
+    // Выборка по критериям: фильтр, сортировка и страница выполняются сервером.
+    // Возвращает число прочитанных строк или -1 при ошибке (неизвестное поле,
+    // ошибка SQL, выборка оборвалась на середине — тогда и findWhere пуст).
+    long long streamWhere(const Criteria& criteria, const RowCallback<Enterprise>& callback);
+    std::vector<Enterprise> findWhere(const Criteria& criteria);
+    // Число строк, удовлетворяющих фильтру criteria; -1 при ошибке
+    long long countWhere(const Criteria& criteria);
+    // Поля для фильтрации и сортировки
+    static const std::vector<CriteriaField>& criteriaFields();
     Enterprise findById(int id);
     
     // Принимает DTO, возвращает ID созданной записи
@@ -62,6 +112,11 @@ public:
 
     // Специфичные методы поиска
     Enterprise findByInn(const std::string& inn);
+
+    // Пакетная вставка одним параметризованным оператором с массивами параметров.
+    // upsert = true обновляет существующие предприятия с тем же ИНН,
+    // иначе такие строки пропускаются. Возвращает число затронутых строк или -1.
+    long insertBatch(const std::vector<Enterprise>& batch, bool upsert);
 };
 
 // ==========================================
@@ -74,6 +129,12 @@ public:
     void createTableIfNotExists() override;
 
     std::vector<Product> findAll();
+    long long streamAll(const RowCallback<Product>& callback) { return streamWhere(Criteria(), callback); }
+
+    long long streamWhere(const Criteria& criteria, const RowCallback<Product>& callback);
+    std::vector<Product> findWhere(const Criteria& criteria);
+    long long countWhere(const Criteria& criteria);
+    static const std::vector<CriteriaField>& criteriaFields();
     Product findById(int id);
     
     // Возвращает ID нового товара
@@ -84,6 +145,12 @@ public:
 
     // Поиск по названию
     Product findByName(const std::string& name);
+
+    // Все названия товаров (для проверки дубликатов при импорте)
+    std::vector<std::string> findAllNames();
+
+    // Пакетная вставка с массивами параметров. Возвращает число вставленных строк или -1.
+    long insertBatch(const std::vector<Product>& batch);
 };
 
 // ==========================================
@@ -100,6 +167,20 @@ public:
     std::vector<EnterpriseProduct> findByEnterprise(int enterprise_id);
     std::vector<EnterpriseProduct> findByProduct(int product_id);
 
+    // Предприятия, предлагающие товары, по возрастанию оптовой цены: не более topN
+    // на товар (0 — все). Товары идут в порядке product_ids; позиции без цены не
+    // учитываются. Список разбивается на запросы по OFFER_BATCH товаров.
+    std::vector<ProductOffer> findBestOffers(const std::vector<int>& product_ids, size_t topN);
+    static const size_t OFFER_BATCH = 1000;
+
+    // Потоковое чтение всего ассортимента (упорядочено по предприятию и товару)
+    long long streamAll(const RowCallback<EnterpriseProduct>& callback) { return streamWhere(Criteria(), callback); }
+
+    long long streamWhere(const Criteria& criteria, const RowCallback<EnterpriseProduct>& callback);
+    std::vector<EnterpriseProduct> findWhere(const Criteria& criteria);
+    long long countWhere(const Criteria& criteria);
+    static const std::vector<CriteriaField>& criteriaFields();
+
     // Добавление связи (товар в ассортимент предприятия)
     // Возвращает bool, так как ID составной
     bool insert(const EnterpriseProduct& item);
@@ -109,6 +190,26 @@ public:
 
     // Удаление связи (нужен составной ключ)
     bool remove(int enterprise_id, int product_id);
+
+    // Количество товаров в ассортименте предприятия; -1 при ошибке
+    int countByEnterprise(int enterprise_id);
+
+    // Копирование всего ассортимента предприятия-источника в группу предприятий
+    // одним INSERT ... SELECT. Цена умножается на priceMultiplier (с округлением до копеек).
+    // Возвращает число вставленных/обновлённых строк или -1 при ошибке.
+    long copyAssortment(int source_enterprise_id, const std::vector<int>& target_ids,
+                        double priceMultiplier, AssortmentConflictPolicy policy);
+
+    // Пакетная вставка с массивами параметров; upsert = true обновляет цену
+    // уже существующих связей. Возвращает число затронутых строк или -1.
+    long insertBatch(const std::vector<EnterpriseProduct>& batch, bool upsert);
+
+    // Пакет правок одного вида: строки загружаются во временную таблицу и
+    // применяются одним оператором. applied[i] — затронула ли правка i позицию
+    // ассортимента. Ключи (предприятие, товар) в пакете не повторяются.
+    // Вызывается внутри транзакции; false при ошибке.
+    bool applyChanges(AssortmentChange kind, const std::vector<EnterpriseProduct>& changes,
+                      std::vector<bool>& applied);
 };
 
 // ==========================================
@@ -121,7 +222,14 @@ public:
     void createTableIfNotExists() override;
 
     std::vector<SalesDepartment> findAll();
+    long long streamAll(const RowCallback<SalesDepartment>& callback) { return streamWhere(Criteria(), callback); }
+
+    long long streamWhere(const Criteria& criteria, const RowCallback<SalesDepartment>& callback);
+    std::vector<SalesDepartment> findWhere(const Criteria& criteria);
+    long long countWhere(const Criteria& criteria);
+    static const std::vector<CriteriaField>& criteriaFields();
     SalesDepartment findById(int id);
+    SalesDepartment findByEnterprise(int enterprise_id);  // id = 0, если отдела нет
 
     int insert(const SalesDepartment& dept);
     bool update(const SalesDepartment& dept);
@@ -138,11 +246,110 @@ public:
     void createTableIfNotExists() override;
 
     std::vector<BankDetails> findAll();
+    long long streamAll(const RowCallback<BankDetails>& callback) { return streamWhere(Criteria(), callback); }
+
+    long long streamWhere(const Criteria& criteria, const RowCallback<BankDetails>& callback);
+    std::vector<BankDetails> findWhere(const Criteria& criteria);
+    long long countWhere(const Criteria& criteria);
+    static const std::vector<CriteriaField>& criteriaFields();
     BankDetails findById(int id);
+    BankDetails findByEnterprise(int enterprise_id);      // id = 0, если реквизитов нет
 
     int insert(const BankDetails& details);
     bool update(const BankDetails& details);
     bool remove(int id);
 };
 
+// ==========================================
+// Шлюз: Сводка ассортимента по предприятиям
+// ==========================================
+// Число позиций, категорий и границы оптовых цен каждого предприятия хранятся
+// в enterprise_assortment_summary и поддерживаются триггерами на enterprise_product
+// и product — при любой записи, включая COPY и операции над множеством строк.
+// Чтение сводки не касается самого ассортимента.
+class AssortmentSummaryGateway : public TableGateway {
+public:
+    using TableGateway::TableGateway;
+
+    // Таблицы сводки, функции и триггеры; при первой установке сводка заполняется
+    void createTableIfNotExists() override;
+
+    // Полный пересчёт сводки по ассортименту
+    bool rebuild();
+
+    std::vector<AssortmentSummary> findWhere(const Criteria& criteria);
+    long long countWhere(const Criteria& criteria);
+    static const std::vector<CriteriaField>& criteriaFields();
+
+    // Сводки перечисленных предприятий (одним запросом); у предприятий без
+    // ассортимента строки сводки нет
+    std::vector<AssortmentSummary> findByEnterprises(const std::vector<int>& enterprise_ids);
+};
+
+// ==========================================
+// Шлюз: Журнал изменений
+// ==========================================
+// Каждое изменение предприятий, товаров, ассортимента, отделов сбыта и реквизитов
+// записывается триггером в change_log в той же транзакции, поэтому в журнал
+// попадает и запись в обход шлюзов (импорт через COPY, ручной SQL).
+//
+// Порядок записей — (txid, seq), а не seq: номера seq выдаются до фиксации, и
+// транзакция с меньшим seq может зафиксироваться позже. Чтение ограничено
+// транзакциями старше самой старой незавершённой, поэтому после выданной
+// позиции новые записи уже не появятся — потребитель не пропустит изменений.
+class ChangeLogGateway : public TableGateway {
+public:
+    using TableGateway::TableGateway;
+
+    // Таблица журнала, функции и триггеры на таблицах реестра
+    void createTableIfNotExists() override;
+
+    // Записи после позиции since по порядку, не более limit (0 — все).
+    // Возвращает число прочитанных записей или -1 при ошибке.
+    long long streamSince(const ChangeCursor& since, long long limit, const RowCallback<ChangeRecord>& callback);
+
+    // Позиция последней записи, доступной для чтения ({0, 0} — журнал пуст)
+    ChangeCursor head();
+};
+
+// ==========================================
+// Шлюз: Отметки об удалённых строках
+// ==========================================
+// Выгрузка по updated_at не видит удалённых строк; их ключи записывает
+// триггер на удаление. Ключ строится функцией change_log_key, поэтому шлюз
+// создаётся после ChangeLogGateway.
+class TombstoneGateway : public TableGateway {
+public:
+    using TableGateway::TableGateway;
+
+    void createTableIfNotExists() override;
+
+    // Удаления начиная с since (ISO 8601; пусто — все) в порядке времени.
+    // Возвращает число прочитанных отметок или -1 при ошибке.
+    long long streamSince(const std::string& since, const RowCallback<Tombstone>& callback);
+};
+
+// ==========================================
+// Шлюз: Аналитика ассортимента (только чтение)
+// ==========================================
+// Агрегаты считаются сервером БД (GROUP BY, оконные функции) — по сети идут
+// только строки отчёта, а не весь ассортимент.
+class AnalyticsGateway : public TableGateway {
+public:
+    using TableGateway::TableGateway;
+
+    // Своих таблиц нет — отчёты строятся по enterprise_product и product
+    void createTableIfNotExists() override {}
+
+    // Маржа по предприятиям, по убыванию маржи; limit = 0 — все предприятия
+    std::vector<MarginSummary> marginByEnterprise(size_t limit);
+
+    // Маржа по категориям товаров, по убыванию маржи
+    std::vector<MarginSummary> marginByCategory();
+
+    // Позиции с оптовой ценой ниже закупочной, по убыванию убытка.
+    // total — число всех таких позиций (без учёта limit).
+    std::vector<PriceOutlier> findPriceOutliers(size_t limit, long long* total);
+};
+
 #endif
\ No newline at end of file
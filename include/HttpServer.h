@@ -0,0 +1,111 @@
+#ifndef HTTP_SERVER_H
+#define HTTP_SERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// ==========================================
+// HTTP/1.1 сервер на epoll
+// ==========================================
+
+struct HttpRequest {
+    std::string method;
+    std::string path;                                    // Без строки запроса, раскодированный
+    std::unordered_map<std::string, std::string> query;  // Параметры ?a=1&b=2, раскодированные
+    std::string body;
+
+    // Значение параметра строки запроса или fallback
+    std::string param(const std::string& name, const std::string& fallback = "") const;
+};
+
+struct HttpResponse {
+    int status = 200;
+    std::string contentType = "application/json; charset=utf-8";
+    std::string body;
+};
+
+using HttpHandler = std::function<HttpResponse(const HttpRequest&)>;
+
+// Один поток принимает соединения и читает/пишет сокеты через epoll (неблокирующий
+// ввод-вывод), разобранные запросы выполняют рабочие потоки — обработчики могут
+// ждать БД, не задерживая остальные соединения. Ответ передаётся обратно циклу
+// через очередь и eventfd. Поддерживаются keep-alive и конвейерные запросы
+// (на соединении выполняется не больше одного запроса за раз, ответы идут по порядку),
+// тело — только с Content-Length.
+class HttpServer {
+private:
+    struct Connection;
+    struct Job {
+        uint64_t connection;
+        HttpRequest request;
+        bool close;         // Закрыть соединение после ответа
+    };
+    struct Done {
+        uint64_t connection;
+        std::string response;
+        bool close;
+    };
+
+    HttpHandler handler;
+    size_t workerCount;
+
+    int listenFd;
+    int epollFd;
+    int wakeFd;     // eventfd: готовые ответы или остановка
+    std::atomic<bool> stopping;
+
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;  // fd -> соединение
+    std::unordered_map<uint64_t, int> fdOf;                            // ID соединения -> fd
+    uint64_t nextId;
+
+    std::mutex jobMutex;
+    std::condition_variable jobReady;
+    std::deque<Job> jobs;
+
+    std::mutex doneMutex;
+    std::vector<Done> done;
+
+    std::vector<std::thread> workers;
+
+    void workerLoop();
+    void acceptAll();
+    void onReadable(Connection& c);
+    void onWritable(Connection& c);
+    void dispatch(Connection& c);     // Следующий полный запрос из буфера — рабочим
+    void deliverDone();
+    void updateInterest(Connection& c);
+    void closeConnection(int fd);
+
+public:
+    // Наибольший размер заголовков и тела запроса
+    static const size_t MAX_HEADER = 64 * 1024;
+    static const size_t MAX_BODY = 16 * 1024 * 1024;
+
+    HttpServer(HttpHandler requestHandler, size_t workerThreads);
+    ~HttpServer();
+
+    HttpServer(const HttpServer&) = delete;
+    HttpServer& operator=(const HttpServer&) = delete;
+
+    // Открывает сокет; false (с сообщением), если адрес занят или неверен
+    bool listen(const std::string& address, int port);
+
+    // Цикл обработки; возвращается после stop()
+    void run();
+
+    // Можно вызывать из другого потока и из обработчика сигнала
+    void stop();
+
+    static const char* statusText(int status);
+};
+
+#endif
\ No newline at end of file
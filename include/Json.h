@@ -0,0 +1,84 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include "Money.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// ==========================================
+// JSON для HTTP API
+// ==========================================
+
+// Дописывает строку в кавычках с экранированием; UTF-8 передаётся как есть,
+// неверные байты заменяются на U+FFFD
+void appendJsonString(std::string& out, const char* s, size_t len);
+
+// Построитель JSON-текста. Запятые между элементами расставляются сами;
+// правильность вложенности (ключ — только внутри объекта) на совести вызывающего.
+class JsonWriter {
+private:
+    std::string out;
+    std::vector<bool> first;    // Для каждого открытого уровня: ещё не было элементов
+    bool afterKey;
+
+    void separate();
+
+public:
+    JsonWriter() : afterKey(false) {}
+
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+    JsonWriter& key(const char* name);
+
+    JsonWriter& value(const std::string& s);
+    JsonWriter& value(const char* s);
+    JsonWriter& value(long long n);
+    JsonWriter& value(int n) { return value(static_cast<long long>(n)); }
+    JsonWriter& value(size_t n) { return value(static_cast<long long>(n)); }
+    JsonWriter& value(double x);
+    JsonWriter& value(bool b);
+    // Число с двумя знаками после точки, без перехода через double
+    JsonWriter& value(Money m);
+    JsonWriter& null();
+
+    // Пара "ключ": значение
+    template <class T>
+    JsonWriter& field(const char* name, const T& v) { return key(name).value(v); }
+
+    const std::string& str() const { return out; }
+};
+
+// Объект JSON верхнего уровня из тела запроса. Значения — строки, числа,
+// true/false/null и массивы чисел; вложенные объекты не поддерживаются.
+class JsonObject {
+private:
+    enum class Kind { String, Number, Bool, Null, NumberArray };
+
+    struct Value {
+        Kind kind;
+        std::string text;               // Строка без экранирования или запись числа
+        std::vector<std::string> items; // Записи чисел массива
+    };
+
+    std::unordered_map<std::string, Value> values;
+
+public:
+    // false и текст ошибки, если тело не является таким объектом
+    bool parse(const std::string& json, std::string& error);
+
+    bool has(const std::string& name) const { return values.count(name) != 0; }
+
+    // false, если поля нет или тип не подходит (out при этом не меняется).
+    // Целые и суммы принимаются и числом, и строкой ("12.50").
+    bool getString(const std::string& name, std::string& out) const;
+    bool getInt(const std::string& name, int& out) const;
+    bool getNumber(const std::string& name, double& out) const;
+    bool getMoney(const std::string& name, Money& out) const;
+    bool getBool(const std::string& name, bool& out) const;
+    bool getIntArray(const std::string& name, std::vector<int>& out) const;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,65 @@
+#ifndef MONEY_H
+#define MONEY_H
+
+#include <cstdint>
+#include <string>
+#include <ostream>
+
+// ==========================================
+// Денежная сумма с фиксированной точкой
+// ==========================================
+// Хранится целым числом копеек (int64). Соответствует NUMERIC(10,2) в схеме БД:
+// значения читаются и записываются без промежуточного double, поэтому
+// 0.10 + 0.20 всегда равно 0.30, а массивы Money можно складывать как массивы int64.
+class Money {
+private:
+    int64_t kopecks;
+
+    explicit constexpr Money(int64_t k) : kopecks(k) {}
+
+public:
+    constexpr Money() : kopecks(0) {}
+
+    static constexpr Money fromKopecks(int64_t k) { return Money(k); }
+    static constexpr Money fromRubles(int64_t rubles) { return Money(rubles * 100); }
+
+    // Разбор десятичной записи: "123", "123.4", "123.45", "-0.50", "1 234,50".
+    // Допускаются пробелы-разделители разрядов и запятая вместо точки.
+    // Возвращает false, если строка не является суммой или содержит больше двух знаков после запятой.
+    static bool parse(const std::string& text, Money& out);
+
+    constexpr int64_t toKopecks() const { return kopecks; }
+
+    // Точная десятичная запись с двумя знаками: "123.45", "-0.05".
+    // Годится и для вывода, и как литерал NUMERIC в SQL.
+    std::string toString() const;
+
+    constexpr bool isNegative() const { return kopecks < 0; }
+    constexpr bool isZero() const { return kopecks == 0; }
+
+    // Умножение на коэффициент (наценка, скидка) с округлением половины от нуля,
+    // как ROUND(numeric, 2) в PostgreSQL
+    Money multiply(double factor) const;
+
+    constexpr Money operator-() const { return Money(-kopecks); }
+    constexpr Money operator+(Money other) const { return Money(kopecks + other.kopecks); }
+    constexpr Money operator-(Money other) const { return Money(kopecks - other.kopecks); }
+    Money& operator+=(Money other) { kopecks += other.kopecks; return *this; }
+    Money& operator-=(Money other) { kopecks -= other.kopecks; return *this; }
+
+    constexpr bool operator==(Money other) const { return kopecks == other.kopecks; }
+    constexpr bool operator!=(Money other) const { return kopecks != other.kopecks; }
+    constexpr bool operator<(Money other) const { return kopecks < other.kopecks; }
+    constexpr bool operator<=(Money other) const { return kopecks <= other.kopecks; }
+    constexpr bool operator>(Money other) const { return kopecks > other.kopecks; }
+    constexpr bool operator>=(Money other) const { return kopecks >= other.kopecks; }
+};
+
+// Money — тонкая обёртка над int64: её массивы совместимы с векторными целочисленными ядрами
+static_assert(sizeof(Money) == sizeof(int64_t), "Money must stay a plain 64-bit value");
+
+inline std::ostream& operator<<(std::ostream& os, Money m) {
+    return os << m.toString();
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,51 @@
+#ifndef PAGE_CACHE_H
+#define PAGE_CACHE_H
+
+#include "TaskExecutor.h"
+#include <functional>
+#include <future>
+#include <map>
+#include <string>
+#include <vector>
+
+// ==========================================
+// Кэш страниц списка с фоновой подгрузкой
+// ==========================================
+// Пока оператор читает страницу, соседние загружаются задачами пула, и
+// переход "следующая"/"предыдущая" берёт готовый результат. Ключ страницы —
+// список, критерии выборки и номер страницы (pageKey). Кэш живёт, пока открыт
+// экран списка: правки, сделанные в других экранах, в нём не задерживаются.
+
+// Страница в виде строк таблицы и общее число записей списка (-1 — ошибка выборки)
+struct ListPage {
+    long long total = -1;
+    std::vector<std::vector<std::string>> rows;
+};
+
+class PageCache {
+public:
+    using Loader = std::function<ListPage()>;
+
+private:
+    static const size_t MAX_PAGES = 16;
+
+    TaskExecutor& executor;
+    std::map<std::string, std::shared_future<ListPage>> pages;
+
+    // Освобождает место: выбрасывает загруженные страницы, кроме keep
+    void evict(const std::string& keep);
+
+public:
+    explicit PageCache(TaskExecutor& tasks) : executor(tasks) {}
+
+    static std::string pageKey(const std::string& list, const std::string& criteria, int pageSize, int page);
+
+    // Страница из кэша (при необходимости дожидается фоновой загрузки) или
+    // загруженная сейчас. Страница с ошибкой в кэше не остаётся.
+    ListPage get(const std::string& key, const Loader& load);
+    // Ставит загрузку страницы в очередь пула, если её ещё нет в кэше
+    void prefetch(const std::string& key, const Loader& load);
+    void clear() { pages.clear(); }
+};
+
+#endif
\ No newline at end of file
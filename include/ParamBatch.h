@@ -0,0 +1,96 @@
+#ifndef PARAM_BATCH_H
+#define PARAM_BATCH_H
+
+#include "DatabaseConnection.h"
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+// ==========================================
+// Пакетное выполнение оператора с массивами параметров
+// ==========================================
+// Один параметризованный оператор (INSERT ... VALUES (?, ?, ...)) выполняется сразу
+// для rows наборов значений: параметры привязываются по столбцам
+// (SQL_ATTR_PARAMSET_SIZE), поэтому строки не склеиваются в текст SQL
+// и не требуют экранирования. Столбцы добавляются в порядке знаков '?'.
+class ParamBatch {
+private:
+    struct TextColumn {
+        std::vector<char> data;     // rows * width байт, строки с завершающим нулём
+        std::vector<SQLLEN> lengths;
+        SQLLEN width;
+    };
+    struct IntColumn {
+        std::vector<SQLINTEGER> values;
+        std::vector<SQLLEN> lengths;
+    };
+    struct BigIntColumn {
+        std::vector<SQLBIGINT> values;
+        std::vector<SQLLEN> lengths;
+    };
+
+    DatabaseConnection* db;
+    std::string sql;
+    size_t rows;
+
+    // deque не перемещает элементы при добавлении — адреса буферов остаются
+    // действительными до выполнения оператора
+    std::deque<TextColumn> textColumns;
+    std::deque<IntColumn> intColumns;
+    std::deque<BigIntColumn> bigIntColumns;
+
+    enum class Kind { Text, Int, BigInt };
+    std::vector<std::pair<Kind, size_t>> order; // Порядок столбцов в операторе
+
+public:
+    ParamBatch(DatabaseConnection* conn, const std::string& statement, size_t rowCount)
+        : db(conn), sql(statement), rows(rowCount) {}
+
+    template <class Row, class Getter>
+    void addText(const std::vector<Row>& items, Getter get) {
+        textColumns.emplace_back();
+        TextColumn& col = textColumns.back();
+        size_t width = 1;
+        for (const auto& item : items) {
+            const std::string& v = get(item);
+            if (v.size() + 1 > width) width = v.size() + 1;
+        }
+        col.width = static_cast<SQLLEN>(width);
+        col.data.assign(items.size() * width, '\0');
+        col.lengths.resize(items.size());
+        for (size_t i = 0; i < items.size(); ++i) {
+            const std::string& v = get(items[i]);
+            std::memcpy(col.data.data() + i * width, v.data(), v.size());
+            col.lengths[i] = static_cast<SQLLEN>(v.size());
+        }
+        order.push_back({Kind::Text, textColumns.size() - 1});
+    }
+
+    template <class Row, class Getter>
+    void addInt(const std::vector<Row>& items, Getter get) {
+        intColumns.emplace_back();
+        IntColumn& col = intColumns.back();
+        col.values.resize(items.size());
+        col.lengths.assign(items.size(), 0);
+        for (size_t i = 0; i < items.size(); ++i) col.values[i] = static_cast<SQLINTEGER>(get(items[i]));
+        order.push_back({Kind::Int, intColumns.size() - 1});
+    }
+
+    template <class Row, class Getter>
+    void addBigInt(const std::vector<Row>& items, Getter get) {
+        bigIntColumns.emplace_back();
+        BigIntColumn& col = bigIntColumns.back();
+        col.values.resize(items.size());
+        col.lengths.assign(items.size(), 0);
+        for (size_t i = 0; i < items.size(); ++i) col.values[i] = static_cast<SQLBIGINT>(get(items[i]));
+        order.push_back({Kind::BigInt, bigIntColumns.size() - 1});
+    }
+
+    // Выполняет оператор для всех наборов параметров.
+    // Возвращает суммарное число затронутых строк или -1 при ошибке.
+    long execute();
+};
+
+#endif
\ No newline at end of file
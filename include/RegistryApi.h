@@ -0,0 +1,81 @@
+#ifndef REGISTRY_API_H
+#define REGISTRY_API_H
+
+#include "HttpServer.h"
+#include "RegistryService.h"
+#include <string>
+#include <vector>
+
+// ==========================================
+// HTTP/JSON API реестра
+// ==========================================
+// Маршруты /api/... отображаются на методы RegistryService; тела запросов и
+// ответов — JSON-объекты с теми же именами полей, что у выгрузки.
+// Обработчик вызывается рабочими потоками HttpServer одновременно: состояния,
+// кроме таблицы маршрутов, у него нет, а сервис потокобезопасен.
+class RegistryApi {
+private:
+    using Args = std::vector<std::string>;  // Значения {} из шаблона пути
+    using Method = HttpResponse (RegistryApi::*)(const HttpRequest&, const Args&);
+
+    struct Route {
+        std::string method;
+        std::vector<std::string> segments;  // "{}" — параметр
+        Method handler;
+        bool write;                         // Изменяет данные: недоступен для снимка
+    };
+
+    RegistryService& service;
+    std::vector<Route> routes;
+
+    void add(const char* method, const char* pattern, Method handler, bool write = false);
+
+    HttpResponse health(const HttpRequest& req, const Args& args);
+    HttpResponse dictionary(const HttpRequest& req, const Args& args);
+
+    HttpResponse listEnterprises(const HttpRequest& req, const Args& args);
+    HttpResponse getEnterprise(const HttpRequest& req, const Args& args);
+    HttpResponse getEnterpriseByInn(const HttpRequest& req, const Args& args);
+    HttpResponse createEnterprise(const HttpRequest& req, const Args& args);
+    HttpResponse updateEnterprise(const HttpRequest& req, const Args& args);
+    HttpResponse deleteEnterprise(const HttpRequest& req, const Args& args);
+
+    HttpResponse getAssortment(const HttpRequest& req, const Args& args);
+    HttpResponse getAssortmentSummary(const HttpRequest& req, const Args& args);
+    HttpResponse getDossier(const HttpRequest& req, const Args& args);
+    HttpResponse addAssortmentLine(const HttpRequest& req, const Args& args);
+    HttpResponse updateAssortmentLine(const HttpRequest& req, const Args& args);
+    HttpResponse deleteAssortmentLine(const HttpRequest& req, const Args& args);
+    HttpResponse copyAssortment(const HttpRequest& req, const Args& args);
+
+    HttpResponse listProducts(const HttpRequest& req, const Args& args);
+    HttpResponse getProduct(const HttpRequest& req, const Args& args);
+    HttpResponse createProduct(const HttpRequest& req, const Args& args);
+    HttpResponse updateProduct(const HttpRequest& req, const Args& args);
+    HttpResponse deleteProduct(const HttpRequest& req, const Args& args);
+    HttpResponse productOffers(const HttpRequest& req, const Args& args);
+    HttpResponse batchOffers(const HttpRequest& req, const Args& args);
+
+    HttpResponse listSalesDepartments(const HttpRequest& req, const Args& args);
+    HttpResponse getSalesDepartment(const HttpRequest& req, const Args& args);
+    HttpResponse createSalesDepartment(const HttpRequest& req, const Args& args);
+    HttpResponse updateSalesDepartment(const HttpRequest& req, const Args& args);
+    HttpResponse deleteSalesDepartment(const HttpRequest& req, const Args& args);
+
+    HttpResponse listBankDetails(const HttpRequest& req, const Args& args);
+    HttpResponse getBankDetails(const HttpRequest& req, const Args& args);
+    HttpResponse createBankDetails(const HttpRequest& req, const Args& args);
+    HttpResponse updateBankDetails(const HttpRequest& req, const Args& args);
+    HttpResponse deleteBankDetails(const HttpRequest& req, const Args& args);
+
+    HttpResponse marginByEnterprise(const HttpRequest& req, const Args& args);
+    HttpResponse marginByCategory(const HttpRequest& req, const Args& args);
+    HttpResponse priceOutliers(const HttpRequest& req, const Args& args);
+
+public:
+    explicit RegistryApi(RegistryService& registry);
+
+    HttpResponse handle(const HttpRequest& req);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,83 @@
+#ifndef REGISTRY_CLIENT_H
+#define REGISTRY_CLIENT_H
+
+#include "RpcProtocol.h"
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ==========================================
+// Клиент демона реестра
+// ==========================================
+// Методы повторяют одноимённые методы RegistryService и так же сообщают об
+// ошибках: -1, false, пустая запись (id = 0) или пустой список, с сообщением
+// в std::cerr. Вызовы из нескольких потоков выполняются по очереди — для
+// параллельной работы каждому потоку нужен свой клиент.
+//
+// Пути файлов импорта и выгрузки передаются демону абсолютными
+// (относительные дополняются текущим каталогом клиента).
+class RegistryClient {
+private:
+    int fd;
+    bool readOnly;
+    std::mutex callMutex;
+
+    // Отправляет запрос и ждёт ответа; false (с сообщением), если демон
+    // недоступен или ответил ошибкой. При NotFound сообщение не выводится.
+    bool call(rpc::Op op, const rpc::Writer& args, std::string& result, rpc::Status* status = nullptr);
+
+public:
+    // Путь сокета по умолчанию: $REGENT_SOCKET или /tmp/RegEnterprise.sock
+    static std::string defaultSocketPath();
+
+    RegistryClient() : fd(-1), readOnly(false) {}
+    ~RegistryClient();
+
+    RegistryClient(const RegistryClient&) = delete;
+    RegistryClient& operator=(const RegistryClient&) = delete;
+
+    // Подключается и сверяет версию протокола; false с сообщением при ошибке
+    bool connect(const std::string& socketPath);
+    bool isConnected() const { return fd >= 0; }
+    bool isReadOnly() const { return readOnly; }
+    void disconnect();
+
+    bool refreshCache();
+
+    Enterprise getEnterpriseById(int id);
+    Enterprise findEnterpriseByInn(const std::string& inn);
+    std::vector<std::pair<Enterprise, float>> searchEnterprises(const std::string& query, size_t limit = 10);
+    int createEnterprise(const Enterprise& ent);
+    bool updateEnterprise(const Enterprise& ent);
+    bool deleteEnterprise(int id);
+
+    Product getProductById(int id);
+    std::vector<std::pair<Product, float>> searchProducts(const std::string& query, size_t limit = 10);
+    int createProduct(const Product& prod);
+    bool updateProduct(const Product& prod);
+    bool deleteProduct(int id);
+
+    std::vector<AssortmentLine> getAssortmentForEnterprise(int enterpriseId);
+    bool addProductToAssortment(int enterpriseId, int productId, Money wholesalePrice);
+    bool updateProductPriceInAssortment(int enterpriseId, int productId, Money newPrice);
+    bool removeProductFromAssortment(int enterpriseId, int productId);
+    long copyAssortment(int sourceEnterpriseId, const std::vector<int>& targetEnterpriseIds,
+                        double priceMultiplier = 1.0,
+                        AssortmentConflictPolicy policy = AssortmentConflictPolicy::Skip);
+    std::vector<ProductOffer> getBestOffers(const std::vector<int>& productIds, size_t topN);
+
+    ImportResult importFromCsv(ImportEntity entity, const std::string& path,
+                               const ImportOptions& options = ImportOptions());
+    long long exportToFile(ExportDataset dataset, const std::string& path,
+                           const ExportOptions& options = ExportOptions());
+    // Наборы выгружаются демоном по очереди, по вызову на набор
+    bool exportToFiles(const std::vector<ExportDataset>& datasets, const std::vector<std::string>& paths,
+                       const ExportOptions& options, std::vector<long long>& rows);
+    std::string getExportWatermark();
+    ChangeCursor getChangeHead();
+    long long exportChanges(const ChangeCursor& since, long long limit, const std::string& path,
+                            const ExportOptions& options, ChangeCursor* last = nullptr);
+};
+
+#endif
\ No newline at end of file
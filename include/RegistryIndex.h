@@ -0,0 +1,188 @@
+#ifndef REGISTRY_INDEX_H
+#define REGISTRY_INDEX_H
+
+#include "DomainEntities.h"
+#include "TrigramIndex.h"
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// ==========================================
+// Хеш-индекс с открытой адресацией
+// ==========================================
+// Уникальный строковый ключ (ИНН, название товара) -> ID. Линейное пробирование,
+// удалённые ячейки помечаются и переиспользуются; таблица растёт вдвое,
+// когда занято больше 70% ячеек (вместе с удалёнными).
+class StringHashIndex {
+private:
+    enum SlotState : uint8_t { Empty, Full, Deleted };
+
+    struct Slot {
+        std::string key;
+        int id = 0;
+        uint64_t hash = 0;
+        SlotState state = Empty;
+    };
+
+    std::vector<Slot> slots;    // Размер — степень двойки
+    size_t used;                // Занятые ячейки
+    size_t deleted;             // Помеченные удалёнными
+
+    static uint64_t hashOf(const std::string& key);
+    size_t probe(const std::string& key, uint64_t hash) const; // Ячейка с ключом или npos
+    void rehash(size_t capacity);
+
+public:
+    StringHashIndex() : used(0), deleted(0) {}
+
+    void reserve(size_t count);
+    void clear();
+
+    // false, если ключ уже занят другим ID (ID не меняется)
+    bool insert(const std::string& key, int id);
+    bool erase(const std::string& key);
+
+    // ID по ключу или 0, если ключа нет
+    int find(const std::string& key) const;
+
+    size_t size() const { return used; }
+};
+
+// ==========================================
+// Упорядоченный индекс
+// ==========================================
+// Отсортированный массив пар (ключ, ID): диапазоны и префиксы — двоичным поиском,
+// вставка и удаление — сдвигом хвоста массива. Первичная загрузка — одна сортировка.
+template <class Key>
+class SortedIndex {
+private:
+    std::vector<std::pair<Key, int>> entries;
+
+public:
+    void clear() { entries.clear(); }
+    size_t size() const { return entries.size(); }
+
+    void bulkLoad(std::vector<std::pair<Key, int>> items) {
+        entries = std::move(items);
+        std::sort(entries.begin(), entries.end());
+    }
+
+    void insert(const Key& key, int id) {
+        std::pair<Key, int> item(key, id);
+        entries.insert(std::lower_bound(entries.begin(), entries.end(), item), std::move(item));
+    }
+
+    void erase(const Key& key, int id) {
+        std::pair<Key, int> item(key, id);
+        auto it = std::lower_bound(entries.begin(), entries.end(), item);
+        if (it != entries.end() && *it == item) entries.erase(it);
+    }
+
+    // ID записи на позиции pos в порядке ключей (0, если позиции нет)
+    int at(size_t pos) const { return pos < entries.size() ? entries[pos].second : 0; }
+
+    // ID с ключами в [from, to), не больше limit штук
+    std::vector<int> range(const Key& from, const Key& to, size_t limit = SIZE_MAX) const {
+        std::vector<int> ids;
+        auto it = std::lower_bound(entries.begin(), entries.end(), std::make_pair(from, INT32_MIN));
+        for (; it != entries.end() && it->first < to && ids.size() < limit; ++it) ids.push_back(it->second);
+        return ids;
+    }
+
+    // Для строковых ключей: все ключи, начинающиеся с prefix (побайтно)
+    std::vector<int> prefix(const std::string& p, size_t limit = SIZE_MAX) const {
+        std::vector<int> ids;
+        auto it = std::lower_bound(entries.begin(), entries.end(), std::make_pair(p, INT32_MIN));
+        for (; it != entries.end() && it->first.compare(0, p.size(), p) == 0 && ids.size() < limit; ++it) {
+            ids.push_back(it->second);
+        }
+        return ids;
+    }
+};
+
+// ==========================================
+// Кэш реестра с индексами
+// ==========================================
+// Предприятия и товары в памяти процесса. Поиск по ИНН и названию товара — через
+// хеш-индексы, список в порядке ID и выборки по префиксу названия — через
+// упорядоченные индексы. RegistryService загружает кэш при первом обращении
+// и обновляет его после каждой успешной записи в БД; изменения, сделанные
+// в обход сервиса (другими процессами, импортом), требуют invalidate().
+// Константные методы можно вызывать из нескольких потоков одновременно,
+// остальные — только при отсутствии других вызовов (блокировки — у владельца).
+class RegistryCache {
+private:
+    bool enterprisesLoaded;
+    bool productsLoaded;
+
+    std::unordered_map<int, Enterprise> enterprises;
+    StringHashIndex enterpriseByInn;
+    SortedIndex<int> enterpriseIds;
+    SortedIndex<std::string> enterpriseNames;
+
+    std::unordered_map<int, Product> products;
+    StringHashIndex productByName;
+    SortedIndex<int> productIds;
+    SortedIndex<std::string> productNames;
+
+    // Триграммные индексы строятся при первом поиске, затем обновляются вместе с кэшем
+    TrigramIndex enterpriseSearch;
+    TrigramIndex productSearch;
+    bool enterpriseSearchBuilt;
+    bool productSearchBuilt;
+
+    static std::string searchText(const Enterprise& e);
+
+public:
+    RegistryCache()
+        : enterprisesLoaded(false), productsLoaded(false),
+          enterpriseSearchBuilt(false), productSearchBuilt(false) {}
+
+    bool hasEnterprises() const { return enterprisesLoaded; }
+    bool hasProducts() const { return productsLoaded; }
+    void invalidate();
+
+    void loadEnterprises(std::vector<Enterprise> list);
+    void loadProducts(std::vector<Product> list);
+
+    // Добавление или замена записи с тем же ID (индексы обновляются)
+    void putEnterprise(const Enterprise& e);
+    void removeEnterprise(int id);
+    void putProduct(const Product& p);
+    void removeProduct(int id);
+
+    const Enterprise* enterprise(int id) const;
+    const Product* product(int id) const;
+    int enterpriseIdByInn(const std::string& inn) const { return enterpriseByInn.find(inn); }
+    int productIdByName(const std::string& name) const { return productByName.find(name); }
+
+    size_t enterpriseCount() const { return enterprises.size(); }
+    size_t productCount() const { return products.size(); }
+
+    // Запись на позиции pos в порядке ID (nullptr, если позиции нет)
+    const Enterprise* enterpriseAt(size_t pos) const { return enterprise(enterpriseIds.at(pos)); }
+    const Product* productAt(size_t pos) const { return product(productIds.at(pos)); }
+
+    // Все записи в порядке ID
+    std::vector<Enterprise> allEnterprises() const;
+    std::vector<Product> allProducts() const;
+
+    // Записи, название которых начинается с prefix, в порядке названий
+    std::vector<Enterprise> enterprisesByNamePrefix(const std::string& prefix, size_t limit = SIZE_MAX) const;
+    std::vector<Product> productsByNamePrefix(const std::string& prefix, size_t limit = SIZE_MAX) const;
+
+    // Нечёткий поиск: предприятия — по названию, адресу и ИНН, товары — по названию.
+    // Лучшие limit совпадений по убыванию сходства. Триграммный индекс строится
+    // отдельно (buildEnterpriseSearch и т.д.); без него поиск ничего не находит.
+    std::vector<SearchHit> searchEnterprises(const std::string& query, size_t limit) const;
+    std::vector<SearchHit> searchProducts(const std::string& query, size_t limit) const;
+    bool hasEnterpriseSearch() const { return enterpriseSearchBuilt; }
+    bool hasProductSearch() const { return productSearchBuilt; }
+    void buildEnterpriseSearch();
+    void buildProductSearch();
+};
+
+#endif
\ No newline at end of file
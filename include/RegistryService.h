@@ -4,33 +4,157 @@
 #include "DatabaseConnection.h"
 #include "Gateways.h"
 #include "DomainEntities.h"
+#include "ConnectionPool.h"
+#include "BulkImporter.h"
+#include "DataExporter.h"
+#include "Snapshot.h"
+#include "RegistryIndex.h"
+#include "ColumnarCatalog.h"
+#include "TaskExecutor.h"
 #include <vector>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <utility> // для std::pair
 
+// Досье предприятия: карточка со связанными записями. Если отдела сбыта или
+// реквизитов нет — у них id = 0; если нет предприятия — enterprise.id = 0.
+struct EnterpriseDossier {
+    Enterprise enterprise{0, "", 0, 0, "", "", "", ""};
+    SalesDepartment salesDepartment{};
+    BankDetails bankDetails{};
+    AssortmentSummary summary;
+    std::vector<AssortmentLine> assortment;
+};
+
+// ==========================================
+// Сервис реестра
+// ==========================================
+// Потокобезопасность: после initialize() / initializeFromSnapshot() методы можно
+// вызывать из любого числа потоков одновременно.
+//  - Каждая операция берёт соединение из пула на время своего выполнения,
+//    поэтому транзакция (копирование ассортимента) не смешивается с чужими
+//    запросами. Когда все соединения заняты, операция ждёт свободное.
+//  - Кэш предприятий и товаров и колоночный каталог читаются под общей
+//    блокировкой, загружаются и обновляются под исключительной. Изменение
+//    через сервис видно всем потокам сразу после возврата из метода.
+//  - Выгрузки и загрузка каталога открывают собственные соединения и не занимают пул.
+//  - Массовые операции (импорт, выгрузка нескольких наборов) выполняются
+//    задачами общего пула потоков executor(); его рабочие потоки берут
+//    соединения из того же пула соединений.
+//  - Импорт читает кэш на протяжении всей загрузки: изменения предприятий
+//    и товаров через сервис на это время ждут его окончания.
+//  - Обработчик строк streamChanges вызывается с занятым соединением пула
+//    и не должен сам обращаться к сервису.
+// initialize* и деструктор в этот контракт не входят: их вызывают, пока
+// сервисом не пользуются другие потоки.
 class RegistryService {
 private:
+    using ReadLock = std::shared_lock<std::shared_mutex>;
+    using WriteLock = std::unique_lock<std::shared_mutex>;
+
+    // Соединение, на котором при запуске создаётся и обновляется схема БД;
+    // операции сервиса его не используют
     DatabaseConnection db;
-    
-    // Шлюзы (владеем ими приватно, UI о них не знает)
-    std::unique_ptr<EnterpriseGateway> enterpriseGateway;
-    std::unique_ptr<ProductGateway> productGateway;
-    std::unique_ptr<EnterpriseProductGateway> enterpriseProductGateway;
-    std::unique_ptr<SalesDepartmentGateway> salesDepartmentGateway;
-    std::unique_ptr<BankDetailsGateway> bankDetailsGateway;
+
+    // Соединения для операций сервиса и массового импорта, открываются по требованию
+    std::unique_ptr<ConnectionPool> pool;
+
+    // Рабочие потоки массовых операций; объявлены после пула и завершаются раньше него
+    std::unique_ptr<TaskExecutor> tasks;
+
+    // Соединение из пула на время одной операции; пустое (с сообщением), если
+    // подключиться не удалось. Внутри операции берётся не больше одного
+    // соединения за раз и никогда — под блокировкой кэша или каталога:
+    // иначе потоки могли бы ждать друг друга бесконечно.
+    ConnectionPool::Lease connection();
+
+    // Открытый снимок: если задан, методы чтения обслуживаются из него,
+    // а изменяющие методы отказывают (режим только для чтения)
+    std::unique_ptr<Snapshot> snapshot;
+
+    // true (с сообщением об ошибке), если сервис работает от снимка
+    bool rejectWriteInReadOnly() const;
+    // То же для выборок по критериям и отчётов: они выполняются только сервером БД
+    bool rejectCriteriaInSnapshot() const;
+
+    // Предприятия и товары с индексами: загружаются при первом обращении,
+    // обновляются после каждой записи через сервис
+    std::shared_mutex cacheMutex;
+    RegistryCache cache;
+    // Общая блокировка кэша с загруженными предприятиями (товарами); загружает их при необходимости
+    ReadLock readEnterprises();
+    ReadLock readProducts();
+    void loadCachedEnterprises();
+    void loadCachedProducts();
+    // Перечитывают запись по соединению операции, записавшей её
+    void refreshCachedEnterprise(DatabaseConnection* conn, int id);
+    void refreshCachedProduct(DatabaseConnection* conn, int id);
+
+    // Колоночная копия предприятий, товаров и ассортимента для отчётов и фильтров.
+    // Загружается явно (loadCatalog) или, для снимка, при первом обращении;
+    // любая запись через сервис сбрасывает её — отчёты снова идут в БД.
+    // catalogGeneration растёт при каждом сбросе: загрузка, во время которой
+    // данные изменились, не устанавливается.
+    std::shared_mutex catalogMutex;
+    ColumnarCatalog catalog;
+    uint64_t catalogGeneration = 0;
+    // Общая блокировка загруженного каталога; не владеет блокировкой, если каталога нет
+    ReadLock readCatalog();
+    void dropCatalog();
 
 public:
     RegistryService();
     ~RegistryService();
 
-    // Инициализация (подключение к БД, создание всех таблиц и справочников)
-    bool initialize(); 
+    // Инициализация (подключение к БД, создание всех таблиц и справочников).
+    // connections — размер пула соединений для операций; 0 — по числу ядер
+    bool initialize(size_t connections = 0);
+
+    // Инициализация без БД: чтение из снимка, созданного saveSnapshot
+    bool initializeFromSnapshot(const std::string& path);
+    bool isReadOnly() const { return snapshot != nullptr; }
+    int64_t snapshotCreatedAt() const { return snapshot ? snapshot->createdAt() : 0; }
+
+    // Общий пул потоков для параллельных операций (после initialize*). Потоков
+    // на один меньше, чем соединений: одно всегда остаётся вызывающим потокам.
+    TaskExecutor& executor() { return *tasks; }
+
+    // Записывает согласованный снимок справочников, предприятий, товаров,
+    // ассортимента, отделов сбыта и реквизитов в файл
+    bool saveSnapshot(const std::string& path, SnapshotStats* stats = nullptr);
+
+    // Сбросить кэш предприятий и товаров (например, после изменений другими
+    // клиентами БД) — при следующем обращении он загрузится заново
+    void refreshCache();
+
+    // Содержимое справочника (ОПФ, формы собственности, категории, условия поставки)
+    std::vector<DictionaryEntry> getDictionary(Dictionary dict);
 
     // ==========================================
     // Методы для работы с Предприятиями
     // ==========================================
     std::vector<Enterprise> getAllEnterprises();
     Enterprise getEnterpriseById(int id);
+    // Запись по номеру в списке (порядок ID, с 0); id = 0, если номера нет
+    Enterprise getEnterpriseAt(size_t position);
+    size_t getEnterpriseCount();
+    Enterprise findEnterpriseByInn(const std::string& inn);
+    std::vector<Enterprise> findEnterprisesByNamePrefix(const std::string& prefix, size_t limit = SIZE_MAX);
+    // Нечёткий поиск по названию, адресу и ИНН (опечатки допустимы).
+    // Возвращает пары {Предприятие, Сходство 0..1} по убыванию сходства.
+    std::vector<std::pair<Enterprise, float>> searchEnterprises(const std::string& query, size_t limit = 10);
+    // Выборка по критериям: фильтр, сортировка и страница (limit/offset) выполняются
+    // сервером БД, передаются только подходящие строки. Поля — enterpriseFields().
+    // countEnterprises учитывает только фильтр; -1 при ошибке. Для снимка недоступны.
+    std::vector<Enterprise> queryEnterprises(const Criteria& criteria);
+    long long countEnterprises(const Criteria& criteria);
+    // Вся выборка по критериям без накопления в памяти: строки читаются курсором
+    // на отдельном соединении и передаются обработчику по мере получения
+    // (false из обработчика прекращает чтение). Число строк или -1. Для снимка —
+    // только без фильтра и сортировки.
+    long long streamEnterprises(const Criteria& criteria, const RowCallback<Enterprise>& callback);
+    static const std::vector<CriteriaField>& enterpriseFields() { return EnterpriseGateway::criteriaFields(); }
     // Возвращает ID созданного предприятия или -1 при ошибке
     int createEnterprise(const Enterprise& ent);
     bool updateEnterprise(const Enterprise& ent);
@@ -41,6 +165,16 @@ public:
     // ==========================================
     std::vector<Product> getAllProducts();
     Product getProductById(int id);
+    Product getProductAt(size_t position);
+    size_t getProductCount();
+    std::vector<Product> findProductsByNamePrefix(const std::string& prefix, size_t limit = SIZE_MAX);
+    std::vector<std::pair<Product, float>> searchProducts(const std::string& query, size_t limit = 10);
+    // Для товаров выборка обслуживается каталогом в памяти, если он загружен (и для снимка)
+    std::vector<Product> queryProducts(const Criteria& criteria);
+    long long countProducts(const Criteria& criteria);
+    // Как streamEnterprises; для снимка — из каталога в памяти
+    long long streamProducts(const Criteria& criteria, const RowCallback<Product>& callback);
+    static const std::vector<CriteriaField>& productFields() { return ProductGateway::criteriaFields(); }
     // Возвращает ID созданного товара или -1 при ошибке
     int createProduct(const Product& prod);
     bool updateProduct(const Product& prod);
@@ -52,22 +186,56 @@ public:
     
     // Получает список товаров конкретного предприятия с их оптовыми ценами.
     // Возвращает пару: {Товар, Оптовая цена}
-    std::vector<std::pair<Product, double>> getAssortmentForEnterprise(int enterpriseId);
+    std::vector<AssortmentLine> getAssortmentForEnterprise(int enterpriseId);
 
     // Добавить товар в ассортимент предприятия
-    bool addProductToAssortment(int enterpriseId, int productId, double wholesalePrice);
+    bool addProductToAssortment(int enterpriseId, int productId, Money wholesalePrice);
 
     // Удалить товар из ассортимента предприятия
     bool removeProductFromAssortment(int enterpriseId, int productId);
 
     // Изменить оптовую цену товара в ассортименте
-    bool updateProductPriceInAssortment(int enterpriseId, int productId, double newPrice);
+    bool updateProductPriceInAssortment(int enterpriseId, int productId, Money newPrice);
+
+    // Пакет правок ассортимента одного вида в одной транзакции (сотни и тысячи
+    // правок — несколько операторов вместо оператора и фиксации на каждую).
+    // applied[i] — выполнена ли правка i: нет позиции для изменения или удаления,
+    // позиция уже есть или нет предприятия либо товара для добавления — false.
+    // Ключи в пакете не должны повторяться. Возвращает false при ошибке —
+    // тогда не выполнена ни одна правка.
+    bool applyAssortmentChanges(AssortmentChange kind, const std::vector<EnterpriseProduct>& changes,
+                                std::vector<bool>& applied);
+
+    // Скопировать весь ассортимент предприятия-источника в одно или несколько предприятий.
+    // priceMultiplier применяется к оптовой цене (1.0 — цены без изменений),
+    // policy определяет поведение для товаров, уже имеющихся у целевого предприятия.
+    // Вся операция выполняется в одной транзакции пакетами INSERT ... SELECT.
+    // Возвращает число добавленных/обновлённых строк ассортимента или -1 при ошибке.
+    long copyAssortment(int sourceEnterpriseId, const std::vector<int>& targetEnterpriseIds,
+                        double priceMultiplier = 1.0,
+                        AssortmentConflictPolicy policy = AssortmentConflictPolicy::Skip);
+
+    // Сводка ассортимента (число позиций и категорий, мин./сред./макс. оптовая цена).
+    // Таблицу сводки ведут триггеры БД, чтение не обходит ассортимент.
+    // Постраничная выборка по полям assortmentSummaryFields() — только для БД;
+    // сводки по списку ID доступны и для снимка (считаются по его ассортименту).
+    std::vector<AssortmentSummary> queryAssortmentSummaries(const Criteria& criteria);
+    long long countAssortmentSummaries(const Criteria& criteria);
+    static const std::vector<CriteriaField>& assortmentSummaryFields() { return AssortmentSummaryGateway::criteriaFields(); }
+    std::vector<AssortmentSummary> getAssortmentSummaries(const std::vector<int>& enterpriseIds);
+    // Полный пересчёт сводки (после правки данных в обход триггеров)
+    bool rebuildAssortmentSummaries();
 
     // ==========================================
     // Методы для работы с Отделами сбыта
     // ==========================================
     std::vector<SalesDepartment> getAllSalesDepartments();
+    // Выборка по критериям, как queryEnterprises. Для снимка — только страница
+    // (limit/offset) без фильтра и сортировки.
+    std::vector<SalesDepartment> querySalesDepartments(const Criteria& criteria);
+    long long countSalesDepartments(const Criteria& criteria);
     SalesDepartment getSalesDepartmentById(int id);
+    SalesDepartment getSalesDepartmentOfEnterprise(int enterpriseId);
     // Возвращает ID созданного отдела или -1 при ошибке
     int createSalesDepartment(const SalesDepartment& dept);
     bool updateSalesDepartment(const SalesDepartment& dept);
@@ -77,11 +245,117 @@ public:
     // Методы для работы с Банковскими реквизитами
     // ==========================================
     std::vector<BankDetails> getAllBankDetails();
+    // Как querySalesDepartments
+    std::vector<BankDetails> queryBankDetails(const Criteria& criteria);
+    long long countBankDetails(const Criteria& criteria);
     BankDetails getBankDetailsById(int id);
+    BankDetails getBankDetailsOfEnterprise(int enterpriseId);
     // Возвращает ID созданной записи или -1 при ошибке
     int createBankDetails(const BankDetails& details);
     bool updateBankDetails(const BankDetails& details);
     bool deleteBankDetails(int id);
+
+    // ==========================================
+    // Асинхронные вызовы
+    // ==========================================
+
+    // Выполняет метод сервиса задачей executor() и сразу возвращает future:
+    // независимые запросы идут одновременно, каждый на своём соединении пула,
+    // и экран ждёт самый долгий из них, а не их сумму. Аргументы копируются.
+    //   auto lines = service.async(&RegistryService::getAssortmentForEnterprise, id);
+    template <class R, class... Params, class... Args>
+    std::future<R> async(R (RegistryService::*method)(Params...), Args... args) {
+        return tasks->submit([this, method, args...](TaskExecutor::TaskContext&) {
+            return (this->*method)(args...);
+        });
+    }
+
+    // Досье: карточка, отдел сбыта, реквизиты, сводка и ассортимент
+    // запрашиваются одновременно
+    EnterpriseDossier getEnterpriseDossier(int enterpriseId);
+
+    // ==========================================
+    // Отчёты по ассортименту
+    // ==========================================
+
+    // Загружает предприятия, товары и ассортимент в колоночный каталог в памяти:
+    // пока он загружен, отчёты и фильтры товаров считаются в процессе, без запросов к БД.
+    // Для снимка каталог загружается автоматически.
+    bool loadCatalog(CatalogStats* stats = nullptr);
+    bool isCatalogLoaded();
+    void releaseCatalog() { dropCatalog(); }
+
+    // Маржа (оптовая цена минус закупочная) по предприятиям, по убыванию;
+    // limit = 0 — все предприятия. Агрегаты считает сервер БД или каталог в памяти.
+    std::vector<MarginSummary> getMarginByEnterprise(size_t limit = 0);
+
+    // Маржа по категориям товаров, по убыванию
+    std::vector<MarginSummary> getMarginByCategory();
+
+    // Позиции ассортимента с оптовой ценой ниже закупочной, самые убыточные первыми.
+    // total (если задан) — число всех таких позиций.
+    std::vector<PriceOutlier> getPriceOutliers(size_t limit, long long* total = nullptr);
+
+    // Где товар дешевле: предприятия с товаром в ассортименте по возрастанию оптовой
+    // цены, не более topN на товар (0 — все). Пакетный вариант отвечает на весь
+    // список несколькими запросами вместо запроса на товар.
+    std::vector<ProductOffer> getBestOffers(int productId, size_t topN = 0) {
+        return getBestOffers(std::vector<int>{productId}, topN);
+    }
+    std::vector<ProductOffer> getBestOffers(const std::vector<int>& productIds, size_t topN);
+
+    // ==========================================
+    // Массовый импорт
+    // ==========================================
+
+    // Загружает предприятия, товары или ассортимент из CSV-файла. Строки
+    // проверяются и загружаются параллельно пакетами — через COPY, если
+    // приложение собрано с libpq, иначе пакетными INSERT через пул соединений;
+    // отбракованные строки с причиной пишутся в файл отказов (см. ImportOptions).
+    ImportResult importFromCsv(ImportEntity entity, const std::string& path,
+                               const ImportOptions& options = ImportOptions());
+
+    // ==========================================
+    // Выгрузка
+    // ==========================================
+
+    // Выгружает набор данных в файл ("-" — стандартный вывод) в формате CSV или JSON Lines.
+    // Строки читаются курсором на отдельном соединении и пишутся по мере выборки;
+    // CSV при наличии libpq выгружается сервером через COPY ... TO STDOUT.
+    // Возвращает число выгруженных строк или -1 при ошибке.
+    long long exportToFile(ExportDataset dataset, const std::string& path,
+                           const ExportOptions& options = ExportOptions());
+
+    // Выгружает наборы datasets[i] в файлы paths[i] одновременно, задачами executor().
+    // rows[i] — число строк набора или -1; false, если не выгружен хотя бы один.
+    bool exportToFiles(const std::vector<ExportDataset>& datasets, const std::vector<std::string>& paths,
+                       const ExportOptions& options, std::vector<long long>& rows);
+
+    // Отметка для выгрузки изменений: запрашивается перед выгрузкой и передаётся
+    // в ExportOptions::since следующей. Соседние выгрузки пересекаются на
+    // границе, так что строки могут повториться, но не потеряться. Пусто при ошибке.
+    std::string getExportWatermark();
+
+    // ==========================================
+    // Журнал изменений
+    // ==========================================
+
+    // Изменения после позиции since, по порядку; limit = 0 — все доступные.
+    // last (если задан) — позиция последней выданной записи (since, если записей нет):
+    // с неё продолжается следующее чтение. Возвращает число записей или -1.
+    long long streamChanges(const ChangeCursor& since, long long limit,
+                            const RowCallback<ChangeRecord>& callback, ChangeCursor* last = nullptr);
+
+    // Текущий конец журнала. Полную выгрузку для нового потребителя делают
+    // после получения позиции: изменения, попавшие и в выгрузку, и в журнал,
+    // повторно применяются без вреда (вставка и изменение несут строку целиком).
+    ChangeCursor getChangeHead();
+
+    // Выгрузка изменений в файл ("-" — stdout): колонки txid, seq, changed_at, table,
+    // operation, key, data (в JSON Lines data — вложенный объект). Записи читаются
+    // курсором на отдельном соединении. Возвращает число записей или -1.
+    long long exportChanges(const ChangeCursor& since, long long limit, const std::string& path,
+                            const ExportOptions& options, ChangeCursor* last = nullptr);
 };
 
 #endif
\ No newline at end of file
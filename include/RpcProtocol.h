@@ -0,0 +1,145 @@
+#ifndef RPC_PROTOCOL_H
+#define RPC_PROTOCOL_H
+
+#include "BulkImporter.h"
+#include "DataExporter.h"
+#include "DomainEntities.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ==========================================
+// Двоичный протокол локального демона
+// ==========================================
+// Кадр — длина полезной нагрузки (uint32) и сама нагрузка. Запрос начинается
+// с кода операции (uint16), ответ — с кода состояния (uint8); дальше идут
+// аргументы или результат. Числа — little-endian фиксированной ширины,
+// строка — длина (uint32) и байты UTF-8, сумма — int64 копеек, список ID —
+// число элементов (uint32) и int32. При состоянии, отличном от Ok, ответ
+// содержит только строку с описанием ошибки.
+//
+// Версия увеличивается при любом изменении кодировки существующих операций;
+// клиент сверяет её при подключении (Ping).
+
+namespace rpc {
+
+const uint32_t PROTOCOL_VERSION = 2;
+
+// Наибольший размер кадра: защищает от чтения мусора как огромной длины
+const uint32_t MAX_FRAME = 64 * 1024 * 1024;
+
+enum class Op : uint16_t {
+    Ping = 1,               // -> u32 версия, u8 только чтение
+    RefreshCache,
+
+    GetEnterprise,          // i32 id -> Enterprise
+    FindEnterpriseByInn,    // str -> Enterprise
+    SearchEnterprises,      // str, u32 limit -> u32 n, n x (Enterprise, f32)
+    CreateEnterprise,       // Enterprise -> i32 id
+    UpdateEnterprise,       // Enterprise
+    DeleteEnterprise,       // i32 id
+
+    GetProduct,
+    SearchProducts,
+    CreateProduct,
+    UpdateProduct,
+    DeleteProduct,
+
+    GetAssortment,          // i32 enterprise -> u32 n, n x AssortmentLine
+    AddToAssortment,        // i32 enterprise, i32 product, money
+    UpdateAssortmentPrice,  // i32 enterprise, i32 product, money
+    RemoveFromAssortment,   // i32 enterprise, i32 product
+    CopyAssortment,         // i32 source, ids targets, f64 multiplier, u8 policy -> i64 rows
+    BestOffers,             // ids, u32 top -> u32 n, n x ProductOffer
+
+    Import,                 // u8 entity, str path, ImportOptions -> ImportResult
+    Export,                 // u8 dataset, str path, ExportOptions -> i64 rows
+    ExportWatermark,        // -> str
+    ChangeHead,             // -> ChangeCursor
+    ExportChanges           // ChangeCursor, i64 limit, str path, ExportOptions -> i64 rows, ChangeCursor
+};
+
+enum class Status : uint8_t {
+    Ok = 0,
+    NotFound,       // Записи с таким ключом нет
+    Failed,         // Сервис отказал; подробности — в журнале демона
+    BadRequest,     // Неизвестная операция или неверные аргументы
+    ReadOnly        // Демон работает от снимка
+};
+
+// Построитель нагрузки кадра
+class Writer {
+private:
+    std::string buf;
+
+public:
+    void u8(uint8_t v) { buf += static_cast<char>(v); }
+    void u16(uint16_t v);
+    void u32(uint32_t v);
+    void i32(int32_t v) { u32(static_cast<uint32_t>(v)); }
+    void i64(int64_t v);
+    void f32(float v);
+    void f64(double v);
+    void money(Money m) { i64(m.toKopecks()); }
+    void str(const std::string& s);
+    void ids(const std::vector<int>& list);
+
+    const std::string& data() const { return buf; }
+};
+
+// Разбор нагрузки кадра. При выходе за конец данных читатель запоминает
+// ошибку и дальше возвращает нули — проверять ok() достаточно один раз в конце.
+class Reader {
+private:
+    const char* p;
+    size_t left;
+    bool good;
+
+    bool take(void* out, size_t n);
+
+public:
+    explicit Reader(const std::string& payload) : p(payload.data()), left(payload.size()), good(true) {}
+
+    uint8_t u8();
+    uint16_t u16();
+    uint32_t u32();
+    int32_t i32() { return static_cast<int32_t>(u32()); }
+    int64_t i64();
+    float f32();
+    double f64();
+    Money money() { return Money::fromKopecks(i64()); }
+    std::string str();
+    std::vector<int> ids();
+
+    bool ok() const { return good; }
+    // Все данные прочитаны без ошибок (лишние байты — тоже ошибка)
+    bool done() const { return good && left == 0; }
+};
+
+// Записи сервиса в кадре: поля в порядке объявления структур
+void write(Writer& w, const Enterprise& e);
+void write(Writer& w, const Product& p);
+void write(Writer& w, const AssortmentLine& l);
+void write(Writer& w, const ProductOffer& o);
+void write(Writer& w, const ImportOptions& o);
+void write(Writer& w, const ImportResult& r);
+void write(Writer& w, const ExportOptions& o);
+void write(Writer& w, const ChangeCursor& c);
+void read(Reader& r, Enterprise& e);
+void read(Reader& r, Product& p);
+void read(Reader& r, AssortmentLine& l);
+void read(Reader& r, ProductOffer& o);
+void read(Reader& r, ImportOptions& o);
+void read(Reader& r, ImportResult& res);
+void read(Reader& r, ExportOptions& o);
+void read(Reader& r, ChangeCursor& c);
+
+// Чтение и запись кадра целиком по блокирующему сокету; false при обрыве
+// соединения, ошибке или кадре больше MAX_FRAME
+bool readFrame(int fd, std::string& payload);
+bool writeFrame(int fd, const std::string& payload);
+
+} // namespace rpc
+
+#endif
\ No newline at end of file
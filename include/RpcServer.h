@@ -0,0 +1,63 @@
+#ifndef RPC_SERVER_H
+#define RPC_SERVER_H
+
+#include "RegistryService.h"
+#include "RpcProtocol.h"
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// ==========================================
+// Демон реестра на Unix-сокете
+// ==========================================
+// Долгоживущий процесс держит открытые соединения пула, загруженные кэши
+// и индексы; локальные задания (cron, скрипты) подключаются к сокету и
+// вызывают операции сервиса по протоколу rpc, не поднимая собственного
+// соединения с БД и не создавая схему при каждом запуске.
+//
+// Каждое подключение обслуживает свой поток: клиентов немного и они
+// последовательно шлют запрос за запросом, а одновременные обращения к БД
+// всё равно ограничены пулом сервиса.
+class RpcServer {
+private:
+    struct Client {
+        int fd;
+        std::thread thread;
+        std::atomic<bool> finished{false};
+    };
+
+    RegistryService& service;
+    std::string socketPath;
+    int listenFd;
+    int wakePipe[2];    // Запись в wakePipe[1] прерывает ожидание подключений
+    std::atomic<bool> stopping;
+
+    std::mutex clientsMutex;
+    std::list<Client> clients;
+
+    void serve(Client& client);
+    // Выполняет запрос: результат — в result, при ошибке — описание в message
+    rpc::Status execute(const std::string& request, rpc::Writer& result, std::string& message);
+    void reapFinished();
+
+public:
+    explicit RpcServer(RegistryService& registry);
+    ~RpcServer();
+
+    RpcServer(const RpcServer&) = delete;
+    RpcServer& operator=(const RpcServer&) = delete;
+
+    // Создаёт сокет (права 0660). Оставшийся от упавшего демона файл сокета
+    // удаляется; если по пути уже отвечает другой демон — false с сообщением.
+    bool listen(const std::string& path);
+
+    // Принимает подключения до stop(); затем закрывает клиентов и удаляет файл сокета
+    void run();
+
+    // Можно вызывать из обработчика сигнала
+    void stop();
+};
+
+#endif
\ No newline at end of file
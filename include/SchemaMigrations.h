@@ -0,0 +1,31 @@
+#ifndef SCHEMA_MIGRATIONS_H
+#define SCHEMA_MIGRATIONS_H
+
+#include "DatabaseConnection.h"
+
+// ==========================================
+// Миграции схемы
+// ==========================================
+// Таблицы создаются шлюзами (CREATE TABLE IF NOT EXISTS), но так нельзя изменить
+// уже существующую таблицу. Такие изменения оформляются пронумерованными
+// миграциями: каждая выполняется один раз в своей транзакции, номер
+// записывается в schema_migrations. Новые миграции только дописываются в конец
+// списка (SchemaMigrations.cpp) — применённые не редактируются.
+class SchemaMigrations {
+private:
+    DatabaseConnection* db;
+
+    bool isApplied(int version);
+
+public:
+    explicit SchemaMigrations(DatabaseConnection* conn) : db(conn) {}
+
+    // Применяет недостающие миграции по порядку; останавливается на первой ошибке.
+    // Несколько одновременно запущенных копий программы не применят миграцию дважды.
+    bool apply();
+
+    // Номер последней применённой миграции (0 — ни одной, -1 — ошибка)
+    int currentVersion();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,218 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "DatabaseConnection.h"
+#include "DomainEntities.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// ==========================================
+// Двоичный снимок реестра
+// ==========================================
+// Файл снимка — заголовок, таблица секций и сами секции. Все числа записаны
+// в little-endian фиксированной ширины, записи в секциях имеют фиксированный
+// размер, строки лежат в общей секции строк и задаются смещением и длиной.
+// Записи каждой секции отсортированы по ключу, поэтому поиск по ID — двоичный,
+// прямо по отображённой в память области, без разбора и копирования.
+//
+// Версия формата увеличивается при любом изменении раскладки или смысла
+// полей записей; снимок другой версии не открывается.
+
+namespace snapshot {
+
+const uint32_t FORMAT_VERSION = 2;
+
+// Цена не указана (NULL в БД)
+const int64_t NO_PRICE = INT64_MIN;
+
+// Строка в секции строк (UTF-8, без завершающего нуля)
+struct StrRef {
+    uint32_t offset;
+    uint32_t length;
+};
+
+enum class Section : uint32_t {
+    Strings = 1,
+    Enterprises,
+    Products,
+    Assortment,         // Отсортирован по (enterprise_id, product_id)
+    SalesDepartments,
+    BankDetails,
+    LegalForms,
+    OwnershipForms,
+    ProductCategories,
+    DeliveryTerms
+};
+
+struct FileHeader {
+    char magic[8];          // "REGSNAP\0"
+    uint32_t version;       // FORMAT_VERSION
+    uint32_t sectionCount;
+    int64_t createdAt;      // Время создания, секунды Unix
+    uint64_t fileSize;      // Для проверки на обрезанный файл
+};
+
+struct SectionEntry {
+    uint32_t kind;          // Section
+    uint32_t count;         // Число записей (для строк — 0)
+    uint64_t offset;        // От начала файла, кратно 8
+    uint64_t size;          // В байтах
+};
+
+struct DictionaryRecord {
+    int32_t id;
+    StrRef name;
+};
+
+struct EnterpriseRecord {
+    int32_t id;
+    int32_t legalFormId;
+    int32_t ownershipFormId;
+    uint32_t reserved;
+    StrRef name;
+    StrRef legalFormName;
+    StrRef ownershipFormName;
+    StrRef postalAddress;
+    StrRef inn;
+};
+
+struct ProductRecord {
+    int32_t id;
+    int32_t categoryId;
+    int32_t shelfLifeDays;
+    int32_t deliveryTermsId;
+    int64_t retailPrice;        // Копейки или NO_PRICE
+    int64_t purchasePrice;      // Копейки или NO_PRICE
+    StrRef name;
+    StrRef categoryName;
+    StrRef deliveryTerms;
+};
+
+struct AssortmentRecord {
+    int32_t enterpriseId;
+    int32_t productId;
+    int64_t wholesalePrice;     // Копейки или NO_PRICE
+};
+
+struct SalesDepartmentRecord {
+    int32_t id;
+    int32_t enterpriseId;
+    StrRef enterpriseName;
+    StrRef phone;
+    StrRef fax;
+    StrRef email;
+    StrRef contactLastName;
+    StrRef contactFirstName;
+    StrRef contactPatronymic;
+};
+
+struct BankDetailsRecord {
+    int32_t id;
+    int32_t enterpriseId;
+    StrRef enterpriseName;
+    StrRef bankName;
+    StrRef bankCity;
+    StrRef accountNumber;
+};
+
+// Раскладка записей — часть формата файла
+static_assert(sizeof(FileHeader) == 32, "формат снимка");
+static_assert(sizeof(SectionEntry) == 24, "формат снимка");
+static_assert(sizeof(DictionaryRecord) == 12, "формат снимка");
+static_assert(sizeof(EnterpriseRecord) == 56, "формат снимка");
+static_assert(sizeof(ProductRecord) == 56, "формат снимка");
+static_assert(sizeof(AssortmentRecord) == 16, "формат снимка");
+static_assert(sizeof(SalesDepartmentRecord) == 64, "формат снимка");
+static_assert(sizeof(BankDetailsRecord) == 40, "формат снимка");
+
+// Непрерывный диапазон записей внутри отображённого файла
+template <class T>
+class Records {
+private:
+    const T* first;
+    size_t count;
+
+public:
+    Records() : first(nullptr), count(0) {}
+    Records(const T* data, size_t n) : first(data), count(n) {}
+
+    const T* begin() const { return first; }
+    const T* end() const { return first + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const T& operator[](size_t i) const { return first[i]; }
+};
+
+} // namespace snapshot
+
+struct SnapshotStats {
+    long long enterprises = 0;
+    long long products = 0;
+    long long assortment = 0;
+    long long salesDepartments = 0;
+    long long bankDetails = 0;
+    long long bytes = 0;
+};
+
+// Снимок, отображённый в память только для чтения
+class Snapshot {
+private:
+    const char* base;
+    size_t length;
+    int64_t created;
+
+    snapshot::Records<snapshot::EnterpriseRecord> enterpriseRecs;
+    snapshot::Records<snapshot::ProductRecord> productRecs;
+    snapshot::Records<snapshot::AssortmentRecord> assortmentRecs;
+    snapshot::Records<snapshot::SalesDepartmentRecord> salesRecs;
+    snapshot::Records<snapshot::BankDetailsRecord> bankRecs;
+    snapshot::Records<snapshot::DictionaryRecord> dictionaryRecs[4];
+    const char* strings;
+    size_t stringsSize;
+
+public:
+    Snapshot();
+    ~Snapshot();
+
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+    // Отображает файл в память и проверяет заголовок и границы секций
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return base != nullptr; }
+    int64_t createdAt() const { return created; }
+
+    // Строка из секции строк (указывает прямо в отображённый файл)
+    std::string_view str(snapshot::StrRef ref) const;
+
+    snapshot::Records<snapshot::EnterpriseRecord> enterprises() const { return enterpriseRecs; }
+    snapshot::Records<snapshot::ProductRecord> products() const { return productRecs; }
+    snapshot::Records<snapshot::AssortmentRecord> assortment() const { return assortmentRecs; }
+    snapshot::Records<snapshot::SalesDepartmentRecord> salesDepartments() const { return salesRecs; }
+    snapshot::Records<snapshot::BankDetailsRecord> bankDetails() const { return bankRecs; }
+    snapshot::Records<snapshot::DictionaryRecord> dictionary(Dictionary dict) const;
+
+    // Двоичный поиск по ID; nullptr, если записи нет
+    const snapshot::EnterpriseRecord* findEnterprise(int id) const;
+    const snapshot::ProductRecord* findProduct(int id) const;
+    const snapshot::SalesDepartmentRecord* findSalesDepartment(int id) const;
+    const snapshot::BankDetailsRecord* findBankDetails(int id) const;
+
+    // Позиции ассортимента одного предприятия
+    snapshot::Records<snapshot::AssortmentRecord> assortmentOf(int enterpriseId) const;
+
+    // Преобразование записей в объекты предметной области
+    Enterprise toEnterprise(const snapshot::EnterpriseRecord& r) const;
+    Product toProduct(const snapshot::ProductRecord& r) const;
+    SalesDepartment toSalesDepartment(const snapshot::SalesDepartmentRecord& r) const;
+    BankDetails toBankDetails(const snapshot::BankDetailsRecord& r) const;
+
+    // Читает реестр через шлюзы и записывает снимок. Файл пишется во временный
+    // и переименовывается, поэтому открытые читатели видят старый снимок целиком.
+    static bool write(DatabaseConnection* db, const std::string& path, SnapshotStats* stats = nullptr);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,73 @@
+#ifndef TABLE_STREAM_H
+#define TABLE_STREAM_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// ==========================================
+// Потоковый вывод таблицы
+// ==========================================
+// Строки выводятся по мере поступления, не дожидаясь конца выборки. Ширина
+// колонок определяется по первым sampleRows строкам: они копятся и выводятся
+// вместе с заголовком, следующие сразу форматируются под эту ширину и уходят
+// порциями по FLUSH_SIZE. Колонка, в которую не поместилось более позднее
+// значение, с этой строки расширяется (до maxWidth, дальше — обрезка с "...").
+//
+// Если stdout — терминал, таблица выводится через программу $PAGER (без неё —
+// "less -SFX"; пустой PAGER выводит прямо в терминал). Программа просмотра
+// читает из канала сколько показывает, поэтому выборка идёт вслед за
+// читателем. Когда он выходит, не досмотрев, row() возвращает false — чтение
+// выборки пора прекращать.
+class TableStream {
+private:
+    static const size_t FLUSH_SIZE = 64 * 1024;
+
+    std::string title;
+    std::vector<std::string> headers;
+    std::vector<size_t> widths;
+    size_t sampleRows;
+    size_t maxColumnWidth;
+    bool widthsFixed;
+
+    std::vector<std::vector<std::string>> sample;   // Строки до определения ширины
+    std::string buffer;
+    long long rows;
+
+    FILE* pager;
+    int fd;                     // -1 — вывод не открыт
+    bool broken;                // Читатель закрыл вывод
+    void (*previousSigpipe)(int);
+
+    void fixWidths();
+    void appendRow(const std::vector<std::string>& cells);
+    void appendRule();
+    bool flush();
+
+public:
+    TableStream(const std::string& tableTitle, const std::vector<std::string>& columns,
+                size_t sampleSize = 200, size_t maxWidth = 50);
+    ~TableStream() { close(); }
+
+    TableStream(const TableStream&) = delete;
+    TableStream& operator=(const TableStream&) = delete;
+
+    // Открывает вывод: программу просмотра или stdout
+    void open();
+    // Добавляет строку; false — читатель закрыл вывод
+    bool row(const std::vector<std::string>& cells);
+    // Выводит остаток и число строк (complete = false — выборка оборвалась
+    // ошибкой) и ждёт, пока читатель выйдет из программы просмотра
+    void close(bool complete = true);
+
+    long long rowCount() const { return rows; }
+
+    // Дописывает ячейку ровно в width колонок: дополненную пробелами или
+    // обрезанную по границе символа с "..." в конце. textWidth — ширина
+    // текста, посчитанная заранее (utf8::displayWidth).
+    static void appendCell(std::string& out, const std::string& text, size_t textWidth, size_t width);
+    // Пишет данные целиком; false при ошибке (EPIPE — читатель закрыл канал)
+    static bool writeAll(int fd, const char* data, size_t len);
+};
+
+#endif
\ No newline at end of file
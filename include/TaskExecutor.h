@@ -0,0 +1,150 @@
+#ifndef TASK_EXECUTOR_H
+#define TASK_EXECUTOR_H
+
+#include "ConnectionPool.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ==========================================
+// Пул рабочих потоков для массовых операций
+// ==========================================
+// У каждого рабочего потока своя очередь задач: поток берёт задачи с конца
+// своей очереди, а когда она пуста — забирает самые старые из чужих. Задачи,
+// поставленные из самой задачи, попадают в очередь её потока.
+//
+// Соединение с БД закреплено за рабочим потоком: TaskContext::connection()
+// берёт его из пула при первой необходимости и держит, пока у потока есть
+// работа, поэтому идущие подряд задачи потока используют одно соединение
+// (и его временные таблицы). Простаивающий поток возвращает соединение в пул.
+class TaskExecutor {
+public:
+    // Признак отмены: один на группу задач, отменяется из любого потока.
+    // Отменённая до запуска задача не вызывается, её future получает R();
+    // уже запущенная проверяет TaskContext::isCancelled() сама.
+    class CancelToken {
+    private:
+        std::shared_ptr<std::atomic<bool>> flag;
+
+    public:
+        CancelToken() : flag(std::make_shared<std::atomic<bool>>(false)) {}
+        void cancel() const { flag->store(true); }
+        bool isCancelled() const { return flag->load(); }
+    };
+
+    class TaskContext;
+
+private:
+    struct Task {
+        std::function<void(TaskContext&)> run;
+        CancelToken token;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        ConnectionPool::Lease lease;
+        std::thread thread;
+    };
+
+public:
+    // Передаётся задаче: соединение её рабочего потока и признак отмены
+    class TaskContext {
+    private:
+        friend class TaskExecutor;
+        TaskExecutor* executor;
+        Worker* worker;
+        const CancelToken* token;
+
+        TaskContext(TaskExecutor* e, Worker* w, const CancelToken* t) : executor(e), worker(w), token(t) {}
+
+    public:
+        // Соединение рабочего потока; nullptr (с сообщением), если пула нет
+        // или подключиться не удалось. Задача не закрывает его и не оставляет
+        // открытой транзакцию.
+        DatabaseConnection* connection();
+        bool isCancelled() const { return token->isCancelled(); }
+    };
+
+private:
+    ConnectionPool* pool;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<size_t> nextWorker;     // Очередь для задачи, поставленной извне
+
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<size_t> queued;         // Задач во всех очередях
+    bool stopping;
+
+    void enqueue(Task task);
+    bool takeTask(size_t index, Task& task);
+    void runTask(Worker& worker, Task& task);
+    void workerLoop(size_t index);
+    // Выполняет одну ожидающую задачу, если вызван из рабочего потока этого пула
+    bool runPending();
+
+    template <class R, class F>
+    static void complete(std::promise<R>& promise, F& fn, TaskContext& ctx) {
+        try {
+            if (ctx.isCancelled()) promise.set_value(R());
+            else promise.set_value(fn(ctx));
+        } catch (...) {
+            promise.set_exception(std::current_exception());
+        }
+    }
+
+    template <class F>
+    static void complete(std::promise<void>& promise, F& fn, TaskContext& ctx) {
+        try {
+            if (!ctx.isCancelled()) fn(ctx);
+            promise.set_value();
+        } catch (...) {
+            promise.set_exception(std::current_exception());
+        }
+    }
+
+public:
+    // workerCount = 0 — по числу ядер. connectionPool может быть nullptr (работа без БД).
+    TaskExecutor(size_t workerCount, ConnectionPool* connectionPool);
+    // Дожидается выполнения всех поставленных задач
+    ~TaskExecutor();
+
+    TaskExecutor(const TaskExecutor&) = delete;
+    TaskExecutor& operator=(const TaskExecutor&) = delete;
+
+    size_t workerCount() const { return workers.size(); }
+
+    // Ставит задачу fn(TaskContext&) в очередь; результат — через future.
+    // fn копируется. Исключение, вышедшее из fn, не роняет рабочий поток:
+    // оно сохраняется в future и выбрасывается из await()/get() у ждущего.
+    template <class F>
+    auto submit(F fn, const CancelToken& token = CancelToken())
+        -> std::future<decltype(fn(std::declval<TaskContext&>()))> {
+        using R = decltype(fn(std::declval<TaskContext&>()));
+        auto promise = std::make_shared<std::promise<R>>();
+        std::future<R> result = promise->get_future();
+        enqueue(Task{[promise, fn](TaskContext& ctx) mutable { complete(*promise, fn, ctx); }, token});
+        return result;
+    }
+
+    // Ждёт результата. В рабочем потоке пула тем временем выполняет другие
+    // задачи — задача, ждущая своих подзадач, не занимает поток впустую.
+    // Они работают на том же соединении, поэтому ждать с открытой
+    // транзакцией нельзя.
+    template <class T>
+    T await(std::future<T>& result) {
+        while (result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            if (!runPending()) result.wait_for(std::chrono::milliseconds(1));
+        }
+        return result.get();
+    }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef TRIGRAM_INDEX_H
+#define TRIGRAM_INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// ==========================================
+// Нечёткий поиск по триграммам
+// ==========================================
+
+struct SearchHit {
+    int id;
+    float score;    // 0..1, больше — лучше
+};
+
+// Инвертированный индекс триграмм (как в pg_trgm): текст приводится к нижнему
+// регистру (латиница и кириллица, ё -> е), разбивается на слова, каждое слово
+// дополняется пробелами по краям и режется на тройки символов. Опечатка меняет
+// лишь несколько триграмм, поэтому похожие строки остаются среди кандидатов.
+//
+// Поиск: счётчики общих с запросом триграмм набираются по спискам документов,
+// затем массив счётчиков просматривается векторно (SSE2) и отбираются документы
+// с достаточным числом совпадений; лучшие k — через кучу.
+//
+// Удаление помечает документ удалённым; списки чистятся, когда удалённых
+// становится больше четверти. search() не меняет индекс (буфер счётчиков у каждого
+// потока свой), поэтому одновременные поиски допустимы; изменения — только
+// при отсутствии поисков.
+class TrigramIndex {
+private:
+    struct Doc {
+        int id;
+        uint16_t trigrams;  // Число различных триграмм документа
+        bool alive;
+    };
+
+    std::vector<Doc> docs;                                       // Слот -> документ
+    std::unordered_map<int, uint32_t> slotOf;                    // ID -> слот
+    std::unordered_map<uint32_t, std::vector<uint32_t>> postings; // Триграмма -> слоты (по возрастанию)
+    size_t deadCount;
+
+    void compact();
+
+public:
+    TrigramIndex() : deadCount(0) {}
+
+    // Различные триграммы текста: три символа по 10 бит (латиница и кириллица
+    // кодируются точно, остальные символы — хешем)
+    static std::vector<uint32_t> trigramsOf(const std::string& text);
+
+    void clear();
+    void reserve(size_t documents);
+
+    // Добавить или заменить документ с этим ID
+    void add(int id, const std::string& text);
+    void remove(int id);
+
+    // До k лучших документов со сходством не ниже minScore
+    std::vector<SearchHit> search(const std::string& query, size_t k, float minScore = 0.3f) const;
+
+    size_t size() const { return slotOf.size(); }
+};
+
+#endif
\ No newline at end of file
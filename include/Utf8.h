@@ -0,0 +1,49 @@
+#ifndef UTF8_H
+#define UTF8_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// ==========================================
+// Текст UTF-8: проверка, длина и ширина на экране
+// ==========================================
+// Функции работают блоками по 32 байта (AVX2) или по 16 (SSE2); набор
+// инструкций выбирается по процессору при первом вызове, на других
+// архитектурах — побайтовый вариант. Переменная окружения
+// REGENT_SIMD=sse2|scalar ограничивает выбор (для сравнения и отладки).
+//
+// Ширина считается в колонках терминала: широкие и полноширинные символы
+// Восточной Азии (иероглифы, хангыль, эмодзи) занимают две колонки,
+// комбинируемые знаки — ни одной, остальные — одну.
+
+namespace utf8 {
+    // Выбранный набор инструкций: "avx2", "sse2" или "scalar"
+    const char* simdLevel();
+
+    // Длина наибольшего корректного (по RFC 3629) начала текста: позиция
+    // первой неверной или оборванной последовательности либо len
+    size_t validLength(const char* s, size_t len);
+    inline bool isValid(const char* s, size_t len) { return validLength(s, len) == len; }
+
+    // Число символов: байты продолжения (10xxxxxx) не считаются
+    size_t countCodePoints(const char* s, size_t len);
+    inline size_t countCodePoints(const std::string& s) { return countCodePoints(s.data(), s.size()); }
+
+    int codePointWidth(uint32_t cp);
+    size_t displayWidth(const char* s, size_t len);
+    inline size_t displayWidth(const std::string& s) { return displayWidth(s.data(), s.size()); }
+
+    // Длина в байтах наибольшего начала текста шириной не более maxWidth;
+    // обрезается по границе символа, ширина начала — в *width
+    size_t fitWidth(const char* s, size_t len, size_t maxWidth, size_t* width = nullptr);
+
+    // Позиция первого байта, который экранируется в строке JSON (управляющий
+    // символ, '"' или '\\'); len, если таких нет
+    size_t findJsonSpecial(const char* s, size_t len);
+    // Позиция первого байта, из-за которого поле CSV берётся в кавычки
+    // (разделитель, '"', '\n' или '\r'); len, если таких нет
+    size_t findCsvSpecial(const char* s, size_t len, char delimiter);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include "Gateways.h"
+
+namespace {
+    // Агрегаты по позициям ассортимента с ценой закупки товара. Суммы NUMERIC
+    // переводятся в копейки BIGINT уже после агрегации; доля в общей марже —
+    // оконной суммой по всем группам, до LIMIT.
+    const char* MARGIN_TAIL = R"(
+               agg.line_count,
+               (agg.wholesale * 100)::BIGINT,
+               (agg.purchase * 100)::BIGINT,
+               agg.below,
+               COALESCE((agg.wholesale - agg.purchase)
+                        / NULLIF(SUM(agg.wholesale - agg.purchase) OVER (), 0), 0)::FLOAT8
+    )";
+
+    const char* MARGIN_AGGREGATES = R"(
+               COUNT(*) AS line_count,
+               COALESCE(SUM(ep.wholesale_price), 0) AS wholesale,
+               COALESCE(SUM(p.purchase_price), 0) AS purchase,
+               COUNT(*) FILTER (WHERE ep.wholesale_price < p.purchase_price) AS below
+        FROM enterprise_product ep
+        JOIN product p ON p.product_id = ep.product_id
+    )";
+
+    SQLHSTMT execute(DatabaseConnection* db, const std::string& sql) {
+        if (!db->isConnected()) return SQL_NULL_HSTMT;
+        SQLHSTMT hStmt;
+        SQLRETURN ret = SQLAllocHandle(SQL_HANDLE_STMT, db->getHandle(), &hStmt);
+        if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) return SQL_NULL_HSTMT;
+
+        ret = SQLExecDirect(hStmt, (SQLCHAR*)sql.c_str(), SQL_NTS);
+        if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) {
+            SQLCHAR sqlState[6], message[512];
+            SQLINTEGER nativeError;
+            sqlState[0] = message[0] = '\0';
+            SQLGetDiagRec(SQL_HANDLE_STMT, hStmt, 1, sqlState, &nativeError, message, sizeof(message), nullptr);
+            std::cerr << "Ошибка построения отчёта: " << message << " (SQLSTATE: " << sqlState << ")" << std::endl;
+            SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+            return SQL_NULL_HSTMT;
+        }
+        return hStmt;
+    }
+
+    // Столбцы: id, name, lines, wholesale, purchase, below, share
+    std::vector<MarginSummary> readMarginRows(SQLHSTMT hStmt) {
+        std::vector<MarginSummary> list;
+        MarginSummary m;
+        SQLCHAR name[256];
+        SQLBIGINT wholesale, purchase;
+        SQLRETURN ret;
+        while (SQL_SUCCEEDED(ret = SQLFetch(hStmt))) {
+            name[0] = '\0';
+            SQLGetData(hStmt, 1, SQL_C_LONG, &m.id, 0, nullptr);
+            SQLGetData(hStmt, 2, SQL_C_CHAR, name, sizeof(name), nullptr);
+            SQLGetData(hStmt, 3, SQL_C_SBIGINT, &m.lines, 0, nullptr);
+            SQLGetData(hStmt, 4, SQL_C_SBIGINT, &wholesale, 0, nullptr);
+            SQLGetData(hStmt, 5, SQL_C_SBIGINT, &purchase, 0, nullptr);
+            SQLGetData(hStmt, 6, SQL_C_SBIGINT, &m.below_purchase, 0, nullptr);
+            SQLGetData(hStmt, 7, SQL_C_DOUBLE, &m.margin_share, 0, nullptr);
+            m.name = (char*)name;
+            m.wholesale_total = Money::fromKopecks(wholesale);
+            m.purchase_total = Money::fromKopecks(purchase);
+            list.push_back(m);
+        }
+        // Отчёт по части групп хуже, чем никакой: доли и порядок были бы неверны
+        bool complete = TableGateway::fetchCompleted(hStmt, ret);
+        SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+        if (!complete) return {};
+        return list;
+    }
+}
+
+std::vector<MarginSummary> AnalyticsGateway::marginByEnterprise(size_t limit) {
+    // Сначала агрегация по ID, затем JOIN с enterprise — названия
+    // присоединяются к строкам отчёта, а не к каждой позиции ассортимента
+    std::string sql = std::string("WITH agg AS (SELECT ep.enterprise_id AS id,") + MARGIN_AGGREGATES +
+        " GROUP BY ep.enterprise_id) "
+        "SELECT agg.id, e.name," + MARGIN_TAIL +
+        " FROM agg JOIN enterprise e ON e.enterprise_id = agg.id"
+        " ORDER BY agg.wholesale - agg.purchase DESC, agg.id";
+    if (limit > 0) sql += " LIMIT " + std::to_string(limit);
+
+    SQLHSTMT hStmt = execute(db, sql);
+    if (hStmt == SQL_NULL_HSTMT) return {};
+    return readMarginRows(hStmt);
+}
+
+std::vector<MarginSummary> AnalyticsGateway::marginByCategory() {
+    std::string sql = std::string("WITH agg AS (SELECT p.category_id AS id,") + MARGIN_AGGREGATES +
+        " GROUP BY p.category_id) "
+        "SELECT agg.id, pc.name," + MARGIN_TAIL +
+        " FROM agg LEFT JOIN product_category pc ON pc.category_id = agg.id"
+        " ORDER BY agg.wholesale - agg.purchase DESC, agg.id";
+
+    SQLHSTMT hStmt = execute(db, sql);
+    if (hStmt == SQL_NULL_HSTMT) return {};
+    return readMarginRows(hStmt);
+}
+
+std::vector<PriceOutlier> AnalyticsGateway::findPriceOutliers(size_t limit, long long* total) {
+    if (total) *total = 0;
+
+    // COUNT(*) OVER () считается до LIMIT — общее число позиций приходит
+    // в каждой строке, отдельный запрос не нужен
+    std::string sql = R"(
+        SELECT ep.enterprise_id, e.name, ep.product_id, p.name,
+               (ep.wholesale_price * 100)::BIGINT, (p.purchase_price * 100)::BIGINT,
+               COUNT(*) OVER ()
+        FROM enterprise_product ep
+        JOIN product p ON p.product_id = ep.product_id
+        JOIN enterprise e ON e.enterprise_id = ep.enterprise_id
+        WHERE ep.wholesale_price < p.purchase_price
+        ORDER BY p.purchase_price - ep.wholesale_price DESC, ep.enterprise_id, ep.product_id
+    )";
+    if (limit > 0) sql += " LIMIT " + std::to_string(limit);
+
+    SQLHSTMT hStmt = execute(db, sql);
+    if (hStmt == SQL_NULL_HSTMT) return {};
+
+    std::vector<PriceOutlier> list;
+    PriceOutlier o;
+    SQLCHAR ent_name[256], prod_name[256];
+    SQLBIGINT wholesale, purchase, count = 0;
+    SQLRETURN ret;
+    while (SQL_SUCCEEDED(ret = SQLFetch(hStmt))) {
+        ent_name[0] = prod_name[0] = '\0';
+        SQLGetData(hStmt, 1, SQL_C_LONG, &o.enterprise_id, 0, nullptr);
+        SQLGetData(hStmt, 2, SQL_C_CHAR, ent_name, sizeof(ent_name), nullptr);
+        SQLGetData(hStmt, 3, SQL_C_LONG, &o.product_id, 0, nullptr);
+        SQLGetData(hStmt, 4, SQL_C_CHAR, prod_name, sizeof(prod_name), nullptr);
+        SQLGetData(hStmt, 5, SQL_C_SBIGINT, &wholesale, 0, nullptr);
+        SQLGetData(hStmt, 6, SQL_C_SBIGINT, &purchase, 0, nullptr);
+        SQLGetData(hStmt, 7, SQL_C_SBIGINT, &count, 0, nullptr);
+        o.enterprise_name = (char*)ent_name;
+        o.product_name = (char*)prod_name;
+        o.wholesale_price = Money::fromKopecks(wholesale);
+        o.purchase_price = Money::fromKopecks(purchase);
+        list.push_back(o);
+    }
+    bool complete = fetchCompleted(hStmt, ret);
+    SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+    if (!complete) return {};
+    if (total) *total = count;
+    return list;
+}
\ No newline at end of file
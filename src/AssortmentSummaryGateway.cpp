@@ -0,0 +1,293 @@
+#include "Gateways.h"
+#include <sstream>
+
+namespace {
+    // Сводка обновляется триггерами уровня оператора: таблицы переходов (new_rows,
+    // old_rows) приходят целиком, поэтому пакетная вставка, COPY и копирование
+    // ассортимента дают одно групповое обновление на оператор, а не на строку.
+    // Сумма и число позиций пересчитываются приращением; минимум и максимум —
+    // по ассортименту предприятия, только если удалена или изменена граничная цена.
+    const char* SUMMARY_TABLES = R"(
+        CREATE TABLE IF NOT EXISTS enterprise_assortment_summary (
+            enterprise_id INTEGER PRIMARY KEY,
+            line_count BIGINT NOT NULL DEFAULT 0,
+            priced_count BIGINT NOT NULL DEFAULT 0,
+            price_sum NUMERIC NOT NULL DEFAULT 0,
+            min_price NUMERIC(10,2),
+            max_price NUMERIC(10,2),
+            category_count INTEGER NOT NULL DEFAULT 0
+        );
+        CREATE TABLE IF NOT EXISTS enterprise_category_lines (
+            enterprise_id INTEGER NOT NULL,
+            category_id INTEGER NOT NULL,
+            line_count BIGINT NOT NULL,
+            PRIMARY KEY (enterprise_id, category_id)
+        );
+    )";
+
+    // Удаление опустевших строк, точные границы цен и число категорий
+    // для затронутых предприятий
+    const char* SUMMARY_SETTLE = R"(
+        CREATE OR REPLACE FUNCTION assortment_summary_settle(touched INTEGER[], extremes INTEGER[])
+        RETURNS void AS $$
+        BEGIN
+            DELETE FROM enterprise_category_lines WHERE enterprise_id = ANY(touched) AND line_count <= 0;
+            DELETE FROM enterprise_assortment_summary WHERE enterprise_id = ANY(touched) AND line_count <= 0;
+
+            UPDATE enterprise_assortment_summary s SET min_price = m.lo, max_price = m.hi
+            FROM (SELECT enterprise_id, MIN(wholesale_price) AS lo, MAX(wholesale_price) AS hi
+                  FROM enterprise_product WHERE enterprise_id = ANY(extremes)
+                  GROUP BY enterprise_id) m
+            WHERE s.enterprise_id = m.enterprise_id;
+
+            UPDATE enterprise_assortment_summary s
+            SET category_count = (SELECT COUNT(*) FROM enterprise_category_lines c
+                                  WHERE c.enterprise_id = s.enterprise_id)
+            WHERE s.enterprise_id = ANY(touched);
+        END;
+        $$ LANGUAGE plpgsql;
+    )";
+
+    const char* SUMMARY_SYNC = R"(
+        CREATE OR REPLACE FUNCTION assortment_summary_sync() RETURNS trigger AS $$
+        DECLARE
+            touched INTEGER[];
+            extremes INTEGER[];
+        BEGIN
+            IF TG_OP IN ('DELETE', 'UPDATE') THEN
+                SELECT array_agg(DISTINCT o.enterprise_id) INTO extremes
+                FROM old_rows o JOIN enterprise_assortment_summary s ON s.enterprise_id = o.enterprise_id
+                WHERE o.wholesale_price <= s.min_price OR o.wholesale_price >= s.max_price;
+
+                UPDATE enterprise_assortment_summary s
+                SET line_count = s.line_count - d.n,
+                    priced_count = s.priced_count - d.priced,
+                    price_sum = s.price_sum - d.total
+                FROM (SELECT enterprise_id, COUNT(*) AS n, COUNT(wholesale_price) AS priced,
+                             COALESCE(SUM(wholesale_price), 0) AS total
+                      FROM old_rows GROUP BY enterprise_id) d
+                WHERE s.enterprise_id = d.enterprise_id;
+
+                -- Товар, удалённый каскадом, уже не найдётся: его категорию
+                -- списывает assortment_summary_product_sync до удаления
+                UPDATE enterprise_category_lines c SET line_count = c.line_count - d.n
+                FROM (SELECT o.enterprise_id, p.category_id, COUNT(*) AS n
+                      FROM old_rows o JOIN product p ON p.product_id = o.product_id
+                      GROUP BY o.enterprise_id, p.category_id) d
+                WHERE c.enterprise_id = d.enterprise_id AND c.category_id = d.category_id;
+
+                touched := ARRAY(SELECT DISTINCT enterprise_id FROM old_rows);
+            END IF;
+
+            IF TG_OP IN ('INSERT', 'UPDATE') THEN
+                INSERT INTO enterprise_assortment_summary AS s
+                    (enterprise_id, line_count, priced_count, price_sum, min_price, max_price)
+                SELECT enterprise_id, COUNT(*), COUNT(wholesale_price), COALESCE(SUM(wholesale_price), 0),
+                       MIN(wholesale_price), MAX(wholesale_price)
+                FROM new_rows GROUP BY enterprise_id
+                ON CONFLICT (enterprise_id) DO UPDATE SET
+                    line_count = s.line_count + EXCLUDED.line_count,
+                    priced_count = s.priced_count + EXCLUDED.priced_count,
+                    price_sum = s.price_sum + EXCLUDED.price_sum,
+                    min_price = LEAST(s.min_price, EXCLUDED.min_price),
+                    max_price = GREATEST(s.max_price, EXCLUDED.max_price);
+
+                INSERT INTO enterprise_category_lines AS c (enterprise_id, category_id, line_count)
+                SELECT n.enterprise_id, p.category_id, COUNT(*)
+                FROM new_rows n JOIN product p ON p.product_id = n.product_id
+                GROUP BY n.enterprise_id, p.category_id
+                ON CONFLICT (enterprise_id, category_id) DO UPDATE SET line_count = c.line_count + EXCLUDED.line_count;
+
+                touched := touched || ARRAY(SELECT DISTINCT enterprise_id FROM new_rows);
+            END IF;
+
+            PERFORM assortment_summary_settle(touched, extremes);
+            RETURN NULL;
+        END;
+        $$ LANGUAGE plpgsql;
+    )";
+
+    // Смена категории товара переносит его позиции между категориями у всех
+    // предприятий; удаление товара списывает их до каскадного удаления позиций
+    const char* SUMMARY_PRODUCT_SYNC = R"(
+        CREATE OR REPLACE FUNCTION assortment_summary_product_sync() RETURNS trigger AS $$
+        DECLARE
+            touched INTEGER[];
+        BEGIN
+            touched := ARRAY(SELECT enterprise_id FROM enterprise_product WHERE product_id = OLD.product_id);
+            IF cardinality(touched) > 0 THEN
+                UPDATE enterprise_category_lines SET line_count = line_count - 1
+                WHERE category_id = OLD.category_id AND enterprise_id = ANY(touched);
+
+                IF TG_OP = 'UPDATE' THEN
+                    INSERT INTO enterprise_category_lines AS c (enterprise_id, category_id, line_count)
+                    SELECT unnest(touched), NEW.category_id, 1
+                    ON CONFLICT (enterprise_id, category_id) DO UPDATE SET line_count = c.line_count + 1;
+                END IF;
+
+                PERFORM assortment_summary_settle(touched, NULL);
+            END IF;
+
+            IF TG_OP = 'DELETE' THEN
+                RETURN OLD;
+            END IF;
+            RETURN NULL;
+        END;
+        $$ LANGUAGE plpgsql;
+    )";
+
+    const char* SUMMARY_REBUILD = R"(
+        CREATE OR REPLACE FUNCTION assortment_summary_rebuild() RETURNS void AS $$
+        BEGIN
+            TRUNCATE enterprise_assortment_summary, enterprise_category_lines;
+
+            INSERT INTO enterprise_category_lines (enterprise_id, category_id, line_count)
+            SELECT ep.enterprise_id, p.category_id, COUNT(*)
+            FROM enterprise_product ep JOIN product p ON p.product_id = ep.product_id
+            GROUP BY ep.enterprise_id, p.category_id;
+
+            INSERT INTO enterprise_assortment_summary
+                (enterprise_id, line_count, priced_count, price_sum, min_price, max_price, category_count)
+            SELECT ep.enterprise_id, COUNT(*), COUNT(ep.wholesale_price), COALESCE(SUM(ep.wholesale_price), 0),
+                   MIN(ep.wholesale_price), MAX(ep.wholesale_price),
+                   (SELECT COUNT(*) FROM enterprise_category_lines c WHERE c.enterprise_id = ep.enterprise_id)
+            FROM enterprise_product ep
+            GROUP BY ep.enterprise_id;
+        END;
+        $$ LANGUAGE plpgsql;
+
+        CREATE OR REPLACE FUNCTION assortment_summary_truncate() RETURNS trigger AS $$
+        BEGIN
+            TRUNCATE enterprise_assortment_summary, enterprise_category_lines;
+            RETURN NULL;
+        END;
+        $$ LANGUAGE plpgsql;
+    )";
+
+    // Триггеры ставятся один раз; при первой установке (новая БД или обновление
+    // старой) сводка заполняется по уже имеющемуся ассортименту
+    const char* SUMMARY_TRIGGERS = R"(
+        DO $$
+        BEGIN
+            IF NOT EXISTS (SELECT 1 FROM pg_trigger WHERE tgname = 'enterprise_product_summary_ins') THEN
+                CREATE TRIGGER enterprise_product_summary_ins AFTER INSERT ON enterprise_product
+                    REFERENCING NEW TABLE AS new_rows
+                    FOR EACH STATEMENT EXECUTE PROCEDURE assortment_summary_sync();
+                CREATE TRIGGER enterprise_product_summary_upd AFTER UPDATE ON enterprise_product
+                    REFERENCING OLD TABLE AS old_rows NEW TABLE AS new_rows
+                    FOR EACH STATEMENT EXECUTE PROCEDURE assortment_summary_sync();
+                CREATE TRIGGER enterprise_product_summary_del AFTER DELETE ON enterprise_product
+                    REFERENCING OLD TABLE AS old_rows
+                    FOR EACH STATEMENT EXECUTE PROCEDURE assortment_summary_sync();
+                CREATE TRIGGER enterprise_product_summary_trunc AFTER TRUNCATE ON enterprise_product
+                    FOR EACH STATEMENT EXECUTE PROCEDURE assortment_summary_truncate();
+                CREATE TRIGGER product_summary_category AFTER UPDATE OF category_id ON product
+                    FOR EACH ROW WHEN (OLD.category_id IS DISTINCT FROM NEW.category_id)
+                    EXECUTE PROCEDURE assortment_summary_product_sync();
+                CREATE TRIGGER product_summary_delete BEFORE DELETE ON product
+                    FOR EACH ROW EXECUTE PROCEDURE assortment_summary_product_sync();
+                PERFORM assortment_summary_rebuild();
+            END IF;
+        END;
+        $$;
+    )";
+
+    const char* SUMMARY_SELECT = R"(
+        SELECT s.enterprise_id, e.name, s.line_count, s.category_count,
+               COALESCE(s.min_price * 100, 0)::BIGINT,
+               COALESCE(ROUND(s.price_sum / NULLIF(s.priced_count, 0), 2) * 100, 0)::BIGINT,
+               COALESCE(s.max_price * 100, 0)::BIGINT
+    )";
+    const char* SUMMARY_FROM = R"(
+        FROM enterprise_assortment_summary s
+        JOIN enterprise e ON e.enterprise_id = s.enterprise_id
+    )";
+
+    AssortmentSummary readSummary(SQLHSTMT hStmt) {
+        AssortmentSummary s;
+        SQLCHAR name[256];
+        SQLBIGINT minPrice, avgPrice, maxPrice;
+        name[0] = '\0';
+        SQLGetData(hStmt, 1, SQL_C_LONG, &s.enterprise_id, 0, nullptr);
+        SQLGetData(hStmt, 2, SQL_C_CHAR, name, sizeof(name), nullptr);
+        SQLGetData(hStmt, 3, SQL_C_SBIGINT, &s.lines, 0, nullptr);
+        SQLGetData(hStmt, 4, SQL_C_LONG, &s.categories, 0, nullptr);
+        SQLGetData(hStmt, 5, SQL_C_SBIGINT, &minPrice, 0, nullptr);
+        SQLGetData(hStmt, 6, SQL_C_SBIGINT, &avgPrice, 0, nullptr);
+        SQLGetData(hStmt, 7, SQL_C_SBIGINT, &maxPrice, 0, nullptr);
+        s.enterprise_name = (char*)name;
+        s.min_price = Money::fromKopecks(minPrice);
+        s.avg_price = Money::fromKopecks(avgPrice);
+        s.max_price = Money::fromKopecks(maxPrice);
+        return s;
+    }
+}
+
+void AssortmentSummaryGateway::createTableIfNotExists() {
+    db->executeQuery(SUMMARY_TABLES);
+    db->executeQuery(SUMMARY_SETTLE);
+    db->executeQuery(SUMMARY_SYNC);
+    db->executeQuery(SUMMARY_PRODUCT_SYNC);
+    db->executeQuery(SUMMARY_REBUILD);
+    db->executeQuery(SUMMARY_TRIGGERS);
+}
+
+bool AssortmentSummaryGateway::rebuild() {
+    return db->executeQuery("SELECT assortment_summary_rebuild()");
+}
+
+const std::vector<CriteriaField>& AssortmentSummaryGateway::criteriaFields() {
+    static const std::vector<CriteriaField> fields = {
+        {"enterprise_id", "s.enterprise_id", FieldType::Int},
+        {"enterprise", "e.name", FieldType::Text},
+        {"lines", "s.line_count", FieldType::Int},
+        {"categories", "s.category_count", FieldType::Int},
+        {"min_price", "s.min_price", FieldType::Money},
+        {"avg_price", "ROUND(s.price_sum / NULLIF(s.priced_count, 0), 2)", FieldType::Money},
+        {"max_price", "s.max_price", FieldType::Money}
+    };
+    return fields;
+}
+
+std::vector<AssortmentSummary> AssortmentSummaryGateway::findWhere(const Criteria& criteria) {
+    std::vector<AssortmentSummary> list;
+    SQLHSTMT hStmt = openQuery(std::string(SUMMARY_SELECT) + SUMMARY_FROM, criteria,
+                               criteriaFields(), "s.enterprise_id");
+    if (hStmt == SQL_NULL_HSTMT) return list;
+
+    SQLRETURN ret;
+    while (SQL_SUCCEEDED(ret = SQLFetch(hStmt))) list.push_back(readSummary(hStmt));
+    bool complete = fetchCompleted(hStmt, ret);
+    SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+    if (!complete) return {};
+    return list;
+}
+
+long long AssortmentSummaryGateway::countWhere(const Criteria& criteria) {
+    return countQuery(SUMMARY_FROM, criteria, criteriaFields());
+}
+
+std::vector<AssortmentSummary> AssortmentSummaryGateway::findByEnterprises(const std::vector<int>& enterprise_ids) {
+    std::vector<AssortmentSummary> list;
+    if (enterprise_ids.empty() || !db->isConnected()) return list;
+
+    std::ostringstream oss;
+    oss << SUMMARY_SELECT << SUMMARY_FROM << " WHERE s.enterprise_id IN (";
+    for (size_t i = 0; i < enterprise_ids.size(); ++i) {
+        if (i > 0) oss << ", ";
+        oss << enterprise_ids[i];
+    }
+    oss << ")";
+
+    SQLHSTMT hStmt;
+    SQLRETURN ret = SQLAllocHandle(SQL_HANDLE_STMT, db->getHandle(), &hStmt);
+    if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) return list;
+    ret = SQLExecDirect(hStmt, (SQLCHAR*)oss.str().c_str(), SQL_NTS);
+    if (ret == SQL_SUCCESS || ret == SQL_SUCCESS_WITH_INFO) {
+        while (SQL_SUCCEEDED(ret = SQLFetch(hStmt))) list.push_back(readSummary(hStmt));
+    }
+    bool complete = fetchCompleted(hStmt, ret);
+    SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+    if (!complete) return {};
+    return list;
+}
\ No newline at end of file
@@ -17,26 +17,57 @@ void BankDetailsGateway::createTableIfNotExists() {
 
 std::vector<BankDetails> BankDetailsGateway::findAll() {
     std::vector<BankDetails> list;
-    if (!db->isConnected()) return list;
-
-    SQLHSTMT hStmt;
-    SQLAllocHandle(SQL_HANDLE_STMT, db->getHandle(), &hStmt);
+    if (streamAll([&list](const BankDetails& bd) { list.push_back(bd); return true; }) < 0) return {};
+    return list;
+}
 
-    std::string sql = R"(
+namespace {
+    const char* BANK_SELECT = R"(
         SELECT 
             bd.bank_id, bd.enterprise_id, e.name as ent_name,
             bd.bank_name, bd.bank_city, bd.account_number
+    )";
+    const char* BANK_FROM = R"(
         FROM bank_details bd
         JOIN enterprise e ON bd.enterprise_id = e.enterprise_id
-        ORDER BY bd.bank_id
     )";
+}
 
-    SQLExecDirect(hStmt, (SQLCHAR*)sql.c_str(), SQL_NTS);
+const std::vector<CriteriaField>& BankDetailsGateway::criteriaFields() {
+    static const std::vector<CriteriaField> fields = {
+        {"id", "bd.bank_id", FieldType::Int},
+        {"enterprise_id", "bd.enterprise_id", FieldType::Int},
+        {"enterprise", "e.name", FieldType::Text},
+        {"bank_name", "bd.bank_name", FieldType::Text},
+        {"bank_city", "bd.bank_city", FieldType::Text},
+        {"account_number", "bd.account_number", FieldType::Text},
+        {"created_at", "bd.created_at", FieldType::Timestamp},
+        {"updated_at", "bd.updated_at", FieldType::Timestamp}
+    };
+    return fields;
+}
+
+std::vector<BankDetails> BankDetailsGateway::findWhere(const Criteria& criteria) {
+    std::vector<BankDetails> list;
+    if (streamWhere(criteria, [&list](const BankDetails& bd) { list.push_back(bd); return true; }) < 0) return {};
+    return list;
+}
+
+long long BankDetailsGateway::countWhere(const Criteria& criteria) {
+    return countQuery(BANK_FROM, criteria, criteriaFields());
+}
+
+long long BankDetailsGateway::streamWhere(const Criteria& criteria, const RowCallback<BankDetails>& callback) {
+    SQLHSTMT hStmt = openQuery(std::string(BANK_SELECT) + BANK_FROM, criteria,
+                               criteriaFields(), "bd.bank_id");
+    if (hStmt == SQL_NULL_HSTMT) return -1;
 
     BankDetails bd;
+    long long count = 0;
     SQLCHAR ent_name[256], b_name[256], b_city[256], acc_num[256];
 
-    while (SQLFetch(hStmt) == SQL_SUCCESS) {
+    SQLRETURN ret;
+    while (SQL_SUCCEEDED(ret = SQLFetch(hStmt))) {
         // Очистка буферов
         ent_name[0] = b_name[0] = b_city[0] = acc_num[0] = '\0';
 
@@ -52,10 +83,12 @@ std::vector<BankDetails> BankDetailsGateway::findAll() {
         bd.bank_city = (char*)b_city;
         bd.account_number = (char*)acc_num;
 
-        list.push_back(bd);
+        ++count;
+        if (!callback(bd)) break;
     }
+    bool complete = fetchCompleted(hStmt, ret);
     SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
-    return list;
+    return complete ? count : -1;
 }
 
 BankDetails BankDetailsGateway::findById(int id) {
@@ -134,4 +167,11 @@ bool BankDetailsGateway::remove(int id) {
     std::ostringstream oss;
     oss << "DELETE FROM bank_details WHERE bank_id=" << id;
     return db->executeQuery(oss.str());
+}
+
+BankDetails BankDetailsGateway::findByEnterprise(int enterprise_id) {
+    BankDetails bd{};
+    streamWhere(Criteria().eq("enterprise_id", static_cast<long long>(enterprise_id)),
+                [&bd](const BankDetails& row) { bd = row; return false; });
+    return bd;
 }
\ No newline at end of file
@@ -0,0 +1,471 @@
+#include "BatchScript.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+#include <poll.h>
+#include <unistd.h>
+
+namespace {
+    // Построчное чтение дескриптора с собственным буфером: в отличие от
+    // std::istream, видно, остались ли прочитанные, но не разобранные строки
+    class LineReader {
+    private:
+        int fd;
+        std::string buffer;
+        size_t position = 0;
+        bool eof = false;
+
+    public:
+        explicit LineReader(int input) : fd(input) {}
+
+        // Следующая строка без '\n' (и '\r'); false — данные кончились
+        bool next(std::string& line) {
+            for (;;) {
+                size_t end = buffer.find('\n', position);
+                if (end != std::string::npos || eof) {
+                    if (end == std::string::npos) {
+                        if (position >= buffer.size()) return false;
+                        end = buffer.size();
+                    }
+                    line.assign(buffer, position, end - position);
+                    if (!line.empty() && line.back() == '\r') line.pop_back();
+                    position = std::min(end + 1, buffer.size());
+                    return true;
+                }
+                buffer.erase(0, position);
+                position = 0;
+                char chunk[65536];
+                ssize_t n = ::read(fd, chunk, sizeof(chunk));
+                if (n < 0 && errno == EINTR) continue;
+                if (n < 0) std::cerr << "Ошибка: Не удалось прочитать сценарий" << std::endl;
+                if (n <= 0) eof = true;
+                else buffer.append(chunk, static_cast<size_t>(n));
+            }
+        }
+
+        // Следующую строку можно получить без ожидания
+        bool ready() const {
+            if (eof || buffer.find('\n', position) != std::string::npos) return true;
+            pollfd p{fd, POLLIN, 0};
+            return ::poll(&p, 1, 0) != 0;
+        }
+    };
+
+    bool parseInt(const std::string& text, long long& out) {
+        if (text.empty()) return false;
+        errno = 0;
+        char* end = nullptr;
+        long long v = std::strtoll(text.c_str(), &end, 10);
+        if (errno != 0 || *end != '\0') return false;
+        out = v;
+        return true;
+    }
+
+    bool parseInt(const std::string& text, int& out) {
+        long long v;
+        if (!parseInt(text, v) || v < INT_MIN || v > INT_MAX) return false;
+        out = static_cast<int>(v);
+        return true;
+    }
+
+    bool parseId(const std::string& text, int& id) {
+        return parseInt(text, id) && id > 0;
+    }
+
+    // Список ID через запятую
+    bool parseIds(const std::string& text, std::vector<int>& ids) {
+        size_t start = 0;
+        while (start <= text.size()) {
+            size_t comma = text.find(',', start);
+            if (comma == std::string::npos) comma = text.size();
+            int id;
+            if (!parseId(text.substr(start, comma - start), id)) return false;
+            ids.push_back(id);
+            start = comma + 1;
+        }
+        return !ids.empty();
+    }
+
+    bool parseFlag(const std::string& text, bool& out) {
+        if (text == "yes" || text == "true" || text == "1") out = true;
+        else if (text == "no" || text == "false" || text == "0") out = false;
+        else return false;
+        return true;
+    }
+
+    bool isAssortmentCommand(const std::string& name, AssortmentChange& kind) {
+        if (name == "add-assortment") kind = AssortmentChange::Add;
+        else if (name == "set-price") kind = AssortmentChange::SetPrice;
+        else if (name == "remove-assortment") kind = AssortmentChange::Remove;
+        else return false;
+        return true;
+    }
+
+    int64_t assortmentKey(const EnterpriseProduct& item) {
+        return (static_cast<int64_t>(item.enterprise_id) << 32) | static_cast<uint32_t>(item.product_id);
+    }
+
+    // Поле записи по имени аргумента: false с ошибкой, если значение не разобрано
+    // или поле неизвестно
+    bool setEnterpriseField(Enterprise& e, const std::string& key, const std::string& value, std::string& error) {
+        bool ok = true;
+        if (key == "name") e.name = value;
+        else if (key == "inn") e.inn = value;
+        else if (key == "postal_address") e.postal_address = value;
+        else if (key == "legal_form_id") ok = parseId(value, e.legal_form_id);
+        else if (key == "ownership_form_id") ok = parseId(value, e.ownership_form_id);
+        else {
+            error = "Неизвестное поле " + key;
+            return false;
+        }
+        if (!ok) error = "Неверное значение поля " + key;
+        return ok;
+    }
+
+    bool setProductField(Product& p, const std::string& key, const std::string& value, std::string& error) {
+        bool ok = true;
+        if (key == "name") p.name = value;
+        else if (key == "category_id") ok = parseId(value, p.category_id);
+        else if (key == "shelf_life_days") ok = parseInt(value, p.shelf_life_days) && p.shelf_life_days >= 0;
+        else if (key == "delivery_terms_id") ok = parseId(value, p.delivery_terms_id);
+        else if (key == "retail_price") ok = Money::parse(value, p.retail_price);
+        else if (key == "purchase_price") ok = Money::parse(value, p.purchase_price);
+        else {
+            error = "Неизвестное поле " + key;
+            return false;
+        }
+        if (!ok) error = "Неверное значение поля " + key;
+        return ok;
+    }
+
+    // Ответ на правку ассортимента, которую БД не применила
+    const char* notAppliedMessage(AssortmentChange kind) {
+        switch (kind) {
+            case AssortmentChange::Add: return "Товар уже в ассортименте или нет предприятия либо товара";
+            case AssortmentChange::SetPrice:
+            case AssortmentChange::Remove: return "Товара нет в ассортименте предприятия";
+        }
+        return "";
+    }
+}
+
+// ==========================================
+// Разбор команд
+// ==========================================
+
+const std::vector<std::string>& BatchScript::columns() {
+    static const std::vector<std::string> names = {"line", "command", "status", "id", "message"};
+    return names;
+}
+
+BatchScript::BatchScript(RegistryService& registry, ExportWriter& output, const BatchOptions& opts)
+    : service(registry), out(output), options(opts), pendingKind(AssortmentChange::Add) {
+    if (options.groupSize == 0) options.groupSize = 1;
+}
+
+bool BatchScript::tokenize(const std::string& text, Command& cmd, std::string& error) {
+    size_t i = 0;
+    auto skipSpaces = [&]() {
+        while (i < text.size() && (text[i] == ' ' || text[i] == '\t')) ++i;
+    };
+
+    skipSpaces();
+    size_t start = i;
+    while (i < text.size() && text[i] != ' ' && text[i] != '\t') ++i;
+    cmd.name = text.substr(start, i - start);
+
+    for (skipSpaces(); i < text.size(); skipSpaces()) {
+        start = i;
+        while (i < text.size() && text[i] != '=' && text[i] != ' ' && text[i] != '\t') ++i;
+        if (i >= text.size() || text[i] != '=' || i == start) {
+            error = "Ожидался аргумент вида поле=значение: " + text.substr(start, i - start);
+            return false;
+        }
+        std::string key = text.substr(start, i - start);
+        ++i;
+
+        std::string value;
+        if (i < text.size() && text[i] == '"') {
+            bool closed = false;
+            for (++i; i < text.size(); ++i) {
+                char c = text[i];
+                if (c == '"') {
+                    closed = true;
+                    ++i;
+                    break;
+                }
+                if (c == '\\' && i + 1 < text.size() && (text[i + 1] == '"' || text[i + 1] == '\\')) c = text[++i];
+                value += c;
+            }
+            if (!closed) {
+                error = "Не закрыта кавычка в значении поля " + key;
+                return false;
+            }
+            if (i < text.size() && text[i] != ' ' && text[i] != '\t') {
+                error = "После кавычки ожидался пробел: поле " + key;
+                return false;
+            }
+        } else {
+            start = i;
+            while (i < text.size() && text[i] != ' ' && text[i] != '\t') ++i;
+            value = text.substr(start, i - start);
+        }
+        for (const auto& arg : cmd.args) {
+            if (arg.first == key) {
+                error = "Поле " + key + " указано дважды";
+                return false;
+            }
+        }
+        cmd.args.emplace_back(std::move(key), std::move(value));
+    }
+    return true;
+}
+
+void BatchScript::result(long long line, const std::string& command, const char* status,
+                         long long id, const std::string& message) {
+    ++stats.commands;
+    if (std::string(status) == "ok") ++stats.succeeded;
+    else ++stats.failed;
+
+    out.beginRow();
+    out.field(line);
+    out.field(command);
+    out.field(std::string(status));
+    out.jsonField(id >= 0 ? std::to_string(id) : std::string());
+    out.field(message);
+    out.endRow();
+}
+
+// ==========================================
+// Выполнение
+// ==========================================
+
+bool BatchScript::execute(const Command& cmd) {
+    auto fail = [&](const std::string& message) {
+        result(cmd.line, cmd.name, "error", -1, message);
+        return false;
+    };
+    auto notFound = [&](const std::string& message) {
+        result(cmd.line, cmd.name, "not_found", -1, message);
+        return false;
+    };
+    auto done = [&](long long id) {
+        result(cmd.line, cmd.name, "ok", id, "");
+        return true;
+    };
+    // Обязательный аргумент id=; остальные аргументы — поля записи
+    auto takeId = [&](int& id, std::string& error) {
+        for (const auto& arg : cmd.args) {
+            if (arg.first == "id") {
+                if (parseId(arg.second, id)) return true;
+                error = "Неверный id: " + arg.second;
+                return false;
+            }
+        }
+        error = "Не указан id";
+        return false;
+    };
+
+    std::string error;
+    const std::string& name = cmd.name;
+
+    if (name == "add-enterprise" || name == "update-enterprise") {
+        bool update = name == "update-enterprise";
+        Enterprise e{0, "", 0, 0, "", "", "", ""};
+        if (update) {
+            int id;
+            if (!takeId(id, error)) return fail(error);
+            e = service.getEnterpriseById(id);
+            if (e.id == 0) return notFound("Предприятие " + std::to_string(id) + " не найдено");
+        }
+        for (const auto& arg : cmd.args) {
+            if (arg.first == "id" && update) continue;
+            if (!setEnterpriseField(e, arg.first, arg.second, error)) return fail(error);
+        }
+        if (e.name.empty() || e.legal_form_id == 0 || e.ownership_form_id == 0)
+            return fail("Нужны поля name, legal_form_id и ownership_form_id");
+        if (!update) {
+            int id = service.createEnterprise(e);
+            return id > 0 ? done(id) : fail("Предприятие не создано (см. stderr)");
+        }
+        return service.updateEnterprise(e) ? done(e.id) : fail("Предприятие не изменено (см. stderr)");
+    }
+
+    if (name == "add-product" || name == "update-product") {
+        bool update = name == "update-product";
+        Product p{0, 0, "", 0, 0, Money(), Money(), "", ""};
+        if (update) {
+            int id;
+            if (!takeId(id, error)) return fail(error);
+            p = service.getProductById(id);
+            if (p.id == 0) return notFound("Товар " + std::to_string(id) + " не найден");
+        }
+        for (const auto& arg : cmd.args) {
+            if (arg.first == "id" && update) continue;
+            if (!setProductField(p, arg.first, arg.second, error)) return fail(error);
+        }
+        if (p.name.empty() || p.category_id == 0 || p.delivery_terms_id == 0)
+            return fail("Нужны поля name, category_id и delivery_terms_id");
+        if (p.retail_price.isNegative() || p.purchase_price.isNegative())
+            return fail("Цена не может быть отрицательной");
+        if (!update) {
+            int id = service.createProduct(p);
+            return id > 0 ? done(id) : fail("Товар не создан (см. stderr)");
+        }
+        return service.updateProduct(p) ? done(p.id) : fail("Товар не изменён (см. stderr)");
+    }
+
+    if (name == "delete-enterprise" || name == "delete-product") {
+        int id;
+        if (!takeId(id, error)) return fail(error);
+        if (cmd.args.size() != 1) return fail("Лишние аргументы: нужен только id");
+        if (name == "delete-enterprise") {
+            if (service.getEnterpriseById(id).id == 0)
+                return notFound("Предприятие " + std::to_string(id) + " не найдено");
+            return service.deleteEnterprise(id) ? done(id) : fail("Предприятие не удалено (см. stderr)");
+        }
+        if (service.getProductById(id).id == 0) return notFound("Товар " + std::to_string(id) + " не найден");
+        return service.deleteProduct(id) ? done(id) : fail("Товар не удалён (см. stderr)");
+    }
+
+    if (name == "copy-assortment") {
+        int source = 0;
+        std::vector<int> targets;
+        double multiplier = 1.0;
+        bool overwrite = false;
+        for (const auto& arg : cmd.args) {
+            bool ok = true;
+            if (arg.first == "from") ok = parseId(arg.second, source);
+            else if (arg.first == "to") ok = parseIds(arg.second, targets);
+            else if (arg.first == "overwrite") ok = parseFlag(arg.second, overwrite);
+            else if (arg.first == "multiplier") {
+                char* end = nullptr;
+                multiplier = std::strtod(arg.second.c_str(), &end);
+                ok = !arg.second.empty() && *end == '\0' && multiplier > 0;
+            } else return fail("Неизвестный аргумент " + arg.first);
+            if (!ok) return fail("Неверное значение аргумента " + arg.first);
+        }
+        if (source == 0 || targets.empty()) return fail("Нужны аргументы from и to");
+        long copied = service.copyAssortment(source, targets, multiplier,
+            overwrite ? AssortmentConflictPolicy::Overwrite : AssortmentConflictPolicy::Skip);
+        return copied >= 0 ? done(copied) : fail("Ассортимент не скопирован (см. stderr)");
+    }
+
+    if (name == "refresh") {
+        if (!cmd.args.empty()) return fail("У команды refresh нет аргументов");
+        service.refreshCache();
+        return done(-1);
+    }
+
+    return fail("Неизвестная команда");
+}
+
+bool BatchScript::queueAssortment(const Command& cmd, AssortmentChange kind) {
+    EnterpriseProduct item{0, 0, Money()};
+    bool hasPrice = false;
+    for (const auto& arg : cmd.args) {
+        bool ok = true;
+        if (arg.first == "enterprise") ok = parseId(arg.second, item.enterprise_id);
+        else if (arg.first == "product") ok = parseId(arg.second, item.product_id);
+        else if (arg.first == "price" && kind != AssortmentChange::Remove) {
+            ok = Money::parse(arg.second, item.wholesale_price) && !item.wholesale_price.isNegative();
+            hasPrice = true;
+        } else {
+            result(cmd.line, cmd.name, "error", -1, "Неизвестный аргумент " + arg.first);
+            return false;
+        }
+        if (!ok) {
+            result(cmd.line, cmd.name, "error", -1, "Неверное значение аргумента " + arg.first);
+            return false;
+        }
+    }
+    if (item.enterprise_id == 0 || item.product_id == 0 || (kind != AssortmentChange::Remove && !hasPrice)) {
+        result(cmd.line, cmd.name, "error", -1,
+               kind == AssortmentChange::Remove ? "Нужны аргументы enterprise и product"
+                                                : "Нужны аргументы enterprise, product и price");
+        return false;
+    }
+
+    // Пакет выполняется одним оператором, поэтому правки одного вида и без
+    // повторов ключа: иначе порядок правок внутри пакета потерялся бы
+    if (!pending.empty() && (kind != pendingKind || pendingKeys.count(assortmentKey(item)))) {
+        if (!flushPending() && options.stopOnError) return false;
+    }
+    pendingKind = kind;
+    pendingKeys.insert(assortmentKey(item));
+    pending.push_back(Pending{cmd.line, cmd.name, item});
+    return pending.size() < options.groupSize || flushPending();
+}
+
+bool BatchScript::flushPending() {
+    if (pending.empty()) return true;
+
+    std::vector<EnterpriseProduct> items;
+    items.reserve(pending.size());
+    for (const auto& p : pending) items.push_back(p.item);
+
+    std::vector<bool> applied;
+    bool executed = service.applyAssortmentChanges(pendingKind, items, applied);
+    bool allApplied = executed;
+    for (size_t i = 0; i < pending.size(); ++i) {
+        if (!executed) {
+            result(pending[i].line, pending[i].name, "error", -1,
+                   "Пакет из " + std::to_string(pending.size()) + " правок отменён (см. stderr)");
+        } else if (applied[i]) {
+            result(pending[i].line, pending[i].name, "ok", 1, "");
+        } else {
+            result(pending[i].line, pending[i].name, "not_found", -1, notAppliedMessage(pendingKind));
+            allApplied = false;
+        }
+    }
+    pending.clear();
+    pendingKeys.clear();
+    return allApplied;
+}
+
+const BatchStats& BatchScript::run(int fd) {
+    LineReader reader(fd);
+    std::string text;
+    long long line = 0;
+
+    for (;;) {
+        // Отправитель ждёт ответов на уже переданное — не держим их до
+        // заполнения пакета
+        if (!reader.ready()) {
+            bool ok = flushPending();
+            out.flush();
+            if (!ok && options.stopOnError) break;
+        }
+        if (!reader.next(text)) break;
+        ++line;
+
+        size_t first = text.find_first_not_of(" \t");
+        if (first == std::string::npos || text[first] == '#') continue;
+
+        Command cmd;
+        cmd.line = line;
+        std::string error;
+        bool ok;
+        AssortmentChange kind;
+        bool parsed = tokenize(text, cmd, error);
+        if (parsed && isAssortmentCommand(cmd.name, kind)) {
+            ok = queueAssortment(cmd, kind);
+        } else {
+            // Прочие команды могут зависеть от уже поставленных в пакет правок
+            ok = flushPending();
+            if (ok || !options.stopOnError) {
+                if (parsed) ok = execute(cmd) && ok;
+                else {
+                    result(line, cmd.name, "error", -1, error);
+                    ok = false;
+                }
+            }
+        }
+        if (!ok && options.stopOnError) break;
+    }
+    flushPending();
+    out.flush();
+    return stats;
+}
\ No newline at end of file
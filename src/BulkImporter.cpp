@@ -0,0 +1,620 @@
+#include "BulkImporter.h"
+#include "CopyChannel.h"
+#include "Csv.h"
+#include "Gateways.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <future>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+    // Пакет сырых строк CSV вместе с номерами строк файла
+    struct Chunk {
+        std::vector<std::vector<std::string>> rows;
+        std::vector<size_t> lines;
+    };
+
+    // Ограниченная очередь пакетов: читатель ждёт, если рабочие не успевают,
+    // поэтому в памяти одновременно не больше capacity пакетов
+    class ChunkQueue {
+    private:
+        std::mutex mutex;
+        std::condition_variable notEmpty;
+        std::condition_variable notFull;
+        std::deque<Chunk> items;
+        size_t capacity;
+        bool closed = false;
+
+    public:
+        explicit ChunkQueue(size_t cap) : capacity(cap) {}
+
+        void push(Chunk&& chunk) {
+            std::unique_lock<std::mutex> lock(mutex);
+            notFull.wait(lock, [this] { return items.size() < capacity; });
+            items.push_back(std::move(chunk));
+            notEmpty.notify_one();
+        }
+
+        bool pop(Chunk& chunk) {
+            std::unique_lock<std::mutex> lock(mutex);
+            notEmpty.wait(lock, [this] { return !items.empty() || closed; });
+            if (items.empty()) return false;
+            chunk = std::move(items.front());
+            items.pop_front();
+            notFull.notify_one();
+            return true;
+        }
+
+        void close() {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+            notEmpty.notify_all();
+        }
+    };
+
+    std::string trim(const std::string& s) {
+        size_t b = s.find_first_not_of(" \t");
+        if (b == std::string::npos) return std::string();
+        size_t e = s.find_last_not_of(" \t");
+        return s.substr(b, e - b + 1);
+    }
+
+    std::string lowerAscii(std::string s) {
+        for (char& c : s) if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+        return s;
+    }
+
+    bool parseInt(const std::string& s, int& out) {
+        if (s.empty() || s.size() > 9) return false;
+        int v = 0;
+        for (char c : s) {
+            if (c < '0' || c > '9') return false;
+            v = v * 10 + (c - '0');
+        }
+        out = v;
+        return true;
+    }
+
+    // Справочник: поиск ID по названию или по самому ID, записанному числом
+    class DictionaryLookup {
+    private:
+        std::unordered_map<std::string, int> byName;
+        std::unordered_set<int> ids;
+
+    public:
+        explicit DictionaryLookup(const std::vector<DictionaryEntry>& entries) {
+            for (const auto& e : entries) {
+                byName[e.name] = e.id;
+                ids.insert(e.id);
+            }
+        }
+
+        bool resolve(const std::string& value, int& id) const {
+            auto it = byName.find(value);
+            if (it != byName.end()) { id = it->second; return true; }
+            return parseInt(value, id) && ids.count(id) > 0;
+        }
+    };
+
+    // Уникальные ключи (ИНН, названия товаров), уже встреченные в файле или существующие в БД
+    class KeySet {
+    private:
+        std::mutex mutex;
+        std::unordered_set<std::string> keys;
+
+    public:
+        void add(const std::string& key) {
+            std::lock_guard<std::mutex> lock(mutex);
+            keys.insert(key);
+        }
+
+        // true, если ключ новый (и теперь занят)
+        bool claim(const std::string& key) {
+            std::lock_guard<std::mutex> lock(mutex);
+            return keys.insert(key).second;
+        }
+    };
+
+    // Файл отказов: исходная строка + номер строки и причина
+    class RejectWriter {
+    private:
+        std::mutex mutex;
+        std::ofstream out;
+        char delimiter;
+
+    public:
+        RejectWriter(const std::string& path, char delim, const std::vector<std::string>& header)
+            : out(path, std::ios::binary | std::ios::trunc), delimiter(delim) {
+            std::vector<std::string> cols = {"line", "reason"};
+            cols.insert(cols.end(), header.begin(), header.end());
+            std::string line;
+            for (size_t i = 0; i < cols.size(); ++i) {
+                if (i > 0) line += delimiter;
+                appendCsvField(line, cols[i], delimiter);
+            }
+            line += '\n';
+            out << line;
+        }
+
+        bool isOpen() const { return out.is_open(); }
+
+        void write(size_t lineNo, const std::string& reason, const std::vector<std::string>& fields) {
+            std::string line = std::to_string(lineNo);
+            line += delimiter;
+            appendCsvField(line, reason, delimiter);
+            for (const auto& f : fields) {
+                line += delimiter;
+                appendCsvField(line, f, delimiter);
+            }
+            line += '\n';
+            std::lock_guard<std::mutex> lock(mutex);
+            out << line;
+        }
+    };
+
+    struct Counters {
+        std::atomic<long long> loaded{0};
+        std::atomic<long long> skipped{0};
+        std::atomic<long long> rejected{0};
+        std::atomic<long long> viaCopy{0};
+        std::atomic<long long> viaInsert{0};
+        std::atomic<bool> failed{false};
+    };
+
+    // Индексы колонок во входном файле по их названиям в заголовке
+    struct Columns {
+        std::unordered_map<std::string, size_t> index;
+
+        bool has(const std::string& name) const { return index.count(name) > 0; }
+
+        const std::string& get(const std::vector<std::string>& row, const std::string& name) const {
+            static const std::string empty;
+            size_t i = index.at(name);
+            return i < row.size() ? row[i] : empty;
+        }
+    };
+
+    // Загрузка пакета через ODBC: сначала целиком в одной транзакции; если сервер
+    // его отверг — построчно, чтобы отбраковать только действительно плохие строки.
+    template <class Entity, class InsertFn>
+    void loadBatch(TaskExecutor::TaskContext& task, std::vector<Entity>& batch, std::vector<size_t>& lines,
+                   std::vector<std::vector<std::string>*>& sources,
+                   InsertFn insert, RejectWriter& rejects, Counters& counters) {
+        if (batch.empty()) return;
+
+        DatabaseConnection* conn = task.connection();
+        if (!conn) {
+            counters.failed = true;
+            return;
+        }
+
+        ++counters.viaInsert;
+        conn->beginTransaction();
+        long affected = insert(conn, batch);
+        if (affected >= 0 && conn->commit()) {
+            counters.loaded += affected;
+            counters.skipped += static_cast<long long>(batch.size()) - affected;
+            return;
+        }
+        conn->rollback();
+
+        for (size_t i = 0; i < batch.size(); ++i) {
+            std::vector<Entity> single(1, batch[i]);
+            long one = insert(conn, single);
+            if (one < 0) {
+                rejects.write(lines[i], "ошибка БД при вставке", *sources[i]);
+                ++counters.rejected;
+            } else {
+                counters.loaded += one;
+                counters.skipped += 1 - one;
+            }
+        }
+    }
+
+    // Загрузка сущности через COPY. Если нужен ON CONFLICT, строки копируются
+    // во временную таблицу (её содержимое очищается при COMMIT), а оттуда
+    // переносятся одним INSERT ... SELECT.
+    struct CopyPlan {
+        std::string prepareSql;  // Выполняется один раз после открытия канала
+        std::string copySql;     // COPY ... FROM STDIN
+        std::string mergeSql;    // Пусто — COPY сразу в целевую таблицу
+    };
+
+    // Канал COPY рабочего потока открывается при первом пакете. Если открыть его
+    // не удалось, поток до конца импорта грузит пакеты через ODBC.
+    struct CopyLoader {
+        CopyChannel channel;
+        bool disabled = false;
+    };
+
+    // Возвращает false, если пакет не загружен и его нужно загрузить через ODBC
+    template <class Entity, class RowFn>
+    bool copyBatch(CopyLoader& loader, const std::string& conninfo, const CopyPlan& plan,
+                   const std::vector<Entity>& batch, RowFn writeRow, Counters& counters) {
+        if (batch.empty() || loader.disabled || conninfo.empty()) return false;
+
+        CopyChannel& ch = loader.channel;
+        if (!ch.isOpen()) {
+            if (!ch.open(conninfo) || (!plan.prepareSql.empty() && !ch.execute(plan.prepareSql))) {
+                std::cerr << "COPY недоступен, загрузка через INSERT: " << ch.lastError() << std::endl;
+                ch.close();
+                loader.disabled = true;
+                return false;
+            }
+        }
+
+        long long affected = 0;
+        bool ok = ch.execute("BEGIN") && ch.beginCopyIn(plan.copySql);
+        if (ok) {
+            bool rowsOk = true;
+            for (const Entity& item : batch) {
+                ch.beginRow();
+                writeRow(ch, item);
+                if (!ch.endRow()) { rowsOk = false; break; }
+            }
+            ok = ch.endCopyIn(&affected) && rowsOk;
+        }
+        if (ok && !plan.mergeSql.empty()) ok = ch.execute(plan.mergeSql, &affected);
+        if (ok) ok = ch.execute("COMMIT");
+
+        if (!ok) {
+            std::cerr << "Ошибка COPY, пакет будет загружен через INSERT: " << ch.lastError() << std::endl;
+            if (!ch.execute("ROLLBACK")) {
+                ch.close();
+                loader.disabled = true;
+            }
+            return false;
+        }
+
+        ++counters.viaCopy;
+        counters.loaded += affected;
+        counters.skipped += static_cast<long long>(batch.size()) - affected;
+        return true;
+    }
+
+    // Общее для загрузчиков: очередь, файл отказов, счётчики и план COPY
+    struct WorkerContext {
+        ChunkQueue& queue;
+        RejectWriter& rejects;
+        Counters& counters;
+        const std::string& conninfo;
+        const CopyPlan& plan;
+    };
+
+    // Загрузчик (задача пула до закрытия очереди): parse проверяет строку CSV
+    // и заполняет сущность (возвращает причину отказа или nullptr), затем пакет
+    // грузится через COPY или insert.
+    template <class Entity, class ParseFn, class InsertFn, class CopyRowFn>
+    void runWorker(WorkerContext& ctx, TaskExecutor::TaskContext& task, ParseFn parse, InsertFn insert,
+                   CopyRowFn copyRow) {
+        CopyLoader loader;
+        Chunk chunk;
+        while (ctx.queue.pop(chunk)) {
+            std::vector<Entity> batch;
+            std::vector<size_t> lines;
+            std::vector<std::vector<std::string>*> sources;
+            batch.reserve(chunk.rows.size());
+
+            for (size_t i = 0; i < chunk.rows.size(); ++i) {
+                auto& row = chunk.rows[i];
+                Entity item{};
+                const char* reason = parse(row, item);
+                if (reason) {
+                    ctx.rejects.write(chunk.lines[i], reason, row);
+                    ++ctx.counters.rejected;
+                    continue;
+                }
+                batch.push_back(std::move(item));
+                lines.push_back(chunk.lines[i]);
+                sources.push_back(&row);
+            }
+
+            if (!copyBatch(loader, ctx.conninfo, ctx.plan, batch, copyRow, ctx.counters)) {
+                loadBatch(task, batch, lines, sources, insert, ctx.rejects, ctx.counters);
+            }
+        }
+    }
+
+    CopyPlan makeCopyPlan(ImportEntity entity, bool upsert) {
+        CopyPlan plan;
+        switch (entity) {
+            case ImportEntity::Enterprises:
+                plan.prepareSql =
+                    "CREATE TEMP TABLE import_enterprise (name TEXT, legal_form_id INT, ownership_form_id INT, "
+                    "postal_address TEXT, inn TEXT) ON COMMIT DELETE ROWS";
+                plan.copySql = "COPY import_enterprise (name, legal_form_id, ownership_form_id, postal_address, inn) FROM STDIN";
+                plan.mergeSql =
+                    "INSERT INTO enterprise (name, legal_form_id, ownership_form_id, postal_address, inn) "
+                    "SELECT name, legal_form_id, ownership_form_id, postal_address, inn FROM import_enterprise "
+                    "ON CONFLICT (inn) DO ";
+                plan.mergeSql += upsert
+                    ? "UPDATE SET name = EXCLUDED.name, legal_form_id = EXCLUDED.legal_form_id, "
+                      "ownership_form_id = EXCLUDED.ownership_form_id, postal_address = EXCLUDED.postal_address"
+                    : "NOTHING";
+                break;
+            case ImportEntity::Products:
+                // Уникального ключа у товаров нет, дубликаты отсекаются при разборе — COPY прямо в таблицу
+                plan.copySql =
+                    "COPY product (category_id, name, shelf_life_days, delivery_terms_id, retail_price, purchase_price) FROM STDIN";
+                break;
+            case ImportEntity::Assortment:
+                plan.prepareSql =
+                    "CREATE TEMP TABLE import_assortment (enterprise_id INT, product_id INT, wholesale_price NUMERIC) "
+                    "ON COMMIT DELETE ROWS";
+                plan.copySql = "COPY import_assortment (enterprise_id, product_id, wholesale_price) FROM STDIN";
+                plan.mergeSql =
+                    "INSERT INTO enterprise_product (enterprise_id, product_id, wholesale_price) "
+                    "SELECT enterprise_id, product_id, wholesale_price FROM import_assortment "
+                    "ON CONFLICT (enterprise_id, product_id) DO ";
+                plan.mergeSql += upsert ? "UPDATE SET wholesale_price = EXCLUDED.wholesale_price" : "NOTHING";
+                break;
+        }
+        return plan;
+    }
+}
+
+bool isValidInn(const std::string& inn) {
+    if (inn.size() != 10 && inn.size() != 12) return false;
+    int d[12];
+    for (size_t i = 0; i < inn.size(); ++i) {
+        if (inn[i] < '0' || inn[i] > '9') return false;
+        d[i] = inn[i] - '0';
+    }
+
+    auto checksum = [&d](const int* weights, int count) {
+        int sum = 0;
+        for (int i = 0; i < count; ++i) sum += weights[i] * d[i];
+        return sum % 11 % 10;
+    };
+
+    if (inn.size() == 10) {
+        static const int w10[] = {2, 4, 10, 3, 5, 9, 4, 6, 8};
+        return checksum(w10, 9) == d[9];
+    }
+    static const int w11[] = {7, 2, 4, 10, 3, 5, 9, 4, 6, 8};
+    static const int w12[] = {3, 7, 2, 4, 10, 3, 5, 9, 4, 6, 8};
+    return checksum(w11, 10) == d[10] && checksum(w12, 11) == d[11];
+}
+
+ImportResult BulkImporter::run(ImportEntity entity, const std::string& path) {
+    ImportResult result;
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::cerr << "Ошибка: Не удалось открыть файл " << path << std::endl;
+        return result;
+    }
+
+    CsvReader reader(in, options.delimiter);
+    std::vector<std::string> header;
+    if (!reader.next(header)) {
+        std::cerr << "Ошибка: Файл пуст." << std::endl;
+        return result;
+    }
+
+    Columns columns;
+    for (size_t i = 0; i < header.size(); ++i) columns.index[lowerAscii(trim(header[i]))] = i;
+
+    std::vector<std::string> required;
+    switch (entity) {
+        case ImportEntity::Enterprises:
+            required = {"name", "legal_form", "ownership_form", "postal_address", "inn"};
+            break;
+        case ImportEntity::Products:
+            required = {"name", "category", "shelf_life_days", "delivery_terms", "retail_price", "purchase_price"};
+            break;
+        case ImportEntity::Assortment:
+            required = {"inn", "product", "wholesale_price"};
+            break;
+    }
+    for (const auto& col : required) {
+        if (!columns.has(col)) {
+            std::cerr << "Ошибка: В заголовке нет обязательной колонки \"" << col << "\"." << std::endl;
+            return result;
+        }
+    }
+
+    std::string rejectPath = options.rejectPath.empty() ? path + ".rejects.csv" : options.rejectPath;
+    RejectWriter rejects(rejectPath, options.delimiter, header);
+    if (!rejects.isOpen()) {
+        std::cerr << "Ошибка: Не удалось создать файл отказов " << rejectPath << std::endl;
+        return result;
+    }
+
+    // Существующие товары и ИНН берутся из копии индексов кэша сервиса, если он был загружен
+    const bool useProductCache = existing.hasProducts;
+    const bool useEnterpriseCache = existing.hasEnterprises;
+
+    // Справочники и существующие ключи загружаются один раз до старта загрузчиков.
+    // Для ассортимента вместо справочников — товары (название/ID) и ИНН предприятий.
+    std::vector<DictionaryEntry> dictA, dictB;
+    std::unordered_map<std::string, int> enterpriseByInn;
+    KeySet seenKeys;
+    auto preload = executor.submit([&](TaskExecutor::TaskContext& task) {
+        DatabaseConnection* conn = task.connection();
+        if (!conn) return false;
+        DictionaryGateway dictionaries(conn);
+        if (entity == ImportEntity::Enterprises) {
+            dictA = dictionaries.findAll(Dictionary::LegalForm);
+            dictB = dictionaries.findAll(Dictionary::OwnershipForm);
+        } else if (entity == ImportEntity::Products) {
+            dictA = dictionaries.findAll(Dictionary::ProductCategory);
+            dictB = dictionaries.findAll(Dictionary::DeliveryTerms);
+            // У товаров нет уникального ограничения в схеме — дубликаты по названию
+            // отсекаем сами, как это делает RegistryService::createProduct
+            if (!useProductCache) {
+                ProductGateway products(conn);
+                for (const auto& name : products.findAllNames()) seenKeys.add(name);
+            }
+        } else if (!useProductCache || !useEnterpriseCache) {
+            ProductGateway(conn).streamAll([&dictA](const Product& p) {
+                dictA.push_back({p.id, p.name});
+                return true;
+            });
+            EnterpriseGateway(conn).streamAll([&enterpriseByInn](const Enterprise& e) {
+                enterpriseByInn[e.inn] = e.id;
+                return true;
+            });
+        }
+        return true;
+    });
+    if (!executor.await(preload)) return result;
+    const DictionaryLookup lookupA(dictA);
+    const DictionaryLookup lookupB(dictB);
+
+    // Загрузчиков больше, чем потоков пула, не бывает: лишние ждали бы в очереди
+    size_t workers = executor.workerCount();
+    if (options.workers != 0) workers = std::min<size_t>(options.workers, workers);
+    size_t batchSize = std::max<size_t>(1, options.batchSize);
+
+    ChunkQueue queue(workers * 2);
+    Counters counters;
+    const bool upsert = options.upsert;
+    const CopyPlan plan = makeCopyPlan(entity, upsert);
+    WorkerContext ctx{queue, rejects, counters, copyConninfo, plan};
+
+    auto parseEnterprise = [&](const std::vector<std::string>& row, Enterprise& e) -> const char* {
+        e.name = trim(columns.get(row, "name"));
+        e.postal_address = trim(columns.get(row, "postal_address"));
+        e.inn = trim(columns.get(row, "inn"));
+
+        if (e.name.empty()) return "не указано название";
+        if (e.postal_address.empty()) return "не указан адрес";
+        if (!isValidInn(e.inn)) return "неверный ИНН";
+        if (!lookupA.resolve(trim(columns.get(row, "legal_form")), e.legal_form_id)) return "неизвестная ОПФ";
+        if (!lookupB.resolve(trim(columns.get(row, "ownership_form")), e.ownership_form_id)) return "неизвестная форма собственности";
+        if (!seenKeys.claim(e.inn)) return "повтор ИНН в файле";
+        return nullptr;
+    };
+
+    auto parseProduct = [&](const std::vector<std::string>& row, Product& p) -> const char* {
+        p.name = trim(columns.get(row, "name"));
+
+        if (p.name.empty()) return "не указано название";
+        if (!parseInt(trim(columns.get(row, "shelf_life_days")), p.shelf_life_days)) return "неверный срок реализации";
+        if (!Money::parse(columns.get(row, "retail_price"), p.retail_price) || p.retail_price.isNegative()) return "неверная розничная цена";
+        if (!Money::parse(columns.get(row, "purchase_price"), p.purchase_price) || p.purchase_price.isNegative()) return "неверная закупочная цена";
+        if (!lookupA.resolve(trim(columns.get(row, "category")), p.category_id)) return "неизвестная категория";
+        if (!lookupB.resolve(trim(columns.get(row, "delivery_terms")), p.delivery_terms_id)) return "неизвестные условия поставки";
+        if (useProductCache && existing.productIdByName.count(p.name) != 0) return "товар с таким названием уже есть";
+        if (!seenKeys.claim(p.name)) return "товар с таким названием уже есть";
+        return nullptr;
+    };
+
+    auto resolveEnterprise = [&](const std::string& inn, int& id) {
+        const auto& index = useEnterpriseCache ? existing.enterpriseIdByInn : enterpriseByInn;
+        auto it = index.find(inn);
+        if (it == index.end()) return false;
+        id = it->second;
+        return true;
+    };
+
+    // Товар указывается названием или ID
+    auto resolveProduct = [&](const std::string& value, int& id) {
+        if (!useProductCache) return lookupA.resolve(value, id);
+        auto it = existing.productIdByName.find(value);
+        if (it != existing.productIdByName.end()) {
+            id = it->second;
+            return true;
+        }
+        return parseInt(value, id) && existing.productIds.count(id) != 0;
+    };
+
+    auto parseAssortment = [&](const std::vector<std::string>& row, EnterpriseProduct& ep) -> const char* {
+        if (!resolveEnterprise(trim(columns.get(row, "inn")), ep.enterprise_id)) return "предприятие с таким ИНН не найдено";
+        if (!resolveProduct(trim(columns.get(row, "product")), ep.product_id)) return "товар не найден";
+        if (!Money::parse(columns.get(row, "wholesale_price"), ep.wholesale_price) || ep.wholesale_price.isNegative()) return "неверная оптовая цена";
+        // В одном INSERT ... ON CONFLICT DO UPDATE пара не может встретиться дважды
+        if (!seenKeys.claim(std::to_string(ep.enterprise_id) + ":" + std::to_string(ep.product_id))) return "повтор позиции в файле";
+        return nullptr;
+    };
+
+    auto enterpriseWorker = [&](TaskExecutor::TaskContext& task) {
+        runWorker<Enterprise>(ctx, task, parseEnterprise,
+            [upsert](DatabaseConnection* db, const std::vector<Enterprise>& b) {
+                return EnterpriseGateway(db).insertBatch(b, upsert);
+            },
+            [](CopyChannel& ch, const Enterprise& e) {
+                ch.field(e.name);
+                ch.field(e.legal_form_id);
+                ch.field(e.ownership_form_id);
+                ch.field(e.postal_address);
+                ch.field(e.inn);
+            });
+    };
+
+    auto productWorker = [&](TaskExecutor::TaskContext& task) {
+        runWorker<Product>(ctx, task, parseProduct,
+            [](DatabaseConnection* db, const std::vector<Product>& b) {
+                return ProductGateway(db).insertBatch(b);
+            },
+            [](CopyChannel& ch, const Product& p) {
+                ch.field(p.category_id);
+                ch.field(p.name);
+                ch.field(p.shelf_life_days);
+                ch.field(p.delivery_terms_id);
+                ch.field(p.retail_price);
+                ch.field(p.purchase_price);
+            });
+    };
+
+    auto assortmentWorker = [&](TaskExecutor::TaskContext& task) {
+        runWorker<EnterpriseProduct>(ctx, task, parseAssortment,
+            [upsert](DatabaseConnection* db, const std::vector<EnterpriseProduct>& b) {
+                return EnterpriseProductGateway(db).insertBatch(b, upsert);
+            },
+            [](CopyChannel& ch, const EnterpriseProduct& ep) {
+                ch.field(ep.enterprise_id);
+                ch.field(ep.product_id);
+                ch.field(ep.wholesale_price);
+            });
+    };
+
+    std::vector<std::future<void>> loaders;
+    for (size_t i = 0; i < workers; ++i) {
+        switch (entity) {
+            case ImportEntity::Enterprises: loaders.push_back(executor.submit(enterpriseWorker)); break;
+            case ImportEntity::Products:    loaders.push_back(executor.submit(productWorker)); break;
+            case ImportEntity::Assortment:  loaders.push_back(executor.submit(assortmentWorker)); break;
+        }
+    }
+
+    // Чтение и нарезка на пакеты идут в текущем потоке параллельно с загрузкой
+    Chunk chunk;
+    std::vector<std::string> fields;
+    while (!counters.failed && reader.next(fields)) {
+        ++result.rowsRead;
+        chunk.rows.push_back(std::move(fields));
+        chunk.lines.push_back(reader.lineNumber());
+        if (chunk.rows.size() >= batchSize) {
+            queue.push(std::move(chunk));
+            chunk = Chunk();
+        }
+    }
+    if (!chunk.rows.empty()) queue.push(std::move(chunk));
+    queue.close();
+
+    for (auto& f : loaders) {
+        try {
+            f.get();
+        } catch (const std::exception& e) {
+            std::cerr << "Сбой загрузчика импорта: " << e.what() << std::endl;
+            counters.failed = true;
+        }
+    }
+
+    result.rowsLoaded = counters.loaded;
+    result.rowsSkipped = counters.skipped;
+    result.rowsRejected = counters.rejected;
+    result.batchesViaCopy = counters.viaCopy;
+    result.batchesViaInsert = counters.viaInsert;
+    result.success = !counters.failed;
+    return result;
+}
\ No newline at end of file
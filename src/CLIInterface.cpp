@@ -1,71 +1,80 @@
 #include "CLIInterface.h"
+#include "BatchScript.h"
+#include "PageCache.h"
+#include "RegistryClient.h"
+#include "RpcServer.h"
+#include "TableStream.h"
+#include "Utf8.h"
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
+#include <charconv>
+#include <cstdio>
 #include <limits>
 #include <sstream>
+#include <fstream>
+#include <unordered_map>
+#include <cstdlib>
+#include <ctime>
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
 
 // ==========================================
-// Вспомогательные функции для UTF-8 (оставлены как были)
+// Вспомогательные функции вывода таблиц
 // ==========================================
 
-size_t utf8_char_count(const std::string& str) {
-    size_t count = 0;
-    for (size_t i = 0; i < str.size(); ++i) {
-        unsigned char c = str[i];
-        if (c < 0x80) count++;
-        else if (c >= 0xC0) count++;
-    }
-    return count;
+void append_number(std::string& out, long long value) {
+    char digits[24];
+    auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+    out.append(digits, end);
 }
 
-std::string truncate_to_visual_width(const std::string& s, size_t maxChars) {
-    if (s.empty()) return std::string(maxChars, ' ');
+// Выводит буфер в stdout одним вызовом write (повторяя его только при
+// частичной записи). Вывод, накопленный до этого в std::cout, уходит первым.
+void write_stdout(const std::string& data) {
+    std::cout.flush();
+    std::fflush(stdout);
+    TableStream::writeAll(STDOUT_FILENO, data.data(), data.size());
+}
 
-    std::string result;
-    size_t charCount = 0;
-    for (size_t i = 0; i < s.size() && charCount < maxChars; ) {
-        unsigned char c = s[i];
-        if (c < 0x80) { // ASCII
-            result += c;
-            ++charCount;
-            ++i;
-        } else if (c < 0xC0) { // Неверный UTF-8
-            ++i;
-        } else if (c < 0xE0) { // 2-байтный
-            if (i + 1 >= s.size()) break;
-            result += c; result += s[i + 1];
-            ++charCount; i += 2;
-        } else if (c < 0xF0) { // 3-байтный
-            if (i + 2 >= s.size()) break;
-            result += c; result += s[i + 1]; result += s[i + 2];
-            ++charCount; i += 3;
-        } else { // 4-байтный
-            ++charCount; i += 4;
-            if (i > s.size()) i = s.size();
-        }
-    }
+// Позиция журнала изменений в командной строке: "txid:seq"
+std::string cursor_text(const ChangeCursor& cursor) {
+    return std::to_string(cursor.txid) + ":" + std::to_string(cursor.seq);
+}
 
-    while (charCount < maxChars) {
-        result += ' ';
-        ++charCount;
-    }
+bool parse_cursor(const std::string& text, ChangeCursor& cursor) {
+    char* end = nullptr;
+    long long txid = std::strtoll(text.c_str(), &end, 10);
+    if (end == text.c_str() || *end != ':' || txid < 0) return false;
+    const char* seqText = end + 1;
+    long long seq = std::strtoll(seqText, &end, 10);
+    if (end == seqText || *end != '\0' || seq < 0) return false;
+    cursor.txid = txid;
+    cursor.seq = seq;
+    return true;
+}
 
-    if (charCount == maxChars && utf8_char_count(s) > maxChars && maxChars >= 3) {
-        size_t pos = result.size();
-        int removed = 0;
-        while (pos > 0 && removed < 3) {
-            unsigned char c = result[pos - 1];
-            if (c < 0x80 || c >= 0xC0) removed++;
-            pos--;
-        }
-        result.resize(pos);
-        result += "...";
-        while (utf8_char_count(result) < maxChars) result += ' ';
-    }
-    return result;
+// Оптовая цена позиции ассортимента; не указанная — прочерк
+std::string wholesale_text(const AssortmentLine& line) {
+    return line.has_wholesale_price ? line.wholesale_price.toString() : "-";
 }
 
+// Процент с одним знаком после запятой: "12.5%"
+std::string percent_text(double value) {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(1) << value * 100 << "%";
+    return oss.str();
+}
+
+// Неинтерактивные команды (определены ниже). Registry — RegistryService
+// (работа с БД в этом процессе) или RegistryClient (те же операции выполняет
+// демон): нужные командам методы у них одноимённые.
+template <class Registry> int command_import(Registry& service, const std::vector<std::string>& args);
+template <class Registry> int command_export(Registry& service, const std::vector<std::string>& args);
+template <class Registry> int command_offers(Registry& service, const std::vector<std::string>& args);
+template <class Registry> int command_changes(Registry& service, const std::vector<std::string>& args);
+
 // ==========================================
 // Реализация CLIInterface
 // ==========================================
@@ -80,7 +89,10 @@ void CLIInterface::run() {
         std::cerr << "Критическая ошибка: Сервис данных недоступен." << std::endl;
         return;
     }
+    menuLoop();
+}
 
+void CLIInterface::menuLoop() {
     while (true) {
         showMainMenu();
         int choice = getIntegerInput("Выберите действие: ");
@@ -90,19 +102,472 @@ void CLIInterface::run() {
             case 3: manageAssortment(); break;
             case 4: manageSalesDepartments(); break;
             case 5: manageBankDetails(); break;
+            case 6: manageReports(); break;
             case 0: std::cout << "Выход из программы." << std::endl; return;
             default: std::cout << "Неверный выбор. Попробуйте снова." << std::endl;
         }
     }
 }
 
+int CLIInterface::runCommand(const std::vector<std::string>& args) {
+    if (args.empty() || args[0] == "help" || args[0] == "--help") {
+        std::cout << "Использование:\n"
+                  << "  RegEnterprise                      интерактивный режим\n"
+                  << "  RegEnterprise --snapshot <файл>    интерактивный режим только для чтения по снимку (без БД)\n"
+                  << "  RegEnterprise snapshot <файл>      сохранить снимок реестра\n"
+                  << "  RegEnterprise import <enterprises|products|assortment> <файл.csv> [параметры]\n"
+                  << "      assortment: колонки inn, product (название или ID), wholesale_price\n"
+                  << "      --reject <файл>     файл отбракованных строк (по умолчанию <файл.csv>.rejects.csv)\n"
+                  << "      --delimiter <c>     разделитель полей (по умолчанию ',')\n"
+                  << "      --batch <N>         строк в пакете (по умолчанию 5000)\n"
+                  << "      --workers <N>       параллельных загрузчиков (по умолчанию по числу ядер)\n"
+                  << "      --upsert            обновлять существующие записи (предприятия по ИНН, цены ассортимента)\n"
+                  << "      --no-copy           не использовать COPY, только пакетные INSERT\n"
+                  << "  RegEnterprise export <набор|all> <файл|каталог|-> [параметры]\n"
+                  << "      наборы: enterprises, products, assortment, sales-departments, bank-details,\n"
+                  << "      deleted (удаления; в all входит только с --since)\n"
+                  << "      отметка для следующего --since выводится в stderr (watermark: ...)\n"
+                  << "      --since <время>     только строки, изменённые с этого момента (ISO 8601)\n"
+                  << "      --format <csv|jsonl> формат (по умолчанию csv)\n"
+                  << "      --gzip              сжимать выгрузку gzip\n"
+                  << "      --no-copy           CSV: читать через ODBC, а не COPY\n"
+                  << "  RegEnterprise offers <файл|-> [параметры]\n"
+                  << "      предложения товаров по возрастанию оптовой цены; файл — ID товаров\n"
+                  << "      через пробел, запятую или с новой строки\n"
+                  << "      --top <N>           предложений на товар (по умолчанию все)\n"
+                  << "      --format <csv|jsonl> формат вывода в stdout (по умолчанию csv)\n"
+                  << "  RegEnterprise changes head        текущая позиция журнала изменений\n"
+                  << "  RegEnterprise changes <файл|-> [параметры]\n"
+                  << "      изменения реестра после позиции; новая позиция выводится в stderr\n"
+                  << "      --since <позиция>   позиция вида txid:seq (по умолчанию с начала журнала)\n"
+                  << "      --limit <N>         не более N изменений\n"
+                  << "      --format <csv|jsonl> формат (по умолчанию jsonl)\n"
+                  << "      --gzip              сжимать выгрузку gzip\n"
+                  << "  RegEnterprise batch <сценарий|-> [параметры]\n"
+                  << "      команды правок по одной на строку (add-enterprise, set-price, delete-product...);\n"
+                  << "      на каждую — строка результата в stdout: line, command, status, id, message\n"
+                  << "      --format <csv|jsonl> формат результатов (по умолчанию jsonl)\n"
+                  << "      --output <файл>     результаты в файл, а не в stdout\n"
+                  << "      --group <N>         правок ассортимента в одной транзакции (по умолчанию 1000)\n"
+                  << "      --stop-on-error     остановиться после первой неудачной команды\n"
+                  << "  RegEnterprise daemon [параметры]   держать сервис запущенным и принимать команды по сокету\n"
+                  << "      --socket <путь>     сокет (по умолчанию $REGENT_SOCKET или /tmp/RegEnterprise.sock)\n"
+                  << "      --workers <N>       соединений с БД (по умолчанию по числу ядер)\n"
+                  << "      --snapshot <файл>   обслуживать чтение из снимка, без БД\n"
+                  << "  RegEnterprise --socket <путь|-> <import|export|offers|changes> ...\n"
+                  << "      выполнить команду запущенным демоном (\"-\" — сокет по умолчанию);\n"
+                  << "      файлы читает и пишет демон, поэтому вывод в stdout (\"-\") недоступен\n";
+        return args.empty() ? 1 : 0;
+    }
+
+    // Режим только для чтения: БД не нужна, сервис читает отображённый в память снимок
+    if (args[0] == "--snapshot") {
+        if (args.size() < 2) {
+            std::cerr << "Использование: --snapshot <файл>" << std::endl;
+            return 1;
+        }
+        if (!service.initializeFromSnapshot(args[1])) return 1;
+        std::time_t created = static_cast<std::time_t>(service.snapshotCreatedAt());
+        char when[32];
+        std::strftime(when, sizeof(when), "%Y-%m-%d %H:%M", std::localtime(&created));
+        std::cout << "Открыт снимок реестра от " << when << " (только чтение)." << std::endl;
+        menuLoop();
+        return 0;
+    }
+
+    // Демон и клиент демона инициализируют сервис сами (или не используют его)
+    if (args[0] == "daemon") return commandDaemon(std::vector<std::string>(args.begin() + 1, args.end()));
+    if (args[0] == "--socket") return commandRemote(args);
+
+    // Сообщения инициализации уводим в stderr: stdout подкоманды может быть потоком данных
+    std::streambuf* stdoutBuf = std::cout.rdbuf(std::cerr.rdbuf());
+    bool ready = service.initialize();
+    std::cout.rdbuf(stdoutBuf);
+    if (!ready) {
+        std::cerr << "Критическая ошибка: Сервис данных недоступен." << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> rest(args.begin() + 1, args.end());
+    if (args[0] == "import") return command_import(service, rest);
+    if (args[0] == "export") return command_export(service, rest);
+    if (args[0] == "snapshot") return commandSnapshot(rest);
+    if (args[0] == "batch") return commandBatch(rest);
+    if (args[0] == "offers") return command_offers(service, rest);
+    if (args[0] == "changes") return command_changes(service, rest);
+
+    std::cerr << "Неизвестная команда: " << args[0] << " (см. RegEnterprise help)" << std::endl;
+    return 1;
+}
+
+// Останавливает демон по SIGINT/SIGTERM
+static RpcServer* runningDaemon = nullptr;
+
+static void stop_daemon(int) {
+    if (runningDaemon) runningDaemon->stop();
+}
+
+int CLIInterface::commandDaemon(const std::vector<std::string>& args) {
+    std::string socketPath = RegistryClient::defaultSocketPath();
+    std::string snapshotPath;
+    size_t connections = 0;
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& opt = args[i];
+        bool hasValue = i + 1 < args.size();
+        if (opt == "--socket" && hasValue) socketPath = args[++i];
+        else if (opt == "--workers" && hasValue) connections = std::stoul(args[++i]);
+        else if (opt == "--snapshot" && hasValue) snapshotPath = args[++i];
+        else {
+            std::cerr << "Неизвестный параметр: " << opt << std::endl;
+            return 1;
+        }
+    }
+
+    bool ready = snapshotPath.empty() ? service.initialize(connections)
+                                      : service.initializeFromSnapshot(snapshotPath);
+    if (!ready) {
+        std::cerr << "Критическая ошибка: Сервис данных недоступен." << std::endl;
+        return 1;
+    }
+
+    RpcServer server(service);
+    if (!server.listen(socketPath)) return 1;
+    runningDaemon = &server;
+    std::signal(SIGINT, stop_daemon);
+    std::signal(SIGTERM, stop_daemon);
+    std::cout << "Демон реестра ожидает команд на " << socketPath
+              << (service.isReadOnly() ? " (снимок, только чтение)" : "") << std::endl;
+    server.run();
+    runningDaemon = nullptr;
+    std::cout << "Демон остановлен." << std::endl;
+    return 0;
+}
+
+int CLIInterface::commandRemote(const std::vector<std::string>& args) {
+    if (args.size() < 3) {
+        std::cerr << "Использование: --socket <путь|-> <import|export|offers|changes> ..." << std::endl;
+        return 1;
+    }
+    RegistryClient client;
+    if (!client.connect(args[1] == "-" ? RegistryClient::defaultSocketPath() : args[1])) return 1;
+
+    std::vector<std::string> rest(args.begin() + 3, args.end());
+    if (args[2] == "import") return command_import(client, rest);
+    if (args[2] == "export") return command_export(client, rest);
+    if (args[2] == "offers") return command_offers(client, rest);
+    if (args[2] == "changes") return command_changes(client, rest);
+
+    std::cerr << "Команда " << args[2] << " через демон не выполняется (см. RegEnterprise help)" << std::endl;
+    return 1;
+}
+
+template <class Registry>
+int command_import(Registry& service, const std::vector<std::string>& args) {
+    if (args.size() < 2) {
+        std::cerr << "Использование: import <enterprises|products|assortment> <файл.csv> [параметры]" << std::endl;
+        return 1;
+    }
+
+    ImportEntity entity;
+    if (args[0] == "enterprises") entity = ImportEntity::Enterprises;
+    else if (args[0] == "products") entity = ImportEntity::Products;
+    else if (args[0] == "assortment") entity = ImportEntity::Assortment;
+    else {
+        std::cerr << "Неизвестный тип данных: " << args[0] << std::endl;
+        return 1;
+    }
+
+    ImportOptions options;
+    for (size_t i = 2; i < args.size(); ++i) {
+        const std::string& opt = args[i];
+        bool hasValue = i + 1 < args.size();
+        if (opt == "--upsert") options.upsert = true;
+        else if (opt == "--no-copy") options.useCopy = false;
+        else if (opt == "--reject" && hasValue) options.rejectPath = args[++i];
+        else if (opt == "--delimiter" && hasValue) options.delimiter = args[++i].empty() ? ',' : args[i][0];
+        else if (opt == "--batch" && hasValue) options.batchSize = std::stoul(args[++i]);
+        else if (opt == "--workers" && hasValue) options.workers = std::stoul(args[++i]);
+        else {
+            std::cerr << "Неизвестный параметр: " << opt << std::endl;
+            return 1;
+        }
+    }
+
+    ImportResult r = service.importFromCsv(entity, args[1], options);
+    std::cout << "Прочитано строк: " << r.rowsRead << "\n"
+              << "Загружено: " << r.rowsLoaded << "\n"
+              << "Пропущено (уже в БД): " << r.rowsSkipped << "\n"
+              << "Отбраковано: " << r.rowsRejected << "\n"
+              << "Пакетов через COPY / INSERT: " << r.batchesViaCopy << " / " << r.batchesViaInsert << std::endl;
+    return r.success ? 0 : 1;
+}
+
+template <class Registry>
+int command_export(Registry& service, const std::vector<std::string>& args) {
+    if (args.size() < 2) {
+        std::cerr << "Использование: export <набор|all> <файл|каталог|-> [параметры]" << std::endl;
+        return 1;
+    }
+
+    ExportOptions options;
+    for (size_t i = 2; i < args.size(); ++i) {
+        const std::string& opt = args[i];
+        if (opt == "--gzip") options.gzip = true;
+        else if (opt == "--no-copy") options.useCopy = false;
+        else if (opt == "--since" && i + 1 < args.size()) {
+            options.since = args[++i];
+            if (!DataExporter::isTimestamp(options.since)) {
+                std::cerr << "Неверная отметка времени: " << options.since << std::endl;
+                return 1;
+            }
+        } else if (opt == "--format" && i + 1 < args.size()) {
+            const std::string& fmt = args[++i];
+            if (fmt == "csv") options.format = ExportFormat::Csv;
+            else if (fmt == "jsonl") options.format = ExportFormat::JsonLines;
+            else { std::cerr << "Неизвестный формат: " << fmt << std::endl; return 1; }
+        } else {
+            std::cerr << "Неизвестный параметр: " << opt << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<ExportDataset> datasets;
+    ExportDataset single;
+    bool all = (args[0] == "all");
+    if (all) {
+        // Выгрузке изменений нужны и удаления; потребитель применяет их первыми
+        if (!options.since.empty()) datasets.push_back(ExportDataset::Deletions);
+        datasets.insert(datasets.end(), {ExportDataset::Enterprises, ExportDataset::Products,
+                                         ExportDataset::Assortment, ExportDataset::SalesDepartments,
+                                         ExportDataset::BankDetails});
+    } else if (DataExporter::parseDataset(args[0], single)) {
+        datasets.push_back(single);
+    } else {
+        std::cerr << "Неизвестный набор данных: " << args[0] << std::endl;
+        return 1;
+    }
+
+    // Для "all" второй аргумент — каталог, файлы называются по наборам
+    std::string ext = (options.format == ExportFormat::Csv) ? ".csv" : ".jsonl";
+    if (options.gzip) ext += ".gz";
+
+    // Отметка берётся до выгрузки: с неё начнётся следующая выгрузка изменений
+    std::string watermark = service.getExportWatermark();
+    if (watermark.empty()) {
+        std::cerr << "Ошибка: Не удалось получить отметку времени." << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> paths;
+    for (ExportDataset d : datasets) {
+        paths.push_back(all ? args[1] + "/" + DataExporter::datasetName(d) + ext : args[1]);
+    }
+    std::vector<long long> rows;
+    bool ok = service.exportToFiles(datasets, paths, options, rows);
+    for (size_t i = 0; i < datasets.size(); ++i) {
+        const char* name = DataExporter::datasetName(datasets[i]);
+        if (rows[i] < 0) {
+            std::cerr << "Ошибка выгрузки " << name << std::endl;
+            continue;
+        }
+        // При выводе в stdout сообщения уходят в stderr, чтобы не смешиваться с данными
+        (paths[i] == "-" ? std::cerr : std::cout)
+            << name << ": " << rows[i] << " строк -> " << paths[i] << std::endl;
+    }
+    if (!ok) return 1;
+    std::cerr << "watermark: " << watermark << std::endl;
+    return 0;
+}
+
+int CLIInterface::commandSnapshot(const std::vector<std::string>& args) {
+    if (args.size() != 1) {
+        std::cerr << "Использование: snapshot <файл>" << std::endl;
+        return 1;
+    }
+
+    SnapshotStats stats;
+    if (!service.saveSnapshot(args[0], &stats)) return 1;
+    std::cout << "Снимок сохранён: " << args[0] << " (" << stats.bytes << " байт)\n"
+              << "Предприятий: " << stats.enterprises << ", товаров: " << stats.products
+              << ", позиций ассортимента: " << stats.assortment << "\n"
+              << "Отделов сбыта: " << stats.salesDepartments
+              << ", банковских реквизитов: " << stats.bankDetails << std::endl;
+    return 0;
+}
+
+int CLIInterface::commandBatch(const std::vector<std::string>& args) {
+    if (args.empty()) {
+        std::cerr << "Использование: batch <сценарий|-> [--format csv|jsonl] [--output <файл>] "
+                  << "[--group N] [--stop-on-error]" << std::endl;
+        return 1;
+    }
+
+    BatchOptions options;
+    ExportFormat format = ExportFormat::JsonLines;
+    std::string outputPath = "-";
+    for (size_t i = 1; i < args.size(); ++i) {
+        const std::string& opt = args[i];
+        bool hasValue = i + 1 < args.size();
+        if (opt == "--group" && hasValue) options.groupSize = std::stoul(args[++i]);
+        else if (opt == "--output" && hasValue) outputPath = args[++i];
+        else if (opt == "--stop-on-error") options.stopOnError = true;
+        else if (opt == "--format" && hasValue) {
+            const std::string& fmt = args[++i];
+            if (fmt == "csv") format = ExportFormat::Csv;
+            else if (fmt == "jsonl") format = ExportFormat::JsonLines;
+            else { std::cerr << "Неизвестный формат: " << fmt << std::endl; return 1; }
+        } else {
+            std::cerr << "Неизвестный параметр: " << opt << std::endl;
+            return 1;
+        }
+    }
+
+    int fd = STDIN_FILENO;
+    if (args[0] != "-") {
+        fd = ::open(args[0].c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            std::cerr << "Ошибка: Не удалось открыть файл " << args[0] << std::endl;
+            return 1;
+        }
+    }
+    auto out = ExportWriter::open(outputPath, format, false);
+    if (!out) {
+        if (fd != STDIN_FILENO) ::close(fd);
+        return 1;
+    }
+    out->begin(BatchScript::columns());
+
+    BatchScript script(service, *out, options);
+    BatchStats stats = script.run(fd);
+    if (fd != STDIN_FILENO) ::close(fd);
+    if (!out->close()) return 1;
+
+    std::cerr << "Команд: " << stats.commands << ", выполнено: " << stats.succeeded
+              << ", с ошибками: " << stats.failed << std::endl;
+    return stats.failed == 0 ? 0 : 2;
+}
+
+template <class Registry>
+int command_offers(Registry& service, const std::vector<std::string>& args) {
+    if (args.empty()) {
+        std::cerr << "Использование: offers <файл|-> [--top N] [--format csv|jsonl]" << std::endl;
+        return 1;
+    }
+
+    size_t topN = 0;
+    ExportFormat format = ExportFormat::Csv;
+    for (size_t i = 1; i < args.size(); ++i) {
+        const std::string& opt = args[i];
+        if (opt == "--top" && i + 1 < args.size()) topN = std::stoul(args[++i]);
+        else if (opt == "--format" && i + 1 < args.size()) {
+            const std::string& fmt = args[++i];
+            if (fmt == "csv") format = ExportFormat::Csv;
+            else if (fmt == "jsonl") format = ExportFormat::JsonLines;
+            else { std::cerr << "Неизвестный формат: " << fmt << std::endl; return 1; }
+        } else {
+            std::cerr << "Неизвестный параметр: " << opt << std::endl;
+            return 1;
+        }
+    }
+
+    std::ifstream file;
+    if (args[0] != "-") {
+        file.open(args[0]);
+        if (!file) {
+            std::cerr << "Ошибка: Не удалось открыть файл " << args[0] << std::endl;
+            return 1;
+        }
+    }
+    std::istream& in = (args[0] == "-") ? std::cin : file;
+
+    std::vector<int> productIds;
+    std::string token;
+    while (in >> token) {
+        std::replace(token.begin(), token.end(), ',', ' ');
+        std::istringstream parts(token);
+        std::string part;
+        while (parts >> part) {
+            char* end = nullptr;
+            long id = std::strtol(part.c_str(), &end, 10);
+            if (*end != '\0' || id <= 0) {
+                std::cerr << "Неверный ID товара: " << part << std::endl;
+                return 1;
+            }
+            productIds.push_back(static_cast<int>(id));
+        }
+    }
+
+    auto offers = service.getBestOffers(productIds, topN);
+    auto out = ExportWriter::open("-", format, false);
+    if (!out) return 1;
+    out->begin({"product_id", "rank", "enterprise_id", "enterprise_name", "wholesale_price"});
+    for (const auto& o : offers) {
+        out->beginRow();
+        out->field(o.product_id);
+        out->field(o.rank);
+        out->field(o.enterprise_id);
+        out->field(o.enterprise_name);
+        out->field(o.wholesale_price);
+        out->endRow();
+    }
+    if (!out->close()) return 1;
+    std::cerr << "Товаров: " << productIds.size() << ", предложений: " << offers.size() << std::endl;
+    return 0;
+}
+
+template <class Registry>
+int command_changes(Registry& service, const std::vector<std::string>& args) {
+    if (args.empty()) {
+        std::cerr << "Использование: changes head | changes <файл|-> [--since txid:seq] [--limit N] "
+                     "[--format csv|jsonl] [--gzip]" << std::endl;
+        return 1;
+    }
+    if (args[0] == "head") {
+        std::cout << cursor_text(service.getChangeHead()) << std::endl;
+        return 0;
+    }
+
+    ChangeCursor since;
+    long long limit = 0;
+    ExportOptions options;
+    options.format = ExportFormat::JsonLines;
+    for (size_t i = 1; i < args.size(); ++i) {
+        const std::string& opt = args[i];
+        bool hasValue = i + 1 < args.size();
+        if (opt == "--gzip") options.gzip = true;
+        else if (opt == "--limit" && hasValue) limit = std::stoll(args[++i]);
+        else if (opt == "--since" && hasValue) {
+            if (!parse_cursor(args[++i], since)) {
+                std::cerr << "Неверная позиция: " << args[i] << " (ожидается txid:seq)" << std::endl;
+                return 1;
+            }
+        } else if (opt == "--format" && hasValue) {
+            const std::string& fmt = args[++i];
+            if (fmt == "csv") options.format = ExportFormat::Csv;
+            else if (fmt == "jsonl") options.format = ExportFormat::JsonLines;
+            else { std::cerr << "Неизвестный формат: " << fmt << std::endl; return 1; }
+        } else {
+            std::cerr << "Неизвестный параметр: " << opt << std::endl;
+            return 1;
+        }
+    }
+
+    ChangeCursor last;
+    long long rows = service.exportChanges(since, limit, args[0], options, &last);
+    if (rows < 0) return 1;
+    // Позиция для следующего запуска — отдельной строкой, удобной для скриптов
+    std::cerr << "Изменений: " << rows << "\n" << "next: " << cursor_text(last) << std::endl;
+    return 0;
+}
+
 void CLIInterface::showMainMenu() {
-    std::cout << "\n=== Реестр предприятий ===\n";
+    std::cout << "\n=== Реестр предприятий ===" << (service.isReadOnly() ? " (снимок, только чтение)" : "") << "\n";
     std::cout << "1. Управление предприятиями\n";
     std::cout << "2. Управление товарами\n";
     std::cout << "3. Управление ассортиментом предприятий\n";
     std::cout << "4. Управление отделами сбыта\n";
     std::cout << "5. Управление банковскими реквизитами\n";
+    std::cout << "6. Отчёты по ассортименту\n";
     std::cout << "0. Выход\n";
 }
 
@@ -119,45 +584,57 @@ void CLIInterface::printTable(
         return;
     }
     const size_t MAX_COL_WIDTH = 50;
-    std::vector<size_t> colWidths(headers.size(), 0);
-
-    for (size_t i = 0; i < headers.size(); ++i) 
-        colWidths[i] = std::min(utf8_char_count(headers[i]), MAX_COL_WIDTH);
-
-    for (const auto& row : rows) {
-        for (size_t i = 0; i < headers.size(); ++i) {
-            if (i < row.size()) {
-                size_t cellWidth = std::min(utf8_char_count(row[i]), MAX_COL_WIDTH);
-                if (cellWidth > colWidths[i]) colWidths[i] = cellWidth;
-            }
+    const size_t columns = headers.size();
+
+    // Буферы переиспользуются между вызовами: после первой страницы вывод
+    // таблицы обходится без выделений памяти на ячейку
+    static std::vector<size_t> lengths;     // Ширина ячеек: заголовки, затем строки
+    static std::vector<size_t> colWidths;
+    static std::string out;
+    lengths.assign((rows.size() + 1) * columns, 0);
+    colWidths.assign(columns, 0);
+    out.clear();
+
+    // Ширина ячеек считается за один проход и дальше не пересчитывается
+    for (size_t r = 0; r <= rows.size(); ++r) {
+        const std::vector<std::string>& row = (r == 0) ? headers : rows[r - 1];
+        size_t* length = &lengths[r * columns];
+        for (size_t i = 0; i < columns && i < row.size(); ++i) {
+            length[i] = utf8::displayWidth(row[i]);
+            colWidths[i] = std::max(colWidths[i], std::min(length[i], MAX_COL_WIDTH));
         }
     }
 
-    std::cout << "\n--- " << title << " (страница " << currentPage << " из " << totalPages << ") ---\n";
-    for (size_t i = 0; i < headers.size(); ++i) {
-        if (i > 0) std::cout << " | ";
-        std::cout << truncate_to_visual_width(headers[i], colWidths[i]);
-    }
-    std::cout << '\n';
-
     size_t totalWidth = 0;
     for (size_t w : colWidths) totalWidth += w;
-    if (colWidths.size() > 1) totalWidth += (colWidths.size() - 1) * 3;
-    std::cout << std::string(totalWidth, '-') << '\n';
-
-    if (rows.empty()) {
-        std::cout << "(нет данных)\n";
-    } else {
-        for (const auto& row : rows) {
-            for (size_t i = 0; i < headers.size(); ++i) {
-                if (i > 0) std::cout << " | ";
-                std::cout << ((i < row.size()) ? truncate_to_visual_width(row[i], colWidths[i]) : std::string(colWidths[i], ' '));
-            }
-            std::cout << '\n';
+    if (columns > 1) totalWidth += (columns - 1) * 3;
+
+    out.append("\n--- ").append(title).append(" (страница ");
+    append_number(out, currentPage);
+    out.append(" из ");
+    append_number(out, totalPages);
+    out.append(") ---\n");
+
+    auto appendRow = [&](const std::vector<std::string>& row, const size_t* length) {
+        for (size_t i = 0; i < columns; ++i) {
+            if (i > 0) out.append(" | ");
+            if (i < row.size()) TableStream::appendCell(out, row[i], length[i], colWidths[i]);
+            else out.append(colWidths[i], ' ');
         }
-    }
-    std::cout << std::string(totalWidth, '-') << '\n';
-    std::cout << "(" << rows.size() << " строк" << (rows.size() != 1 ? "и)" : ")") << '\n';
+        out.push_back('\n');
+    };
+
+    appendRow(headers, &lengths[0]);
+    out.append(totalWidth, '-').push_back('\n');
+    if (rows.empty()) out.append("(нет данных)\n");
+    for (size_t r = 0; r < rows.size(); ++r) appendRow(rows[r], &lengths[(r + 1) * columns]);
+    out.append(totalWidth, '-').push_back('\n');
+
+    out.push_back('(');
+    append_number(out, static_cast<long long>(rows.size()));
+    out.append(rows.size() != 1 ? " строки)\n" : " строк)\n");
+
+    write_stdout(out);
 }
 
 // ============ УПРАВЛЕНИЕ ПРЕДПРИЯТИЯМИ ============
@@ -169,6 +646,8 @@ void CLIInterface::manageEnterprises() {
         std::cout << "2. Добавить предприятие\n";
         std::cout << "3. Редактировать предприятие\n";
         std::cout << "4. Удалить предприятие\n";
+        std::cout << "5. Найти предприятие\n";
+        std::cout << "6. Досье предприятия\n";
         std::cout << "0. Назад\n";
         int choice = getIntegerInput("Выберите действие: ");
         switch (choice) {
@@ -176,6 +655,8 @@ void CLIInterface::manageEnterprises() {
             case 2: addEnterprise(); break;
             case 3: editEnterprise(); break;
             case 4: deleteEnterprise(); break;
+            case 5: findEnterprises(); break;
+            case 6: showEnterpriseDossier(); break;
             case 0: return;
             default: std::cout << "Неверный выбор.\n";
         }
@@ -184,38 +665,93 @@ void CLIInterface::manageEnterprises() {
 
 void CLIInterface::listEnterprises(int initialPage, int pageSize) {
     int page = initialPage;
-    while (true) {
-        // Получаем данные через сервис
-        auto enterprises = service.getAllEnterprises();
-        int total = enterprises.size();
-        int totalPages = (total == 0) ? 1 : (total + pageSize - 1) / pageSize;
+    Criteria criteria;  // Пустой — весь список из кэша, иначе выборка сервером
+    Criteria applied;   // Последние критерии, принятые сервером
+    PageCache pages(service.executor());
+
+    // Загрузка страницы p: выполняется и здесь, и задачей пула, поэтому
+    // берёт критерии копией и обращается только к сервису
+    RegistryService* registry = &service;
+    auto loader = [registry, pageSize](const Criteria& c, int p) -> PageCache::Loader {
+        return [registry, pageSize, c, p]() {
+            ListPage result;
+            std::vector<Enterprise> enterprises;
+            long long start = static_cast<long long>(p - 1) * pageSize;
+            if (c.isDefault()) {
+                result.total = static_cast<long long>(registry->getEnterpriseCount());
+                long long end = std::min(start + pageSize, result.total);
+                for (long long i = start; i < end; ++i) enterprises.push_back(registry->getEnterpriseAt(i));
+            } else {
+                result.total = registry->countEnterprises(c);
+                if (result.total < 0) return result;
+                // Сервер возвращает только строки страницы
+                Criteria pageCriteria = c;
+                enterprises = registry->queryEnterprises(pageCriteria.limit(pageSize).offset(start));
+            }
 
-        if (page < 1) page = 1;
-        if (page > totalPages) page = totalPages;
+            // Сводка ассортимента страницы — одним запросом к таблице сводки
+            std::vector<int> ids;
+            for (const auto& e : enterprises) ids.push_back(e.id);
+            std::unordered_map<int, AssortmentSummary> summaries;
+            for (auto& s : registry->getAssortmentSummaries(ids)) summaries[s.enterprise_id] = std::move(s);
 
-        std::vector<std::vector<std::string>> rows;
-        if (total > 0) {
-            int start = (page - 1) * pageSize;
-            int end = std::min(start + pageSize, total);
-            for (int i = start; i < end; ++i) {
+            for (size_t i = 0; i < enterprises.size(); ++i) {
                 const auto& e = enterprises[i];
-                rows.push_back({
-                    std::to_string(i + 1),
+                auto it = summaries.find(e.id);
+                result.rows.push_back({
+                    // Записи выбираются по ID: номер строки при фильтре и сортировке
+                    // ничего не говорит о записи
+                    std::to_string(e.id),
                     e.name,
                     e.legal_form_name,
                     e.ownership_form_name,
                     e.inn,
-                    e.postal_address
+                    e.postal_address,
+                    it == summaries.end() ? "0" : std::to_string(it->second.lines),
+                    it == summaries.end() ? "-" : it->second.min_price.toString() + " - " + it->second.max_price.toString()
                 });
             }
+            return result;
+        };
+    };
+    auto key = [&](int p) { return PageCache::pageKey("enterprises", criteria.describe(), pageSize, p); };
+
+    while (true) {
+        if (page < 1) page = 1;
+        ListPage current = pages.get(key(page), loader(criteria, page));
+        if (current.total < 0) {
+            // Новые критерии отвергнуты — возвращаемся к принятым; если не
+            // загрузились и они, повторять бессмысленно
+            if (criteria.describe() == applied.describe()) {
+                std::cout << "\n[Ошибка] Не удалось загрузить список.\n";
+                return;
+            }
+            criteria = applied;
+            continue;
         }
+        applied = criteria;
+        long long total = current.total;
+        int totalPages = (total == 0) ? 1 : static_cast<int>((total + pageSize - 1) / pageSize);
+        if (page > totalPages) {
+            page = totalPages;
+            continue;
+        }
+
+        // Соседние страницы грузятся, пока оператор читает эту
+        if (page < totalPages) pages.prefetch(key(page + 1), loader(criteria, page + 1));
+        if (page > 1) pages.prefetch(key(page - 1), loader(criteria, page - 1));
 
-        printTable("Предприятия", page, totalPages, 
-            {"№", "Название", "ОПФ", "Форма собственности", "ИНН", "Адрес"}, rows, pageSize);
+        std::string title = "Предприятия";
+        if (!criteria.isDefault()) title += " [" + criteria.describe() + "]";
+        printTable(title, page, totalPages,
+            {"ID", "Название", "ОПФ", "Форма собственности", "ИНН", "Адрес",
+             "Товаров", "Опт. цены"}, current.rows, pageSize);
 
         std::cout << "\nНавигация: [q] выход";
         if (page > 1) std::cout << ", [p] предыдущая";
         if (total > 0 && page < totalPages) std::cout << ", [n] следующая";
+        std::cout << ", [f] фильтр, [s] сортировка, [v] весь список";
+        if (!criteria.isDefault()) std::cout << ", [c] сбросить";
         std::cout << ": ";
         
         char ch;
@@ -224,7 +760,108 @@ void CLIInterface::listEnterprises(int initialPage, int pageSize) {
         if (ch == 'q') return;
         else if (ch == 'p' && page > 1) page--;
         else if (ch == 'n' && total > 0 && page < totalPages) page++;
+        else if (ch == 'f' || ch == 's') {
+            if (editCriteria(criteria, ch == 'f', service.enterpriseFields())) page = 1;
+        }
+        else if (ch == 'v') viewEnterprises(criteria);
+        else if (ch == 'c') {
+            criteria = Criteria();
+            page = 1;
+        }
+    }
+}
+
+bool CLIInterface::editCriteria(Criteria& criteria, bool filter, const std::vector<CriteriaField>& fields) {
+    std::cout << "Поля:";
+    for (const auto& f : fields) std::cout << " " << f.name;
+    std::cout << "\n";
+
+    Criteria edited = criteria;
+    if (filter) {
+        std::cout << "Условия через ';': поле = != < <= > >= ~ (содержит) ^ (начинается с) значение\n";
+        std::string input = getStringInput("Фильтр (пусто — без фильтра): ");
+        edited.clearFilter();
+        if (!edited.parseFilter(input)) return false;
+    } else {
+        std::cout << "Поля через запятую, '-' перед полем — по убыванию\n";
+        std::string input = getStringInput("Сортировка (пусто — по умолчанию): ");
+        if (!edited.parseOrder(input)) return false;
+    }
+    criteria = edited;
+    return true;
+}
+
+void CLIInterface::findEnterprises() {
+    std::string query = getStringInput("Поиск (название, адрес или ИНН): ");
+    if (query.empty()) return;
+
+    auto hits = service.searchEnterprises(query, 10);
+    std::vector<std::vector<std::string>> rows;
+    for (const auto& [e, score] : hits) {
+        rows.push_back({
+            std::to_string(e.id),
+            std::to_string(static_cast<int>(score * 100 + 0.5f)) + "%",
+            e.name,
+            e.inn,
+            e.postal_address
+        });
+    }
+    if (rows.empty()) {
+        std::cout << "Ничего не найдено.\n";
+        return;
     }
+    printTable("Результаты поиска: " + query, 1, 1, {"ID", "Сходство", "Название", "ИНН", "Адрес"}, rows, 10);
+}
+
+void CLIInterface::showEnterpriseDossier() {
+    int id = getIntegerInput("Введите ID предприятия: ");
+    Enterprise e = id >= 1 ? service.getEnterpriseById(id) : Enterprise{};
+    if (e.id == 0) {
+        std::cout << "Предприятие не найдено." << std::endl;
+        return;
+    }
+
+    // Связанные записи запрашиваются одновременно — экран ждёт самый долгий запрос
+    EnterpriseDossier d = service.getEnterpriseDossier(e.id);
+    if (d.enterprise.id == 0) {
+        std::cout << "Предприятие не найдено." << std::endl;
+        return;
+    }
+
+    const auto& sd = d.salesDepartment;
+    const auto& bd = d.bankDetails;
+    std::string contact = sd.contact_last_name + " " + sd.contact_first_name
+                          + (sd.contact_patronymic.empty() ? "" : " " + sd.contact_patronymic);
+    std::vector<std::vector<std::string>> card = {
+        {"ИНН", d.enterprise.inn},
+        {"ОПФ", d.enterprise.legal_form_name},
+        {"Форма собственности", d.enterprise.ownership_form_name},
+        {"Адрес", d.enterprise.postal_address},
+        {"Отдел сбыта", sd.id == 0 ? "не указан" : contact},
+        {"Телефон / факс", sd.id == 0 ? "-" : sd.phone + " / " + sd.fax},
+        {"E-mail", sd.id == 0 ? "-" : sd.email},
+        {"Банк", bd.id == 0 ? "не указаны" : bd.bank_name + ", " + bd.bank_city},
+        {"Расчётный счёт", bd.id == 0 ? "-" : bd.account_number},
+        {"Товаров / категорий", std::to_string(d.summary.lines) + " / " + std::to_string(d.summary.categories)},
+        {"Опт. цены", d.summary.lines == 0 ? "-"
+            : d.summary.min_price.toString() + " - " + d.summary.max_price.toString()
+              + " (в среднем " + d.summary.avg_price.toString() + ")"}
+    };
+    printTable("Досье: " + d.enterprise.name, 1, 1, {"Поле", "Значение"}, card, 0);
+
+    // Самые дорогие позиции ассортимента; весь список — в меню ассортимента
+    const size_t TOP = 10;
+    auto lines = d.assortment;
+    std::sort(lines.begin(), lines.end(), [](const AssortmentLine& a, const AssortmentLine& b) {
+        if (a.has_wholesale_price != b.has_wholesale_price) return a.has_wholesale_price;
+        return b.wholesale_price < a.wholesale_price;
+    });
+    std::vector<std::vector<std::string>> rows;
+    for (size_t i = 0; i < lines.size() && i < TOP; ++i) {
+        rows.push_back({lines[i].product.name, lines[i].product.category_name, wholesale_text(lines[i])});
+    }
+    printTable("Ассортимент: " + std::to_string(std::min(lines.size(), TOP)) + " самых дорогих позиций из "
+               + std::to_string(lines.size()), 1, 1, {"Товар", "Категория", "Оптовая цена"}, rows, 0);
 }
 
 void CLIInterface::addEnterprise() {
@@ -241,14 +878,13 @@ void CLIInterface::addEnterprise() {
 }
 
 void CLIInterface::editEnterprise() {
-    int num = getIntegerInput("Введите номер предприятия (по списку): ");
-    auto enterprises = service.getAllEnterprises();
-    if (num < 1 || num > (int)enterprises.size()) {
-        std::cout << "Неверный номер." << std::endl;
+    int id = getIntegerInput("Введите ID предприятия: ");
+    Enterprise e = id >= 1 ? service.getEnterpriseById(id) : Enterprise{};
+    if (e.id == 0) {
+        std::cout << "Предприятие не найдено." << std::endl;
         return;
     }
 
-    Enterprise e = enterprises[num - 1]; // Получили копию DTO
     std::cout << "Редактирование: " << e.name << " (ИНН: " << e.inn << ")\n";
 
     std::string input = getStringInput("Новое название (пусто для сохранения): ");
@@ -271,13 +907,12 @@ void CLIInterface::editEnterprise() {
 }
 
 void CLIInterface::deleteEnterprise() {
-    int num = getIntegerInput("Введите номер предприятия для удаления: ");
-    auto enterprises = service.getAllEnterprises();
-    if (num < 1 || num > (int)enterprises.size()) {
-        std::cout << "Неверный номер.\n"; return;
+    int id = getIntegerInput("Введите ID предприятия для удаления: ");
+    Enterprise e = id >= 1 ? service.getEnterpriseById(id) : Enterprise{};
+    if (e.id == 0) {
+        std::cout << "Предприятие не найдено.\n"; return;
     }
 
-    Enterprise e = enterprises[num - 1];
     std::cout << "Удалить \"" << e.name << "\"? (y/n): ";
     char confirm; std::cin >> confirm;
     if (confirm == 'y' || confirm == 'Y') {
@@ -295,6 +930,8 @@ void CLIInterface::manageProducts() {
         std::cout << "2. Добавить товар\n";
         std::cout << "3. Редактировать товар\n";
         std::cout << "4. Удалить товар\n";
+        std::cout << "5. Найти товар\n";
+        std::cout << "6. Где дешевле (предложения предприятий)\n";
         std::cout << "0. Назад\n";
         int choice = getIntegerInput("Выберите действие: ");
         switch (choice) {
@@ -302,43 +939,98 @@ void CLIInterface::manageProducts() {
             case 2: addProduct(); break;
             case 3: editProduct(); break;
             case 4: deleteProduct(); break;
+            case 5: findProducts(); break;
+            case 6: showBestOffers(); break;
             case 0: return;
             default: std::cout << "Неверный выбор.\n";
         }
     }
 }
 
+void CLIInterface::viewEnterprises(const Criteria& criteria) {
+    std::string title = "Предприятия";
+    if (!criteria.isDefault()) title += " [" + criteria.describe() + "]";
+    TableStream table(title, {"ID", "Название", "ОПФ", "Форма собственности", "ИНН", "Адрес"});
+    table.open();
+    long long read = service.streamEnterprises(criteria, [&](const Enterprise& e) {
+        return table.row({std::to_string(e.id), e.name, e.legal_form_name, e.ownership_form_name,
+                          e.inn, e.postal_address});
+    });
+    table.close(read >= 0);
+}
+
 void CLIInterface::listProducts(int initialPage, int pageSize) {
     int page = initialPage;
-    while (true) {
-        auto products = service.getAllProducts();
-        int total = products.size();
-        int totalPages = (total == 0) ? 1 : (total + pageSize - 1) / pageSize;
-        if (page < 1) page = 1;
-        if (page > totalPages) page = totalPages;
+    Criteria criteria;
+    Criteria applied;
+    PageCache pages(service.executor());
+
+    RegistryService* registry = &service;
+    auto loader = [registry, pageSize](const Criteria& c, int p) -> PageCache::Loader {
+        return [registry, pageSize, c, p]() {
+            ListPage result;
+            std::vector<Product> products;
+            long long start = static_cast<long long>(p - 1) * pageSize;
+            if (c.isDefault()) {
+                result.total = static_cast<long long>(registry->getProductCount());
+                long long end = std::min(start + pageSize, result.total);
+                for (long long i = start; i < end; ++i) products.push_back(registry->getProductAt(i));
+            } else {
+                result.total = registry->countProducts(c);
+                if (result.total < 0) return result;
+                Criteria pageCriteria = c;
+                products = registry->queryProducts(pageCriteria.limit(pageSize).offset(start));
+            }
 
-        std::vector<std::vector<std::string>> rows;
-        if (total > 0) {
-            int start = (page - 1) * pageSize;
-            int end = std::min(start + pageSize, total);
-            for (int i = start; i < end; ++i) {
-                const auto& p = products[i];
-                std::ostringstream rS, pS;
-                rS << std::fixed << std::setprecision(2) << p.retail_price;
-                pS << std::fixed << std::setprecision(2) << p.purchase_price;
-                rows.push_back({
-                    std::to_string(i + 1), p.name, p.category_name,
-                    std::to_string(p.shelf_life_days) + " дн.",
-                    p.delivery_terms_description, rS.str(), pS.str()
+            for (size_t i = 0; i < products.size(); ++i) {
+                const auto& pr = products[i];
+                result.rows.push_back({
+                    std::to_string(pr.id),
+                    pr.name, pr.category_name,
+                    std::to_string(pr.shelf_life_days) + " дн.",
+                    pr.delivery_terms_description, pr.retail_price.toString(), pr.purchase_price.toString()
                 });
             }
+            return result;
+        };
+    };
+    auto key = [&](int p) { return PageCache::pageKey("products", criteria.describe(), pageSize, p); };
+
+    while (true) {
+        if (page < 1) page = 1;
+        ListPage current = pages.get(key(page), loader(criteria, page));
+        if (current.total < 0) {
+            // Новые критерии отвергнуты — возвращаемся к принятым; если не
+            // загрузились и они, повторять бессмысленно
+            if (criteria.describe() == applied.describe()) {
+                std::cout << "\n[Ошибка] Не удалось загрузить список.\n";
+                return;
+            }
+            criteria = applied;
+            continue;
         }
-        printTable("Товары", page, totalPages, 
-            {"№", "Наименование", "Категория", "Срок", "Поставка", "Розничная", "Закупочная"}, rows, pageSize);
+        applied = criteria;
+        long long total = current.total;
+        int totalPages = (total == 0) ? 1 : static_cast<int>((total + pageSize - 1) / pageSize);
+        if (page > totalPages) {
+            page = totalPages;
+            continue;
+        }
+
+        if (page < totalPages) pages.prefetch(key(page + 1), loader(criteria, page + 1));
+        if (page > 1) pages.prefetch(key(page - 1), loader(criteria, page - 1));
+
+        std::string title = "Товары";
+        if (!criteria.isDefault()) title += " [" + criteria.describe() + "]";
+        printTable(title, page, totalPages, 
+            {"ID", "Наименование", "Категория", "Срок", "Поставка", "Розничная", "Закупочная"},
+            current.rows, pageSize);
 
         std::cout << "\nНавигация: [q] выход";
         if (page > 1) std::cout << ", [p] предыдущая";
         if (total > 0 && page < totalPages) std::cout << ", [n] следующая";
+        std::cout << ", [f] фильтр, [s] сортировка, [v] весь список";
+        if (!criteria.isDefault()) std::cout << ", [c] сбросить";
         std::cout << ": ";
         
         char ch; std::cin >> ch;
@@ -346,6 +1038,14 @@ void CLIInterface::listProducts(int initialPage, int pageSize) {
         if (ch == 'q') return;
         else if (ch == 'p' && page > 1) page--;
         else if (ch == 'n' && total > 0 && page < totalPages) page++;
+        else if (ch == 'f' || ch == 's') {
+            if (editCriteria(criteria, ch == 'f', service.productFields())) page = 1;
+        }
+        else if (ch == 'v') viewProducts(criteria);
+        else if (ch == 'c') {
+            criteria = Criteria();
+            page = 1;
+        }
     }
 }
 
@@ -355,19 +1055,65 @@ void CLIInterface::addProduct() {
     p.category_id = getIntegerInput("ID категории товара: ");
     p.shelf_life_days = getIntegerInput("Срок реализации (дней): ");
     p.delivery_terms_id = getIntegerInput("ID условий поставки: ");
-    p.retail_price = std::stod(getStringInput("Розничная цена: "));
-    p.purchase_price = std::stod(getStringInput("Закупочная цена: "));
+    p.retail_price = getMoneyInput("Розничная цена: ");
+    p.purchase_price = getMoneyInput("Закупочная цена: ");
 
     if (service.createProduct(p) > 0) std::cout << "Товар успешно добавлен.\n";
     else std::cout << "Ошибка при добавлении товара.\n";
 }
 
+void CLIInterface::findProducts() {
+    std::string query = getStringInput("Поиск товара по названию: ");
+    if (query.empty()) return;
+
+    auto hits = service.searchProducts(query, 10);
+    std::vector<std::vector<std::string>> rows;
+    for (const auto& [p, score] : hits) {
+        rows.push_back({
+            std::to_string(p.id),
+            std::to_string(static_cast<int>(score * 100 + 0.5f)) + "%",
+            p.name,
+            p.category_name,
+            p.retail_price.toString()
+        });
+    }
+    if (rows.empty()) {
+        std::cout << "Ничего не найдено.\n";
+        return;
+    }
+    printTable("Результаты поиска: " + query, 1, 1, {"ID", "Сходство", "Название", "Категория", "Розн. цена"}, rows, 10);
+}
+
+void CLIInterface::showBestOffers() {
+    int id = getIntegerInput("Введите ID товара: ");
+    Product p = id >= 1 ? service.getProductById(id) : Product{};
+    if (p.id == 0) { std::cout << "Товар не найден.\n"; return; }
+    int topN = getIntegerInput("Сколько предложений показать (0 — все): ");
+
+    auto offers = service.getBestOffers(p.id, topN > 0 ? topN : 0);
+    if (offers.empty()) {
+        std::cout << "Товар \"" << p.name << "\" не предлагает ни одно предприятие.\n";
+        return;
+    }
+
+    std::vector<std::vector<std::string>> rows;
+    for (const auto& o : offers) {
+        rows.push_back({
+            std::to_string(o.rank), std::to_string(o.enterprise_id), o.enterprise_name,
+            o.wholesale_price.toString(),
+            (o.wholesale_price - offers.front().wholesale_price).toString(),
+            (o.wholesale_price - p.purchase_price).toString()
+        });
+    }
+    printTable("Предложения товара \"" + p.name + "\" (закупка " + p.purchase_price.toString() + ")", 1, 1,
+        {"Место", "ID", "Предприятие", "Опт", "К лучшей", "К закупке"}, rows, static_cast<int>(rows.size()));
+}
+
 void CLIInterface::editProduct() {
-    int num = getIntegerInput("Введите номер товара (по списку): ");
-    auto products = service.getAllProducts();
-    if (num < 1 || num > (int)products.size()) { std::cout << "Неверный номер.\n"; return; }
+    int id = getIntegerInput("Введите ID товара: ");
+    Product p = id >= 1 ? service.getProductById(id) : Product{};
+    if (p.id == 0) { std::cout << "Товар не найден.\n"; return; }
 
-    Product p = products[num - 1];
     std::cout << "Редактирование: " << p.name << "\n";
 
     std::string input = getStringInput("Новое наименование (пусто для сохранения): ");
@@ -380,18 +1126,21 @@ void CLIInterface::editProduct() {
     if (intInput != 0) p.shelf_life_days = intInput;
 
     input = getStringInput("Новая розничная цена (пусто для сохранения): ");
-    if (!input.empty()) p.retail_price = std::stod(input);
+    if (!input.empty() && !Money::parse(input, p.retail_price)) {
+        std::cout << "Неверная сумма.\n";
+        return;
+    }
 
     if (service.updateProduct(p)) std::cout << "Товар обновлён.\n";
     else std::cout << "Ошибка при обновлении.\n";
 }
 
 void CLIInterface::deleteProduct() {
-    int num = getIntegerInput("Введите номер товара: ");
-    auto products = service.getAllProducts();
-    if (num < 1 || num > (int)products.size()) { std::cout << "Неверный номер.\n"; return; }
+    int id = getIntegerInput("Введите ID товара: ");
+    Product p = id >= 1 ? service.getProductById(id) : Product{};
+    if (p.id == 0) { std::cout << "Товар не найден.\n"; return; }
     
-    if (service.deleteProduct(products[num - 1].id)) std::cout << "Товар удалён.\n";
+    if (service.deleteProduct(p.id)) std::cout << "Товар удалён.\n";
     else std::cout << "Ошибка при удалении.\n";
 }
 
@@ -400,27 +1149,41 @@ void CLIInterface::deleteProduct() {
 void CLIInterface::manageAssortment() {
     std::cout << "\n--- Выбор предприятия ---\n";
     listEnterprises(1, 10);
-    int entNum = getIntegerInput("Введите номер предприятия: ");
-    auto enterprises = service.getAllEnterprises();
-    if (entNum < 1 || entNum > (int)enterprises.size()) { std::cout << "Неверный номер.\n"; return; }
-    
-    Enterprise selectedEnt = enterprises[entNum - 1];
+    int entId = getIntegerInput("Введите ID предприятия: ");
+    Enterprise selectedEnt = entId >= 1 ? service.getEnterpriseById(entId) : Enterprise{};
+    if (selectedEnt.id == 0) { std::cout << "Предприятие не найдено.\n"; return; }
+
     std::cout << "\nПредприятие: " << selectedEnt.name << "\n";
 
     while (true) {
-        std::cout << "\n--- Ассортимент ---\n1. Просмотр\n2. Добавить товар\n3. Удалить товар\n4. Изменить цену\n0. Назад\n";
+        std::cout << "\n--- Ассортимент ---\n1. Просмотр\n2. Добавить товар\n3. Удалить товар\n4. Изменить цену\n"
+                  << "5. Скопировать ассортимент в другие предприятия\n0. Назад\n";
         int choice = getIntegerInput("Выбор: ");
         switch (choice) {
             case 1: listAssortmentForEnterprise(selectedEnt.id); break;
             case 2: addProductToEnterprise(selectedEnt.id); break;
             case 3: removeProductFromEnterprise(selectedEnt.id); break;
             case 4: updateWholesalePrice(selectedEnt.id); break;
+            case 5: copyAssortmentToEnterprises(selectedEnt.id); break;
             case 0: return;
             default: std::cout << "Неверный выбор.\n";
         }
     }
 }
 
+void CLIInterface::viewProducts(const Criteria& criteria) {
+    std::string title = "Товары";
+    if (!criteria.isDefault()) title += " [" + criteria.describe() + "]";
+    TableStream table(title, {"ID", "Наименование", "Категория", "Срок", "Поставка", "Розничная", "Закупочная"});
+    table.open();
+    long long read = service.streamProducts(criteria, [&](const Product& p) {
+        return table.row({std::to_string(p.id), p.name, p.category_name,
+                          std::to_string(p.shelf_life_days) + " дн.", p.delivery_terms_description,
+                          p.retail_price.toString(), p.purchase_price.toString()});
+    });
+    table.close(read >= 0);
+}
+
 void CLIInterface::listAssortmentForEnterprise(int enterpriseId, int initialPage, int pageSize) {
     int page = initialPage;
     while (true) {
@@ -434,8 +1197,7 @@ void CLIInterface::listAssortmentForEnterprise(int enterpriseId, int initialPage
             int start = (page - 1) * pageSize;
             int end = std::min(start + pageSize, total);
             for (int i = start; i < end; ++i) {
-                const auto& [product, wholesale] = assortment[i];
-                rows.push_back({ std::to_string(i + 1), product.name, std::to_string(wholesale) });
+                rows.push_back({ std::to_string(i + 1), assortment[i].product.name, wholesale_text(assortment[i]) });
             }
         }
         printTable("Ассортимент", page, totalPages, {"№", "Товар", "Оптовая цена"}, rows, pageSize);
@@ -448,12 +1210,12 @@ void CLIInterface::listAssortmentForEnterprise(int enterpriseId, int initialPage
 
 void CLIInterface::addProductToEnterprise(int enterpriseId) {
     listProducts(1, 10);
-    int prodNum = getIntegerInput("Введите номер товара: ");
-    auto products = service.getAllProducts();
-    if (prodNum < 1 || prodNum > (int)products.size()) return;
+    int prodId = getIntegerInput("Введите ID товара: ");
+    Product product = prodId >= 1 ? service.getProductById(prodId) : Product{};
+    if (product.id == 0) return;
 
-    double price = std::stod(getStringInput("Оптовая цена: "));
-    if (service.addProductToAssortment(enterpriseId, products[prodNum - 1].id, price))
+    Money price = getMoneyInput("Оптовая цена: ");
+    if (service.addProductToAssortment(enterpriseId, product.id, price))
         std::cout << "Добавлено.\n";
     else std::cout << "Ошибка.\n";
 }
@@ -465,12 +1227,12 @@ void CLIInterface::removeProductFromEnterprise(int enterpriseId) {
 
     std::cout << "--- Список ---\n";
     for(size_t i=0; i<assortment.size(); ++i) 
-        std::cout << i+1 << ". " << assortment[i].first.name << "\n";
+        std::cout << i+1 << ". " << assortment[i].product.name << "\n";
 
     int num = getIntegerInput("Номер для удаления: ");
     if (num < 1 || num > (int)assortment.size()) return;
 
-    if (service.removeProductFromAssortment(enterpriseId, assortment[num-1].first.id))
+    if (service.removeProductFromAssortment(enterpriseId, assortment[num-1].product.id))
         std::cout << "Удалено.\n";
     else std::cout << "Ошибка.\n";
 }
@@ -481,17 +1243,54 @@ void CLIInterface::updateWholesalePrice(int enterpriseId) {
     
     // Упрощенный вывод списка для выбора
     for(size_t i=0; i<assortment.size(); ++i) 
-        std::cout << i+1 << ". " << assortment[i].first.name << " (" << assortment[i].second << ")\n";
+        std::cout << i+1 << ". " << assortment[i].product.name << " (" << wholesale_text(assortment[i]) << ")\n";
 
     int num = getIntegerInput("Номер товара: ");
     if (num < 1 || num > (int)assortment.size()) return;
 
-    double newPrice = std::stod(getStringInput("Новая цена: "));
-    if (service.updateProductPriceInAssortment(enterpriseId, assortment[num-1].first.id, newPrice))
+    Money newPrice = getMoneyInput("Новая цена: ");
+    if (service.updateProductPriceInAssortment(enterpriseId, assortment[num-1].product.id, newPrice))
         std::cout << "Обновлено.\n";
     else std::cout << "Ошибка.\n";
 }
 
+void CLIInterface::copyAssortmentToEnterprises(int enterpriseId) {
+    auto enterprises = service.getAllEnterprises();
+    std::cout << "Предприятия:\n";
+    for (size_t i = 0; i < enterprises.size(); ++i) {
+        if (enterprises[i].id == enterpriseId) continue;
+        std::cout << i + 1 << ". " << enterprises[i].name << "\n";
+    }
+
+    // Номера вводятся через пробел или запятую: "2 5 7" или "2,5,7"
+    std::string input = getStringInput("Номера целевых предприятий: ");
+    std::replace(input.begin(), input.end(), ',', ' ');
+    std::istringstream iss(input);
+    std::vector<int> targets;
+    int num;
+    while (iss >> num) {
+        if (num < 1 || num > (int)enterprises.size()) {
+            std::cout << "Неверный номер: " << num << "\n";
+            return;
+        }
+        targets.push_back(enterprises[num - 1].id);
+    }
+    if (targets.empty()) { std::cout << "Не выбрано ни одного предприятия.\n"; return; }
+
+    double multiplier = 1.0;
+    input = getStringInput("Множитель цены (пусто — 1.0): ");
+    if (!input.empty()) multiplier = std::stod(input);
+
+    input = getStringInput("Перезаписывать цены уже имеющихся товаров? (y/n): ");
+    AssortmentConflictPolicy policy = (input == "y" || input == "Y")
+        ? AssortmentConflictPolicy::Overwrite
+        : AssortmentConflictPolicy::Skip;
+
+    long copied = service.copyAssortment(enterpriseId, targets, multiplier, policy);
+    if (copied >= 0) std::cout << "Скопировано строк ассортимента: " << copied << "\n";
+    else std::cout << "Ошибка.\n";
+}
+
 // ============ ОТДЕЛЫ СБЫТА ============
 
 void CLIInterface::manageSalesDepartments() {
@@ -748,8 +1547,165 @@ std::string CLIInterface::getStringInput(const std::string& prompt) {
     return input;
 }
 
+Money CLIInterface::getMoneyInput(const std::string& prompt) {
+    Money value;
+    while (true) {
+        if (Money::parse(getStringInput(prompt), value)) return value;
+        std::cout << "Ошибка ввода: ожидается сумма вида 123.45\n";
+    }
+}
+
 void CLIInterface::pause() {
     std::cout << "\nНажмите Enter...";
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
     std::cin.get();
+}
+
+// ============ ОТЧЁТЫ ============
+
+void CLIInterface::manageReports() {
+    while (true) {
+        std::cout << "\n--- Отчёты по ассортименту ---\n";
+        std::cout << "Источник: " << (service.isCatalogLoaded() ? "данные в памяти" : "сервер БД") << "\n";
+        std::cout << "1. Маржа по предприятиям\n";
+        std::cout << "2. Маржа по категориям товаров\n";
+        std::cout << "3. Оптовая цена ниже закупочной\n";
+        if (!service.isReadOnly()) {
+            std::cout << "4. Загрузить данные в память\n";
+            std::cout << "5. Выгрузить данные из памяти\n";
+            std::cout << "6. Сводка ассортимента по предприятиям\n";
+        }
+        std::cout << "0. Назад\n";
+        int choice = getIntegerInput("Выберите отчёт: ");
+        switch (choice) {
+            case 1: {
+                int limit = getIntegerInput("Сколько предприятий показать (0 — все): ");
+                printMarginReport("Маржа по предприятиям", service.getMarginByEnterprise(limit > 0 ? limit : 0));
+                break;
+            }
+            case 2: printMarginReport("Маржа по категориям товаров", service.getMarginByCategory()); break;
+            case 3: reportPriceOutliers(); break;
+            case 4: {
+                if (service.isReadOnly()) { std::cout << "Неверный выбор.\n"; break; }
+                CatalogStats stats;
+                if (!service.loadCatalog(&stats)) break;
+                std::cout << "Загружено: предприятий " << stats.enterprises << ", товаров " << stats.products
+                          << ", позиций ассортимента " << stats.assortment << " (строк в словаре " << stats.strings
+                          << ", " << (stats.bytes + (1 << 20) - 1) / (1 << 20) << " МБ).\n"
+                          << "Отчёты и фильтры товаров считаются в памяти до первого изменения данных.\n";
+                break;
+            }
+            case 5:
+                if (service.isReadOnly()) { std::cout << "Неверный выбор.\n"; break; }
+                service.releaseCatalog();
+                std::cout << "Данные выгружены, отчёты снова строит сервер БД.\n";
+                break;
+            case 6:
+                if (service.isReadOnly()) { std::cout << "Неверный выбор.\n"; break; }
+                listAssortmentSummaries();
+                break;
+            case 0: return;
+            default: std::cout << "Неверный выбор.\n";
+        }
+    }
+}
+
+void CLIInterface::listAssortmentSummaries(int pageSize) {
+    int page = 1;
+    Criteria criteria;
+    criteria.orderBy("lines", true);    // Крупные ассортименты первыми
+    Criteria applied = criteria;
+    bool accepted = false;              // Сервер уже принимал критерии
+    while (true) {
+        long long total = service.countAssortmentSummaries(criteria);
+        if (total < 0) {
+            if (!accepted) return;
+            // Не загрузились уже принятые критерии (например, пропало соединение)
+            if (criteria.describe() == applied.describe()) {
+                std::cout << "\n[Ошибка] Не удалось загрузить сводку ассортимента.\n";
+                return;
+            }
+            criteria = applied;
+            continue;
+        }
+        applied = criteria;
+        accepted = true;
+        int totalPages = (total == 0) ? 1 : static_cast<int>((total + pageSize - 1) / pageSize);
+        if (page > totalPages) page = totalPages;
+
+        Criteria pageCriteria = criteria;
+        pageCriteria.limit(pageSize).offset(static_cast<long long>(page - 1) * pageSize);
+        std::vector<std::vector<std::string>> rows;
+        for (const auto& s : service.queryAssortmentSummaries(pageCriteria)) {
+            rows.push_back({
+                std::to_string(s.enterprise_id), s.enterprise_name,
+                std::to_string(s.lines), std::to_string(s.categories),
+                s.min_price.toString(), s.avg_price.toString(), s.max_price.toString()
+            });
+        }
+        printTable("Сводка ассортимента [" + criteria.describe() + "]", page, totalPages,
+            {"ID", "Предприятие", "Товаров", "Категорий", "Мин. опт", "Сред. опт", "Макс. опт"}, rows, pageSize);
+
+        std::cout << "\nНавигация: [q] выход";
+        if (page > 1) std::cout << ", [p] предыдущая";
+        if (page < totalPages) std::cout << ", [n] следующая";
+        std::cout << ", [f] фильтр, [s] сортировка: ";
+
+        char ch;
+        std::cin >> ch;
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        if (ch == 'q') return;
+        else if (ch == 'p' && page > 1) page--;
+        else if (ch == 'n' && page < totalPages) page++;
+        else if (ch == 'f' || ch == 's') {
+            if (editCriteria(criteria, ch == 'f', service.assortmentSummaryFields())) page = 1;
+        }
+    }
+}
+
+void CLIInterface::printMarginReport(const std::string& title, const std::vector<MarginSummary>& report) {
+    if (report.empty()) {
+        std::cout << "Нет данных для отчёта.\n";
+        return;
+    }
+
+    std::vector<std::vector<std::string>> rows;
+    for (const auto& m : report) {
+        Money margin = m.wholesale_total - m.purchase_total;
+        // Маржа в процентах от закупки; без закупочных цен процент не определён
+        std::string marginPercent = m.purchase_total.isZero()
+            ? "-"
+            : percent_text(static_cast<double>(margin.toKopecks()) / m.purchase_total.toKopecks());
+        rows.push_back({
+            std::to_string(m.id), m.name, std::to_string(m.lines),
+            m.wholesale_total.toString(), m.purchase_total.toString(), margin.toString(),
+            marginPercent, percent_text(m.margin_share), std::to_string(m.below_purchase)
+        });
+    }
+    printTable(title, 1, 1,
+        {"ID", "Название", "Позиций", "Опт", "Закупка", "Маржа", "Маржа %", "Доля", "Ниже закупки"},
+        rows, static_cast<int>(rows.size()));
+}
+
+void CLIInterface::reportPriceOutliers() {
+    int limit = getIntegerInput("Сколько позиций показать: ");
+    if (limit <= 0) limit = 20;
+
+    long long total = 0;
+    auto outliers = service.getPriceOutliers(limit, &total);
+    if (outliers.empty()) {
+        std::cout << "Позиций с оптовой ценой ниже закупочной нет.\n";
+        return;
+    }
+
+    std::vector<std::vector<std::string>> rows;
+    for (const auto& o : outliers) {
+        rows.push_back({
+            o.enterprise_name, o.product_name,
+            o.wholesale_price.toString(), o.purchase_price.toString(),
+            (o.purchase_price - o.wholesale_price).toString()
+        });
+    }
+    printTable("Оптовая цена ниже закупочной: " + std::to_string(outliers.size()) + " из " + std::to_string(total),
+        1, 1, {"Предприятие", "Товар", "Опт", "Закупка", "Убыток"}, rows, static_cast<int>(rows.size()));
 }
\ No newline at end of file
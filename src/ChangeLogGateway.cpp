@@ -0,0 +1,168 @@
+#include "Gateways.h"
+#include <sstream>
+
+namespace {
+    // Журнал изменений пишут триггеры уровня оператора в той же транзакции,
+    // что и само изменение: откат транзакции откатывает и записи журнала.
+    // txid — номер транзакции-автора; позиция чтения — пара (txid, seq).
+    const char* CHANGE_LOG_TABLE = R"(
+        CREATE TABLE IF NOT EXISTS change_log (
+            seq BIGSERIAL PRIMARY KEY,
+            txid BIGINT NOT NULL DEFAULT txid_current(),
+            changed_at TIMESTAMPTZ NOT NULL DEFAULT now(),
+            table_name TEXT NOT NULL,
+            operation CHAR(1) NOT NULL,
+            row_key TEXT NOT NULL,
+            row_data JSONB
+        );
+        CREATE INDEX IF NOT EXISTS change_log_position_idx ON change_log (txid, seq);
+    )";
+
+    // Аргументы триггера — имена ключевых столбцов таблицы; составной ключ
+    // записывается через ':' ("12:345" для enterprise_product)
+    const char* CHANGE_LOG_FUNCTIONS = R"(
+        CREATE OR REPLACE FUNCTION change_log_key(rec JSONB, keys TEXT[]) RETURNS TEXT AS $$
+            SELECT string_agg(rec ->> k, ':' ORDER BY i) FROM unnest(keys) WITH ORDINALITY AS t(k, i)
+        $$ LANGUAGE sql IMMUTABLE;
+
+        CREATE OR REPLACE FUNCTION change_log_capture() RETURNS trigger AS $$
+        BEGIN
+            IF TG_OP = 'INSERT' THEN
+                INSERT INTO change_log (table_name, operation, row_key, row_data)
+                SELECT TG_TABLE_NAME, 'I', change_log_key(to_jsonb(n), TG_ARGV), to_jsonb(n) FROM new_rows n;
+            ELSIF TG_OP = 'UPDATE' THEN
+                -- Если изменился сам ключ, прежний ключ для потребителя — удаление
+                INSERT INTO change_log (table_name, operation, row_key, row_data)
+                SELECT TG_TABLE_NAME, 'D', gone.k, NULL
+                FROM (SELECT change_log_key(to_jsonb(o), TG_ARGV) AS k FROM old_rows o
+                      EXCEPT
+                      SELECT change_log_key(to_jsonb(n), TG_ARGV) FROM new_rows n) gone;
+                INSERT INTO change_log (table_name, operation, row_key, row_data)
+                SELECT TG_TABLE_NAME, 'U', change_log_key(to_jsonb(n), TG_ARGV), to_jsonb(n) FROM new_rows n;
+            ELSIF TG_OP = 'DELETE' THEN
+                INSERT INTO change_log (table_name, operation, row_key, row_data)
+                SELECT TG_TABLE_NAME, 'D', change_log_key(to_jsonb(o), TG_ARGV), NULL FROM old_rows o;
+            ELSE
+                INSERT INTO change_log (table_name, operation, row_key) VALUES (TG_TABLE_NAME, 'T', '');
+            END IF;
+            RETURN NULL;
+        END;
+        $$ LANGUAGE plpgsql;
+    )";
+
+    // Таблица и её ключ; триггеры ставятся один раз
+    const char* CAPTURED_TABLES[][2] = {
+        {"enterprise", "'enterprise_id'"},
+        {"product", "'product_id'"},
+        {"enterprise_product", "'enterprise_id', 'product_id'"},
+        {"sales_department", "'depart_id'"},
+        {"bank_details", "'bank_id'"}
+    };
+
+    std::string captureTriggers(const char* table, const char* keys) {
+        std::string t = table;
+        std::string k = keys;
+        return "DO $$ BEGIN "
+               "IF NOT EXISTS (SELECT 1 FROM pg_trigger WHERE tgname = '" + t + "_change_ins') THEN "
+               "CREATE TRIGGER " + t + "_change_ins AFTER INSERT ON " + t +
+               " REFERENCING NEW TABLE AS new_rows FOR EACH STATEMENT EXECUTE PROCEDURE change_log_capture(" + k + "); "
+               "CREATE TRIGGER " + t + "_change_upd AFTER UPDATE ON " + t +
+               " REFERENCING OLD TABLE AS old_rows NEW TABLE AS new_rows FOR EACH STATEMENT EXECUTE PROCEDURE change_log_capture(" + k + "); "
+               "CREATE TRIGGER " + t + "_change_del AFTER DELETE ON " + t +
+               " REFERENCING OLD TABLE AS old_rows FOR EACH STATEMENT EXECUTE PROCEDURE change_log_capture(" + k + "); "
+               "CREATE TRIGGER " + t + "_change_trunc AFTER TRUNCATE ON " + t +
+               " FOR EACH STATEMENT EXECUTE PROCEDURE change_log_capture(" + k + "); "
+               "END IF; END $$;";
+    }
+
+    // Текст произвольной длины: SQLGetData по частям, пока драйвер сообщает об усечении
+    bool getText(SQLHSTMT hStmt, SQLUSMALLINT column, std::string& out) {
+        out.clear();
+        char chunk[4096];
+        while (true) {
+            SQLLEN len = 0;
+            SQLRETURN ret = SQLGetData(hStmt, column, SQL_C_CHAR, chunk, sizeof(chunk), &len);
+            if (ret == SQL_NO_DATA) return true;
+            if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) return false;
+            if (len == SQL_NULL_DATA) return false;
+            size_t got = (len == SQL_NO_TOTAL || len >= static_cast<SQLLEN>(sizeof(chunk)))
+                       ? sizeof(chunk) - 1 : static_cast<size_t>(len);
+            out.append(chunk, got);
+            if (ret == SQL_SUCCESS) return true;
+        }
+    }
+
+    // Граница чтения: все транзакции с txid ниже xmin текущего снимка завершены,
+    // новых записей с такими txid уже не появится
+    const char* HORIZON = "txid_snapshot_xmin(txid_current_snapshot())";
+}
+
+void ChangeLogGateway::createTableIfNotExists() {
+    db->executeQuery(CHANGE_LOG_TABLE);
+    db->executeQuery(CHANGE_LOG_FUNCTIONS);
+    for (const auto& table : CAPTURED_TABLES) db->executeQuery(captureTriggers(table[0], table[1]));
+}
+
+long long ChangeLogGateway::streamSince(const ChangeCursor& since, long long limit,
+                                        const RowCallback<ChangeRecord>& callback) {
+    if (!db->isConnected()) return -1;
+
+    std::ostringstream oss;
+    oss << "SELECT txid, seq, to_char(changed_at AT TIME ZONE 'UTC', 'YYYY-MM-DD\"T\"HH24:MI:SS.US\"Z\"'), "
+        << "table_name, operation, row_key, row_data::TEXT FROM change_log "
+        << "WHERE (txid, seq) > (" << since.txid << ", " << since.seq << ") AND txid < " << HORIZON
+        << " ORDER BY txid, seq";
+    if (limit > 0) oss << " LIMIT " << limit;
+
+    SQLHSTMT hStmt;
+    SQLRETURN ret = SQLAllocHandle(SQL_HANDLE_STMT, db->getHandle(), &hStmt);
+    if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) return -1;
+    ret = SQLExecDirect(hStmt, (SQLCHAR*)oss.str().c_str(), SQL_NTS);
+    if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) {
+        std::cerr << "Ошибка чтения журнала изменений." << std::endl;
+        SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+        return -1;
+    }
+
+    ChangeRecord r;
+    SQLCHAR changedAt[40], table[64], op[4], key[128];
+    long long count = 0;
+    while (SQL_SUCCEEDED(ret = SQLFetch(hStmt))) {
+        changedAt[0] = table[0] = op[0] = key[0] = '\0';
+        SQLGetData(hStmt, 1, SQL_C_SBIGINT, &r.position.txid, 0, nullptr);
+        SQLGetData(hStmt, 2, SQL_C_SBIGINT, &r.position.seq, 0, nullptr);
+        SQLGetData(hStmt, 3, SQL_C_CHAR, changedAt, sizeof(changedAt), nullptr);
+        SQLGetData(hStmt, 4, SQL_C_CHAR, table, sizeof(table), nullptr);
+        SQLGetData(hStmt, 5, SQL_C_CHAR, op, sizeof(op), nullptr);
+        SQLGetData(hStmt, 6, SQL_C_CHAR, key, sizeof(key), nullptr);
+        // NULL у удалений — пустая строка
+        if (!getText(hStmt, 7, r.data)) r.data.clear();
+        r.changed_at = (char*)changedAt;
+        r.table = (char*)table;
+        r.operation = op[0];
+        r.key = (char*)key;
+        ++count;
+        if (!callback(r)) break;
+    }
+    bool complete = fetchCompleted(hStmt, ret);
+    SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+    return complete ? count : -1;
+}
+
+ChangeCursor ChangeLogGateway::head() {
+    ChangeCursor cursor;
+    if (!db->isConnected()) return cursor;
+
+    std::string sql = std::string("SELECT txid, seq FROM change_log WHERE txid < ") + HORIZON +
+                      " ORDER BY txid DESC, seq DESC LIMIT 1";
+    SQLHSTMT hStmt;
+    SQLRETURN ret = SQLAllocHandle(SQL_HANDLE_STMT, db->getHandle(), &hStmt);
+    if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) return cursor;
+    ret = SQLExecDirect(hStmt, (SQLCHAR*)sql.c_str(), SQL_NTS);
+    if ((ret == SQL_SUCCESS || ret == SQL_SUCCESS_WITH_INFO) && SQLFetch(hStmt) == SQL_SUCCESS) {
+        SQLGetData(hStmt, 1, SQL_C_SBIGINT, &cursor.txid, 0, nullptr);
+        SQLGetData(hStmt, 2, SQL_C_SBIGINT, &cursor.seq, 0, nullptr);
+    }
+    SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+    return cursor;
+}
\ No newline at end of file
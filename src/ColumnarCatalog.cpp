@@ -0,0 +1,537 @@
+#include "ColumnarCatalog.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+    // Нижний регистр для латиницы и кириллицы, как при сравнении ILIKE
+    // в базе с русской локалью; прочие символы не меняются
+    std::string foldCase(const std::string& s) {
+        std::string out;
+        out.reserve(s.size());
+        for (size_t i = 0; i < s.size(); ++i) {
+            unsigned char c = static_cast<unsigned char>(s[i]);
+            if (c >= 'A' && c <= 'Z') {
+                out += static_cast<char>(c + 32);
+                continue;
+            }
+            if ((c == 0xD0 || c == 0xD1) && i + 1 < s.size()) {
+                unsigned cp = ((c & 0x1F) << 6) | (static_cast<unsigned char>(s[i + 1]) & 0x3F);
+                if (cp >= 0x0410 && cp <= 0x042F) cp += 0x20;
+                else if (cp == 0x0401) cp = 0x0451;    // Ё
+                out += static_cast<char>(0xC0 | (cp >> 6));
+                out += static_cast<char>(0x80 | (cp & 0x3F));
+                ++i;
+                continue;
+            }
+            out += static_cast<char>(c);
+        }
+        return out;
+    }
+
+    template <class T>
+    size_t bytesOf(const std::vector<T>& v) { return v.capacity() * sizeof(T); }
+
+    template <class T>
+    bool compare(T a, CriteriaOp op, T b) {
+        switch (op) {
+            case CriteriaOp::Eq: return a == b;
+            case CriteriaOp::Ne: return a != b;
+            case CriteriaOp::Lt: return a < b;
+            case CriteriaOp::Le: return a <= b;
+            case CriteriaOp::Gt: return a > b;
+            case CriteriaOp::Ge: return a >= b;
+            default: return false;
+        }
+    }
+
+    // Сужение маски по числовому столбцу. Оператор выбирается вне цикла,
+    // тело цикла — сравнение без ветвлений, которое компилятор векторизует.
+    template <class T>
+    void filterColumn(std::vector<uint8_t>& mask, const T* col, CriteriaOp op, long long value) {
+        const size_t n = mask.size();
+        uint8_t* m = mask.data();
+        const T v = static_cast<T>(value);
+        // Значение вне диапазона столбца (int32) сравнивается как есть
+        if (static_cast<long long>(v) != value) {
+            for (size_t i = 0; i < n; ++i) m[i] &= compare<long long>(col[i], op, value);
+            return;
+        }
+        switch (op) {
+            case CriteriaOp::Eq: for (size_t i = 0; i < n; ++i) m[i] &= (col[i] == v); break;
+            case CriteriaOp::Ne: for (size_t i = 0; i < n; ++i) m[i] &= (col[i] != v); break;
+            case CriteriaOp::Lt: for (size_t i = 0; i < n; ++i) m[i] &= (col[i] < v); break;
+            case CriteriaOp::Le: for (size_t i = 0; i < n; ++i) m[i] &= (col[i] <= v); break;
+            case CriteriaOp::Gt: for (size_t i = 0; i < n; ++i) m[i] &= (col[i] > v); break;
+            case CriteriaOp::Ge: for (size_t i = 0; i < n; ++i) m[i] &= (col[i] >= v); break;
+            default: break;
+        }
+    }
+
+    // Столбец товаров по имени поля критериев
+    struct ColumnRef {
+        FieldType type;
+        const int32_t* i32;
+        const int64_t* i64;
+        const uint32_t* codes;
+        const uint8_t* present;     // Маска «цена указана» для столбцов цен
+    };
+
+    bool productColumn(const ColumnarCatalog::ProductColumns& cols, const std::string& name, ColumnRef& ref) {
+        ref = ColumnRef{FieldType::Int, nullptr, nullptr, nullptr, nullptr};
+        if (name == "id") ref.i32 = cols.id.data();
+        else if (name == "category_id") ref.i32 = cols.categoryId.data();
+        else if (name == "shelf_life_days") ref.i32 = cols.shelfLifeDays.data();
+        else if (name == "delivery_terms_id") ref.i32 = cols.deliveryTermsId.data();
+        else if (name == "retail_price") ref = ColumnRef{FieldType::Money, nullptr, cols.retailPrice.data(), nullptr, cols.hasRetailPrice.data()};
+        else if (name == "purchase_price") ref = ColumnRef{FieldType::Money, nullptr, cols.purchasePrice.data(), nullptr, cols.hasPurchasePrice.data()};
+        else if (name == "name") ref = ColumnRef{FieldType::Text, nullptr, nullptr, cols.name.data(), nullptr};
+        else if (name == "category") ref = ColumnRef{FieldType::Text, nullptr, nullptr, cols.categoryName.data(), nullptr};
+        else if (name == "delivery_terms") ref = ColumnRef{FieldType::Text, nullptr, nullptr, cols.deliveryTerms.data(), nullptr};
+        else return false;
+        return true;
+    }
+
+    // Итоги групп -> строки отчёта, по убыванию маржи (как ORDER BY в AnalyticsGateway)
+    std::vector<MarginSummary> finishMargins(std::vector<MarginSummary> list, size_t limit) {
+        int64_t totalMargin = 0;
+        for (const auto& m : list) totalMargin += (m.wholesale_total - m.purchase_total).toKopecks();
+        for (auto& m : list) {
+            int64_t margin = (m.wholesale_total - m.purchase_total).toKopecks();
+            m.margin_share = totalMargin != 0 ? static_cast<double>(margin) / totalMargin : 0.0;
+        }
+
+        auto better = [](const MarginSummary& a, const MarginSummary& b) {
+            Money ma = a.wholesale_total - a.purchase_total;
+            Money mb = b.wholesale_total - b.purchase_total;
+            if (ma != mb) return ma > mb;
+            return a.id < b.id;
+        };
+        if (limit > 0 && limit < list.size()) {
+            std::partial_sort(list.begin(), list.begin() + limit, list.end(), better);
+            list.resize(limit);
+        } else {
+            std::sort(list.begin(), list.end(), better);
+        }
+        return list;
+    }
+}
+
+// ==========================================
+// StringDictionary
+// ==========================================
+
+uint32_t StringDictionary::encode(std::string_view value) {
+    auto [it, inserted] = codes.emplace(std::string(value), static_cast<uint32_t>(values.size()));
+    if (inserted) values.push_back(it->first);
+    return it->second;
+}
+
+size_t StringDictionary::bytes() const {
+    size_t total = values.capacity() * sizeof(std::string);
+    for (const auto& v : values) total += 2 * v.capacity();   // Строка в массиве и ключ словаря
+    return total + codes.size() * (sizeof(std::string) + sizeof(uint32_t) + 2 * sizeof(void*));
+}
+
+void StringDictionary::clear() {
+    values.clear();
+    codes.clear();
+}
+
+// ==========================================
+// Загрузка
+// ==========================================
+
+void ColumnarCatalog::clear() {
+    strings.clear();
+    enterpriseCols = EnterpriseColumns();
+    productCols = ProductColumns();
+    assortmentCols = AssortmentColumns();
+    enterpriseRowById.clear();
+    productRowById.clear();
+    loaded = false;
+}
+
+void ColumnarCatalog::addEnterprise(int id, std::string_view name) {
+    enterpriseRowById[id] = static_cast<uint32_t>(enterpriseCols.id.size());
+    enterpriseCols.id.push_back(id);
+    enterpriseCols.name.push_back(strings.encode(name));
+}
+
+void ColumnarCatalog::addProduct(const Product& p) {
+    productRowById[p.id] = static_cast<uint32_t>(productCols.id.size());
+    productCols.id.push_back(p.id);
+    productCols.categoryId.push_back(p.category_id);
+    productCols.shelfLifeDays.push_back(p.shelf_life_days);
+    productCols.deliveryTermsId.push_back(p.delivery_terms_id);
+    productCols.retailPrice.push_back(p.retail_price.toKopecks());
+    productCols.purchasePrice.push_back(p.purchase_price.toKopecks());
+    productCols.hasRetailPrice.push_back(p.has_retail_price);
+    productCols.hasPurchasePrice.push_back(p.has_purchase_price);
+    productCols.name.push_back(strings.encode(p.name));
+    productCols.categoryName.push_back(strings.encode(p.category_name));
+    productCols.deliveryTerms.push_back(strings.encode(p.delivery_terms_description));
+}
+
+bool ColumnarCatalog::addAssortment(int enterpriseId, int productId, int64_t wholesale, bool hasWholesale) {
+    auto e = enterpriseRowById.find(enterpriseId);
+    auto p = productRowById.find(productId);
+    // Позиция, добавленная после чтения предприятий и товаров, пропускается
+    if (e == enterpriseRowById.end() || p == productRowById.end()) return false;
+    assortmentCols.enterpriseRow.push_back(e->second);
+    assortmentCols.productRow.push_back(p->second);
+    assortmentCols.wholesalePrice.push_back(hasWholesale ? wholesale : 0);
+    assortmentCols.hasWholesalePrice.push_back(hasWholesale);
+    return true;
+}
+
+bool ColumnarCatalog::load(EnterpriseGateway& enterprises, ProductGateway& products,
+                           EnterpriseProductGateway& assortment) {
+    clear();
+    bool ok = enterprises.streamAll([this](const Enterprise& e) { addEnterprise(e.id, e.name); return true; }) >= 0
+           && products.streamAll([this](const Product& p) { addProduct(p); return true; }) >= 0
+           && assortment.streamAll([this](const EnterpriseProduct& ep) {
+                  addAssortment(ep.enterprise_id, ep.product_id, ep.wholesale_price.toKopecks(), ep.has_wholesale_price);
+                  return true;
+              }) >= 0;
+    if (!ok) {
+        std::cerr << "Ошибка: Не удалось загрузить каталог из БД." << std::endl;
+        clear();
+        return false;
+    }
+    loaded = true;
+    return true;
+}
+
+bool ColumnarCatalog::load(const Snapshot& snap) {
+    clear();
+    enterpriseCols.id.reserve(snap.enterprises().size());
+    enterpriseCols.name.reserve(snap.enterprises().size());
+    for (const auto& r : snap.enterprises()) addEnterprise(r.id, snap.str(r.name));
+
+    Product p;
+    for (const auto& r : snap.products()) {
+        p.id = r.id;
+        p.category_id = r.categoryId;
+        p.shelf_life_days = r.shelfLifeDays;
+        p.delivery_terms_id = r.deliveryTermsId;
+        p.has_retail_price = r.retailPrice != snapshot::NO_PRICE;
+        p.has_purchase_price = r.purchasePrice != snapshot::NO_PRICE;
+        p.retail_price = Money::fromKopecks(p.has_retail_price ? r.retailPrice : 0);
+        p.purchase_price = Money::fromKopecks(p.has_purchase_price ? r.purchasePrice : 0);
+        p.name = snap.str(r.name);
+        p.category_name = snap.str(r.categoryName);
+        p.delivery_terms_description = snap.str(r.deliveryTerms);
+        addProduct(p);
+    }
+
+    auto lines = snap.assortment();
+    assortmentCols.enterpriseRow.reserve(lines.size());
+    assortmentCols.productRow.reserve(lines.size());
+    assortmentCols.wholesalePrice.reserve(lines.size());
+    assortmentCols.hasWholesalePrice.reserve(lines.size());
+    for (const auto& r : lines) {
+        addAssortment(r.enterpriseId, r.productId, r.wholesalePrice, r.wholesalePrice != snapshot::NO_PRICE);
+    }
+
+    loaded = true;
+    return true;
+}
+
+CatalogStats ColumnarCatalog::stats() const {
+    CatalogStats s;
+    s.enterprises = enterpriseCols.id.size();
+    s.products = productCols.id.size();
+    s.assortment = assortmentCols.productRow.size();
+    s.strings = strings.size();
+    s.bytes = strings.bytes()
+            + bytesOf(enterpriseCols.id) + bytesOf(enterpriseCols.name)
+            + bytesOf(productCols.id) + bytesOf(productCols.categoryId) + bytesOf(productCols.shelfLifeDays)
+            + bytesOf(productCols.deliveryTermsId) + bytesOf(productCols.retailPrice)
+            + bytesOf(productCols.purchasePrice) + bytesOf(productCols.hasRetailPrice)
+            + bytesOf(productCols.hasPurchasePrice) + bytesOf(productCols.name)
+            + bytesOf(productCols.categoryName) + bytesOf(productCols.deliveryTerms)
+            + bytesOf(assortmentCols.enterpriseRow) + bytesOf(assortmentCols.productRow)
+            + bytesOf(assortmentCols.wholesalePrice) + bytesOf(assortmentCols.hasWholesalePrice);
+    return s;
+}
+
+Product ColumnarCatalog::productAt(uint32_t row) const {
+    Product p;
+    p.id = productCols.id[row];
+    p.category_id = productCols.categoryId[row];
+    p.shelf_life_days = productCols.shelfLifeDays[row];
+    p.delivery_terms_id = productCols.deliveryTermsId[row];
+    p.retail_price = Money::fromKopecks(productCols.retailPrice[row]);
+    p.purchase_price = Money::fromKopecks(productCols.purchasePrice[row]);
+    p.has_retail_price = productCols.hasRetailPrice[row] != 0;
+    p.has_purchase_price = productCols.hasPurchasePrice[row] != 0;
+    p.name = strings.decode(productCols.name[row]);
+    p.category_name = strings.decode(productCols.categoryName[row]);
+    p.delivery_terms_description = strings.decode(productCols.deliveryTerms[row]);
+    return p;
+}
+
+// ==========================================
+// Отчёты
+// ==========================================
+
+std::vector<MarginSummary> ColumnarCatalog::marginByEnterprise(size_t limit) const {
+    const size_t groups = enterpriseCols.id.size();
+    std::vector<int64_t> lines(groups, 0), wholesale(groups, 0), purchase(groups, 0), below(groups, 0);
+
+    // Один проход по столбцам ассортимента; закупочная цена берётся
+    // по номеру строки товара из столбца, который целиком помещается в кэш.
+    // Цена без значения — ноль и в сумму ничего не добавляет (как SUM),
+    // а «ниже закупки» требует обеих цен (сравнение с NULL в SQL ложно)
+    const size_t n = assortmentCols.productRow.size();
+    const uint32_t* er = assortmentCols.enterpriseRow.data();
+    const uint32_t* pr = assortmentCols.productRow.data();
+    const int64_t* w = assortmentCols.wholesalePrice.data();
+    const uint8_t* hasW = assortmentCols.hasWholesalePrice.data();
+    const int64_t* cost = productCols.purchasePrice.data();
+    const uint8_t* hasCost = productCols.hasPurchasePrice.data();
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t g = er[i];
+        uint32_t r = pr[i];
+        int64_t p = cost[r];
+        lines[g] += 1;
+        wholesale[g] += w[i];
+        purchase[g] += p;
+        below[g] += hasW[i] & hasCost[r] & (w[i] < p);
+    }
+
+    std::vector<MarginSummary> list;
+    for (size_t g = 0; g < groups; ++g) {
+        if (lines[g] == 0) continue;
+        list.push_back(MarginSummary{enterpriseCols.id[g], strings.decode(enterpriseCols.name[g]), lines[g],
+                                     Money::fromKopecks(wholesale[g]), Money::fromKopecks(purchase[g]),
+                                     below[g], 0.0});
+    }
+    return finishMargins(std::move(list), limit);
+}
+
+std::vector<MarginSummary> ColumnarCatalog::marginByCategory() const {
+    // Сначала итоги по товарам (без обращения к закупочной цене в цикле по позициям:
+    // сумма закупки товара — число его позиций, умноженное на цену), затем по категориям
+    const size_t products = productCols.id.size();
+    std::vector<int64_t> lines(products, 0), wholesale(products, 0), below(products, 0);
+
+    const size_t n = assortmentCols.productRow.size();
+    const uint32_t* pr = assortmentCols.productRow.data();
+    const int64_t* w = assortmentCols.wholesalePrice.data();
+    const uint8_t* hasW = assortmentCols.hasWholesalePrice.data();
+    const int64_t* cost = productCols.purchasePrice.data();
+    const uint8_t* hasCost = productCols.hasPurchasePrice.data();
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t r = pr[i];
+        lines[r] += 1;
+        wholesale[r] += w[i];
+        below[r] += hasW[i] & hasCost[r] & (w[i] < cost[r]);
+    }
+
+    std::unordered_map<int, size_t> groupOf;
+    std::vector<MarginSummary> list;
+    for (size_t r = 0; r < products; ++r) {
+        if (lines[r] == 0) continue;
+        auto [it, inserted] = groupOf.emplace(productCols.categoryId[r], list.size());
+        if (inserted) {
+            list.push_back(MarginSummary{productCols.categoryId[r], strings.decode(productCols.categoryName[r]),
+                                         0, Money(), Money(), 0, 0.0});
+        }
+        MarginSummary& m = list[it->second];
+        m.lines += lines[r];
+        m.wholesale_total += Money::fromKopecks(wholesale[r]);
+        m.purchase_total += Money::fromKopecks(cost[r] * lines[r]);
+        m.below_purchase += below[r];
+    }
+    return finishMargins(std::move(list), 0);
+}
+
+std::vector<PriceOutlier> ColumnarCatalog::priceOutliers(size_t limit, long long* total) const {
+    const size_t n = assortmentCols.productRow.size();
+    const uint32_t* pr = assortmentCols.productRow.data();
+    const int64_t* w = assortmentCols.wholesalePrice.data();
+    const uint8_t* hasW = assortmentCols.hasWholesalePrice.data();
+    const int64_t* cost = productCols.purchasePrice.data();
+    const uint8_t* hasCost = productCols.hasPurchasePrice.data();
+
+    // Позиции без оптовой или закупочной цены не сравниваются, как в SQL
+    std::vector<size_t> hits;
+    for (size_t i = 0; i < n; ++i) {
+        if (hasW[i] && hasCost[pr[i]] && w[i] < cost[pr[i]]) hits.push_back(i);
+    }
+    if (total) *total = static_cast<long long>(hits.size());
+
+    auto worse = [&](size_t a, size_t b) {
+        int64_t la = cost[pr[a]] - w[a];
+        int64_t lb = cost[pr[b]] - w[b];
+        if (la != lb) return la > lb;
+        int ea = enterpriseCols.id[assortmentCols.enterpriseRow[a]];
+        int eb = enterpriseCols.id[assortmentCols.enterpriseRow[b]];
+        if (ea != eb) return ea < eb;
+        return productCols.id[pr[a]] < productCols.id[pr[b]];
+    };
+    if (limit > 0 && limit < hits.size()) {
+        std::partial_sort(hits.begin(), hits.begin() + limit, hits.end(), worse);
+        hits.resize(limit);
+    } else {
+        std::sort(hits.begin(), hits.end(), worse);
+    }
+
+    std::vector<PriceOutlier> list;
+    list.reserve(hits.size());
+    for (size_t i : hits) {
+        uint32_t e = assortmentCols.enterpriseRow[i];
+        uint32_t p = pr[i];
+        list.push_back(PriceOutlier{enterpriseCols.id[e], strings.decode(enterpriseCols.name[e]),
+                                    productCols.id[p], strings.decode(productCols.name[p]),
+                                    Money::fromKopecks(w[i]), Money::fromKopecks(cost[p])});
+    }
+    return list;
+}
+
+std::vector<ProductOffer> ColumnarCatalog::bestOffers(const std::vector<int>& productIds, size_t topN) const {
+    // Номер строки товара -> номер запрошенного товара в ответе
+    std::vector<int32_t> slotOf(productCols.id.size(), -1);
+    std::vector<uint32_t> requested;
+    for (int id : productIds) {
+        auto it = productRowById.find(id);
+        if (it == productRowById.end() || slotOf[it->second] >= 0) continue;
+        slotOf[it->second] = static_cast<int32_t>(requested.size());
+        requested.push_back(it->second);
+    }
+
+    // Позиции без цены не предлагаются (ep.wholesale_price IS NOT NULL в шлюзе)
+    std::vector<std::vector<size_t>> lines(requested.size());
+    const size_t n = assortmentCols.productRow.size();
+    const uint32_t* pr = assortmentCols.productRow.data();
+    const uint8_t* hasW = assortmentCols.hasWholesalePrice.data();
+    for (size_t i = 0; i < n; ++i) {
+        int32_t slot = slotOf[pr[i]];
+        if (slot >= 0 && hasW[i]) lines[slot].push_back(i);
+    }
+
+    const int64_t* w = assortmentCols.wholesalePrice.data();
+    auto cheaper = [&](size_t a, size_t b) {
+        if (w[a] != w[b]) return w[a] < w[b];
+        return enterpriseCols.id[assortmentCols.enterpriseRow[a]] < enterpriseCols.id[assortmentCols.enterpriseRow[b]];
+    };
+
+    std::vector<ProductOffer> list;
+    for (size_t slot = 0; slot < requested.size(); ++slot) {
+        std::vector<size_t>& offers = lines[slot];
+        if (topN > 0 && topN < offers.size()) {
+            std::partial_sort(offers.begin(), offers.begin() + topN, offers.end(), cheaper);
+            offers.resize(topN);
+        } else {
+            std::sort(offers.begin(), offers.end(), cheaper);
+        }
+        int rank = 0;
+        for (size_t i : offers) {
+            uint32_t e = assortmentCols.enterpriseRow[i];
+            list.push_back(ProductOffer{productCols.id[requested[slot]], ++rank, enterpriseCols.id[e],
+                                        strings.decode(enterpriseCols.name[e]), Money::fromKopecks(w[i])});
+        }
+    }
+    return list;
+}
+
+// ==========================================
+// Фильтрация товаров
+// ==========================================
+
+bool ColumnarCatalog::selectProducts(const Criteria& criteria, std::vector<uint32_t>& rows, long long* total) const {
+    rows.clear();
+    if (total) *total = 0;
+    const auto& fields = ProductGateway::criteriaFields();
+    const size_t n = productCols.id.size();
+    std::vector<uint8_t> mask(n, 1);
+
+    for (const auto& pred : criteria.getPredicates()) {
+        const CriteriaField* field = Criteria::findField(fields, pred.field);
+        ColumnRef col;
+        if (!field) return false;
+        if (!productColumn(productCols, field->name, col)) {
+            std::cerr << "Поле " << field->name << " недоступно для данных в памяти" << std::endl;
+            return false;
+        }
+
+        bool substring = pred.op == CriteriaOp::Contains || pred.op == CriteriaOp::StartsWith;
+        if (substring && col.type != FieldType::Text) {
+            std::cerr << "Поиск подстроки допустим только для текстовых полей (" << field->name << ")" << std::endl;
+            return false;
+        }
+
+        if (col.type != FieldType::Text) {
+            long long value;
+            if (!Criteria::numericValue(*field, pred.value, value)) return false;
+            if (col.i32) {
+                filterColumn(mask, col.i32, pred.op, value);
+            } else {
+                filterColumn(mask, col.i64, pred.op, value);
+                // Сравнение с NULL ложно при любом операторе
+                uint8_t* m = mask.data();
+                for (size_t i = 0; i < n; ++i) m[i] &= col.present[i];
+            }
+            continue;
+        }
+
+        // Условие по строке вычисляется один раз для каждого кода словаря
+        std::string value = Criteria::textValue(pred.value);
+        std::string folded = foldCase(value);
+        std::vector<int8_t> verdict(strings.size(), -1);
+        auto matches = [&](uint32_t code) {
+            int8_t& v = verdict[code];
+            if (v < 0) {
+                const std::string& s = strings.decode(code);
+                if (pred.op == CriteriaOp::Contains) v = foldCase(s).find(folded) != std::string::npos;
+                else if (pred.op == CriteriaOp::StartsWith) v = foldCase(s).compare(0, folded.size(), folded) == 0;
+                else v = compare<int>(s.compare(value), pred.op, 0);
+            }
+            return v == 1;
+        };
+        for (size_t i = 0; i < n; ++i) {
+            if (mask[i]) mask[i] = matches(col.codes[i]);
+        }
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        if (mask[i]) rows.push_back(static_cast<uint32_t>(i));
+    }
+    if (total) *total = static_cast<long long>(rows.size());
+
+    // Строки лежат в порядке ID, поэтому устойчивая сортировка сохраняет
+    // ID последним ключом — как ORDER BY ..., p.product_id в шлюзе
+    std::vector<std::pair<ColumnRef, bool>> order;
+    for (const auto& o : criteria.getOrdering()) {
+        const CriteriaField* field = Criteria::findField(fields, o.field);
+        ColumnRef col;
+        if (!field) return false;
+        if (!productColumn(productCols, field->name, col)) {
+            std::cerr << "Поле " << field->name << " недоступно для данных в памяти" << std::endl;
+            return false;
+        }
+        order.push_back({col, o.descending});
+    }
+    if (!order.empty()) {
+        std::stable_sort(rows.begin(), rows.end(), [&](uint32_t a, uint32_t b) {
+            for (const auto& [col, desc] : order) {
+                int c;
+                if (col.i32) c = (col.i32[a] > col.i32[b]) - (col.i32[a] < col.i32[b]);
+                else if (col.i64 && col.present[a] != col.present[b]) c = col.present[a] ? -1 : 1;   // NULL — больше любой цены
+                else if (col.i64) c = (col.i64[a] > col.i64[b]) - (col.i64[a] < col.i64[b]);
+                else c = col.codes[a] == col.codes[b] ? 0 : strings.decode(col.codes[a]).compare(strings.decode(col.codes[b]));
+                if (c != 0) return desc ? c > 0 : c < 0;
+            }
+            return false;
+        });
+    }
+
+    size_t offset = static_cast<size_t>(std::max<long long>(criteria.getOffset(), 0));
+    if (offset >= rows.size()) rows.clear();
+    else rows.erase(rows.begin(), rows.begin() + offset);
+    if (criteria.getLimit() >= 0 && static_cast<size_t>(criteria.getLimit()) < rows.size()) {
+        rows.resize(static_cast<size_t>(criteria.getLimit()));
+    }
+    return true;
+}
\ No newline at end of file
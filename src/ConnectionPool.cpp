@@ -0,0 +1,60 @@
+#include "ConnectionPool.h"
+
+ConnectionPool::Lease& ConnectionPool::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool = other.pool;
+        conn = other.conn;
+        other.conn = nullptr;
+    }
+    return *this;
+}
+
+void ConnectionPool::Lease::release() {
+    if (conn && pool) pool->giveBack(conn);
+    conn = nullptr;
+}
+
+ConnectionPool::ConnectionPool(const std::string& dsn, const std::string& user, const std::string& password, size_t maxSize)
+    : dsn(dsn), user(user), password(password), maxSize(maxSize == 0 ? 1 : maxSize) {}
+
+ConnectionPool::Lease ConnectionPool::acquire() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (idle.empty() && connections.size() >= maxSize) {
+        available.wait(lock);
+    }
+
+    if (!idle.empty()) {
+        DatabaseConnection* conn = idle.back();
+        idle.pop_back();
+        return Lease(this, conn);
+    }
+
+    // Резервируем место под новое соединение и подключаемся вне блокировки:
+    // SQLDriverConnect может занимать сотни миллисекунд.
+    connections.push_back(std::make_unique<DatabaseConnection>());
+    DatabaseConnection* conn = connections.back().get();
+    lock.unlock();
+
+    conn->setVerbose(false);
+    if (!conn->connect(dsn, user, password)) {
+        lock.lock();
+        for (auto it = connections.begin(); it != connections.end(); ++it) {
+            if (it->get() == conn) {
+                connections.erase(it);
+                break;
+            }
+        }
+        available.notify_one();
+        return Lease();
+    }
+    return Lease(this, conn);
+}
+
+void ConnectionPool::giveBack(DatabaseConnection* conn) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        idle.push_back(conn);
+    }
+    available.notify_one();
+}
\ No newline at end of file
@@ -0,0 +1,245 @@
+#include "CopyChannel.h"
+#include <cstdlib>
+#include <map>
+#ifdef REGENT_HAVE_LIBPQ
+#include <libpq-fe.h>
+#endif
+
+namespace {
+    // Значение параметра conninfo в кавычках: 'a\'b'
+    std::string quoteConninfo(const std::string& value) {
+        std::string out = "'";
+        for (char c : value) {
+            if (c == '\'' || c == '\\') out += '\\';
+            out += c;
+        }
+        out += '\'';
+        return out;
+    }
+
+    std::string upperAscii(std::string s) {
+        for (char& c : s) if (c >= 'a' && c <= 'z') c = static_cast<char>(c - 'a' + 'A');
+        return s;
+    }
+}
+
+std::string CopyChannel::conninfoFromOdbc(const std::string& odbcConnectionString) {
+    // Разбор "KEY=value;KEY={value;with;semicolons};..."
+    std::map<std::string, std::string> params;
+    size_t i = 0;
+    const std::string& s = odbcConnectionString;
+    while (i < s.size()) {
+        size_t eq = s.find('=', i);
+        if (eq == std::string::npos) break;
+        std::string key = upperAscii(s.substr(i, eq - i));
+        std::string value;
+        size_t j = eq + 1;
+        if (j < s.size() && s[j] == '{') {
+            size_t close = s.find('}', j + 1);
+            if (close == std::string::npos) close = s.size();
+            value = s.substr(j + 1, close - j - 1);
+            j = close + 1;
+            if (j < s.size() && s[j] == ';') ++j;
+        } else {
+            size_t semi = s.find(';', j);
+            if (semi == std::string::npos) semi = s.size();
+            value = s.substr(j, semi - j);
+            j = semi + 1;
+        }
+        params[key] = value;
+        i = j;
+    }
+
+    // Синонимы ключей драйвера PostgreSQL ODBC и соответствующие параметры libpq
+    const std::pair<const char*, const char*> mapping[] = {
+        {"SERVER", "host"}, {"SERVERNAME", "host"},
+        {"PORT", "port"},
+        {"DATABASE", "dbname"},
+        {"UID", "user"}, {"USERNAME", "user"},
+        {"PWD", "password"}, {"PASSWORD", "password"},
+        {"SSLMODE", "sslmode"}
+    };
+
+    std::map<std::string, std::string> libpq;
+    for (const auto& [odbcKey, pqKey] : mapping) {
+        auto it = params.find(odbcKey);
+        if (it != params.end() && !it->second.empty() && libpq.count(pqKey) == 0) libpq[pqKey] = it->second;
+    }
+
+    std::string conninfo;
+    for (const auto& [key, value] : libpq) {
+        if (!conninfo.empty()) conninfo += ' ';
+        conninfo += key + "=" + quoteConninfo(value);
+    }
+    return conninfo;
+}
+
+void CopyChannel::beginField() {
+    if (column > 0) buffer += '\t';
+    ++column;
+}
+
+void CopyChannel::field(const std::string& value) {
+    // Текстовый формат COPY: экранируются обратная косая черта и управляющие символы
+    beginField();
+    for (char c : value) {
+        switch (c) {
+            case '\\': buffer += "\\\\"; break;
+            case '\n': buffer += "\\n"; break;
+            case '\r': buffer += "\\r"; break;
+            case '\t': buffer += "\\t"; break;
+            default:   buffer += c;
+        }
+    }
+}
+
+void CopyChannel::field(long long value) {
+    beginField();
+    buffer += std::to_string(value);
+}
+
+void CopyChannel::field(Money value) {
+    beginField();
+    buffer += value.toString();
+}
+
+#ifdef REGENT_HAVE_LIBPQ
+
+CopyChannel::CopyChannel() : conn(nullptr), column(0) {}
+
+CopyChannel::~CopyChannel() {
+    close();
+}
+
+bool CopyChannel::isSupported() {
+    return true;
+}
+
+bool CopyChannel::open(const std::string& conninfo) {
+    close();
+    conn = PQconnectdb(conninfo.c_str());
+    if (PQstatus(conn) != CONNECTION_OK) {
+        error = PQerrorMessage(conn);
+        PQfinish(conn);
+        conn = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void CopyChannel::close() {
+    if (conn) {
+        PQfinish(conn);
+        conn = nullptr;
+    }
+}
+
+bool CopyChannel::execute(const std::string& sql, long long* affected) {
+    if (!conn) return false;
+    PGresult* res = PQexec(conn, sql.c_str());
+    ExecStatusType status = PQresultStatus(res);
+    bool ok = (status == PGRES_COMMAND_OK || status == PGRES_TUPLES_OK);
+    if (ok && affected) *affected = std::atoll(PQcmdTuples(res));
+    if (!ok) error = PQresultErrorMessage(res);
+    PQclear(res);
+    return ok;
+}
+
+bool CopyChannel::beginCopyIn(const std::string& copySql) {
+    if (!conn) return false;
+    buffer.clear();
+    PGresult* res = PQexec(conn, copySql.c_str());
+    bool ok = PQresultStatus(res) == PGRES_COPY_IN;
+    if (!ok) error = PQresultErrorMessage(res);
+    PQclear(res);
+    return ok;
+}
+
+bool CopyChannel::flush() {
+    if (buffer.empty()) return true;
+    if (PQputCopyData(conn, buffer.data(), static_cast<int>(buffer.size())) != 1) {
+        error = PQerrorMessage(conn);
+        return false;
+    }
+    buffer.clear();
+    return true;
+}
+
+bool CopyChannel::endRow() {
+    buffer += '\n';
+    return buffer.size() < FLUSH_SIZE || flush();
+}
+
+bool CopyChannel::endCopyIn(long long* rows) {
+    bool ok = flush();
+    if (PQputCopyEnd(conn, ok ? nullptr : "прервано клиентом") != 1) {
+        error = PQerrorMessage(conn);
+        ok = false;
+    }
+
+    PGresult* res;
+    while ((res = PQgetResult(conn)) != nullptr) {
+        if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+            if (ok) error = PQresultErrorMessage(res);
+            ok = false;
+        } else if (rows) {
+            *rows = std::atoll(PQcmdTuples(res));
+        }
+        PQclear(res);
+    }
+    return ok;
+}
+
+long long CopyChannel::copyOut(const std::string& copySql, const std::function<bool(const char*, size_t)>& sink) {
+    if (!conn) return -1;
+    PGresult* res = PQexec(conn, copySql.c_str());
+    if (PQresultStatus(res) != PGRES_COPY_OUT) {
+        error = PQresultErrorMessage(res);
+        PQclear(res);
+        return -1;
+    }
+    PQclear(res);
+
+    bool ok = true;
+    char* data = nullptr;
+    int len;
+    // Блокирующее чтение: libpq отдаёт данные по одной строке COPY
+    while ((len = PQgetCopyData(conn, &data, 0)) > 0) {
+        if (ok && !sink(data, static_cast<size_t>(len))) {
+            // Приёмник отказал — остаток не нужен: просим сервер прервать COPY,
+            // а уже отправленное дочитываем, чтобы соединение осталось рабочим
+            ok = false;
+            if (PGcancel* cancel = PQgetCancel(conn)) {
+                char reason[256];
+                PQcancel(cancel, reason, sizeof(reason));
+                PQfreeCancel(cancel);
+            }
+        }
+        PQfreemem(data);
+    }
+
+    long long rows = -1;
+    while ((res = PQgetResult(conn)) != nullptr) {
+        if (PQresultStatus(res) == PGRES_COMMAND_OK) rows = std::atoll(PQcmdTuples(res));
+        else error = PQresultErrorMessage(res);
+        PQclear(res);
+    }
+    if (!ok) error = "выгрузка прервана: приёмник данных отказал";
+    return ok ? rows : -1;
+}
+
+#else // Сборка без libpq: канал всегда недоступен
+
+CopyChannel::CopyChannel() : conn(nullptr), column(0) {}
+CopyChannel::~CopyChannel() {}
+bool CopyChannel::isSupported() { return false; }
+bool CopyChannel::open(const std::string&) { error = "приложение собрано без libpq"; return false; }
+void CopyChannel::close() {}
+bool CopyChannel::execute(const std::string&, long long*) { return false; }
+bool CopyChannel::beginCopyIn(const std::string&) { return false; }
+bool CopyChannel::flush() { return false; }
+bool CopyChannel::endRow() { return false; }
+bool CopyChannel::endCopyIn(long long*) { return false; }
+long long CopyChannel::copyOut(const std::string&, const std::function<bool(const char*, size_t)>&) { return -1; }
+
+#endif
\ No newline at end of file
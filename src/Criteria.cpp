@@ -0,0 +1,311 @@
+#include "Criteria.h"
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+    std::string trim(const std::string& s) {
+        size_t b = s.find_first_not_of(" \t\r\n");
+        if (b == std::string::npos) return "";
+        size_t e = s.find_last_not_of(" \t\r\n");
+        return s.substr(b, e - b + 1);
+    }
+
+    std::vector<std::string> split(const std::string& s, char sep) {
+        std::vector<std::string> parts;
+        size_t start = 0;
+        while (true) {
+            size_t pos = s.find(sep, start);
+            parts.push_back(trim(s.substr(start, pos == std::string::npos ? std::string::npos : pos - start)));
+            if (pos == std::string::npos) break;
+            start = pos + 1;
+        }
+        return parts;
+    }
+
+    bool isIdentChar(char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+    }
+
+    const char* opText(CriteriaOp op) {
+        switch (op) {
+            case CriteriaOp::Eq: return "=";
+            case CriteriaOp::Ne: return "!=";
+            case CriteriaOp::Lt: return "<";
+            case CriteriaOp::Le: return "<=";
+            case CriteriaOp::Gt: return ">";
+            case CriteriaOp::Ge: return ">=";
+            case CriteriaOp::Contains: return "~";
+            case CriteriaOp::StartsWith: return "^";
+        }
+        return "?";
+    }
+
+    // Экранирование спецсимволов шаблона LIKE (символ экранирования по умолчанию — '\')
+    std::string escapeLike(const std::string& s) {
+        std::string out;
+        out.reserve(s.size() + 2);
+        for (char c : s) {
+            if (c == '\\' || c == '%' || c == '_') out += '\\';
+            out += c;
+        }
+        return out;
+    }
+}
+
+// ==========================================
+// Criteria
+// ==========================================
+
+const CriteriaField* Criteria::findField(const std::vector<CriteriaField>& fields, const std::string& name) {
+    for (const auto& f : fields) {
+        if (name == f.name) return &f;
+    }
+    std::cerr << "Неизвестное поле \"" << name << "\". Доступны:";
+    for (const auto& f : fields) std::cerr << " " << f.name;
+    std::cerr << std::endl;
+    return nullptr;
+}
+
+std::string Criteria::textValue(const Value& value) {
+    if (const long long* n = std::get_if<long long>(&value)) return std::to_string(*n);
+    if (const Money* m = std::get_if<Money>(&value)) return m->toString();
+    return std::get<std::string>(value);
+}
+
+bool Criteria::numericValue(const CriteriaField& field, const Value& value, long long& out) {
+    if (field.type == FieldType::Money) {
+        Money m;
+        if (const Money* v = std::get_if<Money>(&value)) {
+            m = *v;
+        } else if (const std::string* s = std::get_if<std::string>(&value)) {
+            if (!Money::parse(*s, m)) {
+                std::cerr << "Поле " << field.name << " ожидает сумму, получено \"" << *s << "\"" << std::endl;
+                return false;
+            }
+        } else {
+            std::cerr << "Поле " << field.name << " ожидает сумму (Money), а не целое число" << std::endl;
+            return false;
+        }
+        out = m.toKopecks();
+        return true;
+    }
+
+    if (const long long* n = std::get_if<long long>(&value)) {
+        out = *n;
+    } else if (const std::string* s = std::get_if<std::string>(&value)) {
+        char* end = nullptr;
+        errno = 0;
+        out = std::strtoll(s->c_str(), &end, 10);
+        if (s->empty() || *end != '\0' || errno != 0) {
+            std::cerr << "Поле " << field.name << " ожидает целое число, получено \"" << *s << "\"" << std::endl;
+            return false;
+        }
+    } else {
+        std::cerr << "Поле " << field.name << " ожидает целое число, получена сумма" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+Criteria& Criteria::where(const std::string& field, CriteriaOp op, Value value) {
+    predicates.push_back(Predicate{field, op, std::move(value)});
+    return *this;
+}
+
+Criteria& Criteria::between(const std::string& field, Value from, Value to) {
+    where(field, CriteriaOp::Ge, std::move(from));
+    return where(field, CriteriaOp::Le, std::move(to));
+}
+
+Criteria& Criteria::orderBy(const std::string& field, bool descending) {
+    ordering.push_back(Order{field, descending});
+    return *this;
+}
+
+bool Criteria::parseFilter(const std::string& text) {
+    std::vector<Predicate> parsed;
+    for (const std::string& part : split(text, ';')) {
+        if (part.empty()) continue;
+
+        size_t pos = 0;
+        while (pos < part.size() && isIdentChar(part[pos])) ++pos;
+        std::string field = part.substr(0, pos);
+        while (pos < part.size() && part[pos] == ' ') ++pos;
+
+        // Двухсимвольные операторы проверяются раньше односимвольных
+        static const std::pair<const char*, CriteriaOp> ops[] = {
+            {"!=", CriteriaOp::Ne}, {"<=", CriteriaOp::Le}, {">=", CriteriaOp::Ge},
+            {"=", CriteriaOp::Eq},  {"<", CriteriaOp::Lt},  {">", CriteriaOp::Gt},
+            {"~", CriteriaOp::Contains}, {"^", CriteriaOp::StartsWith}
+        };
+        bool found = false;
+        CriteriaOp op = CriteriaOp::Eq;
+        for (const auto& [token, value] : ops) {
+            size_t len = std::char_traits<char>::length(token);
+            if (part.compare(pos, len, token) == 0) {
+                op = value;
+                pos += len;
+                found = true;
+                break;
+            }
+        }
+        if (field.empty() || !found) {
+            std::cerr << "Неверное условие фильтра: \"" << part << "\" (ожидается: поле оператор значение)" << std::endl;
+            return false;
+        }
+
+        std::string value = trim(part.substr(pos));
+        if (value.size() >= 2 && (value.front() == '"' || value.front() == '\'') && value.back() == value.front()) {
+            value = value.substr(1, value.size() - 2);
+        }
+        parsed.push_back(Predicate{field, op, value});
+    }
+
+    predicates.insert(predicates.end(), parsed.begin(), parsed.end());
+    return true;
+}
+
+bool Criteria::parseOrder(const std::string& text) {
+    std::vector<Order> parsed;
+    for (std::string part : split(text, ',')) {
+        if (part.empty()) continue;
+
+        bool descending = false;
+        if (part[0] == '-') {
+            descending = true;
+            part = trim(part.substr(1));
+        }
+        size_t space = part.find(' ');
+        if (space != std::string::npos) {
+            std::string dir = trim(part.substr(space));
+            for (char& c : dir) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            part = part.substr(0, space);
+            if (dir == "desc") descending = true;
+            else if (dir != "asc") part.clear();
+        }
+
+        bool valid = !part.empty();
+        for (char c : part) valid = valid && isIdentChar(c);
+        if (!valid) {
+            std::cerr << "Неверное поле сортировки в \"" << text << "\"" << std::endl;
+            return false;
+        }
+        parsed.push_back(Order{part, descending});
+    }
+
+    ordering = std::move(parsed);
+    return true;
+}
+
+std::string Criteria::describe() const {
+    std::string out;
+    for (const auto& p : predicates) {
+        if (!out.empty()) out += "; ";
+        out += p.field + " " + opText(p.op) + " " + textValue(p.value);
+    }
+    if (!ordering.empty()) {
+        if (!out.empty()) out += "; ";
+        out += "сортировка:";
+        for (size_t i = 0; i < ordering.size(); ++i) {
+            out += (i == 0 ? " " : ", ");
+            if (ordering[i].descending) out += "-";
+            out += ordering[i].field;
+        }
+    }
+    return out;
+}
+
+// ==========================================
+// CompiledCriteria
+// ==========================================
+
+bool CompiledCriteria::compile(const Criteria& criteria, const std::vector<CriteriaField>& fields,
+                               const std::string& keyOrder) {
+    params.clear();
+    where.clear();
+    orderBy.clear();
+    limit.clear();
+
+    for (const auto& p : criteria.getPredicates()) {
+        const CriteriaField* f = Criteria::findField(fields, p.field);
+        if (!f) return false;
+
+        Param param{FieldType::Text, 0, "", 0};
+        std::string condition;
+
+        if (p.op == CriteriaOp::Contains || p.op == CriteriaOp::StartsWith) {
+            if (f->type != FieldType::Text) {
+                std::cerr << "Поиск подстроки допустим только для текстовых полей (" << f->name << ")" << std::endl;
+                return false;
+            }
+            std::string pattern = escapeLike(Criteria::textValue(p.value));
+            param.text = (p.op == CriteriaOp::Contains ? "%" : "") + pattern + "%";
+            condition = std::string(f->sql) + " ILIKE ?";
+        } else {
+            switch (f->type) {
+                case FieldType::Text:
+                    param.text = Criteria::textValue(p.value);
+                    condition = std::string(f->sql) + " " + opText(p.op) + " ?";
+                    break;
+                case FieldType::Int:
+                    param.type = FieldType::Int;
+                    if (!Criteria::numericValue(*f, p.value, param.number)) return false;
+                    condition = std::string(f->sql) + " " + opText(p.op) + " ?";
+                    break;
+                case FieldType::Money:
+                    param.type = FieldType::Money;
+                    if (!Criteria::numericValue(*f, p.value, param.number)) return false;
+                    // Копейки переводятся в NUMERIC на сервере: сравнение точное,
+                    // а сам столбец остаётся без преобразования и может идти по индексу
+                    condition = std::string(f->sql) + " " + opText(p.op) + " CAST(? AS NUMERIC) / 100";
+                    break;
+                case FieldType::Timestamp:
+                    param.text = Criteria::textValue(p.value);
+                    condition = std::string(f->sql) + " " + opText(p.op) + " CAST(? AS TIMESTAMPTZ)";
+                    break;
+            }
+        }
+
+        params.push_back(std::move(param));
+        where += (where.empty() ? " WHERE " : " AND ") + condition;
+    }
+
+    bool keyListed = false;
+    for (const auto& o : criteria.getOrdering()) {
+        const CriteriaField* f = Criteria::findField(fields, o.field);
+        if (!f) return false;
+        orderBy += (orderBy.empty() ? " ORDER BY " : ", ") + std::string(f->sql);
+        if (o.descending) orderBy += " DESC";
+        keyListed = keyListed || keyOrder == f->sql;
+    }
+    if (!keyListed) orderBy += (orderBy.empty() ? " ORDER BY " : ", ") + keyOrder;
+
+    if (criteria.getLimit() >= 0) limit = " LIMIT " + std::to_string(criteria.getLimit());
+    if (criteria.getOffset() > 0) limit += " OFFSET " + std::to_string(criteria.getOffset());
+    return true;
+}
+
+bool CompiledCriteria::bind(SQLHSTMT hStmt) {
+    SQLUSMALLINT index = 1;
+    for (Param& p : params) {
+        SQLRETURN ret;
+        if (p.type == FieldType::Text) {
+            p.length = static_cast<SQLLEN>(p.text.size());
+            ret = SQLBindParameter(hStmt, index, SQL_PARAM_INPUT, SQL_C_CHAR, SQL_VARCHAR,
+                                   p.text.size() + 1, 0, (SQLPOINTER)p.text.c_str(),
+                                   static_cast<SQLLEN>(p.text.size() + 1), &p.length);
+        } else {
+            p.length = 0;
+            ret = SQLBindParameter(hStmt, index, SQL_PARAM_INPUT, SQL_C_SBIGINT, SQL_BIGINT,
+                                   0, 0, &p.number, 0, &p.length);
+        }
+        if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) {
+            std::cerr << "Ошибка привязки параметра " << index << std::endl;
+            return false;
+        }
+        ++index;
+    }
+    return true;
+}
\ No newline at end of file
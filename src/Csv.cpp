@@ -0,0 +1,108 @@
+#include "Csv.h"
+#include "Utf8.h"
+
+CsvReader::CsvReader(std::istream& input, char delim, size_t bufferSize)
+    : in(input), delimiter(delim), buffer(bufferSize), pos(0), end(0), line(1), recordLine(0), eof(false) {
+    // Пропускаем UTF-8 BOM, который добавляют табличные редакторы
+    if (fill() && end >= 3 &&
+        (unsigned char)buffer[0] == 0xEF && (unsigned char)buffer[1] == 0xBB && (unsigned char)buffer[2] == 0xBF) {
+        pos = 3;
+    }
+}
+
+bool CsvReader::fill() {
+    if (eof) return false;
+    in.read(buffer.data(), buffer.size());
+    end = static_cast<size_t>(in.gcount());
+    pos = 0;
+    if (end == 0) eof = true;
+    return end > 0;
+}
+
+int CsvReader::peekChar() {
+    if (pos >= end && !fill()) return -1;
+    return (unsigned char)buffer[pos];
+}
+
+int CsvReader::getChar() {
+    int c = peekChar();
+    if (c >= 0) {
+        ++pos;
+        if (c == '\n') ++line;
+    }
+    return c;
+}
+
+bool CsvReader::next(std::vector<std::string>& fields) {
+    fields.clear();
+
+    // Пустые строки между записями пропускаем
+    int c = peekChar();
+    while (c == '\n' || c == '\r') {
+        getChar();
+        c = peekChar();
+    }
+    if (c < 0) return false;
+
+    recordLine = line;
+    std::string field;
+    bool quoted = false;
+    bool fieldStarted = false;
+
+    while (true) {
+        c = getChar();
+        if (c < 0) {
+            fields.push_back(std::move(field));
+            return true;
+        }
+
+        if (quoted) {
+            if (c == '"') {
+                if (peekChar() == '"') { // Удвоенная кавычка внутри поля
+                    getChar();
+                    field += '"';
+                } else {
+                    quoted = false;
+                }
+            } else {
+                field += static_cast<char>(c);
+            }
+            continue;
+        }
+
+        if (c == '"' && !fieldStarted) {
+            quoted = true;
+            fieldStarted = true;
+        } else if (c == delimiter) {
+            fields.push_back(std::move(field));
+            field.clear();
+            fieldStarted = false;
+        } else if (c == '\r') {
+            // CR учитываем только как часть CRLF
+            if (peekChar() != '\n') field += '\r';
+        } else if (c == '\n') {
+            fields.push_back(std::move(field));
+            return true;
+        } else {
+            field += static_cast<char>(c);
+            fieldStarted = true;
+        }
+    }
+}
+
+void appendCsvField(std::string& out, const std::string& field, char delimiter) {
+    if (utf8::findCsvSpecial(field.data(), field.size(), delimiter) == field.size()) {
+        out += field;
+        return;
+    }
+
+    out += '"';
+    size_t start = 0;
+    for (size_t quote = field.find('"'); quote != std::string::npos; quote = field.find('"', start)) {
+        out.append(field, start, quote + 1 - start);
+        out += '"';
+        start = quote + 1;
+    }
+    out.append(field, start, std::string::npos);
+    out += '"';
+}
\ No newline at end of file
@@ -0,0 +1,252 @@
+#include "DataExporter.h"
+#include "Gateways.h"
+
+namespace {
+    const ExportDataset ALL_DATASETS[] = {
+        ExportDataset::Enterprises,
+        ExportDataset::Products,
+        ExportDataset::Assortment,
+        ExportDataset::SalesDepartments,
+        ExportDataset::BankDetails,
+        ExportDataset::Deletions
+    };
+
+    // Запросы для COPY: те же колонки, что пишет exportDataset. Цены приводятся
+    // к копейкам и обратно, как при чтении в Money, — два знака после точки.
+    // updatedAt — столбец для отбора по отметке времени (ExportOptions::since).
+    struct CopySource {
+        const char* select;
+        const char* updatedAt;
+        const char* order;
+    };
+
+    bool copySource(ExportDataset dataset, CopySource& source) {
+        switch (dataset) {
+            case ExportDataset::Enterprises:
+                source = {"SELECT e.enterprise_id, e.name, e.legal_form_id, lf.name AS legal_form, "
+                          "e.ownership_form_id, of.name AS ownership_form, e.postal_address, e.inn "
+                          "FROM enterprise e "
+                          "LEFT JOIN legal_form lf ON e.legal_form_id = lf.legal_form_id "
+                          "LEFT JOIN ownership_form of ON e.ownership_form_id = of.ownership_form_id",
+                          "e.updated_at", "e.enterprise_id"};
+                return true;
+            case ExportDataset::Products:
+                source = {"SELECT p.product_id, p.name, p.category_id, pc.name AS category, p.shelf_life_days, "
+                          "p.delivery_terms_id, dt.description AS delivery_terms, "
+                          "(COALESCE(p.retail_price * 100, 0)::BIGINT / 100.0)::NUMERIC(20,2) AS retail_price, "
+                          "(COALESCE(p.purchase_price * 100, 0)::BIGINT / 100.0)::NUMERIC(20,2) AS purchase_price "
+                          "FROM product p "
+                          "LEFT JOIN product_category pc ON p.category_id = pc.category_id "
+                          "LEFT JOIN delivery_terms dt ON p.delivery_terms_id = dt.delivery_terms_id",
+                          "p.updated_at", "p.product_id"};
+                return true;
+            case ExportDataset::Assortment:
+                source = {"SELECT enterprise_id, product_id, "
+                          "(COALESCE(wholesale_price * 100, 0)::BIGINT / 100.0)::NUMERIC(20,2) AS wholesale_price "
+                          "FROM enterprise_product",
+                          "updated_at", "enterprise_id, product_id"};
+                return true;
+            case ExportDataset::SalesDepartments:
+                source = {"SELECT sd.depart_id, sd.enterprise_id, e.name AS enterprise, sd.phone, sd.fax, sd.email, "
+                          "sd.contact_last_name, sd.contact_first_name, sd.contact_patronymic "
+                          "FROM sales_department sd JOIN enterprise e ON sd.enterprise_id = e.enterprise_id",
+                          "sd.updated_at", "sd.depart_id"};
+                return true;
+            case ExportDataset::BankDetails:
+                source = {"SELECT bd.bank_id, bd.enterprise_id, e.name AS enterprise, "
+                          "bd.bank_name, bd.bank_city, bd.account_number "
+                          "FROM bank_details bd JOIN enterprise e ON bd.enterprise_id = e.enterprise_id",
+                          "bd.updated_at", "bd.bank_id"};
+                return true;
+            case ExportDataset::Deletions:
+                return false;   // Строк немного — только через ODBC
+        }
+        return false;
+    }
+
+    // Строки, изменённые начиная с since; пустая строка — все
+    Criteria changedSince(const std::string& since) {
+        Criteria criteria;
+        if (!since.empty()) criteria.where("updated_at", CriteriaOp::Ge, since);
+        return criteria;
+    }
+}
+
+const char* DataExporter::datasetName(ExportDataset dataset) {
+    switch (dataset) {
+        case ExportDataset::Enterprises:      return "enterprises";
+        case ExportDataset::Products:         return "products";
+        case ExportDataset::Assortment:       return "assortment";
+        case ExportDataset::SalesDepartments: return "sales-departments";
+        case ExportDataset::BankDetails:      return "bank-details";
+        case ExportDataset::Deletions:        return "deleted";
+    }
+    return "";
+}
+
+bool DataExporter::parseDataset(const std::string& name, ExportDataset& dataset) {
+    for (ExportDataset d : ALL_DATASETS) {
+        if (name == datasetName(d)) {
+            dataset = d;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool DataExporter::supportsCopy(ExportDataset dataset) {
+    CopySource source;
+    return copySource(dataset, source);
+}
+
+bool DataExporter::isTimestamp(const std::string& text) {
+    // Разбор оставляем серверу; здесь отсекаем всё, кроме цифр и разделителей,
+    // чтобы значение можно было подставить в запрос COPY литералом
+    if (text.empty() || text.size() > 40) return false;
+    for (char c : text) {
+        bool allowed = (c >= '0' && c <= '9') || c == '-' || c == ':' || c == '.' || c == '+'
+                    || c == ' ' || c == 'T' || c == 'Z';
+        if (!allowed) return false;
+    }
+    return true;
+}
+
+std::string DataExporter::watermark() {
+    if (!db->isConnected()) return "";
+
+    // Незавершённая транзакция поставит своим строкам updated_at не раньше
+    // собственного начала, поэтому отметка не позже начала самой старой из них:
+    // следующая выгрузка с этой отметкой не пропустит строк, зафиксированных
+    // после текущей. Учитываются все открытые транзакции, а не только с
+    // backend_xid: номер выдаётся при первой записи, а её строки получат время
+    // начала транзакции. Из pg_stat_activity видны транзакции того же
+    // пользователя БД, то есть других копий программы.
+    const char* sql =
+        "SELECT to_char(LEAST(now(), COALESCE((SELECT MIN(xact_start) FROM pg_stat_activity "
+        "WHERE xact_start IS NOT NULL AND pid <> pg_backend_pid()), now())) AT TIME ZONE 'UTC', "
+        "'YYYY-MM-DD\"T\"HH24:MI:SS.US\"Z\"')";
+
+    SQLHSTMT hStmt;
+    SQLRETURN ret = SQLAllocHandle(SQL_HANDLE_STMT, db->getHandle(), &hStmt);
+    if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) return "";
+    SQLCHAR value[40];
+    value[0] = '\0';
+    ret = SQLExecDirect(hStmt, (SQLCHAR*)sql, SQL_NTS);
+    if ((ret == SQL_SUCCESS || ret == SQL_SUCCESS_WITH_INFO) && SQLFetch(hStmt) == SQL_SUCCESS) {
+        SQLGetData(hStmt, 1, SQL_C_CHAR, value, sizeof(value), nullptr);
+    }
+    SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+    return (char*)value;
+}
+
+long long DataExporter::exportDataset(ExportDataset dataset, ExportWriter& out, const std::string& since) {
+    switch (dataset) {
+        case ExportDataset::Enterprises: {
+            out.begin({"enterprise_id", "name", "legal_form_id", "legal_form", "ownership_form_id",
+                       "ownership_form", "postal_address", "inn"});
+            return EnterpriseGateway(db).streamWhere(changedSince(since), [&out](const Enterprise& e) {
+                out.beginRow();
+                out.field(e.id);
+                out.field(e.name);
+                out.field(e.legal_form_id);
+                out.field(e.legal_form_name);
+                out.field(e.ownership_form_id);
+                out.field(e.ownership_form_name);
+                out.field(e.postal_address);
+                out.field(e.inn);
+                out.endRow();
+                return out.good();
+            });
+        }
+        case ExportDataset::Products: {
+            out.begin({"product_id", "name", "category_id", "category", "shelf_life_days",
+                       "delivery_terms_id", "delivery_terms", "retail_price", "purchase_price"});
+            return ProductGateway(db).streamWhere(changedSince(since), [&out](const Product& p) {
+                out.beginRow();
+                out.field(p.id);
+                out.field(p.name);
+                out.field(p.category_id);
+                out.field(p.category_name);
+                out.field(p.shelf_life_days);
+                out.field(p.delivery_terms_id);
+                out.field(p.delivery_terms_description);
+                out.field(p.retail_price);
+                out.field(p.purchase_price);
+                out.endRow();
+                return out.good();
+            });
+        }
+        case ExportDataset::Assortment: {
+            out.begin({"enterprise_id", "product_id", "wholesale_price"});
+            return EnterpriseProductGateway(db).streamWhere(changedSince(since), [&out](const EnterpriseProduct& ep) {
+                out.beginRow();
+                out.field(ep.enterprise_id);
+                out.field(ep.product_id);
+                out.field(ep.wholesale_price);
+                out.endRow();
+                return out.good();
+            });
+        }
+        case ExportDataset::SalesDepartments: {
+            out.begin({"depart_id", "enterprise_id", "enterprise", "phone", "fax", "email",
+                       "contact_last_name", "contact_first_name", "contact_patronymic"});
+            return SalesDepartmentGateway(db).streamWhere(changedSince(since), [&out](const SalesDepartment& sd) {
+                out.beginRow();
+                out.field(sd.id);
+                out.field(sd.enterprise_id);
+                out.field(sd.enterprise_name);
+                out.field(sd.phone);
+                out.field(sd.fax);
+                out.field(sd.email);
+                out.field(sd.contact_last_name);
+                out.field(sd.contact_first_name);
+                out.field(sd.contact_patronymic);
+                out.endRow();
+                return out.good();
+            });
+        }
+        case ExportDataset::BankDetails: {
+            out.begin({"bank_id", "enterprise_id", "enterprise", "bank_name", "bank_city", "account_number"});
+            return BankDetailsGateway(db).streamWhere(changedSince(since), [&out](const BankDetails& bd) {
+                out.beginRow();
+                out.field(bd.id);
+                out.field(bd.enterprise_id);
+                out.field(bd.enterprise_name);
+                out.field(bd.bank_name);
+                out.field(bd.bank_city);
+                out.field(bd.account_number);
+                out.endRow();
+                return out.good();
+            });
+        }
+        case ExportDataset::Deletions: {
+            out.begin({"table", "key", "deleted_at"});
+            return TombstoneGateway(db).streamSince(since, [&out](const Tombstone& t) {
+                out.beginRow();
+                out.field(t.table);
+                out.field(t.key);
+                out.field(t.deleted_at);
+                out.endRow();
+                return out.good();
+            });
+        }
+    }
+    return -1;
+}
+
+long long DataExporter::exportDatasetViaCopy(ExportDataset dataset, CopyChannel& channel, ExportWriter& out,
+                                             const std::string& since) {
+    CopySource source;
+    if (!copySource(dataset, source) || !channel.isOpen()) return -1;
+    if (!since.empty() && !isTimestamp(since)) return -1;
+
+    std::string query = source.select;
+    if (!since.empty()) query += std::string(" WHERE ") + source.updatedAt + " >= '" + since + "'::TIMESTAMPTZ";
+    query += std::string(" ORDER BY ") + source.order;
+
+    std::string sql = "COPY (" + query + ") TO STDOUT WITH (FORMAT csv, HEADER)";
+    return channel.copyOut(sql, [&out](const char* data, size_t len) {
+        out.writeRaw(data, len);
+        return out.good();
+    });
+}
\ No newline at end of file
@@ -1,12 +1,14 @@
 #include "DatabaseConnection.h"
+#include <algorithm>
 
-DatabaseConnection::DatabaseConnection() : hEnv(SQL_NULL_HANDLE), hDbc(SQL_NULL_HANDLE), connected(false) {}
+DatabaseConnection::DatabaseConnection() : hEnv(SQL_NULL_HANDLE), hDbc(SQL_NULL_HANDLE), connected(false), verbose(true) {}
 
 DatabaseConnection::~DatabaseConnection() {
     disconnect();
 }
 
-bool DatabaseConnection::connect(const std::string& dsn, const std::string& user, const std::string& password) {
+bool DatabaseConnection::connect(const std::string& dsn, const std::string& user, const std::string& password,
+                                 const std::string& options) {
     SQLRETURN ret;
 
     // Инициализация среды
@@ -35,8 +37,11 @@ bool DatabaseConnection::connect(const std::string& dsn, const std::string& user
     SQLCHAR outConnStr[1024];
     SQLSMALLINT outConnStrLen;
 
+    std::string connStr = "DSN=" + dsn + ";UID=" + user + ";PWD=" + password;
+    if (!options.empty()) connStr += ";" + options;
+
     ret = SQLDriverConnect(hDbc, nullptr,
-                           (SQLCHAR*)("DSN=" + dsn + ";UID=" + user + ";PWD=" + password).c_str(),
+                           (SQLCHAR*)connStr.c_str(),
                            SQL_NTS, outConnStr, sizeof(outConnStr), &outConnStrLen,
                            SQL_DRIVER_NOPROMPT);
 
@@ -50,8 +55,9 @@ bool DatabaseConnection::connect(const std::string& dsn, const std::string& user
         return false;
     }
 
+    connectionString.assign((char*)outConnStr, outConnStrLen > 0 ? std::min<size_t>(outConnStrLen, sizeof(outConnStr) - 1) : 0);
     connected = true;
-    std::cout << "Подключено к БД через ODBC." << std::endl;
+    if (verbose) std::cout << "Подключено к БД через ODBC." << std::endl;
     return true;
 }
 
@@ -61,7 +67,7 @@ void DatabaseConnection::disconnect() {
         SQLFreeHandle(SQL_HANDLE_DBC, hDbc);
         SQLFreeHandle(SQL_HANDLE_ENV, hEnv);
         connected = false;
-        std::cout << "Отключено от БД." << std::endl;
+        if (verbose) std::cout << "Отключено от БД." << std::endl;
     }
 }
 
@@ -90,4 +96,58 @@ bool DatabaseConnection::executeQuery(const std::string& sql) {
 
     SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
     return true;
+}
+
+long DatabaseConnection::executeUpdate(const std::string& sql) {
+    if (!connected) {
+        std::cerr << "Не подключено к БД!" << std::endl;
+        return -1;
+    }
+
+    SQLHSTMT hStmt;
+    SQLRETURN ret = SQLAllocHandle(SQL_HANDLE_STMT, hDbc, &hStmt);
+    if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) {
+        std::cerr << "Ошибка при выделении оператора SQL" << std::endl;
+        return -1;
+    }
+
+    ret = SQLExecDirect(hStmt, (SQLCHAR*)sql.c_str(), SQL_NTS);
+    // SQL_NO_DATA — запрос выполнен, но не затронул ни одной строки
+    if (ret == SQL_NO_DATA) {
+        SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+        return 0;
+    }
+    if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) {
+        SQLCHAR sqlState[6], message[512];
+        SQLINTEGER nativeError;
+        SQLGetDiagRec(SQL_HANDLE_STMT, hStmt, 1, sqlState, &nativeError, message, sizeof(message), nullptr);
+        std::cerr << "Ошибка выполнения запроса: " << message << " (SQLSTATE: " << sqlState << ")" << std::endl;
+        SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+        return -1;
+    }
+
+    SQLLEN rows = 0;
+    SQLRowCount(hStmt, &rows);
+    SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+    return static_cast<long>(rows);
+}
+
+bool DatabaseConnection::beginTransaction() {
+    if (!connected) return false;
+    SQLRETURN ret = SQLSetConnectAttr(hDbc, SQL_ATTR_AUTOCOMMIT, (SQLPOINTER)SQL_AUTOCOMMIT_OFF, 0);
+    return ret == SQL_SUCCESS || ret == SQL_SUCCESS_WITH_INFO;
+}
+
+bool DatabaseConnection::commit() {
+    if (!connected) return false;
+    SQLRETURN ret = SQLEndTran(SQL_HANDLE_DBC, hDbc, SQL_COMMIT);
+    SQLSetConnectAttr(hDbc, SQL_ATTR_AUTOCOMMIT, (SQLPOINTER)SQL_AUTOCOMMIT_ON, 0);
+    return ret == SQL_SUCCESS || ret == SQL_SUCCESS_WITH_INFO;
+}
+
+bool DatabaseConnection::rollback() {
+    if (!connected) return false;
+    SQLRETURN ret = SQLEndTran(SQL_HANDLE_DBC, hDbc, SQL_ROLLBACK);
+    SQLSetConnectAttr(hDbc, SQL_ATTR_AUTOCOMMIT, (SQLPOINTER)SQL_AUTOCOMMIT_ON, 0);
+    return ret == SQL_SUCCESS || ret == SQL_SUCCESS_WITH_INFO;
 }
\ No newline at end of file
@@ -0,0 +1,84 @@
+#include "Gateways.h"
+
+// Справочники не имеют собственных сущностей-DTO: у всех четырёх таблиц
+// одна структура (ID + уникальное имя), поэтому они обслуживаются одним шлюзом.
+
+namespace {
+    struct DictionaryTable {
+        const char* table;
+        const char* idColumn;
+        const char* nameColumn;
+    };
+
+    DictionaryTable tableFor(Dictionary dict) {
+        switch (dict) {
+            case Dictionary::LegalForm:       return {"legal_form", "legal_form_id", "name"};
+            case Dictionary::OwnershipForm:   return {"ownership_form", "ownership_form_id", "name"};
+            case Dictionary::ProductCategory: return {"product_category", "category_id", "name"};
+            case Dictionary::DeliveryTerms:   return {"delivery_terms", "delivery_terms_id", "description"};
+        }
+        return {"legal_form", "legal_form_id", "name"};
+    }
+}
+
+void DictionaryGateway::createTableIfNotExists() {
+    // Справочник организационно-правовых форм
+    db->executeQuery(R"(
+        CREATE TABLE IF NOT EXISTS legal_form (
+            legal_form_id SERIAL PRIMARY KEY,
+            name TEXT NOT NULL UNIQUE
+        );
+    )");
+
+    // Справочник форм собственности
+    db->executeQuery(R"(
+        CREATE TABLE IF NOT EXISTS ownership_form (
+            ownership_form_id SERIAL PRIMARY KEY,
+            name TEXT NOT NULL UNIQUE
+        );
+    )");
+
+    // Справочник категорий товаров
+    db->executeQuery(R"(
+        CREATE TABLE IF NOT EXISTS product_category (
+            category_id SERIAL PRIMARY KEY,
+            name TEXT NOT NULL UNIQUE
+        );
+    )");
+
+    // Справочник условий поставки
+    db->executeQuery(R"(
+        CREATE TABLE IF NOT EXISTS delivery_terms (
+            delivery_terms_id SERIAL PRIMARY KEY,
+            description TEXT NOT NULL UNIQUE
+        );
+    )");
+}
+
+std::vector<DictionaryEntry> DictionaryGateway::findAll(Dictionary dict) {
+    std::vector<DictionaryEntry> list;
+    if (!db->isConnected()) return list;
+
+    DictionaryTable t = tableFor(dict);
+    std::string sql = std::string("SELECT ") + t.idColumn + ", " + t.nameColumn +
+                      " FROM " + t.table + " ORDER BY " + t.idColumn;
+
+    SQLHSTMT hStmt;
+    SQLAllocHandle(SQL_HANDLE_STMT, db->getHandle(), &hStmt);
+    SQLExecDirect(hStmt, (SQLCHAR*)sql.c_str(), SQL_NTS);
+
+    DictionaryEntry entry;
+    SQLCHAR name[256];
+    SQLRETURN ret;
+    while (SQL_SUCCEEDED(ret = SQLFetch(hStmt))) {
+        name[0] = '\0';
+        SQLGetData(hStmt, 1, SQL_C_LONG, &entry.id, 0, nullptr);
+        SQLGetData(hStmt, 2, SQL_C_CHAR, name, sizeof(name), nullptr);
+        entry.name = (char*)name;
+        list.push_back(entry);
+    }
+    bool complete = fetchCompleted(hStmt, ret);
+    SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+    if (!complete) return {};
+    return list;
+}
\ No newline at end of file
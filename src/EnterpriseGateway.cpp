@@ -1,4 +1,5 @@
 #include "Gateways.h"
+#include "ParamBatch.h"
 #include <sstream>
 
 void EnterpriseGateway::createTableIfNotExists() {
@@ -14,30 +15,68 @@ void EnterpriseGateway::createTableIfNotExists() {
         );
     )";
     db->executeQuery(sql);
+
+    // Индексы под частые фильтры списка (см. criteriaFields)
+    db->executeQuery("CREATE INDEX IF NOT EXISTS enterprise_legal_form_idx ON enterprise (legal_form_id)");
+    db->executeQuery("CREATE INDEX IF NOT EXISTS enterprise_ownership_form_idx ON enterprise (ownership_form_id)");
 }
 
 std::vector<Enterprise> EnterpriseGateway::findAll() {
     std::vector<Enterprise> list;
-    if (!db->isConnected()) return list;
-
-    SQLHSTMT hStmt;
-    SQLAllocHandle(SQL_HANDLE_STMT, db->getHandle(), &hStmt);
+    if (streamAll([&list](const Enterprise& e) { list.push_back(e); return true; }) < 0) return {};
+    return list;
+}
 
-    std::string sql = R"(
+namespace {
+    const char* ENTERPRISE_SELECT = R"(
         SELECT e.enterprise_id, e.name, e.legal_form_id, e.ownership_form_id, 
                e.postal_address, e.inn, lf.name, of.name
+    )";
+    const char* ENTERPRISE_FROM = R"(
         FROM enterprise e
         LEFT JOIN legal_form lf ON e.legal_form_id = lf.legal_form_id
         LEFT JOIN ownership_form of ON e.ownership_form_id = of.ownership_form_id
-        ORDER BY e.enterprise_id
     )";
+}
+
+const std::vector<CriteriaField>& EnterpriseGateway::criteriaFields() {
+    static const std::vector<CriteriaField> fields = {
+        {"id", "e.enterprise_id", FieldType::Int},
+        {"name", "e.name", FieldType::Text},
+        {"inn", "e.inn", FieldType::Text},
+        {"address", "e.postal_address", FieldType::Text},
+        {"legal_form_id", "e.legal_form_id", FieldType::Int},
+        {"legal_form", "lf.name", FieldType::Text},
+        {"ownership_form_id", "e.ownership_form_id", FieldType::Int},
+        {"ownership_form", "of.name", FieldType::Text},
+        {"created_at", "e.created_at", FieldType::Timestamp},
+        {"updated_at", "e.updated_at", FieldType::Timestamp}
+    };
+    return fields;
+}
 
-    SQLExecDirect(hStmt, (SQLCHAR*)sql.c_str(), SQL_NTS);
+std::vector<Enterprise> EnterpriseGateway::findWhere(const Criteria& criteria) {
+    std::vector<Enterprise> list;
+    if (streamWhere(criteria, [&list](const Enterprise& e) { list.push_back(e); return true; }) < 0) return {};
+    return list;
+}
+
+long long EnterpriseGateway::countWhere(const Criteria& criteria) {
+    return countQuery(ENTERPRISE_FROM, criteria, criteriaFields());
+}
+
+long long EnterpriseGateway::streamWhere(const Criteria& criteria, const RowCallback<Enterprise>& callback) {
+    SQLHSTMT hStmt = openQuery(std::string(ENTERPRISE_SELECT) + ENTERPRISE_FROM, criteria,
+                               criteriaFields(), "e.enterprise_id");
+    if (hStmt == SQL_NULL_HSTMT) return -1;
 
     Enterprise e;
     SQLCHAR name[256], addr[256], inn[64], lf_name[128], of_name[128];
+    long long count = 0;
     
-    while (SQLFetch(hStmt) == SQL_SUCCESS) {
+    SQLRETURN ret;
+    while (SQL_SUCCEEDED(ret = SQLFetch(hStmt))) {
+        lf_name[0] = of_name[0] = '\0';
         SQLGetData(hStmt, 1, SQL_C_LONG, &e.id, 0, nullptr);
         SQLGetData(hStmt, 2, SQL_C_CHAR, name, sizeof(name), nullptr);
         SQLGetData(hStmt, 3, SQL_C_LONG, &e.legal_form_id, 0, nullptr);
@@ -52,10 +91,12 @@ std::vector<Enterprise> EnterpriseGateway::findAll() {
         e.inn = (char*)inn;
         e.legal_form_name = (char*)lf_name;
         e.ownership_form_name = (char*)of_name;
-        list.push_back(e);
+        ++count;
+        if (!callback(e)) break;
     }
+    bool complete = fetchCompleted(hStmt, ret);
     SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
-    return list;
+    return complete ? count : -1;
 }
 
 Enterprise EnterpriseGateway::findById(int id) {
@@ -148,4 +189,26 @@ Enterprise EnterpriseGateway::findByInn(const std::string& inn) {
     }
     SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
     return e;
+}
+
+long EnterpriseGateway::insertBatch(const std::vector<Enterprise>& batch, bool upsert) {
+    if (batch.empty()) return 0;
+
+    std::string sql =
+        "INSERT INTO enterprise (name, legal_form_id, ownership_form_id, postal_address, inn) "
+        "VALUES (?, ?, ?, ?, ?) ON CONFLICT (inn) DO ";
+    if (upsert) {
+        sql += "UPDATE SET name = EXCLUDED.name, legal_form_id = EXCLUDED.legal_form_id, "
+               "ownership_form_id = EXCLUDED.ownership_form_id, postal_address = EXCLUDED.postal_address";
+    } else {
+        sql += "NOTHING";
+    }
+
+    ParamBatch params(db, sql, batch.size());
+    params.addText(batch, [](const Enterprise& e) -> const std::string& { return e.name; });
+    params.addInt(batch, [](const Enterprise& e) { return e.legal_form_id; });
+    params.addInt(batch, [](const Enterprise& e) { return e.ownership_form_id; });
+    params.addText(batch, [](const Enterprise& e) -> const std::string& { return e.postal_address; });
+    params.addText(batch, [](const Enterprise& e) -> const std::string& { return e.inn; });
+    return params.execute();
 }
\ No newline at end of file
@@ -1,5 +1,12 @@
 #include "Gateways.h"
+#include "ParamBatch.h"
+#include <algorithm>
 #include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <locale>
+#include <unordered_map>
+#include <unordered_set>
 
 void EnterpriseProductGateway::createTableIfNotExists() {
     db->executeQuery(R"(
@@ -10,6 +17,11 @@ void EnterpriseProductGateway::createTableIfNotExists() {
             PRIMARY KEY (enterprise_id, product_id)
         );
     )");
+
+    // Поиск предложений товара по возрастанию цены (findBestOffers): первичный ключ
+    // начинается с enterprise_id и для поиска по товару не годится
+    db->executeQuery("CREATE INDEX IF NOT EXISTS enterprise_product_offer_idx "
+                     "ON enterprise_product (product_id, wholesale_price, enterprise_id)");
 }
 
 std::vector<EnterpriseProduct> EnterpriseProductGateway::findByEnterprise(int enterprise_id) {
@@ -19,17 +31,24 @@ std::vector<EnterpriseProduct> EnterpriseProductGateway::findByEnterprise(int en
     SQLHSTMT hStmt;
     SQLAllocHandle(SQL_HANDLE_STMT, db->getHandle(), &hStmt);
     std::ostringstream oss;
-    oss << "SELECT enterprise_id, product_id, wholesale_price FROM enterprise_product WHERE enterprise_id=" << enterprise_id;
+    oss << "SELECT enterprise_id, product_id, (wholesale_price * 100)::BIGINT FROM enterprise_product WHERE enterprise_id=" << enterprise_id;
     SQLExecDirect(hStmt, (SQLCHAR*)oss.str().c_str(), SQL_NTS);
 
     EnterpriseProduct ep;
-    while (SQLFetch(hStmt) == SQL_SUCCESS) {
+    SQLBIGINT wholesale; // Копейки
+    SQLLEN wholesaleLen;
+    SQLRETURN ret;
+    while (SQL_SUCCEEDED(ret = SQLFetch(hStmt))) {
         SQLGetData(hStmt, 1, SQL_C_LONG, &ep.enterprise_id, 0, nullptr);
         SQLGetData(hStmt, 2, SQL_C_LONG, &ep.product_id, 0, nullptr);
-        SQLGetData(hStmt, 3, SQL_C_DOUBLE, &ep.wholesale_price, 0, nullptr);
+        SQLGetData(hStmt, 3, SQL_C_SBIGINT, &wholesale, 0, &wholesaleLen);
+        ep.has_wholesale_price = wholesaleLen != SQL_NULL_DATA;
+        ep.wholesale_price = Money::fromKopecks(ep.has_wholesale_price ? wholesale : 0);
         list.push_back(ep);
     }
+    bool complete = fetchCompleted(hStmt, ret);
     SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+    if (!complete) return {};
     return list;
 }
 
@@ -45,24 +64,142 @@ std::vector<EnterpriseProduct> EnterpriseProductGateway::findByProduct(int produ
 
     // Формируем запрос: выбираем все предприятия, у которых есть конкретный товар
     std::ostringstream oss;
-    oss << "SELECT enterprise_id, product_id, wholesale_price "
+    oss << "SELECT enterprise_id, product_id, (wholesale_price * 100)::BIGINT "
         << "FROM enterprise_product WHERE product_id=" << product_id;
 
     SQLExecDirect(hStmt, (SQLCHAR*)oss.str().c_str(), SQL_NTS);
 
     EnterpriseProduct ep;
-    while (SQLFetch(hStmt) == SQL_SUCCESS) {
+    SQLBIGINT wholesale; // Копейки
+    SQLLEN wholesaleLen;
+    while (SQL_SUCCEEDED(ret = SQLFetch(hStmt))) {
         SQLGetData(hStmt, 1, SQL_C_LONG, &ep.enterprise_id, 0, nullptr);
         SQLGetData(hStmt, 2, SQL_C_LONG, &ep.product_id, 0, nullptr);
-        SQLGetData(hStmt, 3, SQL_C_DOUBLE, &ep.wholesale_price, 0, nullptr);
+        SQLGetData(hStmt, 3, SQL_C_SBIGINT, &wholesale, 0, &wholesaleLen);
+        ep.has_wholesale_price = wholesaleLen != SQL_NULL_DATA;
+        ep.wholesale_price = Money::fromKopecks(ep.has_wholesale_price ? wholesale : 0);
         
         list.push_back(ep);
     }
 
+    bool complete = fetchCompleted(hStmt, ret);
     SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+    if (!complete) return {};
+    return list;
+}
+
+std::vector<ProductOffer> EnterpriseProductGateway::findBestOffers(const std::vector<int>& product_ids, size_t topN) {
+    std::vector<ProductOffer> list;
+    if (!db->isConnected()) return list;
+
+    // Повторы в списке товаров отбрасываются, порядок первых вхождений сохраняется
+    std::vector<int> ids;
+    std::unordered_set<int> seen;
+    for (int id : product_ids) {
+        if (seen.insert(id).second) ids.push_back(id);
+    }
+
+    for (size_t start = 0; start < ids.size(); start += OFFER_BATCH) {
+        size_t end = std::min(ids.size(), start + OFFER_BATCH);
+
+        // LATERAL с LIMIT по каждому товару: сервер читает индекс
+        // enterprise_product_offer_idx с начала диапазона товара и останавливается
+        // на topN-й строке, не сортируя все предложения
+        std::ostringstream oss;
+        oss << "SELECT t.product_id, o.enterprise_id, e.name, (o.wholesale_price * 100)::BIGINT "
+            << "FROM (VALUES ";
+        for (size_t i = start; i < end; ++i) {
+            if (i > start) oss << ", ";
+            oss << "(" << ids[i] << ", " << i << ")";
+        }
+        oss << ") AS t(product_id, ord) "
+            << "CROSS JOIN LATERAL (SELECT ep.enterprise_id, ep.wholesale_price FROM enterprise_product ep "
+            << "WHERE ep.product_id = t.product_id AND ep.wholesale_price IS NOT NULL "
+            << "ORDER BY ep.wholesale_price, ep.enterprise_id";
+        if (topN > 0) oss << " LIMIT " << topN;
+        oss << ") AS o "
+            << "JOIN enterprise e ON e.enterprise_id = o.enterprise_id "
+            << "ORDER BY t.ord, o.wholesale_price, o.enterprise_id";
+
+        SQLHSTMT hStmt;
+        SQLRETURN ret = SQLAllocHandle(SQL_HANDLE_STMT, db->getHandle(), &hStmt);
+        if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) return {};
+        ret = SQLExecDirect(hStmt, (SQLCHAR*)oss.str().c_str(), SQL_NTS);
+        if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) {
+            std::cerr << "Ошибка поиска предложений товара." << std::endl;
+            SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+            return {};
+        }
+
+        ProductOffer o;
+        SQLCHAR name[256];
+        SQLBIGINT wholesale;
+        while (SQL_SUCCEEDED(ret = SQLFetch(hStmt))) {
+            name[0] = '\0';
+            SQLGetData(hStmt, 1, SQL_C_LONG, &o.product_id, 0, nullptr);
+            SQLGetData(hStmt, 2, SQL_C_LONG, &o.enterprise_id, 0, nullptr);
+            SQLGetData(hStmt, 3, SQL_C_CHAR, name, sizeof(name), nullptr);
+            SQLGetData(hStmt, 4, SQL_C_SBIGINT, &wholesale, 0, nullptr);
+            // Строки одного товара идут подряд по возрастанию цены
+            o.rank = (!list.empty() && list.back().product_id == o.product_id) ? list.back().rank + 1 : 1;
+            o.enterprise_name = (char*)name;
+            o.wholesale_price = Money::fromKopecks(wholesale);
+            list.push_back(o);
+        }
+        bool complete = fetchCompleted(hStmt, ret);
+        SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+        if (!complete) return {};
+    }
     return list;
 }
 
+const std::vector<CriteriaField>& EnterpriseProductGateway::criteriaFields() {
+    static const std::vector<CriteriaField> fields = {
+        {"enterprise_id", "enterprise_id", FieldType::Int},
+        {"product_id", "product_id", FieldType::Int},
+        {"wholesale_price", "wholesale_price", FieldType::Money},
+        {"created_at", "created_at", FieldType::Timestamp},
+        {"updated_at", "updated_at", FieldType::Timestamp}
+    };
+    return fields;
+}
+
+std::vector<EnterpriseProduct> EnterpriseProductGateway::findWhere(const Criteria& criteria) {
+    std::vector<EnterpriseProduct> list;
+    if (streamWhere(criteria, [&list](const EnterpriseProduct& ep) { list.push_back(ep); return true; }) < 0) return {};
+    return list;
+}
+
+long long EnterpriseProductGateway::countWhere(const Criteria& criteria) {
+    return countQuery("FROM enterprise_product", criteria, criteriaFields());
+}
+
+long long EnterpriseProductGateway::streamWhere(const Criteria& criteria,
+                                                const RowCallback<EnterpriseProduct>& callback) {
+    SQLHSTMT hStmt = openQuery(
+        "SELECT enterprise_id, product_id, (wholesale_price * 100)::BIGINT FROM enterprise_product",
+        criteria, criteriaFields(), "enterprise_id, product_id");
+    if (hStmt == SQL_NULL_HSTMT) return -1;
+
+    EnterpriseProduct ep;
+    SQLBIGINT wholesale;
+    SQLLEN wholesaleLen;
+    long long count = 0;
+    SQLRETURN ret;
+    while (SQL_SUCCEEDED(ret = SQLFetch(hStmt))) {
+        SQLGetData(hStmt, 1, SQL_C_LONG, &ep.enterprise_id, 0, nullptr);
+        SQLGetData(hStmt, 2, SQL_C_LONG, &ep.product_id, 0, nullptr);
+        SQLGetData(hStmt, 3, SQL_C_SBIGINT, &wholesale, 0, &wholesaleLen);
+        ep.has_wholesale_price = wholesaleLen != SQL_NULL_DATA;
+        ep.wholesale_price = Money::fromKopecks(ep.has_wholesale_price ? wholesale : 0);
+        ++count;
+        if (!callback(ep)) break;
+    }
+    bool complete = fetchCompleted(hStmt, ret);
+    SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+    return complete ? count : -1;
+}
+
 bool EnterpriseProductGateway::insert(const EnterpriseProduct& item) {
     std::ostringstream oss;
     oss << "INSERT INTO enterprise_product (enterprise_id, product_id, wholesale_price) VALUES ("
@@ -81,4 +218,145 @@ bool EnterpriseProductGateway::remove(int enterprise_id, int product_id) {
     std::ostringstream oss;
     oss << "DELETE FROM enterprise_product WHERE enterprise_id=" << enterprise_id << " AND product_id=" << product_id;
     return db->executeQuery(oss.str());
+}
+
+int EnterpriseProductGateway::countByEnterprise(int enterprise_id) {
+    if (!db->isConnected()) return -1;
+
+    SQLHSTMT hStmt;
+    SQLRETURN ret = SQLAllocHandle(SQL_HANDLE_STMT, db->getHandle(), &hStmt);
+    if (!SQL_SUCCEEDED(ret)) return -1;
+    std::ostringstream oss;
+    oss << "SELECT COUNT(*) FROM enterprise_product WHERE enterprise_id=" << enterprise_id;
+    int count = -1;
+    ret = SQLExecDirect(hStmt, (SQLCHAR*)oss.str().c_str(), SQL_NTS);
+    if (SQL_SUCCEEDED(ret) && SQL_SUCCEEDED(SQLFetch(hStmt))) {
+        SQLGetData(hStmt, 1, SQL_C_LONG, &count, 0, nullptr);
+    }
+    SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+    if (count < 0) std::cerr << "Ошибка: Не удалось подсчитать ассортимент предприятия." << std::endl;
+    return count;
+}
+
+long EnterpriseProductGateway::copyAssortment(int source_enterprise_id, const std::vector<int>& target_ids,
+                                              double priceMultiplier, AssortmentConflictPolicy policy) {
+    if (target_ids.empty()) return 0;
+
+    // Множитель подставляется как числовой литерал NUMERIC, чтобы округление
+    // выполнялось на стороне сервера в десятичной арифметике, а не в double.
+    std::ostringstream mult;
+    mult.imbue(std::locale::classic());
+    mult << std::setprecision(12) << priceMultiplier;
+
+    // Целевые предприятия передаются списком VALUES; JOIN с enterprise отсекает
+    // несуществующие ID, чтобы одна опечатка не срывала весь пакет по внешнему ключу.
+    std::ostringstream oss;
+    oss << "INSERT INTO enterprise_product (enterprise_id, product_id, wholesale_price) "
+        << "SELECT t.enterprise_id, ep.product_id, ROUND(ep.wholesale_price * " << mult.str() << "::NUMERIC, 2) "
+        << "FROM enterprise_product ep "
+        << "CROSS JOIN (VALUES ";
+    for (size_t i = 0; i < target_ids.size(); ++i) {
+        if (i > 0) oss << ", ";
+        oss << "(" << target_ids[i] << ")";
+    }
+    oss << ") AS t(enterprise_id) "
+        << "JOIN enterprise e ON e.enterprise_id = t.enterprise_id "
+        << "WHERE ep.enterprise_id=" << source_enterprise_id
+        << " AND t.enterprise_id <> " << source_enterprise_id
+        << " ON CONFLICT (enterprise_id, product_id) ";
+
+    if (policy == AssortmentConflictPolicy::Overwrite)
+        oss << "DO UPDATE SET wholesale_price = EXCLUDED.wholesale_price";
+    else
+        oss << "DO NOTHING";
+
+    return db->executeUpdate(oss.str());
+}
+
+long EnterpriseProductGateway::insertBatch(const std::vector<EnterpriseProduct>& batch, bool upsert) {
+    if (batch.empty()) return 0;
+
+    std::string sql =
+        "INSERT INTO enterprise_product (enterprise_id, product_id, wholesale_price) "
+        "VALUES (?, ?, CAST(? AS BIGINT) / 100.0) ON CONFLICT (enterprise_id, product_id) DO ";
+    sql += upsert ? "UPDATE SET wholesale_price = EXCLUDED.wholesale_price" : "NOTHING";
+
+    ParamBatch params(db, sql, batch.size());
+    params.addInt(batch, [](const EnterpriseProduct& ep) { return ep.enterprise_id; });
+    params.addInt(batch, [](const EnterpriseProduct& ep) { return ep.product_id; });
+    params.addBigInt(batch, [](const EnterpriseProduct& ep) { return ep.wholesale_price.toKopecks(); });
+    return params.execute();
+}
+
+bool EnterpriseProductGateway::applyChanges(AssortmentChange kind, const std::vector<EnterpriseProduct>& changes,
+                                            std::vector<bool>& applied) {
+    applied.assign(changes.size(), false);
+    if (changes.empty()) return true;
+
+    // Временная таблица живёт до конца сеанса и очищается при фиксации:
+    // соединения пула переиспользуют её, не создавая заново
+    if (!db->executeQuery("CREATE TEMP TABLE IF NOT EXISTS assortment_change ("
+                          "enterprise_id INTEGER, product_id INTEGER, price BIGINT) ON COMMIT DELETE ROWS")) {
+        return false;
+    }
+    ParamBatch rows(db, "INSERT INTO assortment_change VALUES (?, ?, ?)", changes.size());
+    rows.addInt(changes, [](const EnterpriseProduct& ep) { return ep.enterprise_id; });
+    rows.addInt(changes, [](const EnterpriseProduct& ep) { return ep.product_id; });
+    rows.addBigInt(changes, [](const EnterpriseProduct& ep) { return ep.wholesale_price.toKopecks(); });
+    if (rows.execute() < 0) return false;
+
+    // RETURNING сообщает, какие правки затронули позиции. Добавление соединяется
+    // с enterprise и product: несуществующий ID отсеивается, а не срывает пакет
+    // нарушением внешнего ключа.
+    std::string sql;
+    switch (kind) {
+        case AssortmentChange::Add:
+            sql = "INSERT INTO enterprise_product (enterprise_id, product_id, wholesale_price) "
+                  "SELECT c.enterprise_id, c.product_id, c.price / 100.0 FROM assortment_change c "
+                  "JOIN enterprise e ON e.enterprise_id = c.enterprise_id "
+                  "JOIN product p ON p.product_id = c.product_id "
+                  "ON CONFLICT (enterprise_id, product_id) DO NOTHING "
+                  "RETURNING enterprise_id, product_id";
+            break;
+        case AssortmentChange::SetPrice:
+            sql = "UPDATE enterprise_product ep SET wholesale_price = c.price / 100.0 FROM assortment_change c "
+                  "WHERE ep.enterprise_id = c.enterprise_id AND ep.product_id = c.product_id "
+                  "RETURNING ep.enterprise_id, ep.product_id";
+            break;
+        case AssortmentChange::Remove:
+            sql = "DELETE FROM enterprise_product ep USING assortment_change c "
+                  "WHERE ep.enterprise_id = c.enterprise_id AND ep.product_id = c.product_id "
+                  "RETURNING ep.enterprise_id, ep.product_id";
+            break;
+    }
+
+    std::unordered_map<int64_t, size_t> position;
+    position.reserve(changes.size());
+    for (size_t i = 0; i < changes.size(); ++i) {
+        int64_t key = (static_cast<int64_t>(changes[i].enterprise_id) << 32) | static_cast<uint32_t>(changes[i].product_id);
+        position[key] = i;
+    }
+
+    SQLHSTMT hStmt;
+    SQLRETURN ret = SQLAllocHandle(SQL_HANDLE_STMT, db->getHandle(), &hStmt);
+    if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) return false;
+    ret = SQLExecDirect(hStmt, (SQLCHAR*)sql.c_str(), SQL_NTS);
+    if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO && ret != SQL_NO_DATA) {
+        SQLCHAR sqlState[6], message[512];
+        SQLINTEGER nativeError;
+        SQLGetDiagRec(SQL_HANDLE_STMT, hStmt, 1, sqlState, &nativeError, message, sizeof(message), nullptr);
+        std::cerr << "Ошибка пакетной правки ассортимента: " << message << " (SQLSTATE: " << sqlState << ")" << std::endl;
+        SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+        return false;
+    }
+    SQLINTEGER enterpriseId, productId;
+    while (SQL_SUCCEEDED(ret = SQLFetch(hStmt))) {
+        SQLGetData(hStmt, 1, SQL_C_LONG, &enterpriseId, 0, nullptr);
+        SQLGetData(hStmt, 2, SQL_C_LONG, &productId, 0, nullptr);
+        auto it = position.find((static_cast<int64_t>(enterpriseId) << 32) | static_cast<uint32_t>(productId));
+        if (it != position.end()) applied[it->second] = true;
+    }
+    bool complete = fetchCompleted(hStmt, ret);
+    SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+    return complete;
 }
\ No newline at end of file
@@ -0,0 +1,234 @@
+#include "ExportWriter.h"
+#include "Csv.h"
+#include "Json.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <unistd.h>
+#ifdef REGENT_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+// ==========================================
+// Приёмники данных
+// ==========================================
+
+class ExportWriter::Sink {
+public:
+    virtual ~Sink() = default;
+    virtual bool write(const char* data, size_t len) = 0;
+    virtual bool close() = 0;
+};
+
+namespace {
+    class FileSink : public ExportWriter::Sink {
+    private:
+        int fd;
+        bool owned;
+
+    public:
+        FileSink(int descriptor, bool own) : fd(descriptor), owned(own) {}
+        ~FileSink() override { close(); }
+
+        bool write(const char* data, size_t len) override {
+            while (len > 0) {
+                ssize_t n = ::write(fd, data, len);
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    return false;
+                }
+                data += n;
+                len -= static_cast<size_t>(n);
+            }
+            return true;
+        }
+
+        bool close() override {
+            if (fd < 0) return true;
+            bool ok = owned ? (::close(fd) == 0) : true;
+            fd = -1;
+            return ok;
+        }
+    };
+
+#ifdef REGENT_HAVE_ZLIB
+    class GzipSink : public ExportWriter::Sink {
+    private:
+        gzFile file;
+
+    public:
+        explicit GzipSink(gzFile f) : file(f) {
+            gzbuffer(file, 1 << 20);
+        }
+        ~GzipSink() override { close(); }
+
+        bool write(const char* data, size_t len) override {
+            while (len > 0) {
+                unsigned chunk = len > (1u << 30) ? (1u << 30) : static_cast<unsigned>(len);
+                if (gzwrite(file, data, chunk) != static_cast<int>(chunk)) return false;
+                data += chunk;
+                len -= chunk;
+            }
+            return true;
+        }
+
+        bool close() override {
+            if (!file) return true;
+            bool ok = gzclose(file) == Z_OK;
+            file = nullptr;
+            return ok;
+        }
+    };
+#endif
+}
+
+// ==========================================
+// ExportWriter
+// ==========================================
+
+ExportWriter::ExportWriter(std::unique_ptr<Sink> out, ExportFormat fmt)
+    : sink(std::move(out)), format(fmt), column(0), failed(false) {
+    buffer.reserve(BUFFER_SIZE + 4096);
+}
+
+ExportWriter::~ExportWriter() {
+    close();
+}
+
+bool ExportWriter::gzipSupported() {
+#ifdef REGENT_HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::unique_ptr<ExportWriter> ExportWriter::open(const std::string& path, ExportFormat fmt, bool gzip) {
+    int fd = (path == "-") ? STDOUT_FILENO : ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "Ошибка: Не удалось открыть " << path << ": " << std::strerror(errno) << std::endl;
+        return nullptr;
+    }
+
+    std::unique_ptr<Sink> sink;
+    if (gzip) {
+#ifdef REGENT_HAVE_ZLIB
+        gzFile gz = gzdopen(fd, "wb6");
+        if (!gz) {
+            std::cerr << "Ошибка: Не удалось инициализировать gzip для " << path << std::endl;
+            if (fd != STDOUT_FILENO) ::close(fd);
+            return nullptr;
+        }
+        sink = std::make_unique<GzipSink>(gz);
+#else
+        std::cerr << "Ошибка: Приложение собрано без поддержки zlib." << std::endl;
+        if (fd != STDOUT_FILENO) ::close(fd);
+        return nullptr;
+#endif
+    } else {
+        sink = std::make_unique<FileSink>(fd, fd != STDOUT_FILENO);
+    }
+    return std::unique_ptr<ExportWriter>(new ExportWriter(std::move(sink), fmt));
+}
+
+void ExportWriter::begin(const std::vector<std::string>& columnNames) {
+    columns = columnNames;
+    if (format == ExportFormat::Csv) {
+        for (size_t i = 0; i < columns.size(); ++i) {
+            if (i > 0) buffer += ',';
+            appendCsvField(buffer, columns[i]);
+        }
+        buffer += '\n';
+    }
+}
+
+void ExportWriter::beginRow() {
+    column = 0;
+    if (format == ExportFormat::JsonLines) buffer += '{';
+}
+
+void ExportWriter::beginField() {
+    if (format == ExportFormat::Csv) {
+        if (column > 0) buffer += ',';
+    } else {
+        if (column > 0) buffer += ',';
+        if (column < columns.size()) appendJsonString(buffer, columns[column].data(), columns[column].size());
+        else appendJsonString(buffer, "", 0);
+        buffer += ':';
+    }
+    ++column;
+}
+
+void ExportWriter::rawField(const char* text, size_t len) {
+    beginField();
+    buffer.append(text, len);
+}
+
+void ExportWriter::field(const std::string& value) {
+    if (format == ExportFormat::Csv) {
+        beginField();
+        appendCsvField(buffer, value);
+    } else {
+        beginField();
+        appendJsonString(buffer, value.data(), value.size());
+    }
+}
+
+void ExportWriter::field(long long value) {
+    char tmp[24];
+    int n = std::snprintf(tmp, sizeof(tmp), "%lld", value);
+    rawField(tmp, static_cast<size_t>(n));
+}
+
+void ExportWriter::field(Money value) {
+    // Точная десятичная запись: в JSON это число, а не строка
+    std::string s = value.toString();
+    rawField(s.data(), s.size());
+}
+
+void ExportWriter::jsonField(const std::string& json) {
+    if (format == ExportFormat::Csv) field(json);
+    else if (json.empty()) rawField("null", 4);
+    else rawField(json.data(), json.size());
+}
+
+void ExportWriter::endRow() {
+    if (format == ExportFormat::JsonLines) buffer += '}';
+    buffer += '\n';
+    flushIfFull();
+}
+
+void ExportWriter::writeRaw(const char* data, size_t len) {
+    buffer.append(data, len);
+    flushIfFull();
+}
+
+void ExportWriter::flushIfFull() {
+    if (buffer.size() < BUFFER_SIZE) return;
+    if (!failed && !sink->write(buffer.data(), buffer.size())) {
+        std::cerr << "Ошибка записи выгрузки: " << std::strerror(errno) << std::endl;
+        failed = true;
+    }
+    buffer.clear();
+}
+
+bool ExportWriter::flush() {
+    if (!sink) return !failed;
+    if (!failed && !buffer.empty() && !sink->write(buffer.data(), buffer.size())) {
+        std::cerr << "Ошибка записи выгрузки: " << std::strerror(errno) << std::endl;
+        failed = true;
+    }
+    buffer.clear();
+    return !failed;
+}
+
+bool ExportWriter::close() {
+    if (!sink) return !failed;
+    if (!failed && !buffer.empty() && !sink->write(buffer.data(), buffer.size())) failed = true;
+    buffer.clear();
+    if (!sink->close()) failed = true;
+    sink.reset();
+    return !failed;
+}
\ No newline at end of file
@@ -0,0 +1,526 @@
+#include "HttpServer.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+struct HttpServer::Connection {
+    int fd;
+    uint64_t id;
+    std::string in;             // Принятые, ещё не разобранные байты
+    std::string out;            // Ответ, ожидающий отправки
+    size_t outPos = 0;
+    bool busy = false;          // Запрос выполняется рабочим потоком
+    bool closeAfterWrite = false;
+    bool peerClosed = false;    // Клиент закрыл свою сторону
+    bool continueSent = false;  // Отправлен "100 Continue" для текущего запроса
+    bool wantWrite = false;     // Подписка на EPOLLOUT
+};
+
+namespace {
+    int hexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    // Раскодирование %XX; в строке запроса '+' — пробел
+    std::string urlDecode(const std::string& s, bool plusIsSpace) {
+        std::string out;
+        out.reserve(s.size());
+        for (size_t i = 0; i < s.size(); ++i) {
+            if (s[i] == '%' && i + 2 < s.size() && hexValue(s[i + 1]) >= 0 && hexValue(s[i + 2]) >= 0) {
+                out += static_cast<char>(hexValue(s[i + 1]) * 16 + hexValue(s[i + 2]));
+                i += 2;
+            } else if (s[i] == '+' && plusIsSpace) {
+                out += ' ';
+            } else {
+                out += s[i];
+            }
+        }
+        return out;
+    }
+
+    void parseQuery(const std::string& text, std::unordered_map<std::string, std::string>& query) {
+        size_t start = 0;
+        while (start <= text.size()) {
+            size_t amp = text.find('&', start);
+            if (amp == std::string::npos) amp = text.size();
+            std::string pair = text.substr(start, amp - start);
+            if (!pair.empty()) {
+                size_t eq = pair.find('=');
+                if (eq == std::string::npos) query[urlDecode(pair, true)] = "";
+                else query[urlDecode(pair.substr(0, eq), true)] = urlDecode(pair.substr(eq + 1), true);
+            }
+            start = amp + 1;
+        }
+    }
+
+    std::string lower(std::string s) {
+        for (char& c : s) {
+            if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+        }
+        return s;
+    }
+
+    std::string trim(const std::string& s) {
+        size_t a = s.find_first_not_of(" \t");
+        if (a == std::string::npos) return "";
+        size_t b = s.find_last_not_of(" \t");
+        return s.substr(a, b - a + 1);
+    }
+
+    enum class Parse { Incomplete, Ready, Failed };
+
+    // Разбор одного запроса из начала буфера. Ready: req, consumed и keepAlive заполнены;
+    // Failed: errorStatus — код ответа; Incomplete: expectContinue — клиент ждёт "100 Continue".
+    Parse parseRequest(const std::string& buf, HttpRequest& req, size_t& consumed, bool& keepAlive,
+                       int& errorStatus, bool& expectContinue) {
+        expectContinue = false;
+        size_t headerEnd = buf.find("\r\n\r\n");
+        if (headerEnd == std::string::npos) {
+            if (buf.size() > HttpServer::MAX_HEADER) {
+                errorStatus = 431;
+                return Parse::Failed;
+            }
+            return Parse::Incomplete;
+        }
+
+        size_t lineEnd = buf.find("\r\n");
+        std::string requestLine = buf.substr(0, lineEnd);
+        size_t sp1 = requestLine.find(' ');
+        size_t sp2 = requestLine.rfind(' ');
+        if (sp1 == std::string::npos || sp2 == sp1) {
+            errorStatus = 400;
+            return Parse::Failed;
+        }
+        std::string method = requestLine.substr(0, sp1);
+        std::string target = requestLine.substr(sp1 + 1, sp2 - sp1 - 1);
+        std::string version = requestLine.substr(sp2 + 1);
+        if (version != "HTTP/1.1" && version != "HTTP/1.0") {
+            errorStatus = 505;
+            return Parse::Failed;
+        }
+
+        keepAlive = (version == "HTTP/1.1");
+        size_t contentLength = 0;
+        bool expects = false;
+        size_t pos = lineEnd + 2;
+        while (pos < headerEnd) {
+            size_t end = buf.find("\r\n", pos);
+            std::string line = buf.substr(pos, end - pos);
+            pos = end + 2;
+            size_t colon = line.find(':');
+            if (colon == std::string::npos) continue;
+            std::string name = lower(trim(line.substr(0, colon)));
+            std::string value = trim(line.substr(colon + 1));
+            if (name == "content-length") {
+                char* endp = nullptr;
+                errno = 0;
+                unsigned long long n = std::strtoull(value.c_str(), &endp, 10);
+                if (errno != 0 || value.empty() || *endp != '\0') {
+                    errorStatus = 400;
+                    return Parse::Failed;
+                }
+                if (n > HttpServer::MAX_BODY) {
+                    errorStatus = 413;
+                    return Parse::Failed;
+                }
+                contentLength = static_cast<size_t>(n);
+            } else if (name == "transfer-encoding") {
+                errorStatus = 501;  // chunked не поддерживается — клиент должен указать длину
+                return Parse::Failed;
+            } else if (name == "connection") {
+                std::string v = lower(value);
+                if (v == "close") keepAlive = false;
+                else if (v == "keep-alive") keepAlive = true;
+            } else if (name == "expect") {
+                expects = (lower(value) == "100-continue");
+            }
+        }
+
+        size_t bodyStart = headerEnd + 4;
+        if (buf.size() < bodyStart + contentLength) {
+            expectContinue = expects;
+            return Parse::Incomplete;
+        }
+
+        req = HttpRequest();
+        req.method = method;
+        size_t qmark = target.find('?');
+        req.path = urlDecode(target.substr(0, qmark), false);
+        if (qmark != std::string::npos) parseQuery(target.substr(qmark + 1), req.query);
+        req.body.assign(buf, bodyStart, contentLength);
+        consumed = bodyStart + contentLength;
+        return Parse::Ready;
+    }
+
+    std::string serialize(const HttpResponse& r, bool close) {
+        std::string text;
+        text.reserve(r.body.size() + 160);
+        text += "HTTP/1.1 ";
+        text += std::to_string(r.status);
+        text += ' ';
+        text += HttpServer::statusText(r.status);
+        text += "\r\nContent-Type: ";
+        text += r.contentType;
+        text += "\r\nContent-Length: ";
+        text += std::to_string(r.body.size());
+        text += close ? "\r\nConnection: close\r\n\r\n" : "\r\n\r\n";
+        text += r.body;
+        return text;
+    }
+
+    HttpResponse errorResponse(int status) {
+        HttpResponse r;
+        r.status = status;
+        r.body = std::string("{\"error\":\"") + HttpServer::statusText(status) + "\"}";
+        return r;
+    }
+}
+
+std::string HttpRequest::param(const std::string& name, const std::string& fallback) const {
+    auto it = query.find(name);
+    return it == query.end() ? fallback : it->second;
+}
+
+const char* HttpServer::statusText(int status) {
+    switch (status) {
+        case 100: return "Continue";
+        case 200: return "OK";
+        case 201: return "Created";
+        case 204: return "No Content";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 409: return "Conflict";
+        case 413: return "Payload Too Large";
+        case 422: return "Unprocessable Entity";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        case 503: return "Service Unavailable";
+        case 505: return "HTTP Version Not Supported";
+    }
+    return "Unknown";
+}
+
+// ==========================================
+// Запуск и остановка
+// ==========================================
+
+HttpServer::HttpServer(HttpHandler requestHandler, size_t workerThreads)
+    : handler(std::move(requestHandler)), workerCount(workerThreads == 0 ? 1 : workerThreads),
+      listenFd(-1), epollFd(-1), wakeFd(-1), stopping(false), nextId(1) {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+}
+
+HttpServer::~HttpServer() {
+    for (auto& [fd, c] : connections) ::close(fd);
+    if (listenFd >= 0) ::close(listenFd);
+    if (wakeFd >= 0) ::close(wakeFd);
+    if (epollFd >= 0) ::close(epollFd);
+}
+
+bool HttpServer::listen(const std::string& address, int port) {
+    if (epollFd < 0 || wakeFd < 0) {
+        std::cerr << "Ошибка: epoll недоступен: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+        std::cerr << "Ошибка: Неверный адрес " << address << std::endl;
+        return false;
+    }
+
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) {
+        std::cerr << "Ошибка: socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    int one = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(listenFd, SOMAXCONN) != 0) {
+        std::cerr << "Ошибка: Не удалось открыть " << address << ":" << port << ": " << std::strerror(errno) << std::endl;
+        ::close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = listenFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+    ev.data.fd = wakeFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+    return true;
+}
+
+void HttpServer::stop() {
+    stopping.store(true);
+    uint64_t one = 1;
+    // write(2) допустим в обработчике сигнала
+    ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+    (void)ignored;
+}
+
+void HttpServer::run() {
+    if (listenFd < 0) return;
+    for (size_t i = 0; i < workerCount; ++i) workers.emplace_back(&HttpServer::workerLoop, this);
+
+    epoll_event events[256];
+    while (!stopping.load()) {
+        int n = epoll_wait(epollFd, events, 256, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Ошибка: epoll_wait: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            uint32_t what = events[i].events;
+            if (fd == listenFd) {
+                acceptAll();
+                continue;
+            }
+            if (fd == wakeFd) {
+                uint64_t count;
+                while (::read(wakeFd, &count, sizeof(count)) > 0) {}
+                deliverDone();
+                continue;
+            }
+            auto it = connections.find(fd);
+            if (it == connections.end()) continue;
+            Connection& c = *it->second;
+            if (what & EPOLLERR) {
+                closeConnection(fd);
+                continue;
+            }
+            // EPOLLHUP без данных тоже приходит как чтение с результатом 0
+            if (what & (EPOLLIN | EPOLLHUP | EPOLLRDHUP)) {
+                onReadable(c);
+                if (connections.find(fd) == connections.end()) continue;
+            }
+            if (what & EPOLLOUT) onWritable(c);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        jobs.clear();
+    }
+    jobReady.notify_all();
+    for (std::thread& t : workers) t.join();
+    workers.clear();
+}
+
+// ==========================================
+// Рабочие потоки
+// ==========================================
+
+void HttpServer::workerLoop() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobReady.wait(lock, [this] { return stopping.load() || !jobs.empty(); });
+            if (stopping.load()) return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        HttpResponse response;
+        try {
+            response = handler(job.request);
+        } catch (const std::exception& e) {
+            std::cerr << "Ошибка обработки " << job.request.method << " " << job.request.path << ": "
+                      << e.what() << std::endl;
+            response = errorResponse(500);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(doneMutex);
+            done.push_back(Done{job.connection, serialize(response, job.close), job.close});
+        }
+        uint64_t one = 1;
+        ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+// ==========================================
+// Соединения
+// ==========================================
+
+void HttpServer::acceptAll() {
+    while (true) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            // EAGAIN — очередь пуста; EMFILE и прочее — попробуем при следующем событии
+            return;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        auto c = std::make_unique<Connection>();
+        c->fd = fd;
+        c->id = nextId++;
+        fdOf[c->id] = fd;
+        connections[fd] = std::move(c);
+
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+    }
+}
+
+void HttpServer::closeConnection(int fd) {
+    auto it = connections.find(fd);
+    if (it == connections.end()) return;
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    fdOf.erase(it->second->id);
+    connections.erase(it);
+    ::close(fd);
+}
+
+void HttpServer::updateInterest(Connection& c) {
+    epoll_event ev{};
+    // После закрытия клиентом чтение больше не отслеживается: иначе epoll
+    // сообщал бы о нём непрерывно, пока запрос выполняется
+    ev.events = 0;
+    if (!c.peerClosed) ev.events |= EPOLLIN | EPOLLRDHUP;
+    if (c.wantWrite) ev.events |= EPOLLOUT;
+    ev.data.fd = c.fd;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, c.fd, &ev);
+}
+
+void HttpServer::onReadable(Connection& c) {
+    char chunk[65536];
+    while (true) {
+        ssize_t n = ::recv(c.fd, chunk, sizeof(chunk), 0);
+        if (n > 0) {
+            c.in.append(chunk, static_cast<size_t>(n));
+            // Клиент шлёт запросы быстрее, чем получает ответы
+            if (c.in.size() > MAX_HEADER + MAX_BODY) {
+                closeConnection(c.fd);
+                return;
+            }
+            continue;
+        }
+        if (n == 0) {
+            c.peerClosed = true;
+            updateInterest(c);
+            break;
+        }
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+        closeConnection(c.fd);
+        return;
+    }
+
+    if (!c.busy) dispatch(c);
+}
+
+void HttpServer::onWritable(Connection& c) {
+    while (c.outPos < c.out.size()) {
+        ssize_t n = ::send(c.fd, c.out.data() + c.outPos, c.out.size() - c.outPos, MSG_NOSIGNAL);
+        if (n > 0) {
+            c.outPos += static_cast<size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (!c.wantWrite) {
+                c.wantWrite = true;
+                updateInterest(c);
+            }
+            return;
+        }
+        closeConnection(c.fd);
+        return;
+    }
+
+    c.out.clear();
+    c.outPos = 0;
+    if (c.wantWrite) {
+        c.wantWrite = false;
+        updateInterest(c);
+    }
+    if (c.closeAfterWrite) {
+        closeConnection(c.fd);
+        return;
+    }
+    if (!c.busy) dispatch(c);
+}
+
+void HttpServer::dispatch(Connection& c) {
+    if (c.busy || c.closeAfterWrite) return;
+
+    HttpRequest req;
+    size_t consumed = 0;
+    bool keepAlive = true;
+    int errorStatus = 400;
+    bool expectContinue = false;
+    Parse result = parseRequest(c.in, req, consumed, keepAlive, errorStatus, expectContinue);
+
+    if (result == Parse::Incomplete) {
+        if (c.peerClosed) {
+            if (c.out.empty()) closeConnection(c.fd);
+            return;
+        }
+        if (expectContinue && !c.continueSent) {
+            c.continueSent = true;
+            c.out += "HTTP/1.1 100 Continue\r\n\r\n";
+            onWritable(c);
+        }
+        return;
+    }
+
+    if (result == Parse::Failed) {
+        c.in.clear();
+        c.out += serialize(errorResponse(errorStatus), true);
+        c.closeAfterWrite = true;
+        onWritable(c);
+        return;
+    }
+
+    c.in.erase(0, consumed);
+    c.continueSent = false;
+    c.busy = true;
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        jobs.push_back(Job{c.id, std::move(req), !keepAlive || c.peerClosed});
+    }
+    jobReady.notify_one();
+}
+
+void HttpServer::deliverDone() {
+    std::vector<Done> ready;
+    {
+        std::lock_guard<std::mutex> lock(doneMutex);
+        ready.swap(done);
+    }
+    for (Done& d : ready) {
+        auto it = fdOf.find(d.connection);
+        if (it == fdOf.end()) continue;     // Клиент ушёл, не дождавшись ответа
+        Connection& c = *connections[it->second];
+        c.busy = false;
+        c.out += d.response;
+        if (d.close) c.closeAfterWrite = true;
+        onWritable(c);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,429 @@
+#include "Json.h"
+#include "Utf8.h"
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+void appendJsonString(std::string& out, const char* s, size_t len) {
+    static const char* hex = "0123456789abcdef";
+    out += '"';
+    size_t i = 0;
+    while (i < len) {
+        // Куски без экранирования и без ошибок UTF-8 копируются целиком
+        size_t valid = i + utf8::validLength(s + i, len - i);
+        while (i < valid) {
+            size_t plain = i + utf8::findJsonSpecial(s + i, valid - i);
+            out.append(s + i, plain - i);
+            i = plain;
+            if (i == valid) break;
+            unsigned char c = static_cast<unsigned char>(s[i++]);
+            switch (c) {
+                case '"':  out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    out += "\\u00";
+                    out += hex[c >> 4];
+                    out += hex[c & 0x0F];
+            }
+        }
+        if (i < len) {
+            out += "\xEF\xBF\xBD";     // Неверный байт UTF-8 — U+FFFD, иначе JSON будет неверным
+            ++i;
+        }
+    }
+    out += '"';
+}
+
+// ==========================================
+// JsonWriter
+// ==========================================
+
+void JsonWriter::separate() {
+    if (afterKey) {
+        afterKey = false;
+        return;
+    }
+    if (!first.empty()) {
+        if (!first.back()) out += ',';
+        first.back() = false;
+    }
+}
+
+JsonWriter& JsonWriter::beginObject() {
+    separate();
+    out += '{';
+    first.push_back(true);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+    out += '}';
+    first.pop_back();
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray() {
+    separate();
+    out += '[';
+    first.push_back(true);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+    out += ']';
+    first.pop_back();
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(const char* name) {
+    separate();
+    appendJsonString(out, name, std::char_traits<char>::length(name));
+    out += ':';
+    afterKey = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const std::string& s) {
+    separate();
+    appendJsonString(out, s.data(), s.size());
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const char* s) {
+    separate();
+    appendJsonString(out, s, std::char_traits<char>::length(s));
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(long long n) {
+    separate();
+    out += std::to_string(n);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(double x) {
+    separate();
+    // NaN и бесконечность в JSON не представимы
+    if (!std::isfinite(x)) {
+        out += "null";
+        return *this;
+    }
+    char buf[32];
+    int n = std::snprintf(buf, sizeof(buf), "%.6g", x);
+    out.append(buf, n);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool b) {
+    separate();
+    out += b ? "true" : "false";
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(Money m) {
+    separate();
+    out += m.toString();
+    return *this;
+}
+
+JsonWriter& JsonWriter::null() {
+    separate();
+    out += "null";
+    return *this;
+}
+
+// ==========================================
+// JsonObject
+// ==========================================
+
+namespace {
+    class Parser {
+    private:
+        const std::string& s;
+        size_t pos;
+
+    public:
+        std::string error;
+
+        explicit Parser(const std::string& text) : s(text), pos(0) {}
+
+        void skipSpace() {
+            while (pos < s.size() && (s[pos] == ' ' || s[pos] == '\t' || s[pos] == '\n' || s[pos] == '\r')) ++pos;
+        }
+
+        bool atEnd() {
+            skipSpace();
+            return pos >= s.size();
+        }
+
+        bool expect(char c) {
+            skipSpace();
+            if (pos < s.size() && s[pos] == c) {
+                ++pos;
+                return true;
+            }
+            error = std::string("ожидался символ '") + c + "' в позиции " + std::to_string(pos);
+            return false;
+        }
+
+        bool peek(char c) {
+            skipSpace();
+            return pos < s.size() && s[pos] == c;
+        }
+
+        bool literal(const char* word) {
+            size_t len = std::char_traits<char>::length(word);
+            if (s.compare(pos, len, word) != 0) return false;
+            pos += len;
+            return true;
+        }
+
+        static void appendUtf8(std::string& out, uint32_t cp) {
+            if (cp < 0x80) {
+                out += static_cast<char>(cp);
+            } else if (cp < 0x800) {
+                out += static_cast<char>(0xC0 | (cp >> 6));
+                out += static_cast<char>(0x80 | (cp & 0x3F));
+            } else if (cp < 0x10000) {
+                out += static_cast<char>(0xE0 | (cp >> 12));
+                out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (cp & 0x3F));
+            } else {
+                out += static_cast<char>(0xF0 | (cp >> 18));
+                out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (cp & 0x3F));
+            }
+        }
+
+        bool hex4(uint32_t& cp) {
+            if (pos + 4 > s.size()) return false;
+            cp = 0;
+            for (int i = 0; i < 4; ++i) {
+                char c = s[pos++];
+                cp <<= 4;
+                if (c >= '0' && c <= '9') cp |= c - '0';
+                else if (c >= 'a' && c <= 'f') cp |= c - 'a' + 10;
+                else if (c >= 'A' && c <= 'F') cp |= c - 'A' + 10;
+                else return false;
+            }
+            return true;
+        }
+
+        bool string(std::string& out) {
+            if (!expect('"')) return false;
+            out.clear();
+            while (pos < s.size()) {
+                char c = s[pos++];
+                if (c == '"') return true;
+                if (static_cast<unsigned char>(c) < 0x20) break;
+                if (c != '\\') {
+                    out += c;
+                    continue;
+                }
+                if (pos >= s.size()) break;
+                char e = s[pos++];
+                switch (e) {
+                    case '"': out += '"'; break;
+                    case '\\': out += '\\'; break;
+                    case '/': out += '/'; break;
+                    case 'b': out += '\b'; break;
+                    case 'f': out += '\f'; break;
+                    case 'n': out += '\n'; break;
+                    case 'r': out += '\r'; break;
+                    case 't': out += '\t'; break;
+                    case 'u': {
+                        uint32_t cp;
+                        if (!hex4(cp)) {
+                            error = "неверная последовательность \\u";
+                            return false;
+                        }
+                        // Суррогатная пара — символ вне основной плоскости
+                        if (cp >= 0xD800 && cp < 0xDC00 && s.compare(pos, 2, "\\u") == 0) {
+                            pos += 2;
+                            uint32_t low;
+                            if (!hex4(low) || low < 0xDC00 || low >= 0xE000) {
+                                error = "неверная суррогатная пара";
+                                return false;
+                            }
+                            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                        appendUtf8(out, cp);
+                        break;
+                    }
+                    default:
+                        error = "неверное экранирование в строке";
+                        return false;
+                }
+            }
+            if (error.empty()) error = "незакрытая строка";
+            return false;
+        }
+
+        bool number(std::string& out) {
+            skipSpace();
+            size_t start = pos;
+            if (pos < s.size() && s[pos] == '-') ++pos;
+            size_t digits = pos;
+            while (pos < s.size() && ((s[pos] >= '0' && s[pos] <= '9') || s[pos] == '.' || s[pos] == 'e'
+                                      || s[pos] == 'E' || s[pos] == '+' || s[pos] == '-')) ++pos;
+            if (pos == digits) {
+                error = "ожидалось значение в позиции " + std::to_string(start);
+                return false;
+            }
+            out.assign(s, start, pos - start);
+            return true;
+        }
+    };
+
+    bool toInt(const std::string& text, int& out) {
+        if (text.empty()) return false;
+        errno = 0;
+        char* end = nullptr;
+        long v = std::strtol(text.c_str(), &end, 10);
+        if (errno != 0 || *end != '\0' || v < INT_MIN || v > INT_MAX) return false;
+        out = static_cast<int>(v);
+        return true;
+    }
+}
+
+bool JsonObject::parse(const std::string& json, std::string& error) {
+    values.clear();
+    Parser p(json);
+    if (!p.expect('{')) {
+        error = "ожидался объект JSON";
+        return false;
+    }
+    if (p.peek('}')) {
+        p.expect('}');
+    } else {
+        while (true) {
+            std::string name;
+            if (!p.string(name) || !p.expect(':')) {
+                error = p.error;
+                return false;
+            }
+            Value v;
+            p.skipSpace();
+            if (p.peek('"')) {
+                v.kind = Kind::String;
+                if (!p.string(v.text)) {
+                    error = p.error;
+                    return false;
+                }
+            } else if (p.peek('[')) {
+                p.expect('[');
+                v.kind = Kind::NumberArray;
+                if (p.peek(']')) {
+                    p.expect(']');
+                } else {
+                    while (true) {
+                        std::string item;
+                        if (!p.number(item)) {
+                            error = "массив может содержать только числа";
+                            return false;
+                        }
+                        v.items.push_back(item);
+                        if (p.peek(',')) { p.expect(','); continue; }
+                        if (!p.expect(']')) {
+                            error = p.error;
+                            return false;
+                        }
+                        break;
+                    }
+                }
+            } else if (p.peek('{')) {
+                error = "вложенные объекты не поддерживаются (поле " + name + ")";
+                return false;
+            } else if (p.literal("true")) {
+                v.kind = Kind::Bool;
+                v.text = "true";
+            } else if (p.literal("false")) {
+                v.kind = Kind::Bool;
+                v.text = "false";
+            } else if (p.literal("null")) {
+                v.kind = Kind::Null;
+            } else {
+                v.kind = Kind::Number;
+                if (!p.number(v.text)) {
+                    error = p.error;
+                    return false;
+                }
+            }
+            values[name] = std::move(v);
+
+            if (p.peek(',')) { p.expect(','); continue; }
+            if (!p.expect('}')) {
+                error = p.error;
+                return false;
+            }
+            break;
+        }
+    }
+    if (!p.atEnd()) {
+        error = "лишние данные после объекта JSON";
+        return false;
+    }
+    return true;
+}
+
+bool JsonObject::getString(const std::string& name, std::string& out) const {
+    auto it = values.find(name);
+    if (it == values.end() || it->second.kind != Kind::String) return false;
+    out = it->second.text;
+    return true;
+}
+
+bool JsonObject::getInt(const std::string& name, int& out) const {
+    auto it = values.find(name);
+    if (it == values.end()) return false;
+    if (it->second.kind != Kind::Number && it->second.kind != Kind::String) return false;
+    return toInt(it->second.text, out);
+}
+
+bool JsonObject::getNumber(const std::string& name, double& out) const {
+    auto it = values.find(name);
+    if (it == values.end()) return false;
+    if (it->second.kind != Kind::Number && it->second.kind != Kind::String) return false;
+    const std::string& text = it->second.text;
+    if (text.empty()) return false;
+    char* end = nullptr;
+    double v = std::strtod(text.c_str(), &end);
+    if (*end != '\0' || !std::isfinite(v)) return false;
+    out = v;
+    return true;
+}
+
+bool JsonObject::getMoney(const std::string& name, Money& out) const {
+    auto it = values.find(name);
+    if (it == values.end()) return false;
+    if (it->second.kind != Kind::Number && it->second.kind != Kind::String) return false;
+    return Money::parse(it->second.text, out);
+}
+
+bool JsonObject::getBool(const std::string& name, bool& out) const {
+    auto it = values.find(name);
+    if (it == values.end() || it->second.kind != Kind::Bool) return false;
+    out = (it->second.text == "true");
+    return true;
+}
+
+bool JsonObject::getIntArray(const std::string& name, std::vector<int>& out) const {
+    auto it = values.find(name);
+    if (it == values.end() || it->second.kind != Kind::NumberArray) return false;
+    std::vector<int> list;
+    list.reserve(it->second.items.size());
+    for (const std::string& item : it->second.items) {
+        int v;
+        if (!toInt(item, v)) return false;
+        list.push_back(v);
+    }
+    out.swap(list);
+    return true;
+}
\ No newline at end of file
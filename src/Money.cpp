@@ -0,0 +1,84 @@
+#include "Money.h"
+#include <cmath>
+#include <limits>
+
+bool Money::parse(const std::string& text, Money& out) {
+    size_t i = 0;
+    size_t n = text.size();
+
+    while (i < n && (text[i] == ' ' || text[i] == '\t')) ++i;
+    while (n > i && (text[n - 1] == ' ' || text[n - 1] == '\t')) --n;
+    if (i == n) return false;
+
+    bool negative = false;
+    if (text[i] == '-' || text[i] == '+') {
+        negative = (text[i] == '-');
+        ++i;
+    }
+
+    const int64_t limit = std::numeric_limits<int64_t>::max() / 100;
+    int64_t whole = 0;
+    int64_t fraction = 0;
+    int fractionDigits = 0;
+    bool seenDigit = false;
+    bool seenPoint = false;
+
+    for (; i < n; ++i) {
+        char c = text[i];
+        if (c >= '0' && c <= '9') {
+            seenDigit = true;
+            if (seenPoint) {
+                if (++fractionDigits > 2) return false; // Точность NUMERIC(10,2)
+                fraction = fraction * 10 + (c - '0');
+            } else {
+                if (whole > (limit - (c - '0')) / 10) return false; // Переполнение
+                whole = whole * 10 + (c - '0');
+            }
+        } else if ((c == '.' || c == ',') && !seenPoint) {
+            seenPoint = true;
+        } else if (c == ' ' && !seenPoint) {
+            continue; // Разделитель разрядов: "1 234.50"
+        } else {
+            return false;
+        }
+    }
+    if (!seenDigit) return false;
+
+    if (fractionDigits == 1) fraction *= 10;
+    int64_t value = whole * 100 + fraction;
+    out = Money(negative ? -value : value);
+    return true;
+}
+
+std::string Money::toString() const {
+    // Модуль считаем в беззнаковом типе, чтобы не переполниться на INT64_MIN
+    uint64_t abs = kopecks < 0 ? 0 - static_cast<uint64_t>(kopecks) : static_cast<uint64_t>(kopecks);
+
+    char buf[32];
+    char* p = buf + sizeof(buf);
+    uint64_t cents = abs % 100;
+    uint64_t whole = abs / 100;
+
+    *--p = static_cast<char>('0' + cents % 10);
+    *--p = static_cast<char>('0' + cents / 10);
+    *--p = '.';
+    do {
+        *--p = static_cast<char>('0' + whole % 10);
+        whole /= 10;
+    } while (whole != 0);
+    if (kopecks < 0) *--p = '-';
+
+    return std::string(p, buf + sizeof(buf) - p);
+}
+
+Money Money::multiply(double factor) const {
+    // Коэффициент переводим в десятичную дробь с 9 знаками (1.15 -> 1150000000),
+    // чтобы двоичная погрешность double не сдвигала округление на половинах:
+    // 0.10 * 1.15 = 0.115 -> 0.12, как и ROUND(0.10 * 1.15, 2) на сервере.
+    const int64_t SCALE = 1000000000;
+    __int128 scaledFactor = static_cast<__int128>(std::llround(factor * SCALE));
+    __int128 product = static_cast<__int128>(kopecks) * scaledFactor;
+    __int128 half = SCALE / 2;
+    __int128 rounded = (product >= 0 ? product + half : product - half) / SCALE;
+    return Money(static_cast<int64_t>(rounded));
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include "PageCache.h"
+
+std::string PageCache::pageKey(const std::string& list, const std::string& criteria, int pageSize, int page) {
+    return list + "\n" + criteria + "\n" + std::to_string(pageSize) + "\n" + std::to_string(page);
+}
+
+void PageCache::evict(const std::string& keep) {
+    for (auto it = pages.begin(); it != pages.end() && pages.size() >= MAX_PAGES;) {
+        bool ready = it->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        if (ready && it->first != keep) it = pages.erase(it);
+        else ++it;
+    }
+}
+
+ListPage PageCache::get(const std::string& key, const Loader& load) {
+    auto it = pages.find(key);
+    if (it != pages.end()) {
+        ListPage page = it->second.get();
+        if (page.total < 0) pages.erase(it);
+        return page;
+    }
+
+    ListPage page = load();
+    if (page.total >= 0) {
+        evict(key);
+        std::promise<ListPage> ready;
+        ready.set_value(page);
+        pages.emplace(key, ready.get_future().share());
+    }
+    return page;
+}
+
+void PageCache::prefetch(const std::string& key, const Loader& load) {
+    if (pages.count(key)) return;
+    evict(key);
+    // Loader копируется в задачу: экран может закрыться раньше, чем она выполнится
+    pages.emplace(key, executor.submit([load](TaskExecutor::TaskContext&) { return load(); }).share());
+}
\ No newline at end of file
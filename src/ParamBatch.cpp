@@ -0,0 +1,64 @@
+#include "ParamBatch.h"
+
+long ParamBatch::execute() {
+    if (rows == 0) return 0;
+    if (!db->isConnected()) {
+        std::cerr << "Не подключено к БД!" << std::endl;
+        return -1;
+    }
+
+    SQLHSTMT hStmt;
+    SQLRETURN ret = SQLAllocHandle(SQL_HANDLE_STMT, db->getHandle(), &hStmt);
+    if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) {
+        std::cerr << "Ошибка при выделении оператора SQL" << std::endl;
+        return -1;
+    }
+
+    SQLSetStmtAttr(hStmt, SQL_ATTR_PARAM_BIND_TYPE, (SQLPOINTER)SQL_PARAM_BIND_BY_COLUMN, 0);
+    SQLSetStmtAttr(hStmt, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)rows, 0);
+
+    SQLUSMALLINT index = 1;
+    for (const auto& [kind, i] : order) {
+        switch (kind) {
+            case Kind::Text: {
+                TextColumn& col = textColumns[i];
+                ret = SQLBindParameter(hStmt, index, SQL_PARAM_INPUT, SQL_C_CHAR, SQL_VARCHAR,
+                                       col.width, 0, col.data.data(), col.width, col.lengths.data());
+                break;
+            }
+            case Kind::Int: {
+                IntColumn& col = intColumns[i];
+                ret = SQLBindParameter(hStmt, index, SQL_PARAM_INPUT, SQL_C_SLONG, SQL_INTEGER,
+                                       0, 0, col.values.data(), 0, col.lengths.data());
+                break;
+            }
+            case Kind::BigInt: {
+                BigIntColumn& col = bigIntColumns[i];
+                ret = SQLBindParameter(hStmt, index, SQL_PARAM_INPUT, SQL_C_SBIGINT, SQL_BIGINT,
+                                       0, 0, col.values.data(), 0, col.lengths.data());
+                break;
+            }
+        }
+        if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) {
+            std::cerr << "Ошибка привязки параметра " << index << std::endl;
+            SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+            return -1;
+        }
+        ++index;
+    }
+
+    ret = SQLExecDirect(hStmt, (SQLCHAR*)sql.c_str(), SQL_NTS);
+    if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO && ret != SQL_NO_DATA) {
+        SQLCHAR sqlState[6], message[512];
+        SQLINTEGER nativeError;
+        SQLGetDiagRec(SQL_HANDLE_STMT, hStmt, 1, sqlState, &nativeError, message, sizeof(message), nullptr);
+        std::cerr << "Ошибка пакетного выполнения: " << message << " (SQLSTATE: " << sqlState << ")" << std::endl;
+        SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+        return -1;
+    }
+
+    SQLLEN affected = 0;
+    SQLRowCount(hStmt, &affected);
+    SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+    return static_cast<long>(affected);
+}
\ No newline at end of file
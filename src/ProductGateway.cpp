@@ -1,4 +1,5 @@
 #include "Gateways.h"
+#include "ParamBatch.h"
 #include <sstream>
 
 void ProductGateway::createTableIfNotExists() {
@@ -13,45 +14,95 @@ void ProductGateway::createTableIfNotExists() {
             purchase_price NUMERIC(10,2)
         );
     )");
+
+    // Индексы под частые фильтры списка (см. criteriaFields)
+    db->executeQuery("CREATE INDEX IF NOT EXISTS product_category_idx ON product (category_id)");
+    db->executeQuery("CREATE INDEX IF NOT EXISTS product_retail_price_idx ON product (retail_price)");
 }
 
 std::vector<Product> ProductGateway::findAll() {
     std::vector<Product> list;
-    if (!db->isConnected()) return list;
-    SQLHSTMT hStmt;
-    SQLAllocHandle(SQL_HANDLE_STMT, db->getHandle(), &hStmt);
+    if (streamAll([&list](const Product& p) { list.push_back(p); return true; }) < 0) return {};
+    return list;
+}
 
-    std::string sql = R"(
+namespace {
+    const char* PRODUCT_SELECT = R"(
         SELECT p.product_id, p.category_id, p.name, p.shelf_life_days, 
-               p.delivery_terms_id, p.retail_price, p.purchase_price,
+               p.delivery_terms_id,
+               (p.retail_price * 100)::BIGINT, (p.purchase_price * 100)::BIGINT,
                pc.name as cat_name, dt.description as dt_desc
+    )";
+    const char* PRODUCT_FROM = R"(
         FROM product p
         LEFT JOIN product_category pc ON p.category_id = pc.category_id
         LEFT JOIN delivery_terms dt ON p.delivery_terms_id = dt.delivery_terms_id
-        ORDER BY p.product_id
     )";
-    SQLExecDirect(hStmt, (SQLCHAR*)sql.c_str(), SQL_NTS);
+}
+
+const std::vector<CriteriaField>& ProductGateway::criteriaFields() {
+    static const std::vector<CriteriaField> fields = {
+        {"id", "p.product_id", FieldType::Int},
+        {"name", "p.name", FieldType::Text},
+        {"category_id", "p.category_id", FieldType::Int},
+        {"category", "pc.name", FieldType::Text},
+        {"shelf_life_days", "p.shelf_life_days", FieldType::Int},
+        {"delivery_terms_id", "p.delivery_terms_id", FieldType::Int},
+        {"delivery_terms", "dt.description", FieldType::Text},
+        {"retail_price", "p.retail_price", FieldType::Money},
+        {"purchase_price", "p.purchase_price", FieldType::Money},
+        {"created_at", "p.created_at", FieldType::Timestamp},
+        {"updated_at", "p.updated_at", FieldType::Timestamp}
+    };
+    return fields;
+}
+
+std::vector<Product> ProductGateway::findWhere(const Criteria& criteria) {
+    std::vector<Product> list;
+    if (streamWhere(criteria, [&list](const Product& p) { list.push_back(p); return true; }) < 0) return {};
+    return list;
+}
+
+long long ProductGateway::countWhere(const Criteria& criteria) {
+    return countQuery(PRODUCT_FROM, criteria, criteriaFields());
+}
+
+long long ProductGateway::streamWhere(const Criteria& criteria, const RowCallback<Product>& callback) {
+    SQLHSTMT hStmt = openQuery(std::string(PRODUCT_SELECT) + PRODUCT_FROM, criteria,
+                               criteriaFields(), "p.product_id");
+    if (hStmt == SQL_NULL_HSTMT) return -1;
 
     Product p;
     SQLCHAR name[256], cat_name[128], dt_desc[256];
-    while (SQLFetch(hStmt) == SQL_SUCCESS) {
+    SQLBIGINT retail, purchase; // Цены приходят в копейках, без double
+    SQLLEN retailLen, purchaseLen;
+    long long count = 0;
+    SQLRETURN ret;
+    while (SQL_SUCCEEDED(ret = SQLFetch(hStmt))) {
+        cat_name[0] = dt_desc[0] = '\0';
         SQLGetData(hStmt, 1, SQL_C_LONG, &p.id, 0, nullptr);
         SQLGetData(hStmt, 2, SQL_C_LONG, &p.category_id, 0, nullptr);
         SQLGetData(hStmt, 3, SQL_C_CHAR, name, sizeof(name), nullptr);
         SQLGetData(hStmt, 4, SQL_C_LONG, &p.shelf_life_days, 0, nullptr);
         SQLGetData(hStmt, 5, SQL_C_LONG, &p.delivery_terms_id, 0, nullptr);
-        SQLGetData(hStmt, 6, SQL_C_DOUBLE, &p.retail_price, 0, nullptr);
-        SQLGetData(hStmt, 7, SQL_C_DOUBLE, &p.purchase_price, 0, nullptr);
+        SQLGetData(hStmt, 6, SQL_C_SBIGINT, &retail, 0, &retailLen);
+        SQLGetData(hStmt, 7, SQL_C_SBIGINT, &purchase, 0, &purchaseLen);
         SQLGetData(hStmt, 8, SQL_C_CHAR, cat_name, sizeof(cat_name), nullptr);
         SQLGetData(hStmt, 9, SQL_C_CHAR, dt_desc, sizeof(dt_desc), nullptr);
         
         p.name = (char*)name;
+        p.has_retail_price = retailLen != SQL_NULL_DATA;
+        p.has_purchase_price = purchaseLen != SQL_NULL_DATA;
+        p.retail_price = Money::fromKopecks(p.has_retail_price ? retail : 0);
+        p.purchase_price = Money::fromKopecks(p.has_purchase_price ? purchase : 0);
         p.category_name = (char*)cat_name;
         p.delivery_terms_description = (char*)dt_desc;
-        list.push_back(p);
+        ++count;
+        if (!callback(p)) break;
     }
+    bool complete = fetchCompleted(hStmt, ret);
     SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
-    return list;
+    return complete ? count : -1;
 }
 
 Product ProductGateway::findById(int id) {
@@ -59,14 +110,18 @@ Product ProductGateway::findById(int id) {
     SQLHSTMT hStmt;
     SQLAllocHandle(SQL_HANDLE_STMT, db->getHandle(), &hStmt);
     std::ostringstream oss;
-    oss << "SELECT product_id, name, retail_price FROM product WHERE product_id=" << id;
+    oss << "SELECT product_id, name, (retail_price * 100)::BIGINT FROM product WHERE product_id=" << id;
     SQLExecDirect(hStmt, (SQLCHAR*)oss.str().c_str(), SQL_NTS);
     SQLCHAR name[256];
+    SQLBIGINT retail = 0;
+    SQLLEN retailLen;
     if (SQLFetch(hStmt) == SQL_SUCCESS) {
         SQLGetData(hStmt, 1, SQL_C_LONG, &p.id, 0, nullptr);
         SQLGetData(hStmt, 2, SQL_C_CHAR, name, sizeof(name), nullptr);
-        SQLGetData(hStmt, 3, SQL_C_DOUBLE, &p.retail_price, 0, nullptr);
+        SQLGetData(hStmt, 3, SQL_C_SBIGINT, &retail, 0, &retailLen);
         p.name = (char*)name;
+        p.has_retail_price = retailLen != SQL_NULL_DATA;
+        p.retail_price = Money::fromKopecks(p.has_retail_price ? retail : 0);
     }
     SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
     return p;
@@ -124,4 +179,44 @@ Product ProductGateway::findByName(const std::string& name) {
     }
     SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
     return p;
+}
+
+std::vector<std::string> ProductGateway::findAllNames() {
+    std::vector<std::string> names;
+    if (!db->isConnected()) return names;
+
+    SQLHSTMT hStmt;
+    SQLAllocHandle(SQL_HANDLE_STMT, db->getHandle(), &hStmt);
+    std::string sql = "SELECT name FROM product";
+    SQLExecDirect(hStmt, (SQLCHAR*)sql.c_str(), SQL_NTS);
+
+    SQLCHAR name[256];
+    SQLRETURN ret;
+    while (SQL_SUCCEEDED(ret = SQLFetch(hStmt))) {
+        name[0] = '\0';
+        SQLGetData(hStmt, 1, SQL_C_CHAR, name, sizeof(name), nullptr);
+        names.push_back((char*)name);
+    }
+    bool complete = fetchCompleted(hStmt, ret);
+    SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+    if (!complete) return {};
+    return names;
+}
+
+long ProductGateway::insertBatch(const std::vector<Product>& batch) {
+    if (batch.empty()) return 0;
+
+    // Цены передаются целыми копейками и делятся на сервере в NUMERIC — без double
+    std::string sql =
+        "INSERT INTO product (category_id, name, shelf_life_days, delivery_terms_id, retail_price, purchase_price) "
+        "VALUES (?, ?, ?, ?, CAST(? AS BIGINT) / 100.0, CAST(? AS BIGINT) / 100.0)";
+
+    ParamBatch params(db, sql, batch.size());
+    params.addInt(batch, [](const Product& p) { return p.category_id; });
+    params.addText(batch, [](const Product& p) -> const std::string& { return p.name; });
+    params.addInt(batch, [](const Product& p) { return p.shelf_life_days; });
+    params.addInt(batch, [](const Product& p) { return p.delivery_terms_id; });
+    params.addBigInt(batch, [](const Product& p) { return p.retail_price.toKopecks(); });
+    params.addBigInt(batch, [](const Product& p) { return p.purchase_price.toKopecks(); });
+    return params.execute();
 }
\ No newline at end of file
@@ -0,0 +1,887 @@
+#include "RegistryApi.h"
+#include "Json.h"
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+    const size_t DEFAULT_PAGE = 50;
+    const size_t MAX_PAGE = 1000;
+
+    HttpResponse reply(int status, const JsonWriter& json) {
+        HttpResponse res;
+        res.status = status;
+        res.body = json.str();
+        return res;
+    }
+
+    HttpResponse fail(int status, const std::string& message) {
+        JsonWriter json;
+        json.beginObject().field("error", message).endObject();
+        return reply(status, json);
+    }
+
+    HttpResponse notFound(const char* what) {
+        return fail(404, std::string(what) + " не найден(о)");
+    }
+
+    bool parseInt(const std::string& text, long long& out) {
+        if (text.empty()) return false;
+        errno = 0;
+        char* end = nullptr;
+        long long v = std::strtoll(text.c_str(), &end, 10);
+        if (errno != 0 || *end != '\0') return false;
+        out = v;
+        return true;
+    }
+
+    bool parseId(const std::string& text, int& id) {
+        long long v;
+        if (!parseInt(text, v) || v <= 0 || v > INT_MAX) return false;
+        id = static_cast<int>(v);
+        return true;
+    }
+
+    // Неотрицательный параметр строки запроса; fallback, если его нет
+    bool countParam(const HttpRequest& req, const char* name, size_t fallback, size_t& out) {
+        std::string text = req.param(name);
+        if (text.empty()) {
+            out = fallback;
+            return true;
+        }
+        long long v;
+        if (!parseInt(text, v) || v < 0) return false;
+        out = static_cast<size_t>(v);
+        return true;
+    }
+
+    // offset и limit страницы списка; limit ограничен MAX_PAGE
+    bool pageParams(const HttpRequest& req, size_t& offset, size_t& limit, HttpResponse& error) {
+        if (!countParam(req, "offset", 0, offset) || !countParam(req, "limit", DEFAULT_PAGE, limit)) {
+            error = fail(400, "offset и limit должны быть неотрицательными целыми");
+            return false;
+        }
+        if (limit > MAX_PAGE) limit = MAX_PAGE;
+        return true;
+    }
+
+    bool readBody(const HttpRequest& req, JsonObject& body, HttpResponse& error) {
+        std::string message;
+        if (!body.parse(req.body, message)) {
+            error = fail(400, "Неверное тело запроса: " + message);
+            return false;
+        }
+        return true;
+    }
+
+    // Поле тела, если оно задано: false (и ошибка), если задано значение не того типа
+    template <class T, class Getter>
+    bool overlay(const JsonObject& body, const char* name, T& target, Getter get, std::string& error) {
+        if (!body.has(name)) return true;
+        if (!(body.*get)(name, target)) {
+            error = std::string("Неверное значение поля ") + name;
+            return false;
+        }
+        return true;
+    }
+
+    bool applyEnterprise(const JsonObject& body, Enterprise& e, std::string& error) {
+        return overlay(body, "name", e.name, &JsonObject::getString, error)
+            && overlay(body, "legal_form_id", e.legal_form_id, &JsonObject::getInt, error)
+            && overlay(body, "ownership_form_id", e.ownership_form_id, &JsonObject::getInt, error)
+            && overlay(body, "postal_address", e.postal_address, &JsonObject::getString, error)
+            && overlay(body, "inn", e.inn, &JsonObject::getString, error);
+    }
+
+    bool applyProduct(const JsonObject& body, Product& p, std::string& error) {
+        return overlay(body, "name", p.name, &JsonObject::getString, error)
+            && overlay(body, "category_id", p.category_id, &JsonObject::getInt, error)
+            && overlay(body, "shelf_life_days", p.shelf_life_days, &JsonObject::getInt, error)
+            && overlay(body, "delivery_terms_id", p.delivery_terms_id, &JsonObject::getInt, error)
+            && overlay(body, "retail_price", p.retail_price, &JsonObject::getMoney, error)
+            && overlay(body, "purchase_price", p.purchase_price, &JsonObject::getMoney, error);
+    }
+
+    bool applySalesDepartment(const JsonObject& body, SalesDepartment& d, std::string& error) {
+        return overlay(body, "enterprise_id", d.enterprise_id, &JsonObject::getInt, error)
+            && overlay(body, "phone", d.phone, &JsonObject::getString, error)
+            && overlay(body, "fax", d.fax, &JsonObject::getString, error)
+            && overlay(body, "email", d.email, &JsonObject::getString, error)
+            && overlay(body, "contact_last_name", d.contact_last_name, &JsonObject::getString, error)
+            && overlay(body, "contact_first_name", d.contact_first_name, &JsonObject::getString, error)
+            && overlay(body, "contact_patronymic", d.contact_patronymic, &JsonObject::getString, error);
+    }
+
+    bool applyBankDetails(const JsonObject& body, BankDetails& b, std::string& error) {
+        return overlay(body, "enterprise_id", b.enterprise_id, &JsonObject::getInt, error)
+            && overlay(body, "bank_name", b.bank_name, &JsonObject::getString, error)
+            && overlay(body, "bank_city", b.bank_city, &JsonObject::getString, error)
+            && overlay(body, "account_number", b.account_number, &JsonObject::getString, error);
+    }
+
+    void writeEnterprise(JsonWriter& json, const Enterprise& e) {
+        json.beginObject()
+            .field("enterprise_id", e.id)
+            .field("name", e.name)
+            .field("legal_form_id", e.legal_form_id)
+            .field("legal_form", e.legal_form_name)
+            .field("ownership_form_id", e.ownership_form_id)
+            .field("ownership_form", e.ownership_form_name)
+            .field("postal_address", e.postal_address)
+            .field("inn", e.inn)
+            .endObject();
+    }
+
+    // Цена, не указанная в БД, выводится как null, а не как "0.00"
+    void writePrice(JsonWriter& json, const char* name, Money price, bool known) {
+        json.key(name);
+        if (known) json.value(price);
+        else json.null();
+    }
+
+    void writeProductFields(JsonWriter& json, const Product& p) {
+        json.field("product_id", p.id)
+            .field("name", p.name)
+            .field("category_id", p.category_id)
+            .field("category", p.category_name)
+            .field("shelf_life_days", p.shelf_life_days)
+            .field("delivery_terms_id", p.delivery_terms_id)
+            .field("delivery_terms", p.delivery_terms_description);
+        writePrice(json, "retail_price", p.retail_price, p.has_retail_price);
+        writePrice(json, "purchase_price", p.purchase_price, p.has_purchase_price);
+    }
+
+    void writeAssortmentLine(JsonWriter& json, const AssortmentLine& line) {
+        json.beginObject();
+        writeProductFields(json, line.product);
+        writePrice(json, "wholesale_price", line.wholesale_price, line.has_wholesale_price);
+        json.endObject();
+    }
+
+    void writeProduct(JsonWriter& json, const Product& p) {
+        json.beginObject();
+        writeProductFields(json, p);
+        json.endObject();
+    }
+
+    void writeSalesDepartment(JsonWriter& json, const SalesDepartment& d) {
+        json.beginObject()
+            .field("depart_id", d.id)
+            .field("enterprise_id", d.enterprise_id)
+            .field("enterprise", d.enterprise_name)
+            .field("phone", d.phone)
+            .field("fax", d.fax)
+            .field("email", d.email)
+            .field("contact_last_name", d.contact_last_name)
+            .field("contact_first_name", d.contact_first_name)
+            .field("contact_patronymic", d.contact_patronymic)
+            .endObject();
+    }
+
+    void writeBankDetails(JsonWriter& json, const BankDetails& b) {
+        json.beginObject()
+            .field("bank_id", b.id)
+            .field("enterprise_id", b.enterprise_id)
+            .field("enterprise", b.enterprise_name)
+            .field("bank_name", b.bank_name)
+            .field("bank_city", b.bank_city)
+            .field("account_number", b.account_number)
+            .endObject();
+    }
+
+    void writeOffer(JsonWriter& json, const ProductOffer& o) {
+        json.beginObject()
+            .field("product_id", o.product_id)
+            .field("rank", o.rank)
+            .field("enterprise_id", o.enterprise_id)
+            .field("enterprise", o.enterprise_name)
+            .field("wholesale_price", o.wholesale_price)
+            .endObject();
+    }
+
+    HttpResponse marginReport(const std::vector<MarginSummary>& report) {
+        JsonWriter json;
+        json.beginObject().key("items").beginArray();
+        for (const MarginSummary& m : report) {
+            json.beginObject()
+                .field("id", m.id)
+                .field("name", m.name)
+                .field("lines", m.lines)
+                .field("wholesale_total", m.wholesale_total)
+                .field("purchase_total", m.purchase_total)
+                .field("margin", m.wholesale_total - m.purchase_total)
+                .field("below_purchase", m.below_purchase)
+                .field("margin_share", m.margin_share)
+                .endObject();
+        }
+        json.endArray().endObject();
+        return reply(200, json);
+    }
+
+    // Ответ на список, уже выбранный целиком: страница offset/limit из него
+    template <class T, class Write>
+    HttpResponse pageOf(const std::vector<T>& all, size_t offset, size_t limit, Write write) {
+        JsonWriter json;
+        json.beginObject().field("total", all.size()).field("offset", offset).key("items").beginArray();
+        for (size_t i = offset; i < all.size() && i - offset < limit; ++i) write(json, all[i]);
+        json.endArray().endObject();
+        return reply(200, json);
+    }
+
+    // Ответ на страницу, выбранную сервером БД (LIMIT/OFFSET); total — число всех строк
+    template <class T, class Write>
+    HttpResponse pageReply(long long total, const std::vector<T>& page, size_t offset, Write write) {
+        if (total < 0) return fail(503, "Реестр недоступен");
+        JsonWriter json;
+        json.beginObject().field("total", total).field("offset", offset).key("items").beginArray();
+        for (const T& item : page) write(json, item);
+        json.endArray().endObject();
+        return reply(200, json);
+    }
+
+    // Ответ на создание: 201 и ID новой записи
+    HttpResponse created(const char* idField, int id) {
+        JsonWriter json;
+        json.beginObject().field(idField, id).endObject();
+        return reply(201, json);
+    }
+
+    HttpResponse ok() {
+        JsonWriter json;
+        json.beginObject().field("ok", true).endObject();
+        return reply(200, json);
+    }
+
+    std::vector<std::string> splitPath(const std::string& path) {
+        std::vector<std::string> parts;
+        size_t pos = 0;
+        while (pos < path.size()) {
+            size_t next = path.find('/', pos);
+            if (next == std::string::npos) next = path.size();
+            if (next > pos) parts.emplace_back(path, pos, next - pos);
+            pos = next + 1;
+        }
+        return parts;
+    }
+}
+
+// ==========================================
+// Маршрутизация
+// ==========================================
+
+RegistryApi::RegistryApi(RegistryService& registry) : service(registry) {
+    add("GET",    "/api/health", &RegistryApi::health);
+    add("GET",    "/api/dictionaries/{}", &RegistryApi::dictionary);
+
+    add("GET",    "/api/enterprises", &RegistryApi::listEnterprises);
+    add("POST",   "/api/enterprises", &RegistryApi::createEnterprise, true);
+    add("GET",    "/api/enterprises/inn/{}", &RegistryApi::getEnterpriseByInn);
+    add("GET",    "/api/enterprises/{}", &RegistryApi::getEnterprise);
+    add("PUT",    "/api/enterprises/{}", &RegistryApi::updateEnterprise, true);
+    add("DELETE", "/api/enterprises/{}", &RegistryApi::deleteEnterprise, true);
+    add("GET",    "/api/enterprises/{}/summary", &RegistryApi::getAssortmentSummary);
+    add("GET",    "/api/enterprises/{}/dossier", &RegistryApi::getDossier);
+    add("GET",    "/api/enterprises/{}/assortment", &RegistryApi::getAssortment);
+    add("POST",   "/api/enterprises/{}/assortment", &RegistryApi::addAssortmentLine, true);
+    add("POST",   "/api/enterprises/{}/assortment/copy", &RegistryApi::copyAssortment, true);
+    add("PUT",    "/api/enterprises/{}/assortment/{}", &RegistryApi::updateAssortmentLine, true);
+    add("DELETE", "/api/enterprises/{}/assortment/{}", &RegistryApi::deleteAssortmentLine, true);
+
+    add("GET",    "/api/products", &RegistryApi::listProducts);
+    add("POST",   "/api/products", &RegistryApi::createProduct, true);
+    add("GET",    "/api/products/{}", &RegistryApi::getProduct);
+    add("PUT",    "/api/products/{}", &RegistryApi::updateProduct, true);
+    add("DELETE", "/api/products/{}", &RegistryApi::deleteProduct, true);
+    add("GET",    "/api/products/{}/offers", &RegistryApi::productOffers);
+    add("POST",   "/api/offers", &RegistryApi::batchOffers);
+
+    add("GET",    "/api/sales-departments", &RegistryApi::listSalesDepartments);
+    add("POST",   "/api/sales-departments", &RegistryApi::createSalesDepartment, true);
+    add("GET",    "/api/sales-departments/{}", &RegistryApi::getSalesDepartment);
+    add("PUT",    "/api/sales-departments/{}", &RegistryApi::updateSalesDepartment, true);
+    add("DELETE", "/api/sales-departments/{}", &RegistryApi::deleteSalesDepartment, true);
+
+    add("GET",    "/api/bank-details", &RegistryApi::listBankDetails);
+    add("POST",   "/api/bank-details", &RegistryApi::createBankDetails, true);
+    add("GET",    "/api/bank-details/{}", &RegistryApi::getBankDetails);
+    add("PUT",    "/api/bank-details/{}", &RegistryApi::updateBankDetails, true);
+    add("DELETE", "/api/bank-details/{}", &RegistryApi::deleteBankDetails, true);
+
+    add("GET",    "/api/reports/margin/enterprises", &RegistryApi::marginByEnterprise);
+    add("GET",    "/api/reports/margin/categories", &RegistryApi::marginByCategory);
+    add("GET",    "/api/reports/price-outliers", &RegistryApi::priceOutliers);
+}
+
+void RegistryApi::add(const char* method, const char* pattern, Method handler, bool write) {
+    routes.push_back({method, splitPath(pattern), handler, write});
+}
+
+HttpResponse RegistryApi::handle(const HttpRequest& req) {
+    std::vector<std::string> parts = splitPath(req.path);
+    bool pathMatched = false;
+    Args args;
+    // Маршрутов несколько десятков: линейный перебор дешевле обращения к БД
+    for (const Route& route : routes) {
+        if (route.segments.size() != parts.size()) continue;
+        args.clear();
+        bool match = true;
+        for (size_t i = 0; i < parts.size() && match; ++i) {
+            if (route.segments[i] == "{}") args.push_back(parts[i]);
+            else match = (route.segments[i] == parts[i]);
+        }
+        if (!match) continue;
+        pathMatched = true;
+        if (route.method != req.method) continue;
+        if (route.write && service.isReadOnly()) {
+            return fail(409, "Сервер работает от снимка: изменения недоступны");
+        }
+        return (this->*route.handler)(req, args);
+    }
+    if (pathMatched) return fail(405, "Метод " + req.method + " не поддерживается для " + req.path);
+    return fail(404, "Нет такого ресурса: " + req.path);
+}
+
+HttpResponse RegistryApi::health(const HttpRequest&, const Args&) {
+    JsonWriter json;
+    json.beginObject()
+        .field("status", "ok")
+        .field("read_only", service.isReadOnly())
+        .field("catalog_loaded", service.isCatalogLoaded())
+        .endObject();
+    return reply(200, json);
+}
+
+HttpResponse RegistryApi::dictionary(const HttpRequest&, const Args& args) {
+    Dictionary dict;
+    if (args[0] == "legal-forms") dict = Dictionary::LegalForm;
+    else if (args[0] == "ownership-forms") dict = Dictionary::OwnershipForm;
+    else if (args[0] == "categories") dict = Dictionary::ProductCategory;
+    else if (args[0] == "delivery-terms") dict = Dictionary::DeliveryTerms;
+    else return fail(404, "Нет справочника " + args[0]);
+
+    JsonWriter json;
+    json.beginObject().key("items").beginArray();
+    for (const DictionaryEntry& e : service.getDictionary(dict)) {
+        json.beginObject().field("id", e.id).field("name", e.name).endObject();
+    }
+    json.endArray().endObject();
+    return reply(200, json);
+}
+
+// ==========================================
+// Предприятия
+// ==========================================
+
+// ?q= — нечёткий поиск, ?prefix= — по началу названия, иначе страница offset/limit
+HttpResponse RegistryApi::listEnterprises(const HttpRequest& req, const Args&) {
+    size_t offset, limit;
+    HttpResponse error;
+    if (!pageParams(req, offset, limit, error)) return error;
+
+    JsonWriter json;
+    std::string q = req.param("q");
+    std::string prefix = req.param("prefix");
+    if (!q.empty()) {
+        json.beginObject().key("items").beginArray();
+        for (const auto& hit : service.searchEnterprises(q, limit)) {
+            json.beginObject().key("enterprise");
+            writeEnterprise(json, hit.first);
+            json.field("score", static_cast<double>(hit.second)).endObject();
+        }
+        json.endArray().endObject();
+    } else if (!prefix.empty()) {
+        json.beginObject().key("items").beginArray();
+        for (const Enterprise& e : service.findEnterprisesByNamePrefix(prefix, limit)) writeEnterprise(json, e);
+        json.endArray().endObject();
+    } else {
+        size_t total = service.getEnterpriseCount();
+        json.beginObject().field("total", total).field("offset", offset).key("items").beginArray();
+        for (size_t i = offset; i < total && i - offset < limit; ++i) {
+            Enterprise e = service.getEnterpriseAt(i);
+            if (e.id == 0) break; // Список сократился во время обхода
+            writeEnterprise(json, e);
+        }
+        json.endArray().endObject();
+    }
+    return reply(200, json);
+}
+
+HttpResponse RegistryApi::getEnterprise(const HttpRequest&, const Args& args) {
+    int id;
+    if (!parseId(args[0], id)) return fail(400, "Неверный ID предприятия");
+    Enterprise e = service.getEnterpriseById(id);
+    if (e.id == 0) return notFound("Предприятие");
+    JsonWriter json;
+    writeEnterprise(json, e);
+    return reply(200, json);
+}
+
+HttpResponse RegistryApi::getEnterpriseByInn(const HttpRequest&, const Args& args) {
+    Enterprise e = service.findEnterpriseByInn(args[0]);
+    if (e.id == 0) return notFound("Предприятие");
+    JsonWriter json;
+    writeEnterprise(json, e);
+    return reply(200, json);
+}
+
+HttpResponse RegistryApi::createEnterprise(const HttpRequest& req, const Args&) {
+    JsonObject body;
+    HttpResponse error;
+    if (!readBody(req, body, error)) return error;
+    Enterprise e{0, "", 0, 0, "", "", "", ""};
+    std::string message;
+    if (!applyEnterprise(body, e, message)) return fail(400, message);
+    if (e.name.empty() || e.inn.empty()) return fail(422, "Поля name и inn обязательны");
+
+    int id = service.createEnterprise(e);
+    if (id < 0) return fail(422, "Предприятие не создано (проверьте справочники и уникальность ИНН)");
+    return created("enterprise_id", id);
+}
+
+// Поля, отсутствующие в теле, сохраняют прежние значения
+HttpResponse RegistryApi::updateEnterprise(const HttpRequest& req, const Args& args) {
+    int id;
+    if (!parseId(args[0], id)) return fail(400, "Неверный ID предприятия");
+    JsonObject body;
+    HttpResponse error;
+    if (!readBody(req, body, error)) return error;
+
+    Enterprise e = service.getEnterpriseById(id);
+    if (e.id == 0) return notFound("Предприятие");
+    std::string message;
+    if (!applyEnterprise(body, e, message)) return fail(400, message);
+    if (!service.updateEnterprise(e)) return fail(422, "Предприятие не изменено");
+
+    JsonWriter json;
+    writeEnterprise(json, service.getEnterpriseById(id));
+    return reply(200, json);
+}
+
+HttpResponse RegistryApi::deleteEnterprise(const HttpRequest&, const Args& args) {
+    int id;
+    if (!parseId(args[0], id)) return fail(400, "Неверный ID предприятия");
+    if (service.getEnterpriseById(id).id == 0) return notFound("Предприятие");
+    if (!service.deleteEnterprise(id)) return fail(409, "Предприятие не удалено");
+    return ok();
+}
+
+// ==========================================
+// Ассортимент
+// ==========================================
+
+HttpResponse RegistryApi::getAssortment(const HttpRequest& req, const Args& args) {
+    int id;
+    if (!parseId(args[0], id)) return fail(400, "Неверный ID предприятия");
+    size_t offset, limit;
+    HttpResponse error;
+    if (!pageParams(req, offset, limit, error)) return error;
+    if (service.getEnterpriseById(id).id == 0) return notFound("Предприятие");
+
+    return pageOf(service.getAssortmentForEnterprise(id), offset, limit, writeAssortmentLine);
+}
+
+HttpResponse RegistryApi::getAssortmentSummary(const HttpRequest&, const Args& args) {
+    int id;
+    if (!parseId(args[0], id)) return fail(400, "Неверный ID предприятия");
+    std::vector<AssortmentSummary> list = service.getAssortmentSummaries({id});
+    if (list.empty()) return notFound("Предприятие");
+
+    const AssortmentSummary& s = list.front();
+    JsonWriter json;
+    json.beginObject()
+        .field("enterprise_id", s.enterprise_id)
+        .field("enterprise", s.enterprise_name)
+        .field("lines", s.lines)
+        .field("categories", s.categories)
+        .field("min_price", s.min_price)
+        .field("avg_price", s.avg_price)
+        .field("max_price", s.max_price)
+        .endObject();
+    return reply(200, json);
+}
+
+// Карточка со связанными записями; отсутствующие отдел сбыта и реквизиты — null
+HttpResponse RegistryApi::getDossier(const HttpRequest&, const Args& args) {
+    int id;
+    if (!parseId(args[0], id)) return fail(400, "Неверный ID предприятия");
+    EnterpriseDossier d = service.getEnterpriseDossier(id);
+    if (d.enterprise.id == 0) return notFound("Предприятие");
+
+    JsonWriter json;
+    json.beginObject().key("enterprise");
+    writeEnterprise(json, d.enterprise);
+    json.key("sales_department");
+    if (d.salesDepartment.id != 0) writeSalesDepartment(json, d.salesDepartment);
+    else json.null();
+    json.key("bank_details");
+    if (d.bankDetails.id != 0) writeBankDetails(json, d.bankDetails);
+    else json.null();
+    json.key("summary").beginObject()
+        .field("lines", d.summary.lines)
+        .field("categories", d.summary.categories)
+        .field("min_price", d.summary.min_price)
+        .field("avg_price", d.summary.avg_price)
+        .field("max_price", d.summary.max_price)
+        .endObject();
+    json.key("assortment").beginArray();
+    for (const auto& line : d.assortment) writeAssortmentLine(json, line);
+    json.endArray().endObject();
+    return reply(200, json);
+}
+
+// Тело: {"product_id": 7, "wholesale_price": "120.50"}
+HttpResponse RegistryApi::addAssortmentLine(const HttpRequest& req, const Args& args) {
+    int id;
+    if (!parseId(args[0], id)) return fail(400, "Неверный ID предприятия");
+    JsonObject body;
+    HttpResponse error;
+    if (!readBody(req, body, error)) return error;
+    int productId;
+    Money price;
+    if (!body.getInt("product_id", productId) || !body.getMoney("wholesale_price", price)) {
+        return fail(400, "Нужны поля product_id и wholesale_price");
+    }
+    if (!service.addProductToAssortment(id, productId, price)) {
+        return fail(422, "Позиция не добавлена (нет предприятия или товара, либо товар уже в ассортименте)");
+    }
+    JsonWriter json;
+    json.beginObject().field("enterprise_id", id).field("product_id", productId)
+        .field("wholesale_price", price).endObject();
+    return reply(201, json);
+}
+
+HttpResponse RegistryApi::updateAssortmentLine(const HttpRequest& req, const Args& args) {
+    int id, productId;
+    if (!parseId(args[0], id) || !parseId(args[1], productId)) return fail(400, "Неверный ID");
+    JsonObject body;
+    HttpResponse error;
+    if (!readBody(req, body, error)) return error;
+    Money price;
+    if (!body.getMoney("wholesale_price", price)) return fail(400, "Нужно поле wholesale_price");
+    if (!service.updateProductPriceInAssortment(id, productId, price)) return notFound("Товар в ассортименте");
+    return ok();
+}
+
+HttpResponse RegistryApi::deleteAssortmentLine(const HttpRequest&, const Args& args) {
+    int id, productId;
+    if (!parseId(args[0], id) || !parseId(args[1], productId)) return fail(400, "Неверный ID");
+    if (!service.removeProductFromAssortment(id, productId)) return notFound("Товар в ассортименте");
+    return ok();
+}
+
+// Тело: {"targets": [2, 3], "multiplier": 1.1, "overwrite": false}
+HttpResponse RegistryApi::copyAssortment(const HttpRequest& req, const Args& args) {
+    int id;
+    if (!parseId(args[0], id)) return fail(400, "Неверный ID предприятия");
+    JsonObject body;
+    HttpResponse error;
+    if (!readBody(req, body, error)) return error;
+
+    std::vector<int> targets;
+    if (!body.getIntArray("targets", targets) || targets.empty()) {
+        return fail(400, "Нужно поле targets — непустой массив ID предприятий");
+    }
+    double multiplier = 1.0;
+    bool overwrite = false;
+    if (body.has("multiplier") && (!body.getNumber("multiplier", multiplier) || !(multiplier > 0) || !std::isfinite(multiplier))) {
+        return fail(400, "multiplier должен быть положительным числом");
+    }
+    if (body.has("overwrite") && !body.getBool("overwrite", overwrite)) {
+        return fail(400, "overwrite должен быть true или false");
+    }
+
+    long rows = service.copyAssortment(id, targets, multiplier,
+                                       overwrite ? AssortmentConflictPolicy::Overwrite
+                                                 : AssortmentConflictPolicy::Skip);
+    if (rows < 0) return fail(422, "Ассортимент не скопирован");
+    JsonWriter json;
+    json.beginObject().field("rows", static_cast<long long>(rows)).endObject();
+    return reply(200, json);
+}
+
+// ==========================================
+// Товары
+// ==========================================
+
+HttpResponse RegistryApi::listProducts(const HttpRequest& req, const Args&) {
+    size_t offset, limit;
+    HttpResponse error;
+    if (!pageParams(req, offset, limit, error)) return error;
+
+    JsonWriter json;
+    std::string q = req.param("q");
+    std::string prefix = req.param("prefix");
+    if (!q.empty()) {
+        json.beginObject().key("items").beginArray();
+        for (const auto& hit : service.searchProducts(q, limit)) {
+            json.beginObject().key("product");
+            writeProduct(json, hit.first);
+            json.field("score", static_cast<double>(hit.second)).endObject();
+        }
+        json.endArray().endObject();
+    } else if (!prefix.empty()) {
+        json.beginObject().key("items").beginArray();
+        for (const Product& p : service.findProductsByNamePrefix(prefix, limit)) writeProduct(json, p);
+        json.endArray().endObject();
+    } else {
+        size_t total = service.getProductCount();
+        json.beginObject().field("total", total).field("offset", offset).key("items").beginArray();
+        for (size_t i = offset; i < total && i - offset < limit; ++i) {
+            Product p = service.getProductAt(i);
+            if (p.id == 0) break;
+            writeProduct(json, p);
+        }
+        json.endArray().endObject();
+    }
+    return reply(200, json);
+}
+
+HttpResponse RegistryApi::getProduct(const HttpRequest&, const Args& args) {
+    int id;
+    if (!parseId(args[0], id)) return fail(400, "Неверный ID товара");
+    Product p = service.getProductById(id);
+    if (p.id == 0) return notFound("Товар");
+    JsonWriter json;
+    writeProduct(json, p);
+    return reply(200, json);
+}
+
+HttpResponse RegistryApi::createProduct(const HttpRequest& req, const Args&) {
+    JsonObject body;
+    HttpResponse error;
+    if (!readBody(req, body, error)) return error;
+    Product p{0, 0, "", 0, 0, Money(), Money(), "", ""};
+    std::string message;
+    if (!applyProduct(body, p, message)) return fail(400, message);
+    if (p.name.empty()) return fail(422, "Поле name обязательно");
+
+    int id = service.createProduct(p);
+    if (id < 0) return fail(422, "Товар не создан (проверьте категорию и условия поставки)");
+    return created("product_id", id);
+}
+
+HttpResponse RegistryApi::updateProduct(const HttpRequest& req, const Args& args) {
+    int id;
+    if (!parseId(args[0], id)) return fail(400, "Неверный ID товара");
+    JsonObject body;
+    HttpResponse error;
+    if (!readBody(req, body, error)) return error;
+
+    Product p = service.getProductById(id);
+    if (p.id == 0) return notFound("Товар");
+    std::string message;
+    if (!applyProduct(body, p, message)) return fail(400, message);
+    if (!service.updateProduct(p)) return fail(422, "Товар не изменён");
+
+    JsonWriter json;
+    writeProduct(json, service.getProductById(id));
+    return reply(200, json);
+}
+
+HttpResponse RegistryApi::deleteProduct(const HttpRequest&, const Args& args) {
+    int id;
+    if (!parseId(args[0], id)) return fail(400, "Неверный ID товара");
+    if (service.getProductById(id).id == 0) return notFound("Товар");
+    if (!service.deleteProduct(id)) return fail(409, "Товар не удалён");
+    return ok();
+}
+
+// ?top=N — не больше N предложений (0 — все)
+HttpResponse RegistryApi::productOffers(const HttpRequest& req, const Args& args) {
+    int id;
+    size_t top;
+    if (!parseId(args[0], id)) return fail(400, "Неверный ID товара");
+    if (!countParam(req, "top", 0, top)) return fail(400, "top должен быть неотрицательным целым");
+
+    JsonWriter json;
+    json.beginObject().key("items").beginArray();
+    for (const ProductOffer& o : service.getBestOffers(id, top)) writeOffer(json, o);
+    json.endArray().endObject();
+    return reply(200, json);
+}
+
+// Тело: {"product_ids": [1, 2, 3], "top": 3} — предложения по всем товарам одним ответом
+HttpResponse RegistryApi::batchOffers(const HttpRequest& req, const Args&) {
+    JsonObject body;
+    HttpResponse error;
+    if (!readBody(req, body, error)) return error;
+    std::vector<int> ids;
+    if (!body.getIntArray("product_ids", ids)) return fail(400, "Нужно поле product_ids — массив ID товаров");
+    int top = 0;
+    if (body.has("top") && (!body.getInt("top", top) || top < 0)) {
+        return fail(400, "top должен быть неотрицательным целым");
+    }
+
+    JsonWriter json;
+    json.beginObject().key("items").beginArray();
+    for (const ProductOffer& o : service.getBestOffers(ids, static_cast<size_t>(top))) writeOffer(json, o);
+    json.endArray().endObject();
+    return reply(200, json);
+}
+
+// ==========================================
+// Отделы сбыта
+// ==========================================
+
+HttpResponse RegistryApi::listSalesDepartments(const HttpRequest& req, const Args&) {
+    size_t offset, limit;
+    HttpResponse error;
+    if (!pageParams(req, offset, limit, error)) return error;
+    Criteria page = Criteria().limit(static_cast<long long>(limit)).offset(static_cast<long long>(offset));
+    long long total = service.countSalesDepartments(page);
+    return pageReply(total, total > 0 ? service.querySalesDepartments(page) : std::vector<SalesDepartment>(),
+                     offset, writeSalesDepartment);
+}
+
+HttpResponse RegistryApi::getSalesDepartment(const HttpRequest&, const Args& args) {
+    int id;
+    if (!parseId(args[0], id)) return fail(400, "Неверный ID отдела");
+    SalesDepartment d = service.getSalesDepartmentById(id);
+    if (d.id == 0) return notFound("Отдел сбыта");
+    JsonWriter json;
+    writeSalesDepartment(json, d);
+    return reply(200, json);
+}
+
+HttpResponse RegistryApi::createSalesDepartment(const HttpRequest& req, const Args&) {
+    JsonObject body;
+    HttpResponse error;
+    if (!readBody(req, body, error)) return error;
+    SalesDepartment d{0, 0, "", "", "", "", "", "", ""};
+    std::string message;
+    if (!applySalesDepartment(body, d, message)) return fail(400, message);
+    if (d.enterprise_id <= 0) return fail(422, "Поле enterprise_id обязательно");
+
+    int id = service.createSalesDepartment(d);
+    if (id < 0) return fail(422, "Отдел сбыта не создан");
+    return created("depart_id", id);
+}
+
+HttpResponse RegistryApi::updateSalesDepartment(const HttpRequest& req, const Args& args) {
+    int id;
+    if (!parseId(args[0], id)) return fail(400, "Неверный ID отдела");
+    JsonObject body;
+    HttpResponse error;
+    if (!readBody(req, body, error)) return error;
+
+    SalesDepartment d = service.getSalesDepartmentById(id);
+    if (d.id == 0) return notFound("Отдел сбыта");
+    std::string message;
+    if (!applySalesDepartment(body, d, message)) return fail(400, message);
+    if (!service.updateSalesDepartment(d)) return fail(422, "Отдел сбыта не изменён");
+
+    JsonWriter json;
+    writeSalesDepartment(json, service.getSalesDepartmentById(id));
+    return reply(200, json);
+}
+
+HttpResponse RegistryApi::deleteSalesDepartment(const HttpRequest&, const Args& args) {
+    int id;
+    if (!parseId(args[0], id)) return fail(400, "Неверный ID отдела");
+    if (service.getSalesDepartmentById(id).id == 0) return notFound("Отдел сбыта");
+    if (!service.deleteSalesDepartment(id)) return fail(409, "Отдел сбыта не удалён");
+    return ok();
+}
+
+// ==========================================
+// Банковские реквизиты
+// ==========================================
+
+HttpResponse RegistryApi::listBankDetails(const HttpRequest& req, const Args&) {
+    size_t offset, limit;
+    HttpResponse error;
+    if (!pageParams(req, offset, limit, error)) return error;
+    Criteria page = Criteria().limit(static_cast<long long>(limit)).offset(static_cast<long long>(offset));
+    long long total = service.countBankDetails(page);
+    return pageReply(total, total > 0 ? service.queryBankDetails(page) : std::vector<BankDetails>(),
+                     offset, writeBankDetails);
+}
+
+HttpResponse RegistryApi::getBankDetails(const HttpRequest&, const Args& args) {
+    int id;
+    if (!parseId(args[0], id)) return fail(400, "Неверный ID реквизитов");
+    BankDetails b = service.getBankDetailsById(id);
+    if (b.id == 0) return notFound("Реквизиты");
+    JsonWriter json;
+    writeBankDetails(json, b);
+    return reply(200, json);
+}
+
+HttpResponse RegistryApi::createBankDetails(const HttpRequest& req, const Args&) {
+    JsonObject body;
+    HttpResponse error;
+    if (!readBody(req, body, error)) return error;
+    BankDetails b{0, 0, "", "", "", ""};
+    std::string message;
+    if (!applyBankDetails(body, b, message)) return fail(400, message);
+    if (b.enterprise_id <= 0 || b.account_number.empty()) {
+        return fail(422, "Поля enterprise_id и account_number обязательны");
+    }
+
+    int id = service.createBankDetails(b);
+    if (id < 0) return fail(422, "Реквизиты не созданы");
+    return created("bank_id", id);
+}
+
+HttpResponse RegistryApi::updateBankDetails(const HttpRequest& req, const Args& args) {
+    int id;
+    if (!parseId(args[0], id)) return fail(400, "Неверный ID реквизитов");
+    JsonObject body;
+    HttpResponse error;
+    if (!readBody(req, body, error)) return error;
+
+    BankDetails b = service.getBankDetailsById(id);
+    if (b.id == 0) return notFound("Реквизиты");
+    std::string message;
+    if (!applyBankDetails(body, b, message)) return fail(400, message);
+    if (!service.updateBankDetails(b)) return fail(422, "Реквизиты не изменены");
+
+    JsonWriter json;
+    writeBankDetails(json, service.getBankDetailsById(id));
+    return reply(200, json);
+}
+
+HttpResponse RegistryApi::deleteBankDetails(const HttpRequest&, const Args& args) {
+    int id;
+    if (!parseId(args[0], id)) return fail(400, "Неверный ID реквизитов");
+    if (service.getBankDetailsById(id).id == 0) return notFound("Реквизиты");
+    if (!service.deleteBankDetails(id)) return fail(409, "Реквизиты не удалены");
+    return ok();
+}
+
+// ==========================================
+// Отчёты
+// ==========================================
+
+HttpResponse RegistryApi::marginByEnterprise(const HttpRequest& req, const Args&) {
+    size_t limit;
+    if (!countParam(req, "limit", 0, limit)) return fail(400, "limit должен быть неотрицательным целым");
+    return marginReport(service.getMarginByEnterprise(limit));
+}
+
+HttpResponse RegistryApi::marginByCategory(const HttpRequest&, const Args&) {
+    return marginReport(service.getMarginByCategory());
+}
+
+HttpResponse RegistryApi::priceOutliers(const HttpRequest& req, const Args&) {
+    size_t limit;
+    if (!countParam(req, "limit", DEFAULT_PAGE, limit)) return fail(400, "limit должен быть неотрицательным целым");
+    long long total = 0;
+    std::vector<PriceOutlier> list = service.getPriceOutliers(limit, &total);
+
+    JsonWriter json;
+    json.beginObject().field("total", total).key("items").beginArray();
+    for (const PriceOutlier& o : list) {
+        json.beginObject()
+            .field("enterprise_id", o.enterprise_id)
+            .field("enterprise", o.enterprise_name)
+            .field("product_id", o.product_id)
+            .field("product", o.product_name)
+            .field("wholesale_price", o.wholesale_price)
+            .field("purchase_price", o.purchase_price)
+            .endObject();
+    }
+    json.endArray().endObject();
+    return reply(200, json);
+}
\ No newline at end of file
@@ -0,0 +1,374 @@
+#include "RegistryClient.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using rpc::Op;
+using rpc::Status;
+
+namespace {
+    // Путь, понятный демону: относительный дополняется текущим каталогом клиента
+    std::string absolutePath(const std::string& path) {
+        if (path.empty() || path[0] == '/' || path == "-") return path;
+        char cwd[4096];
+        if (!getcwd(cwd, sizeof(cwd))) return path;
+        return std::string(cwd) + "/" + path;
+    }
+
+    template <class T>
+    std::vector<std::pair<T, float>> readHits(const std::string& payload) {
+        rpc::Reader in(payload);
+        uint32_t n = in.u32();
+        std::vector<std::pair<T, float>> hits;
+        for (uint32_t i = 0; i < n && in.ok(); ++i) {
+            T item;
+            rpc::read(in, item);
+            float score = in.f32();
+            hits.emplace_back(std::move(item), score);
+        }
+        if (!in.done()) return {};
+        return hits;
+    }
+}
+
+std::string RegistryClient::defaultSocketPath() {
+    const char* env = std::getenv("REGENT_SOCKET");
+    return (env && *env) ? env : "/tmp/RegEnterprise.sock";
+}
+
+RegistryClient::~RegistryClient() {
+    disconnect();
+}
+
+bool RegistryClient::connect(const std::string& socketPath) {
+    disconnect();
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Ошибка: Неверный путь сокета: " << socketPath << std::endl;
+        return false;
+    }
+    std::memcpy(addr.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        std::cerr << "Ошибка: Демон недоступен (" << socketPath << "): " << std::strerror(errno) << std::endl;
+        disconnect();
+        return false;
+    }
+
+    std::string result;
+    if (!call(Op::Ping, rpc::Writer(), result)) {
+        disconnect();
+        return false;
+    }
+    rpc::Reader in(result);
+    uint32_t version = in.u32();
+    readOnly = in.u8() != 0;
+    if (!in.done() || version != rpc::PROTOCOL_VERSION) {
+        std::cerr << "Ошибка: Версия протокола демона (" << version << ") не совпадает с клиентом ("
+                  << rpc::PROTOCOL_VERSION << ")" << std::endl;
+        disconnect();
+        return false;
+    }
+    return true;
+}
+
+void RegistryClient::disconnect() {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+}
+
+bool RegistryClient::call(Op op, const rpc::Writer& args, std::string& result, Status* status) {
+    std::lock_guard<std::mutex> lock(callMutex);
+    if (fd < 0) {
+        std::cerr << "Ошибка: Нет подключения к демону" << std::endl;
+        return false;
+    }
+    rpc::Writer request;
+    request.u16(static_cast<uint16_t>(op));
+    std::string frame = request.data() + args.data();
+
+    std::string response;
+    if (!rpc::writeFrame(fd, frame) || !rpc::readFrame(fd, response) || response.empty()) {
+        std::cerr << "Ошибка: Соединение с демоном прервано" << std::endl;
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    Status code = static_cast<Status>(static_cast<uint8_t>(response[0]));
+    if (status) *status = code;
+    result.assign(response, 1, std::string::npos);
+    if (code == Status::Ok) return true;
+    if (code != Status::NotFound) {
+        rpc::Reader in(result);
+        std::cerr << "Ошибка демона: " << in.str() << std::endl;
+    }
+    return false;
+}
+
+bool RegistryClient::refreshCache() {
+    std::string result;
+    return call(Op::RefreshCache, rpc::Writer(), result);
+}
+
+// ==========================================
+// Предприятия и товары
+// ==========================================
+
+Enterprise RegistryClient::getEnterpriseById(int id) {
+    rpc::Writer args;
+    args.i32(id);
+    std::string result;
+    Enterprise e{0, "", 0, 0, "", "", "", ""};
+    if (!call(Op::GetEnterprise, args, result)) return e;
+    rpc::Reader in(result);
+    rpc::read(in, e);
+    return e;
+}
+
+Enterprise RegistryClient::findEnterpriseByInn(const std::string& inn) {
+    rpc::Writer args;
+    args.str(inn);
+    std::string result;
+    Enterprise e{0, "", 0, 0, "", "", "", ""};
+    if (!call(Op::FindEnterpriseByInn, args, result)) return e;
+    rpc::Reader in(result);
+    rpc::read(in, e);
+    return e;
+}
+
+std::vector<std::pair<Enterprise, float>> RegistryClient::searchEnterprises(const std::string& query, size_t limit) {
+    rpc::Writer args;
+    args.str(query);
+    args.u32(static_cast<uint32_t>(limit));
+    std::string result;
+    if (!call(Op::SearchEnterprises, args, result)) return {};
+    return readHits<Enterprise>(result);
+}
+
+int RegistryClient::createEnterprise(const Enterprise& ent) {
+    rpc::Writer args;
+    rpc::write(args, ent);
+    std::string result;
+    if (!call(Op::CreateEnterprise, args, result)) return -1;
+    rpc::Reader in(result);
+    return in.i32();
+}
+
+bool RegistryClient::updateEnterprise(const Enterprise& ent) {
+    rpc::Writer args;
+    rpc::write(args, ent);
+    std::string result;
+    return call(Op::UpdateEnterprise, args, result);
+}
+
+bool RegistryClient::deleteEnterprise(int id) {
+    rpc::Writer args;
+    args.i32(id);
+    std::string result;
+    return call(Op::DeleteEnterprise, args, result);
+}
+
+Product RegistryClient::getProductById(int id) {
+    rpc::Writer args;
+    args.i32(id);
+    std::string result;
+    Product p{0, 0, "", 0, 0, Money(), Money(), "", ""};
+    if (!call(Op::GetProduct, args, result)) return p;
+    rpc::Reader in(result);
+    rpc::read(in, p);
+    return p;
+}
+
+std::vector<std::pair<Product, float>> RegistryClient::searchProducts(const std::string& query, size_t limit) {
+    rpc::Writer args;
+    args.str(query);
+    args.u32(static_cast<uint32_t>(limit));
+    std::string result;
+    if (!call(Op::SearchProducts, args, result)) return {};
+    return readHits<Product>(result);
+}
+
+int RegistryClient::createProduct(const Product& prod) {
+    rpc::Writer args;
+    rpc::write(args, prod);
+    std::string result;
+    if (!call(Op::CreateProduct, args, result)) return -1;
+    rpc::Reader in(result);
+    return in.i32();
+}
+
+bool RegistryClient::updateProduct(const Product& prod) {
+    rpc::Writer args;
+    rpc::write(args, prod);
+    std::string result;
+    return call(Op::UpdateProduct, args, result);
+}
+
+bool RegistryClient::deleteProduct(int id) {
+    rpc::Writer args;
+    args.i32(id);
+    std::string result;
+    return call(Op::DeleteProduct, args, result);
+}
+
+// ==========================================
+// Ассортимент
+// ==========================================
+
+std::vector<AssortmentLine> RegistryClient::getAssortmentForEnterprise(int enterpriseId) {
+    rpc::Writer args;
+    args.i32(enterpriseId);
+    std::string result;
+    if (!call(Op::GetAssortment, args, result)) return {};
+    rpc::Reader in(result);
+    uint32_t n = in.u32();
+    std::vector<AssortmentLine> lines;
+    for (uint32_t i = 0; i < n && in.ok(); ++i) {
+        AssortmentLine line;
+        rpc::read(in, line);
+        lines.push_back(std::move(line));
+    }
+    if (!in.done()) return {};
+    return lines;
+}
+
+bool RegistryClient::addProductToAssortment(int enterpriseId, int productId, Money wholesalePrice) {
+    rpc::Writer args;
+    args.i32(enterpriseId);
+    args.i32(productId);
+    args.money(wholesalePrice);
+    std::string result;
+    return call(Op::AddToAssortment, args, result);
+}
+
+bool RegistryClient::updateProductPriceInAssortment(int enterpriseId, int productId, Money newPrice) {
+    rpc::Writer args;
+    args.i32(enterpriseId);
+    args.i32(productId);
+    args.money(newPrice);
+    std::string result;
+    return call(Op::UpdateAssortmentPrice, args, result);
+}
+
+bool RegistryClient::removeProductFromAssortment(int enterpriseId, int productId) {
+    rpc::Writer args;
+    args.i32(enterpriseId);
+    args.i32(productId);
+    std::string result;
+    return call(Op::RemoveFromAssortment, args, result);
+}
+
+long RegistryClient::copyAssortment(int sourceEnterpriseId, const std::vector<int>& targetEnterpriseIds,
+                                    double priceMultiplier, AssortmentConflictPolicy policy) {
+    rpc::Writer args;
+    args.i32(sourceEnterpriseId);
+    args.ids(targetEnterpriseIds);
+    args.f64(priceMultiplier);
+    args.u8(policy == AssortmentConflictPolicy::Overwrite);
+    std::string result;
+    if (!call(Op::CopyAssortment, args, result)) return -1;
+    rpc::Reader in(result);
+    return static_cast<long>(in.i64());
+}
+
+std::vector<ProductOffer> RegistryClient::getBestOffers(const std::vector<int>& productIds, size_t topN) {
+    rpc::Writer args;
+    args.ids(productIds);
+    args.u32(static_cast<uint32_t>(topN));
+    std::string result;
+    if (!call(Op::BestOffers, args, result)) return {};
+    rpc::Reader in(result);
+    uint32_t n = in.u32();
+    std::vector<ProductOffer> offers;
+    for (uint32_t i = 0; i < n && in.ok(); ++i) {
+        ProductOffer o;
+        rpc::read(in, o);
+        offers.push_back(std::move(o));
+    }
+    if (!in.done()) return {};
+    return offers;
+}
+
+// ==========================================
+// Импорт, выгрузка и журнал изменений
+// ==========================================
+
+ImportResult RegistryClient::importFromCsv(ImportEntity entity, const std::string& path,
+                                           const ImportOptions& options) {
+    ImportOptions remote = options;
+    remote.rejectPath = absolutePath(options.rejectPath);
+    rpc::Writer args;
+    args.u8(static_cast<uint8_t>(entity));
+    args.str(absolutePath(path));
+    rpc::write(args, remote);
+
+    ImportResult r;
+    std::string result;
+    if (!call(Op::Import, args, result)) return r;
+    rpc::Reader in(result);
+    rpc::read(in, r);
+    return r;
+}
+
+long long RegistryClient::exportToFile(ExportDataset dataset, const std::string& path,
+                                       const ExportOptions& options) {
+    rpc::Writer args;
+    args.u8(static_cast<uint8_t>(dataset));
+    args.str(absolutePath(path));
+    rpc::write(args, options);
+    std::string result;
+    if (!call(Op::Export, args, result)) return -1;
+    rpc::Reader in(result);
+    return in.i64();
+}
+
+bool RegistryClient::exportToFiles(const std::vector<ExportDataset>& datasets, const std::vector<std::string>& paths,
+                                   const ExportOptions& options, std::vector<long long>& rows) {
+    rows.assign(datasets.size(), -1);
+    if (paths.size() != datasets.size()) return false;
+    for (size_t i = 0; i < datasets.size(); ++i) {
+        rows[i] = exportToFile(datasets[i], paths[i], options);
+        if (rows[i] < 0) return false;
+    }
+    return true;
+}
+
+std::string RegistryClient::getExportWatermark() {
+    std::string result;
+    if (!call(Op::ExportWatermark, rpc::Writer(), result)) return "";
+    rpc::Reader in(result);
+    return in.str();
+}
+
+ChangeCursor RegistryClient::getChangeHead() {
+    ChangeCursor head;
+    std::string result;
+    if (!call(Op::ChangeHead, rpc::Writer(), result)) return head;
+    rpc::Reader in(result);
+    rpc::read(in, head);
+    return head;
+}
+
+long long RegistryClient::exportChanges(const ChangeCursor& since, long long limit, const std::string& path,
+                                        const ExportOptions& options, ChangeCursor* last) {
+    rpc::Writer args;
+    rpc::write(args, since);
+    args.i64(limit);
+    args.str(absolutePath(path));
+    rpc::write(args, options);
+    std::string result;
+    if (!call(Op::ExportChanges, args, result)) return -1;
+    rpc::Reader in(result);
+    long long rows = in.i64();
+    ChangeCursor position;
+    rpc::read(in, position);
+    if (last) *last = position;
+    return rows;
+}
\ No newline at end of file
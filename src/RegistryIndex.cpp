@@ -0,0 +1,286 @@
+#include "RegistryIndex.h"
+
+// ==========================================
+// StringHashIndex
+// ==========================================
+
+uint64_t StringHashIndex::hashOf(const std::string& key) {
+    // FNV-1a, 64 бита
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+size_t StringHashIndex::probe(const std::string& key, uint64_t hash) const {
+    if (slots.empty()) return std::string::npos;
+    size_t mask = slots.size() - 1;
+    for (size_t i = hash & mask, n = 0; n < slots.size(); i = (i + 1) & mask, ++n) {
+        const Slot& s = slots[i];
+        if (s.state == Empty) return std::string::npos;
+        if (s.state == Full && s.hash == hash && s.key == key) return i;
+    }
+    return std::string::npos;
+}
+
+void StringHashIndex::rehash(size_t capacity) {
+    size_t size = 16;
+    while (size < capacity) size <<= 1;
+
+    std::vector<Slot> old;
+    old.swap(slots);
+    slots.resize(size);
+    deleted = 0;
+
+    size_t mask = size - 1;
+    for (Slot& s : old) {
+        if (s.state != Full) continue;
+        size_t i = s.hash & mask;
+        while (slots[i].state == Full) i = (i + 1) & mask;
+        slots[i] = std::move(s);
+    }
+}
+
+void StringHashIndex::reserve(size_t count) {
+    // Заполнение не выше 70%
+    size_t needed = count + count / 2 + 1;
+    if (needed > slots.size()) rehash(needed);
+}
+
+void StringHashIndex::clear() {
+    slots.clear();
+    used = 0;
+    deleted = 0;
+}
+
+bool StringHashIndex::insert(const std::string& key, int id) {
+    if ((used + deleted + 1) * 10 > slots.size() * 7) rehash(used * 2 + 16);
+
+    uint64_t hash = hashOf(key);
+    size_t mask = slots.size() - 1;
+    size_t target = std::string::npos;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        Slot& s = slots[i];
+        if (s.state == Full) {
+            if (s.hash == hash && s.key == key) return false;
+        } else {
+            // Первая удалённая ячейка подходит для вставки, но ключ может быть дальше
+            if (target == std::string::npos) target = i;
+            if (s.state == Empty) break;
+        }
+    }
+
+    Slot& s = slots[target];
+    if (s.state == Deleted) --deleted;
+    s.key = key;
+    s.id = id;
+    s.hash = hash;
+    s.state = Full;
+    ++used;
+    return true;
+}
+
+bool StringHashIndex::erase(const std::string& key) {
+    size_t i = probe(key, hashOf(key));
+    if (i == std::string::npos) return false;
+    slots[i].state = Deleted;
+    slots[i].key.clear();
+    --used;
+    ++deleted;
+    return true;
+}
+
+int StringHashIndex::find(const std::string& key) const {
+    size_t i = probe(key, hashOf(key));
+    return i == std::string::npos ? 0 : slots[i].id;
+}
+
+// ==========================================
+// RegistryCache
+// ==========================================
+
+void RegistryCache::invalidate() {
+    enterprisesLoaded = false;
+    productsLoaded = false;
+    enterprises.clear();
+    enterpriseByInn.clear();
+    enterpriseIds.clear();
+    enterpriseNames.clear();
+    products.clear();
+    productByName.clear();
+    productIds.clear();
+    productNames.clear();
+    enterpriseSearch.clear();
+    productSearch.clear();
+    enterpriseSearchBuilt = false;
+    productSearchBuilt = false;
+}
+
+void RegistryCache::loadEnterprises(std::vector<Enterprise> list) {
+    enterprises.clear();
+    enterpriseByInn.clear();
+    enterprises.reserve(list.size());
+    enterpriseByInn.reserve(list.size());
+
+    std::vector<std::pair<int, int>> ids;
+    std::vector<std::pair<std::string, int>> names;
+    ids.reserve(list.size());
+    names.reserve(list.size());
+    for (auto& e : list) {
+        ids.emplace_back(e.id, e.id);
+        names.emplace_back(e.name, e.id);
+        enterpriseByInn.insert(e.inn, e.id);
+        enterprises.emplace(e.id, std::move(e));
+    }
+    enterpriseIds.bulkLoad(std::move(ids));
+    enterpriseNames.bulkLoad(std::move(names));
+    enterprisesLoaded = true;
+    enterpriseSearch.clear();
+    enterpriseSearchBuilt = false;
+}
+
+void RegistryCache::loadProducts(std::vector<Product> list) {
+    products.clear();
+    productByName.clear();
+    products.reserve(list.size());
+    productByName.reserve(list.size());
+
+    std::vector<std::pair<int, int>> ids;
+    std::vector<std::pair<std::string, int>> names;
+    ids.reserve(list.size());
+    names.reserve(list.size());
+    for (auto& p : list) {
+        ids.emplace_back(p.id, p.id);
+        names.emplace_back(p.name, p.id);
+        // Уникальности названий в схеме нет: при старых дубликатах индекс хранит первый ID
+        productByName.insert(p.name, p.id);
+        products.emplace(p.id, std::move(p));
+    }
+    productIds.bulkLoad(std::move(ids));
+    productNames.bulkLoad(std::move(names));
+    productsLoaded = true;
+    productSearch.clear();
+    productSearchBuilt = false;
+}
+
+void RegistryCache::putEnterprise(const Enterprise& e) {
+    if (!enterprisesLoaded) return;
+    auto it = enterprises.find(e.id);
+    if (it != enterprises.end()) {
+        const Enterprise& old = it->second;
+        if (enterpriseByInn.find(old.inn) == old.id) enterpriseByInn.erase(old.inn);
+        enterpriseNames.erase(old.name, old.id);
+        it->second = e;
+    } else {
+        enterprises.emplace(e.id, e);
+        enterpriseIds.insert(e.id, e.id);
+    }
+    enterpriseByInn.insert(e.inn, e.id);
+    enterpriseNames.insert(e.name, e.id);
+    if (enterpriseSearchBuilt) enterpriseSearch.add(e.id, searchText(e));
+}
+
+void RegistryCache::removeEnterprise(int id) {
+    auto it = enterprises.find(id);
+    if (it == enterprises.end()) return;
+    const Enterprise& old = it->second;
+    if (enterpriseByInn.find(old.inn) == id) enterpriseByInn.erase(old.inn);
+    enterpriseNames.erase(old.name, id);
+    enterpriseIds.erase(id, id);
+    enterprises.erase(it);
+    if (enterpriseSearchBuilt) enterpriseSearch.remove(id);
+}
+
+void RegistryCache::putProduct(const Product& p) {
+    if (!productsLoaded) return;
+    auto it = products.find(p.id);
+    if (it != products.end()) {
+        const Product& old = it->second;
+        if (productByName.find(old.name) == old.id) productByName.erase(old.name);
+        productNames.erase(old.name, old.id);
+        it->second = p;
+    } else {
+        products.emplace(p.id, p);
+        productIds.insert(p.id, p.id);
+    }
+    productByName.insert(p.name, p.id);
+    productNames.insert(p.name, p.id);
+    if (productSearchBuilt) productSearch.add(p.id, p.name);
+}
+
+void RegistryCache::removeProduct(int id) {
+    auto it = products.find(id);
+    if (it == products.end()) return;
+    const Product& old = it->second;
+    if (productByName.find(old.name) == id) productByName.erase(old.name);
+    productNames.erase(old.name, id);
+    productIds.erase(id, id);
+    products.erase(it);
+    if (productSearchBuilt) productSearch.remove(id);
+}
+
+const Enterprise* RegistryCache::enterprise(int id) const {
+    auto it = enterprises.find(id);
+    return it == enterprises.end() ? nullptr : &it->second;
+}
+
+const Product* RegistryCache::product(int id) const {
+    auto it = products.find(id);
+    return it == products.end() ? nullptr : &it->second;
+}
+
+std::vector<Enterprise> RegistryCache::allEnterprises() const {
+    std::vector<Enterprise> list;
+    list.reserve(enterprises.size());
+    for (size_t i = 0; i < enterpriseIds.size(); ++i) list.push_back(*enterprise(enterpriseIds.at(i)));
+    return list;
+}
+
+std::vector<Product> RegistryCache::allProducts() const {
+    std::vector<Product> list;
+    list.reserve(products.size());
+    for (size_t i = 0; i < productIds.size(); ++i) list.push_back(*product(productIds.at(i)));
+    return list;
+}
+
+std::vector<Enterprise> RegistryCache::enterprisesByNamePrefix(const std::string& prefix, size_t limit) const {
+    std::vector<Enterprise> list;
+    for (int id : enterpriseNames.prefix(prefix, limit)) list.push_back(*enterprise(id));
+    return list;
+}
+
+std::vector<Product> RegistryCache::productsByNamePrefix(const std::string& prefix, size_t limit) const {
+    std::vector<Product> list;
+    for (int id : productNames.prefix(prefix, limit)) list.push_back(*product(id));
+    return list;
+}
+
+std::string RegistryCache::searchText(const Enterprise& e) {
+    return e.name + " " + e.postal_address + " " + e.inn;
+}
+
+void RegistryCache::buildEnterpriseSearch() {
+    if (enterpriseSearchBuilt || !enterprisesLoaded) return;
+    enterpriseSearch.clear();
+    enterpriseSearch.reserve(enterprises.size());
+    for (const auto& [id, e] : enterprises) enterpriseSearch.add(id, searchText(e));
+    enterpriseSearchBuilt = true;
+}
+
+void RegistryCache::buildProductSearch() {
+    if (productSearchBuilt || !productsLoaded) return;
+    productSearch.clear();
+    productSearch.reserve(products.size());
+    for (const auto& [id, p] : products) productSearch.add(id, p.name);
+    productSearchBuilt = true;
+}
+
+std::vector<SearchHit> RegistryCache::searchEnterprises(const std::string& query, size_t limit) const {
+    return enterpriseSearch.search(query, limit);
+}
+
+std::vector<SearchHit> RegistryCache::searchProducts(const std::string& query, size_t limit) const {
+    return productSearch.search(query, limit);
+}
\ No newline at end of file
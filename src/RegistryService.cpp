@@ -1,121 +1,489 @@
 #include "RegistryService.h"
+#include "SchemaMigrations.h"
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <unordered_set>
+
+namespace {
+    // Параметры подключения по умолчанию
+    const char* DEFAULT_DSN = "rab_dsn";
+    const char* DEFAULT_USER = "rab";
+    const char* DEFAULT_PASSWORD = "1111";
+
+    // Выборка курсором порциями по 10 тыс. строк: драйвер PostgreSQL не держит
+    // в памяти весь результат запроса (нужно для выгрузок больших таблиц)
+    const char* STREAMING_OPTIONS = "UseDeclareFetch=1;Fetch=10000";
+
+    // Ограничение на число строк, порождаемых одним INSERT ... SELECT при копировании
+    // ассортимента: при 100 тыс. позиций это 5 целевых предприятий за оператор.
+    const long COPY_ROWS_PER_BATCH = 500000;
+}
 
 // ==========================================
 // Конструктор и Деструктор
 // ==========================================
 
-RegistryService::RegistryService() {
-    // Инициализируем шлюзы, передавая им указатель на (пока еще закрытое) соединение.
-    // std::make_unique создает экземпляры классов и управляет памятью.
-    enterpriseGateway = std::make_unique<EnterpriseGateway>(&db);
-    productGateway = std::make_unique<ProductGateway>(&db);
-    enterpriseProductGateway = std::make_unique<EnterpriseProductGateway>(&db);
-    salesDepartmentGateway = std::make_unique<SalesDepartmentGateway>(&db);
-    bankDetailsGateway = std::make_unique<BankDetailsGateway>(&db);
-}
+// Шлюзы не хранят состояния, кроме соединения, поэтому создаются в каждой
+// операции на полученном ею соединении
+RegistryService::RegistryService() {}
 
 RegistryService::~RegistryService() {}
 
+ConnectionPool::Lease RegistryService::connection() {
+    ConnectionPool::Lease conn;
+    if (pool) conn = pool->acquire();
+    if (!conn) std::cerr << "Ошибка: Нет соединения с БД." << std::endl;
+    return conn;
+}
+
 // ==========================================
 // Инициализация
 // ==========================================
 
-bool RegistryService::initialize() {
+bool RegistryService::initialize(size_t connections) {
     // 1. Подключение к БД
     // Используем параметры по умолчанию из вашего старого кода
-    if (!db.connect("rab_dsn", "rab", "1111")) {
+    if (!db.connect(DEFAULT_DSN, DEFAULT_USER, DEFAULT_PASSWORD)) {
         std::cerr << "Критическая ошибка: Не удалось подключиться к БД." << std::endl;
         return false;
     }
 
+    // Пул для операций сервиса; соединения в нём открываются только при первом запросе
+    if (connections == 0) connections = std::max(2u, std::thread::hardware_concurrency());
+    pool = std::make_unique<ConnectionPool>(DEFAULT_DSN, DEFAULT_USER, DEFAULT_PASSWORD, connections);
+    tasks = std::make_unique<TaskExecutor>(std::max<size_t>(1, connections - 1), pool.get());
+
     // 2. Создание справочников (Словари)
-    // Эти таблицы не имеют собственных шлюзов, так как они статичны, 
-    // но они нужны для Foreign Keys основных таблиц.
-    
-    // Справочник организационно-правовых форм
-    db.executeQuery(R"(
-        CREATE TABLE IF NOT EXISTS legal_form (
-            legal_form_id SERIAL PRIMARY KEY,
-            name TEXT NOT NULL UNIQUE
-        );
-    )");
-
-    // Справочник форм собственности
-    db.executeQuery(R"(
-        CREATE TABLE IF NOT EXISTS ownership_form (
-            ownership_form_id SERIAL PRIMARY KEY,
-            name TEXT NOT NULL UNIQUE
-        );
-    )");
-
-    // Справочник категорий товаров
-    db.executeQuery(R"(
-        CREATE TABLE IF NOT EXISTS product_category (
-            category_id SERIAL PRIMARY KEY,
-            name TEXT NOT NULL UNIQUE
-        );
-    )");
-
-    // Справочник условий поставки
-    db.executeQuery(R"(
-        CREATE TABLE IF NOT EXISTS delivery_terms (
-            delivery_terms_id SERIAL PRIMARY KEY,
-            description TEXT NOT NULL UNIQUE
-        );
-    )");
+    // Эти таблицы статичны и не имеют своих DTO, но они нужны
+    // для Foreign Keys основных таблиц.
+    DictionaryGateway(&db).createTableIfNotExists();
 
     // 3. Создание основных таблиц через шлюзы
     // Порядок важен из-за внешних ключей (Foreign Keys)
     
-    enterpriseGateway->createTableIfNotExists();         // Зависит от legal_form, ownership_form
-    productGateway->createTableIfNotExists();            // Зависит от product_category, delivery_terms
-    enterpriseProductGateway->createTableIfNotExists();  // Зависит от enterprise, product
-    salesDepartmentGateway->createTableIfNotExists();    // Зависит от enterprise
-    bankDetailsGateway->createTableIfNotExists();        // Зависит от enterprise
+    EnterpriseGateway(&db).createTableIfNotExists();         // Зависит от legal_form, ownership_form
+    ProductGateway(&db).createTableIfNotExists();            // Зависит от product_category, delivery_terms
+    EnterpriseProductGateway(&db).createTableIfNotExists();  // Зависит от enterprise, product
+    AssortmentSummaryGateway(&db).createTableIfNotExists();  // Триггеры на enterprise_product и product
+    SalesDepartmentGateway(&db).createTableIfNotExists();    // Зависит от enterprise
+    BankDetailsGateway(&db).createTableIfNotExists();        // Зависит от enterprise
+    ChangeLogGateway(&db).createTableIfNotExists();          // Триггеры на всех таблицах реестра
+    TombstoneGateway(&db).createTableIfNotExists();          // Использует change_log_key
+
+    // 4. Изменения уже существующих таблиц
+    if (!SchemaMigrations(&db).apply()) {
+        std::cerr << "Критическая ошибка: Схема БД не обновлена." << std::endl;
+        return false;
+    }
 
     std::cout << "Сервис данных инициализирован успешно." << std::endl;
     return true;
 }
 
+std::vector<DictionaryEntry> RegistryService::getDictionary(Dictionary dict) {
+    if (snapshot) {
+        std::vector<DictionaryEntry> list;
+        for (const auto& r : snapshot->dictionary(dict)) list.push_back({r.id, std::string(snapshot->str(r.name))});
+        return list;
+    }
+    auto conn = connection();
+    if (!conn) return {};
+    return DictionaryGateway(conn.get()).findAll(dict);
+}
+
+// ==========================================
+// Снимок и режим только для чтения
+// ==========================================
+
+bool RegistryService::initializeFromSnapshot(const std::string& path) {
+    auto opened = std::make_unique<Snapshot>();
+    if (!opened->open(path)) return false;
+    snapshot = std::move(opened);
+    tasks = std::make_unique<TaskExecutor>(0, nullptr);
+    return true;
+}
+
+bool RegistryService::saveSnapshot(const std::string& path, SnapshotStats* stats) {
+    if (snapshot) {
+        std::cerr << "Ошибка: Снимок создаётся только из базы данных." << std::endl;
+        return false;
+    }
+    auto conn = connection();
+    if (!conn) return false;
+    return Snapshot::write(conn.get(), path, stats);
+}
+
+bool RegistryService::rejectWriteInReadOnly() const {
+    if (!snapshot) return false;
+    std::cerr << "Ошибка: Открыт снимок реестра — изменения недоступны." << std::endl;
+    return true;
+}
+
+bool RegistryService::rejectCriteriaInSnapshot() const {
+    if (!snapshot) return false;
+    std::cerr << "Ошибка: Запрос выполняется сервером БД и недоступен для снимка." << std::endl;
+    return true;
+}
+
+// ==========================================
+// Кэш с индексами
+// ==========================================
+
+void RegistryService::loadCachedEnterprises() {
+    // В режиме снимка кэш (и поиск по нему) заполняется из снимка
+    if (snapshot) {
+        std::vector<Enterprise> list = getAllEnterprises();
+        WriteLock lock(cacheMutex);
+        if (!cache.hasEnterprises()) cache.loadEnterprises(std::move(list));
+        return;
+    }
+    auto conn = connection();
+    if (!conn) return;
+    // Чтение идёт под блокировкой: запись, зафиксированная во время загрузки,
+    // обновит кэш уже после неё и не будет затёрта устаревшим списком
+    WriteLock lock(cacheMutex);
+    if (!cache.hasEnterprises()) cache.loadEnterprises(EnterpriseGateway(conn.get()).findAll());
+}
+
+void RegistryService::loadCachedProducts() {
+    if (snapshot) {
+        std::vector<Product> list = getAllProducts();
+        WriteLock lock(cacheMutex);
+        if (!cache.hasProducts()) cache.loadProducts(std::move(list));
+        return;
+    }
+    auto conn = connection();
+    if (!conn) return;
+    WriteLock lock(cacheMutex);
+    if (!cache.hasProducts()) cache.loadProducts(ProductGateway(conn.get()).findAll());
+}
+
+RegistryService::ReadLock RegistryService::readEnterprises() {
+    // Вторая попытка — на случай, если кэш сбросили сразу после загрузки
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        ReadLock lock(cacheMutex);
+        if (cache.hasEnterprises()) return lock;
+        lock.unlock();
+        loadCachedEnterprises();
+    }
+    return ReadLock(cacheMutex);
+}
+
+RegistryService::ReadLock RegistryService::readProducts() {
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        ReadLock lock(cacheMutex);
+        if (cache.hasProducts()) return lock;
+        lock.unlock();
+        loadCachedProducts();
+    }
+    return ReadLock(cacheMutex);
+}
+
+void RegistryService::refreshCachedEnterprise(DatabaseConnection* conn, int id) {
+    {
+        WriteLock lock(cacheMutex);
+        // Перечитываем запись: названия ОПФ и формы собственности приходят из JOIN.
+        // Под блокировкой — из двух одновременных изменений в кэше останется последнее.
+        if (cache.hasEnterprises()) {
+            Enterprise e = EnterpriseGateway(conn).findById(id);
+            if (e.id != 0) cache.putEnterprise(e);
+            else cache.removeEnterprise(id);
+        }
+    }
+    dropCatalog();
+}
+
+void RegistryService::refreshCachedProduct(DatabaseConnection* conn, int id) {
+    {
+        WriteLock lock(cacheMutex);
+        if (cache.hasProducts()) {
+            Product p = ProductGateway(conn).findById(id);
+            if (p.id != 0) cache.putProduct(p);
+            else cache.removeProduct(id);
+        }
+    }
+    dropCatalog();
+}
+
+void RegistryService::refreshCache() {
+    {
+        WriteLock lock(cacheMutex);
+        cache.invalidate();
+    }
+    dropCatalog();
+}
+
+// ==========================================
+// Колоночный каталог
+// ==========================================
+
+void RegistryService::dropCatalog() {
+    // Каталог снимка не устаревает — снимок не меняется
+    if (snapshot) return;
+    WriteLock lock(catalogMutex);
+    catalog.clear();
+    ++catalogGeneration;
+}
+
+RegistryService::ReadLock RegistryService::readCatalog() {
+    ReadLock lock(catalogMutex);
+    if (!catalog.isLoaded() && snapshot) {
+        lock.unlock();
+        {
+            WriteLock load(catalogMutex);
+            if (!catalog.isLoaded()) catalog.load(*snapshot);
+        }
+        lock.lock();
+    }
+    if (!catalog.isLoaded()) lock.unlock();
+    return lock;
+}
+
+bool RegistryService::isCatalogLoaded() {
+    ReadLock lock(catalogMutex);
+    return catalog.isLoaded();
+}
+
+bool RegistryService::loadCatalog(CatalogStats* stats) {
+    if (snapshot) {
+        ReadLock lock = readCatalog();
+        if (!lock) return false;
+        if (stats) *stats = catalog.stats();
+        return true;
+    }
+
+    uint64_t generation;
+    {
+        ReadLock lock(catalogMutex);
+        generation = catalogGeneration;
+    }
+
+    // Ассортимент читается курсором на отдельном соединении: десятки миллионов
+    // строк не должны целиком оседать в буфере драйвера. Каталог собирается
+    // без блокировки — отчёты тем временем обслуживаются прежним или БД.
+    DatabaseConnection streamConn;
+    streamConn.setVerbose(false);
+    if (!streamConn.connect(DEFAULT_DSN, DEFAULT_USER, DEFAULT_PASSWORD, STREAMING_OPTIONS)) {
+        std::cerr << "Ошибка: Не удалось открыть соединение для загрузки каталога." << std::endl;
+        return false;
+    }
+    EnterpriseGateway enterprises(&streamConn);
+    ProductGateway products(&streamConn);
+    EnterpriseProductGateway assortment(&streamConn);
+    ColumnarCatalog loaded;
+    if (!loaded.load(enterprises, products, assortment)) return false;
+
+    WriteLock lock(catalogMutex);
+    if (catalogGeneration != generation) {
+        std::cerr << "Ошибка: Данные изменились во время загрузки каталога, повторите загрузку." << std::endl;
+        return false;
+    }
+    catalog = std::move(loaded);
+    if (stats) *stats = catalog.stats();
+    return true;
+}
+
 // ==========================================
 // Предприятия (Enterprise)
 // ==========================================
 
 std::vector<Enterprise> RegistryService::getAllEnterprises() {
-    return enterpriseGateway->findAll();
+    if (snapshot) {
+        std::vector<Enterprise> list;
+        list.reserve(snapshot->enterprises().size());
+        for (const auto& r : snapshot->enterprises()) list.push_back(snapshot->toEnterprise(r));
+        return list;
+    }
+    ReadLock lock = readEnterprises();
+    return cache.allEnterprises();
 }
 
 Enterprise RegistryService::getEnterpriseById(int id) {
-    return enterpriseGateway->findById(id);
+    if (snapshot) {
+        const auto* r = snapshot->findEnterprise(id);
+        if (r) return snapshot->toEnterprise(*r);
+        Enterprise e;
+        e.id = 0;
+        return e;
+    }
+    {
+        ReadLock lock = readEnterprises();
+        const Enterprise* cached = cache.enterprise(id);
+        if (cached) return *cached;
+    }
+    Enterprise e;
+    e.id = 0;
+    auto conn = connection();
+    if (!conn) return e;
+    return EnterpriseGateway(conn.get()).findById(id);
+}
+
+Enterprise RegistryService::getEnterpriseAt(size_t position) {
+    if (snapshot) {
+        auto records = snapshot->enterprises();
+        if (position < records.size()) return snapshot->toEnterprise(records[position]);
+        Enterprise e;
+        e.id = 0;
+        return e;
+    }
+    ReadLock lock = readEnterprises();
+    const Enterprise* cached = cache.enterpriseAt(position);
+    if (cached) return *cached;
+    Enterprise e;
+    e.id = 0;
+    return e;
+}
+
+size_t RegistryService::getEnterpriseCount() {
+    if (snapshot) return snapshot->enterprises().size();
+    ReadLock lock = readEnterprises();
+    return cache.enterpriseCount();
+}
+
+Enterprise RegistryService::findEnterpriseByInn(const std::string& inn) {
+    if (snapshot) {
+        for (const auto& r : snapshot->enterprises()) {
+            if (snapshot->str(r.inn) == inn) return snapshot->toEnterprise(r);
+        }
+        Enterprise e;
+        e.id = 0;
+        return e;
+    }
+    ReadLock lock = readEnterprises();
+    const Enterprise* cached = cache.enterprise(cache.enterpriseIdByInn(inn));
+    if (cached) return *cached;
+    Enterprise e;
+    e.id = 0;
+    return e;
+}
+
+std::vector<Enterprise> RegistryService::findEnterprisesByNamePrefix(const std::string& prefix, size_t limit) {
+    if (snapshot) {
+        std::vector<Enterprise> list;
+        for (const auto& r : snapshot->enterprises()) {
+            if (list.size() >= limit) break;
+            if (snapshot->str(r.name).substr(0, prefix.size()) == prefix) list.push_back(snapshot->toEnterprise(r));
+        }
+        return list;
+    }
+    ReadLock lock = readEnterprises();
+    return cache.enterprisesByNamePrefix(prefix, limit);
 }
 
 int RegistryService::createEnterprise(const Enterprise& ent) {
+    if (rejectWriteInReadOnly()) return -1;
     // Бизнес-валидация
     if (ent.name.empty() || ent.inn.empty()) {
         std::cerr << "Ошибка: Название предприятия и ИНН обязательны." << std::endl;
         return -1;
     }
-    // Можно добавить проверку на уникальность ИНН
-    Enterprise existing = enterpriseGateway->findByInn(ent.inn);
-    if (existing.id != 0) {
-        std::cerr << "Ошибка: Предприятие с таким ИНН уже существует." << std::endl;
-        return -1;
+    // Уникальность ИНН проверяется по индексу кэша, без запроса к серверу.
+    // Одновременную вставку того же ИНН из другого потока отклонит уже БД.
+    {
+        ReadLock lock = readEnterprises();
+        if (cache.enterpriseIdByInn(ent.inn) != 0) {
+            std::cerr << "Ошибка: Предприятие с таким ИНН уже существует." << std::endl;
+            return -1;
+        }
     }
 
-    return enterpriseGateway->insert(ent);
+    auto conn = connection();
+    if (!conn) return -1;
+    int id = EnterpriseGateway(conn.get()).insert(ent);
+    if (id > 0) refreshCachedEnterprise(conn.get(), id);
+    return id;
 }
 
 bool RegistryService::updateEnterprise(const Enterprise& ent) {
+    if (rejectWriteInReadOnly()) return false;
     if (ent.id <= 0) return false;
     if (ent.name.empty() || ent.inn.empty()) return false;
-    return enterpriseGateway->update(ent);
+
+    {
+        ReadLock lock = readEnterprises();
+        int owner = cache.enterpriseIdByInn(ent.inn);
+        if (owner != 0 && owner != ent.id) {
+            std::cerr << "Ошибка: Предприятие с таким ИНН уже существует." << std::endl;
+            return false;
+        }
+    }
+
+    auto conn = connection();
+    if (!conn) return false;
+    if (!EnterpriseGateway(conn.get()).update(ent)) return false;
+    refreshCachedEnterprise(conn.get(), ent.id);
+    return true;
 }
 
 bool RegistryService::deleteEnterprise(int id) {
+    if (rejectWriteInReadOnly()) return false;
+    auto conn = connection();
+    if (!conn) return false;
     // В базе настроен ON DELETE CASCADE, поэтому удаление предприятия
     // автоматически удалит отделы сбыта, банковские реквизиты и связи ассортимента.
-    return enterpriseGateway->remove(id);
+    if (!EnterpriseGateway(conn.get()).remove(id)) return false;
+    {
+        WriteLock lock(cacheMutex);
+        cache.removeEnterprise(id);
+    }
+    dropCatalog();
+    return true;
+}
+
+std::vector<std::pair<Enterprise, float>> RegistryService::searchEnterprises(const std::string& query, size_t limit) {
+    std::vector<std::pair<Enterprise, float>> result;
+    ReadLock lock = readEnterprises();
+    if (!cache.hasEnterpriseSearch()) {
+        // Триграммный индекс строится один раз, под исключительной блокировкой
+        lock.unlock();
+        {
+            WriteLock build(cacheMutex);
+            cache.buildEnterpriseSearch();
+        }
+        lock = readEnterprises();
+    }
+    for (const SearchHit& hit : cache.searchEnterprises(query, limit)) {
+        const Enterprise* e = cache.enterprise(hit.id);
+        if (e) result.push_back({*e, hit.score});
+    }
+    return result;
+}
+
+std::vector<Enterprise> RegistryService::queryEnterprises(const Criteria& criteria) {
+    if (rejectCriteriaInSnapshot()) return {};
+    auto conn = connection();
+    if (!conn) return {};
+    return EnterpriseGateway(conn.get()).findWhere(criteria);
+}
+
+long long RegistryService::countEnterprises(const Criteria& criteria) {
+    if (rejectCriteriaInSnapshot()) return -1;
+    auto conn = connection();
+    if (!conn) return -1;
+    return EnterpriseGateway(conn.get()).countWhere(criteria);
+}
+
+long long RegistryService::streamEnterprises(const Criteria& criteria, const RowCallback<Enterprise>& callback) {
+    if (snapshot && criteria.isDefault()) {
+        long long count = 0;
+        for (const auto& r : snapshot->enterprises()) {
+            ++count;
+            if (!callback(snapshot->toEnterprise(r))) break;
+        }
+        return count;
+    }
+    if (rejectCriteriaInSnapshot()) return -1;
+
+    // Соединение пула не занимаем: читатель может листать результат сколько угодно
+    DatabaseConnection streamConn;
+    streamConn.setVerbose(false);
+    if (!streamConn.connect(DEFAULT_DSN, DEFAULT_USER, DEFAULT_PASSWORD, STREAMING_OPTIONS)) {
+        std::cerr << "Ошибка: Не удалось открыть соединение для чтения выборки." << std::endl;
+        return -1;
+    }
+    return EnterpriseGateway(&streamConn).streamWhere(criteria, callback);
 }
 
 // ==========================================
@@ -123,64 +491,229 @@ bool RegistryService::deleteEnterprise(int id) {
 // ==========================================
 
 std::vector<Product> RegistryService::getAllProducts() {
-    return productGateway->findAll();
+    if (snapshot) {
+        std::vector<Product> list;
+        list.reserve(snapshot->products().size());
+        for (const auto& r : snapshot->products()) list.push_back(snapshot->toProduct(r));
+        return list;
+    }
+    ReadLock lock = readProducts();
+    return cache.allProducts();
 }
 
 Product RegistryService::getProductById(int id) {
-    return productGateway->findById(id);
+    if (snapshot) {
+        const auto* r = snapshot->findProduct(id);
+        if (r) return snapshot->toProduct(*r);
+        Product p;
+        p.id = 0;
+        return p;
+    }
+    {
+        ReadLock lock = readProducts();
+        const Product* cached = cache.product(id);
+        if (cached) return *cached;
+    }
+    Product p;
+    p.id = 0;
+    auto conn = connection();
+    if (!conn) return p;
+    return ProductGateway(conn.get()).findById(id);
+}
+
+Product RegistryService::getProductAt(size_t position) {
+    if (snapshot) {
+        auto records = snapshot->products();
+        if (position < records.size()) return snapshot->toProduct(records[position]);
+        Product p;
+        p.id = 0;
+        return p;
+    }
+    ReadLock lock = readProducts();
+    const Product* cached = cache.productAt(position);
+    if (cached) return *cached;
+    Product p;
+    p.id = 0;
+    return p;
+}
+
+size_t RegistryService::getProductCount() {
+    if (snapshot) return snapshot->products().size();
+    ReadLock lock = readProducts();
+    return cache.productCount();
+}
+
+std::vector<Product> RegistryService::findProductsByNamePrefix(const std::string& prefix, size_t limit) {
+    if (snapshot) {
+        std::vector<Product> list;
+        for (const auto& r : snapshot->products()) {
+            if (list.size() >= limit) break;
+            if (snapshot->str(r.name).substr(0, prefix.size()) == prefix) list.push_back(snapshot->toProduct(r));
+        }
+        return list;
+    }
+    ReadLock lock = readProducts();
+    return cache.productsByNamePrefix(prefix, limit);
 }
 
 int RegistryService::createProduct(const Product& prod) {
+    if (rejectWriteInReadOnly()) return -1;
     if (prod.name.empty()) {
         std::cerr << "Ошибка: У товара должно быть название." << std::endl;
         return -1;
     }
-    if (prod.retail_price < 0 || prod.purchase_price < 0) {
+    if (prod.retail_price.isNegative() || prod.purchase_price.isNegative()) {
         std::cerr << "Ошибка: Цена не может быть отрицательной." << std::endl;
         return -1;
     }
     
-    // Проверка на дубликат имени (бизнес-логика)
-    Product existing = productGateway->findByName(prod.name);
-    if (existing.id != 0) {
-        std::cerr << "Ошибка: Товар с таким названием уже существует." << std::endl;
-        return -1;
+    // Проверка на дубликат имени (бизнес-логика) — по индексу кэша
+    {
+        ReadLock lock = readProducts();
+        if (cache.productIdByName(prod.name) != 0) {
+            std::cerr << "Ошибка: Товар с таким названием уже существует." << std::endl;
+            return -1;
+        }
     }
 
-    return productGateway->insert(prod);
+    auto conn = connection();
+    if (!conn) return -1;
+    int id = ProductGateway(conn.get()).insert(prod);
+    if (id > 0) refreshCachedProduct(conn.get(), id);
+    return id;
 }
 
 bool RegistryService::updateProduct(const Product& prod) {
+    if (rejectWriteInReadOnly()) return false;
     if (prod.id <= 0) return false;
-    return productGateway->update(prod);
+    auto conn = connection();
+    if (!conn) return false;
+    if (!ProductGateway(conn.get()).update(prod)) return false;
+    refreshCachedProduct(conn.get(), prod.id);
+    return true;
 }
 
 bool RegistryService::deleteProduct(int id) {
-    return productGateway->remove(id);
+    if (rejectWriteInReadOnly()) return false;
+    auto conn = connection();
+    if (!conn) return false;
+    if (!ProductGateway(conn.get()).remove(id)) return false;
+    {
+        WriteLock lock(cacheMutex);
+        cache.removeProduct(id);
+    }
+    dropCatalog();
+    return true;
+}
+
+std::vector<std::pair<Product, float>> RegistryService::searchProducts(const std::string& query, size_t limit) {
+    std::vector<std::pair<Product, float>> result;
+    ReadLock lock = readProducts();
+    if (!cache.hasProductSearch()) {
+        lock.unlock();
+        {
+            WriteLock build(cacheMutex);
+            cache.buildProductSearch();
+        }
+        lock = readProducts();
+    }
+    for (const SearchHit& hit : cache.searchProducts(query, limit)) {
+        const Product* p = cache.product(hit.id);
+        if (p) result.push_back({*p, hit.score});
+    }
+    return result;
+}
+
+std::vector<Product> RegistryService::queryProducts(const Criteria& criteria) {
+    if (ReadLock lock = readCatalog()) {
+        std::vector<uint32_t> rows;
+        std::vector<Product> list;
+        if (!catalog.selectProducts(criteria, rows, nullptr)) return list;
+        list.reserve(rows.size());
+        for (uint32_t row : rows) list.push_back(catalog.productAt(row));
+        return list;
+    }
+    auto conn = connection();
+    if (!conn) return {};
+    return ProductGateway(conn.get()).findWhere(criteria);
+}
+
+long long RegistryService::countProducts(const Criteria& criteria) {
+    if (ReadLock lock = readCatalog()) {
+        // Нужен только total: без сортировки и с пустой страницей
+        Criteria filter = criteria;
+        filter.clearOrder();
+        std::vector<uint32_t> rows;
+        long long total = 0;
+        return catalog.selectProducts(filter.limit(0), rows, &total) ? total : -1;
+    }
+    auto conn = connection();
+    if (!conn) return -1;
+    return ProductGateway(conn.get()).countWhere(criteria);
+}
+
+long long RegistryService::streamProducts(const Criteria& criteria, const RowCallback<Product>& callback) {
+    if (snapshot) {
+        // Снимок не меняется, поэтому каталог можно держать, пока читатель листает
+        ReadLock lock = readCatalog();
+        std::vector<uint32_t> rows;
+        if (!lock || !catalog.selectProducts(criteria, rows, nullptr)) return -1;
+        long long count = 0;
+        for (uint32_t row : rows) {
+            ++count;
+            if (!callback(catalog.productAt(row))) break;
+        }
+        return count;
+    }
+
+    DatabaseConnection streamConn;
+    streamConn.setVerbose(false);
+    if (!streamConn.connect(DEFAULT_DSN, DEFAULT_USER, DEFAULT_PASSWORD, STREAMING_OPTIONS)) {
+        std::cerr << "Ошибка: Не удалось открыть соединение для чтения выборки." << std::endl;
+        return -1;
+    }
+    return ProductGateway(&streamConn).streamWhere(criteria, callback);
 }
 
 // ==========================================
 // Ассортимент (Assortment)
 // ==========================================
 
-std::vector<std::pair<Product, double>> RegistryService::getAssortmentForEnterprise(int enterpriseId) {
-    std::vector<std::pair<Product, double>> result;
+std::vector<AssortmentLine> RegistryService::getAssortmentForEnterprise(int enterpriseId) {
+    std::vector<AssortmentLine> result;
+
+    if (snapshot) {
+        for (const auto& link : snapshot->assortmentOf(enterpriseId)) {
+            const auto* r = snapshot->findProduct(link.productId);
+            if (!r) continue;
+            bool priced = link.wholesalePrice != snapshot::NO_PRICE;
+            result.push_back({snapshot->toProduct(*r), Money::fromKopecks(priced ? link.wholesalePrice : 0), priced});
+        }
+        return result;
+    }
     
     // 1. Получаем связи из таблицы связей
-    auto links = enterpriseProductGateway->findByEnterprise(enterpriseId);
+    std::vector<EnterpriseProduct> links;
+    {
+        auto conn = connection();
+        if (!conn) return result;
+        links = EnterpriseProductGateway(conn.get()).findByEnterprise(enterpriseId);
+    }
 
-    // 2. Для каждой связи подтягиваем полную информацию о товаре
+    // 2. Для каждой связи берём полную информацию о товаре из кэша
+    ReadLock lock = readProducts();
     for (const auto& link : links) {
-        Product p = productGateway->findById(link.product_id);
-        if (p.id != 0) {
-            result.push_back({p, link.wholesale_price});
+        const Product* p = cache.product(link.product_id);
+        if (p) {
+            result.push_back({*p, link.wholesale_price, link.has_wholesale_price});
         }
     }
     return result;
 }
 
-bool RegistryService::addProductToAssortment(int enterpriseId, int productId, double wholesalePrice) {
-    if (wholesalePrice < 0) {
+bool RegistryService::addProductToAssortment(int enterpriseId, int productId, Money wholesalePrice) {
+    if (rejectWriteInReadOnly()) return false;
+    if (wholesalePrice.isNegative()) {
         std::cerr << "Ошибка: Оптовая цена не может быть отрицательной." << std::endl;
         return false;
     }
@@ -191,29 +724,196 @@ bool RegistryService::addProductToAssortment(int enterpriseId, int productId, do
     link.product_id = productId;
     link.wholesale_price = wholesalePrice;
 
+    auto conn = connection();
+    if (!conn) return false;
     // Пытаемся вставить. Если связь уже есть — БД может вернуть ошибку (PK constraint),
     // либо можно предварительно проверить наличие.
     // В данном примере полагаемся на то, что insert вернет false при дубликате.
-    if (!enterpriseProductGateway->insert(link)) {
+    if (!EnterpriseProductGateway(conn.get()).insert(link)) {
         std::cerr << "Ошибка: Не удалось добавить товар (возможно, он уже в ассортименте)." << std::endl;
         return false;
     }
+    dropCatalog();
     return true;
 }
 
 bool RegistryService::removeProductFromAssortment(int enterpriseId, int productId) {
-    return enterpriseProductGateway->remove(enterpriseId, productId);
+    if (rejectWriteInReadOnly()) return false;
+    auto conn = connection();
+    if (!conn) return false;
+    if (!EnterpriseProductGateway(conn.get()).remove(enterpriseId, productId)) return false;
+    dropCatalog();
+    return true;
 }
 
-bool RegistryService::updateProductPriceInAssortment(int enterpriseId, int productId, double newPrice) {
-    if (newPrice < 0) return false;
+bool RegistryService::updateProductPriceInAssortment(int enterpriseId, int productId, Money newPrice) {
+    if (rejectWriteInReadOnly()) return false;
+    if (newPrice.isNegative()) return false;
 
     EnterpriseProduct link;
     link.enterprise_id = enterpriseId;
     link.product_id = productId;
     link.wholesale_price = newPrice;
 
-    return enterpriseProductGateway->update(link);
+    auto conn = connection();
+    if (!conn) return false;
+    if (!EnterpriseProductGateway(conn.get()).update(link)) return false;
+    dropCatalog();
+    return true;
+}
+
+bool RegistryService::applyAssortmentChanges(AssortmentChange kind, const std::vector<EnterpriseProduct>& changes,
+                                             std::vector<bool>& applied) {
+    applied.assign(changes.size(), false);
+    if (rejectWriteInReadOnly()) return false;
+    if (changes.empty()) return true;
+
+    std::unordered_set<int64_t> keys;
+    for (const EnterpriseProduct& c : changes) {
+        if (kind != AssortmentChange::Remove && c.wholesale_price.isNegative()) {
+            std::cerr << "Ошибка: Оптовая цена не может быть отрицательной." << std::endl;
+            return false;
+        }
+        if (!keys.insert((static_cast<int64_t>(c.enterprise_id) << 32) | static_cast<uint32_t>(c.product_id)).second) {
+            std::cerr << "Ошибка: Позиция " << c.enterprise_id << "/" << c.product_id
+                      << " повторяется в пакете." << std::endl;
+            return false;
+        }
+    }
+
+    auto conn = connection();
+    if (!conn) return false;
+    if (!conn->beginTransaction()) {
+        std::cerr << "Ошибка: Не удалось начать транзакцию." << std::endl;
+        return false;
+    }
+    if (!EnterpriseProductGateway(conn.get()).applyChanges(kind, changes, applied) || !conn->commit()) {
+        conn->rollback();
+        applied.assign(changes.size(), false);
+        std::cerr << "Ошибка: Пакет правок ассортимента отменён." << std::endl;
+        return false;
+    }
+    dropCatalog();
+    return true;
+}
+
+long RegistryService::copyAssortment(int sourceEnterpriseId, const std::vector<int>& targetEnterpriseIds,
+                                     double priceMultiplier, AssortmentConflictPolicy policy) {
+    if (rejectWriteInReadOnly()) return -1;
+    // Сравнение с нулём ложно для NaN; бесконечность отсекает isfinite
+    if (!(priceMultiplier > 0) || !std::isfinite(priceMultiplier)) {
+        std::cerr << "Ошибка: Множитель цены должен быть положительным конечным числом." << std::endl;
+        return -1;
+    }
+
+    // Убираем повторы и само предприятие-источник: повтор цели в одном операторе
+    // недопустим для ON CONFLICT DO UPDATE.
+    std::vector<int> targets = targetEnterpriseIds;
+    std::sort(targets.begin(), targets.end());
+    targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+    targets.erase(std::remove(targets.begin(), targets.end(), sourceEnterpriseId), targets.end());
+    if (targets.empty()) return 0;
+
+    // Транзакция открывается на соединении операции: запросы других потоков
+    // идут через другие соединения пула и в неё не попадают
+    auto conn = connection();
+    if (!conn) return -1;
+    EnterpriseProductGateway assortment(conn.get());
+
+    int lines = assortment.countByEnterprise(sourceEnterpriseId);
+    if (lines < 0) return -1;
+    if (lines == 0) return 0;
+
+    // Размер пакета подбираем так, чтобы один оператор порождал не больше
+    // COPY_ROWS_PER_BATCH строк, но всегда хотя бы одно предприятие.
+    size_t targetsPerBatch = static_cast<size_t>(std::max<long>(1, COPY_ROWS_PER_BATCH / lines));
+
+    if (!conn->beginTransaction()) {
+        std::cerr << "Ошибка: Не удалось начать транзакцию." << std::endl;
+        return -1;
+    }
+
+    long total = 0;
+    for (size_t start = 0; start < targets.size(); start += targetsPerBatch) {
+        size_t end = std::min(start + targetsPerBatch, targets.size());
+        std::vector<int> batch(targets.begin() + start, targets.begin() + end);
+
+        long affected = assortment.copyAssortment(sourceEnterpriseId, batch, priceMultiplier, policy);
+        if (affected < 0) {
+            conn->rollback();
+            std::cerr << "Ошибка: Копирование ассортимента отменено." << std::endl;
+            return -1;
+        }
+        total += affected;
+    }
+
+    if (!conn->commit()) {
+        conn->rollback();
+        std::cerr << "Ошибка: Не удалось зафиксировать копирование ассортимента." << std::endl;
+        return -1;
+    }
+    dropCatalog();
+    return total;
+}
+
+std::vector<AssortmentSummary> RegistryService::queryAssortmentSummaries(const Criteria& criteria) {
+    if (rejectCriteriaInSnapshot()) return {};
+    auto conn = connection();
+    if (!conn) return {};
+    return AssortmentSummaryGateway(conn.get()).findWhere(criteria);
+}
+
+long long RegistryService::countAssortmentSummaries(const Criteria& criteria) {
+    if (rejectCriteriaInSnapshot()) return -1;
+    auto conn = connection();
+    if (!conn) return -1;
+    return AssortmentSummaryGateway(conn.get()).countWhere(criteria);
+}
+
+std::vector<AssortmentSummary> RegistryService::getAssortmentSummaries(const std::vector<int>& enterpriseIds) {
+    if (!snapshot) {
+        auto conn = connection();
+        if (!conn) return {};
+        return AssortmentSummaryGateway(conn.get()).findByEnterprises(enterpriseIds);
+    }
+
+    // В снимке сводки нет: считаем по позициям предприятия, их немного на страницу
+    std::vector<AssortmentSummary> list;
+    for (int id : enterpriseIds) {
+        auto lines = snapshot->assortmentOf(id);
+        if (lines.size() == 0) continue;
+        AssortmentSummary s;
+        s.enterprise_id = id;
+        if (const auto* e = snapshot->findEnterprise(id)) s.enterprise_name = snapshot->str(e->name);
+        s.lines = static_cast<long long>(lines.size());
+        // Цены — только по позициям с указанной ценой, как MIN/SUM в БД
+        int64_t lo = 0, hi = 0, sum = 0;
+        long long priced = 0;
+        std::unordered_set<int> categories;
+        for (const auto& link : lines) {
+            if (link.wholesalePrice != snapshot::NO_PRICE) {
+                lo = priced > 0 ? std::min<int64_t>(lo, link.wholesalePrice) : link.wholesalePrice;
+                hi = priced > 0 ? std::max<int64_t>(hi, link.wholesalePrice) : link.wholesalePrice;
+                sum += link.wholesalePrice;
+                ++priced;
+            }
+            if (const auto* p = snapshot->findProduct(link.productId)) categories.insert(p->categoryId);
+        }
+        s.categories = static_cast<int>(categories.size());
+        s.min_price = Money::fromKopecks(lo);
+        s.max_price = Money::fromKopecks(hi);
+        // Среднее с округлением до копейки, как ROUND(..., 2) в БД
+        if (priced > 0) s.avg_price = Money::fromKopecks((2 * sum + priced) / (2 * priced));
+        list.push_back(s);
+    }
+    return list;
+}
+
+bool RegistryService::rebuildAssortmentSummaries() {
+    if (rejectWriteInReadOnly()) return false;
+    auto conn = connection();
+    if (!conn) return false;
+    return AssortmentSummaryGateway(conn.get()).rebuild();
 }
 
 // ==========================================
@@ -221,28 +921,91 @@ bool RegistryService::updateProductPriceInAssortment(int enterpriseId, int produ
 // ==========================================
 
 std::vector<SalesDepartment> RegistryService::getAllSalesDepartments() {
-    return salesDepartmentGateway->findAll();
+    if (snapshot) {
+        std::vector<SalesDepartment> list;
+        for (const auto& r : snapshot->salesDepartments()) list.push_back(snapshot->toSalesDepartment(r));
+        return list;
+    }
+    auto conn = connection();
+    if (!conn) return {};
+    return SalesDepartmentGateway(conn.get()).findAll();
+}
+
+std::vector<SalesDepartment> RegistryService::querySalesDepartments(const Criteria& criteria) {
+    if (snapshot && criteria.isDefault()) {
+        // Записи снимка упорядочены по ID, как и выборка шлюза, — страница берётся прямо из них
+        auto records = snapshot->salesDepartments();
+        size_t first = static_cast<size_t>(std::max<long long>(criteria.getOffset(), 0));
+        size_t last = criteria.getLimit() < 0
+                          ? records.size()
+                          : std::min(records.size(), first + static_cast<size_t>(criteria.getLimit()));
+        std::vector<SalesDepartment> list;
+        for (size_t i = first; i < last; ++i) list.push_back(snapshot->toSalesDepartment(records[i]));
+        return list;
+    }
+    if (rejectCriteriaInSnapshot()) return {};
+    auto conn = connection();
+    if (!conn) return {};
+    return SalesDepartmentGateway(conn.get()).findWhere(criteria);
+}
+
+long long RegistryService::countSalesDepartments(const Criteria& criteria) {
+    if (snapshot && criteria.isDefault()) return static_cast<long long>(snapshot->salesDepartments().size());
+    if (rejectCriteriaInSnapshot()) return -1;
+    auto conn = connection();
+    if (!conn) return -1;
+    return SalesDepartmentGateway(conn.get()).countWhere(criteria);
 }
 
 SalesDepartment RegistryService::getSalesDepartmentById(int id) {
-    return salesDepartmentGateway->findById(id);
+    SalesDepartment sd;
+    sd.id = 0;
+    if (snapshot) {
+        const auto* r = snapshot->findSalesDepartment(id);
+        if (r) return snapshot->toSalesDepartment(*r);
+        return sd;
+    }
+    auto conn = connection();
+    if (!conn) return sd;
+    return SalesDepartmentGateway(conn.get()).findById(id);
+}
+
+SalesDepartment RegistryService::getSalesDepartmentOfEnterprise(int enterpriseId) {
+    if (snapshot) {
+        for (const auto& r : snapshot->salesDepartments()) {
+            if (r.enterpriseId == enterpriseId) return snapshot->toSalesDepartment(r);
+        }
+        return SalesDepartment{};
+    }
+    auto conn = connection();
+    if (!conn) return SalesDepartment{};
+    return SalesDepartmentGateway(conn.get()).findByEnterprise(enterpriseId);
 }
 
 int RegistryService::createSalesDepartment(const SalesDepartment& dept) {
+    if (rejectWriteInReadOnly()) return -1;
     if (dept.contact_last_name.empty() || dept.contact_first_name.empty()) {
         std::cerr << "Ошибка: Фамилия и Имя контакта обязательны." << std::endl;
         return -1;
     }
-    return salesDepartmentGateway->insert(dept);
+    auto conn = connection();
+    if (!conn) return -1;
+    return SalesDepartmentGateway(conn.get()).insert(dept);
 }
 
 bool RegistryService::updateSalesDepartment(const SalesDepartment& dept) {
+    if (rejectWriteInReadOnly()) return false;
     if (dept.id <= 0) return false;
-    return salesDepartmentGateway->update(dept);
+    auto conn = connection();
+    if (!conn) return false;
+    return SalesDepartmentGateway(conn.get()).update(dept);
 }
 
 bool RegistryService::deleteSalesDepartment(int id) {
-    return salesDepartmentGateway->remove(id);
+    if (rejectWriteInReadOnly()) return false;
+    auto conn = connection();
+    if (!conn) return false;
+    return SalesDepartmentGateway(conn.get()).remove(id);
 }
 
 // ==========================================
@@ -250,26 +1013,340 @@ bool RegistryService::deleteSalesDepartment(int id) {
 // ==========================================
 
 std::vector<BankDetails> RegistryService::getAllBankDetails() {
-    return bankDetailsGateway->findAll();
+    if (snapshot) {
+        std::vector<BankDetails> list;
+        for (const auto& r : snapshot->bankDetails()) list.push_back(snapshot->toBankDetails(r));
+        return list;
+    }
+    auto conn = connection();
+    if (!conn) return {};
+    return BankDetailsGateway(conn.get()).findAll();
+}
+
+std::vector<BankDetails> RegistryService::queryBankDetails(const Criteria& criteria) {
+    if (snapshot && criteria.isDefault()) {
+        auto records = snapshot->bankDetails();
+        size_t first = static_cast<size_t>(std::max<long long>(criteria.getOffset(), 0));
+        size_t last = criteria.getLimit() < 0
+                          ? records.size()
+                          : std::min(records.size(), first + static_cast<size_t>(criteria.getLimit()));
+        std::vector<BankDetails> list;
+        for (size_t i = first; i < last; ++i) list.push_back(snapshot->toBankDetails(records[i]));
+        return list;
+    }
+    if (rejectCriteriaInSnapshot()) return {};
+    auto conn = connection();
+    if (!conn) return {};
+    return BankDetailsGateway(conn.get()).findWhere(criteria);
+}
+
+long long RegistryService::countBankDetails(const Criteria& criteria) {
+    if (snapshot && criteria.isDefault()) return static_cast<long long>(snapshot->bankDetails().size());
+    if (rejectCriteriaInSnapshot()) return -1;
+    auto conn = connection();
+    if (!conn) return -1;
+    return BankDetailsGateway(conn.get()).countWhere(criteria);
 }
 
 BankDetails RegistryService::getBankDetailsById(int id) {
-    return bankDetailsGateway->findById(id);
+    BankDetails bd;
+    bd.id = 0;
+    if (snapshot) {
+        const auto* r = snapshot->findBankDetails(id);
+        if (r) return snapshot->toBankDetails(*r);
+        return bd;
+    }
+    auto conn = connection();
+    if (!conn) return bd;
+    return BankDetailsGateway(conn.get()).findById(id);
+}
+
+BankDetails RegistryService::getBankDetailsOfEnterprise(int enterpriseId) {
+    if (snapshot) {
+        for (const auto& r : snapshot->bankDetails()) {
+            if (r.enterpriseId == enterpriseId) return snapshot->toBankDetails(r);
+        }
+        return BankDetails{};
+    }
+    auto conn = connection();
+    if (!conn) return BankDetails{};
+    return BankDetailsGateway(conn.get()).findByEnterprise(enterpriseId);
 }
 
 int RegistryService::createBankDetails(const BankDetails& details) {
+    if (rejectWriteInReadOnly()) return -1;
     if (details.bank_name.empty() || details.account_number.empty()) {
         std::cerr << "Ошибка: Название банка и номер счета обязательны." << std::endl;
         return -1;
     }
-    return bankDetailsGateway->insert(details);
+    auto conn = connection();
+    if (!conn) return -1;
+    return BankDetailsGateway(conn.get()).insert(details);
 }
 
 bool RegistryService::updateBankDetails(const BankDetails& details) {
+    if (rejectWriteInReadOnly()) return false;
     if (details.id <= 0) return false;
-    return bankDetailsGateway->update(details);
+    auto conn = connection();
+    if (!conn) return false;
+    return BankDetailsGateway(conn.get()).update(details);
 }
 
 bool RegistryService::deleteBankDetails(int id) {
-    return bankDetailsGateway->remove(id);
+    if (rejectWriteInReadOnly()) return false;
+    auto conn = connection();
+    if (!conn) return false;
+    return BankDetailsGateway(conn.get()).remove(id);
+}
+
+// ==========================================
+// Досье предприятия
+// ==========================================
+
+EnterpriseDossier RegistryService::getEnterpriseDossier(int enterpriseId) {
+    EnterpriseDossier dossier;
+    dossier.enterprise = getEnterpriseById(enterpriseId);
+    if (dossier.enterprise.id == 0) return dossier;
+
+    // Карточка берётся из кэша; связанные записи — отдельными запросами,
+    // поставленными все сразу
+    auto department = async(&RegistryService::getSalesDepartmentOfEnterprise, enterpriseId);
+    auto bank = async(&RegistryService::getBankDetailsOfEnterprise, enterpriseId);
+    auto summaries = async(&RegistryService::getAssortmentSummaries, std::vector<int>{enterpriseId});
+    auto assortment = async(&RegistryService::getAssortmentForEnterprise, enterpriseId);
+
+    dossier.salesDepartment = tasks->await(department);
+    dossier.bankDetails = tasks->await(bank);
+    std::vector<AssortmentSummary> list = tasks->await(summaries);
+    if (!list.empty()) dossier.summary = list.front();
+    dossier.assortment = tasks->await(assortment);
+    return dossier;
+}
+
+// ==========================================
+// Отчёты по ассортименту
+// ==========================================
+
+std::vector<MarginSummary> RegistryService::getMarginByEnterprise(size_t limit) {
+    if (ReadLock lock = readCatalog()) return catalog.marginByEnterprise(limit);
+    auto conn = connection();
+    if (!conn) return {};
+    return AnalyticsGateway(conn.get()).marginByEnterprise(limit);
+}
+
+std::vector<MarginSummary> RegistryService::getMarginByCategory() {
+    if (ReadLock lock = readCatalog()) return catalog.marginByCategory();
+    auto conn = connection();
+    if (!conn) return {};
+    return AnalyticsGateway(conn.get()).marginByCategory();
+}
+
+std::vector<ProductOffer> RegistryService::getBestOffers(const std::vector<int>& productIds, size_t topN) {
+    if (ReadLock lock = readCatalog()) return catalog.bestOffers(productIds, topN);
+    auto conn = connection();
+    if (!conn) return {};
+    return EnterpriseProductGateway(conn.get()).findBestOffers(productIds, topN);
+}
+
+std::vector<PriceOutlier> RegistryService::getPriceOutliers(size_t limit, long long* total) {
+    if (ReadLock lock = readCatalog()) return catalog.priceOutliers(limit, total);
+    auto conn = connection();
+    if (!conn) return {};
+    return AnalyticsGateway(conn.get()).findPriceOutliers(limit, total);
+}
+
+// ==========================================
+// Массовый импорт
+// ==========================================
+
+ImportResult RegistryService::importFromCsv(ImportEntity entity, const std::string& path, const ImportOptions& options) {
+    if (rejectWriteInReadOnly()) return ImportResult();
+    if (!pool) {
+        std::cerr << "Ошибка: Сервис не инициализирован." << std::endl;
+        return ImportResult();
+    }
+    std::string conninfo;
+    if (options.useCopy && CopyChannel::isSupported()) {
+        conninfo = CopyChannel::conninfoFromOdbc(db.getConnectionString());
+    }
+    // Проверки импорта (существующие товары, ИНН предприятий) идут по индексам кэша.
+    // Если кэш сбросят до начала загрузки, импорт проверит строки запросами к БД.
+    if (entity == ImportEntity::Products || entity == ImportEntity::Assortment) readProducts();
+    if (entity == ImportEntity::Assortment) readEnterprises();
+
+    // Ключи копируются под короткой блокировкой: задачи импорта берут соединения
+    // из пула, а под блокировкой кэша этого делать нельзя (см. connection())
+    ImportKeys keys;
+    {
+        ReadLock lock(cacheMutex);
+        if (entity != ImportEntity::Enterprises && cache.hasProducts()) {
+            keys.hasProducts = true;
+            for (size_t i = 0; i < cache.productCount(); ++i) {
+                const Product* p = cache.productAt(i);
+                if (!p) continue;
+                keys.productIdByName.emplace(p->name, p->id);
+                if (entity == ImportEntity::Assortment) keys.productIds.insert(p->id);
+            }
+        }
+        if (entity == ImportEntity::Assortment && cache.hasEnterprises()) {
+            keys.hasEnterprises = true;
+            for (size_t i = 0; i < cache.enterpriseCount(); ++i) {
+                const Enterprise* e = cache.enterpriseAt(i);
+                if (e) keys.enterpriseIdByInn.emplace(e->inn, e->id);
+            }
+        }
+    }
+    BulkImporter importer(*tasks, options, conninfo, std::move(keys));
+    ImportResult result = importer.run(entity, path);
+    // Строки загружены в обход кэша
+    refreshCache();
+    return result;
+}
+
+// ==========================================
+// Выгрузка
+// ==========================================
+
+long long RegistryService::exportToFile(ExportDataset dataset, const std::string& path, const ExportOptions& options) {
+    if (snapshot) {
+        std::cerr << "Ошибка: Выгрузка выполняется из базы данных, а открыт снимок." << std::endl;
+        return -1;
+    }
+
+    if (!options.since.empty() && !DataExporter::isTimestamp(options.since)) {
+        std::cerr << "Ошибка: Неверная отметка времени: " << options.since << std::endl;
+        return -1;
+    }
+
+    // Быстрый путь: CSV формирует сам сервер. Если канал COPY открыть не удалось,
+    // выгрузка идёт обычным путём через ODBC.
+    CopyChannel channel;
+    bool viaCopy = options.useCopy && options.format == ExportFormat::Csv && DataExporter::supportsCopy(dataset)
+                   && CopyChannel::isSupported()
+                   && channel.open(CopyChannel::conninfoFromOdbc(db.getConnectionString()));
+    if (viaCopy) {
+        auto writer = ExportWriter::open(path, options.format, options.gzip);
+        if (!writer) return -1;
+        long long rows = DataExporter::exportDatasetViaCopy(dataset, channel, *writer, options.since);
+        if (rows < 0) std::cerr << "Ошибка COPY: " << channel.lastError() << std::endl;
+        if (!writer->close()) {
+            std::cerr << "Ошибка: Не удалось записать " << path << std::endl;
+            return -1;
+        }
+        return rows;
+    }
+
+    DatabaseConnection streamConn;
+    streamConn.setVerbose(false);
+    if (!streamConn.connect(DEFAULT_DSN, DEFAULT_USER, DEFAULT_PASSWORD, STREAMING_OPTIONS)) {
+        std::cerr << "Ошибка: Не удалось открыть соединение для выгрузки." << std::endl;
+        return -1;
+    }
+
+    auto writer = ExportWriter::open(path, options.format, options.gzip);
+    if (!writer) return -1;
+
+    DataExporter exporter(&streamConn);
+    long long rows = exporter.exportDataset(dataset, *writer, options.since);
+    if (!writer->close()) {
+        std::cerr << "Ошибка: Не удалось записать " << path << std::endl;
+        return -1;
+    }
+    return rows;
+}
+
+bool RegistryService::exportToFiles(const std::vector<ExportDataset>& datasets, const std::vector<std::string>& paths,
+                                    const ExportOptions& options, std::vector<long long>& rows) {
+    rows.assign(datasets.size(), -1);
+    if (paths.size() != datasets.size()) return false;
+
+    // Каждый набор читается своим соединением выгрузки, так что наборы
+    // выгружаются одновременно, а самый большой (ассортимент) не задерживает остальные
+    std::vector<std::future<long long>> results;
+    for (size_t i = 0; i < datasets.size(); ++i) {
+        ExportDataset dataset = datasets[i];
+        const std::string& path = paths[i];
+        results.push_back(tasks->submit([this, dataset, &path, &options](TaskExecutor::TaskContext&) {
+            return exportToFile(dataset, path, options);
+        }));
+    }
+    bool ok = true;
+    for (size_t i = 0; i < results.size(); ++i) {
+        rows[i] = tasks->await(results[i]);
+        if (rows[i] < 0) ok = false;
+    }
+    return ok;
+}
+
+std::string RegistryService::getExportWatermark() {
+    if (snapshot) {
+        std::cerr << "Ошибка: Выгрузка выполняется из базы данных, а открыт снимок." << std::endl;
+        return "";
+    }
+    auto conn = connection();
+    if (!conn) return "";
+    return DataExporter(conn.get()).watermark();
+}
+
+// ==========================================
+// Журнал изменений
+// ==========================================
+
+long long RegistryService::streamChanges(const ChangeCursor& since, long long limit,
+                                         const RowCallback<ChangeRecord>& callback, ChangeCursor* last) {
+    if (last) *last = since;
+    if (rejectCriteriaInSnapshot()) return -1;
+    auto conn = connection();
+    if (!conn) return -1;
+    return ChangeLogGateway(conn.get()).streamSince(since, limit, [&](const ChangeRecord& r) {
+        if (last) *last = r.position;
+        return callback(r);
+    });
+}
+
+ChangeCursor RegistryService::getChangeHead() {
+    if (rejectCriteriaInSnapshot()) return ChangeCursor();
+    auto conn = connection();
+    if (!conn) return ChangeCursor();
+    return ChangeLogGateway(conn.get()).head();
+}
+
+long long RegistryService::exportChanges(const ChangeCursor& since, long long limit, const std::string& path,
+                                         const ExportOptions& options, ChangeCursor* last) {
+    if (last) *last = since;
+    if (snapshot) {
+        std::cerr << "Ошибка: Журнал изменений хранится в базе данных, а открыт снимок." << std::endl;
+        return -1;
+    }
+
+    DatabaseConnection streamConn;
+    streamConn.setVerbose(false);
+    if (!streamConn.connect(DEFAULT_DSN, DEFAULT_USER, DEFAULT_PASSWORD, STREAMING_OPTIONS)) {
+        std::cerr << "Ошибка: Не удалось открыть соединение для выгрузки." << std::endl;
+        return -1;
+    }
+
+    auto writer = ExportWriter::open(path, options.format, options.gzip);
+    if (!writer) return -1;
+    writer->begin({"txid", "seq", "changed_at", "table", "operation", "key", "data"});
+
+    ChangeLogGateway changes(&streamConn);
+    long long rows = changes.streamSince(since, limit, [&](const ChangeRecord& r) {
+        writer->beginRow();
+        writer->field(r.position.txid);
+        writer->field(r.position.seq);
+        writer->field(r.changed_at);
+        writer->field(r.table);
+        writer->field(std::string(1, r.operation));
+        writer->field(r.key);
+        writer->jsonField(r.data);
+        writer->endRow();
+        if (last) *last = r.position;
+        return writer->good();
+    });
+    if (!writer->close()) {
+        std::cerr << "Ошибка: Не удалось записать " << path << std::endl;
+        return -1;
+    }
+    return rows;
 }
\ No newline at end of file
@@ -0,0 +1,323 @@
+#include "RpcProtocol.h"
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace rpc {
+
+// ==========================================
+// Writer / Reader
+// ==========================================
+// Раскладка — little-endian независимо от платформы: байты собираются сдвигами
+
+void Writer::u16(uint16_t v) {
+    buf += static_cast<char>(v & 0xFF);
+    buf += static_cast<char>(v >> 8);
+}
+
+void Writer::u32(uint32_t v) {
+    for (int i = 0; i < 4; ++i) buf += static_cast<char>((v >> (8 * i)) & 0xFF);
+}
+
+void Writer::i64(int64_t v) {
+    uint64_t u = static_cast<uint64_t>(v);
+    for (int i = 0; i < 8; ++i) buf += static_cast<char>((u >> (8 * i)) & 0xFF);
+}
+
+void Writer::f32(float v) {
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    u32(bits);
+}
+
+void Writer::f64(double v) {
+    int64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    i64(bits);
+}
+
+void Writer::str(const std::string& s) {
+    u32(static_cast<uint32_t>(s.size()));
+    buf += s;
+}
+
+void Writer::ids(const std::vector<int>& list) {
+    u32(static_cast<uint32_t>(list.size()));
+    for (int id : list) i32(id);
+}
+
+bool Reader::take(void* out, size_t n) {
+    if (!good || left < n) {
+        good = false;
+        std::memset(out, 0, n);
+        return false;
+    }
+    std::memcpy(out, p, n);
+    p += n;
+    left -= n;
+    return true;
+}
+
+uint8_t Reader::u8() {
+    uint8_t v;
+    take(&v, 1);
+    return v;
+}
+
+uint16_t Reader::u16() {
+    unsigned char b[2];
+    take(b, 2);
+    return static_cast<uint16_t>(b[0] | (b[1] << 8));
+}
+
+uint32_t Reader::u32() {
+    unsigned char b[4];
+    take(b, 4);
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; --i) v = (v << 8) | b[i];
+    return v;
+}
+
+int64_t Reader::i64() {
+    unsigned char b[8];
+    take(b, 8);
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i) v = (v << 8) | b[i];
+    return static_cast<int64_t>(v);
+}
+
+float Reader::f32() {
+    uint32_t bits = u32();
+    float v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+double Reader::f64() {
+    int64_t bits = i64();
+    double v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+std::string Reader::str() {
+    uint32_t n = u32();
+    if (!good || left < n) {
+        good = false;
+        return std::string();
+    }
+    std::string s(p, n);
+    p += n;
+    left -= n;
+    return s;
+}
+
+std::vector<int> Reader::ids() {
+    uint32_t n = u32();
+    // Длина проверяется до выделения памяти: каждый ID занимает 4 байта
+    if (!good || left / 4 < n) {
+        good = false;
+        return {};
+    }
+    std::vector<int> list(n);
+    for (uint32_t i = 0; i < n; ++i) list[i] = i32();
+    return list;
+}
+
+// ==========================================
+// Записи сервиса
+// ==========================================
+
+void write(Writer& w, const Enterprise& e) {
+    w.i32(e.id);
+    w.str(e.name);
+    w.i32(e.legal_form_id);
+    w.i32(e.ownership_form_id);
+    w.str(e.legal_form_name);
+    w.str(e.ownership_form_name);
+    w.str(e.postal_address);
+    w.str(e.inn);
+}
+
+void read(Reader& r, Enterprise& e) {
+    e.id = r.i32();
+    e.name = r.str();
+    e.legal_form_id = r.i32();
+    e.ownership_form_id = r.i32();
+    e.legal_form_name = r.str();
+    e.ownership_form_name = r.str();
+    e.postal_address = r.str();
+    e.inn = r.str();
+}
+
+void write(Writer& w, const Product& p) {
+    w.i32(p.id);
+    w.i32(p.category_id);
+    w.str(p.name);
+    w.i32(p.shelf_life_days);
+    w.i32(p.delivery_terms_id);
+    w.money(p.retail_price);
+    w.money(p.purchase_price);
+    w.str(p.category_name);
+    w.str(p.delivery_terms_description);
+    w.u8(p.has_retail_price);
+    w.u8(p.has_purchase_price);
+}
+
+void read(Reader& r, Product& p) {
+    p.id = r.i32();
+    p.category_id = r.i32();
+    p.name = r.str();
+    p.shelf_life_days = r.i32();
+    p.delivery_terms_id = r.i32();
+    p.retail_price = r.money();
+    p.purchase_price = r.money();
+    p.category_name = r.str();
+    p.delivery_terms_description = r.str();
+    p.has_retail_price = r.u8() != 0;
+    p.has_purchase_price = r.u8() != 0;
+}
+
+void write(Writer& w, const AssortmentLine& l) {
+    write(w, l.product);
+    w.money(l.wholesale_price);
+    w.u8(l.has_wholesale_price);
+}
+
+void read(Reader& r, AssortmentLine& l) {
+    read(r, l.product);
+    l.wholesale_price = r.money();
+    l.has_wholesale_price = r.u8() != 0;
+}
+
+void write(Writer& w, const ProductOffer& o) {
+    w.i32(o.product_id);
+    w.i32(o.rank);
+    w.i32(o.enterprise_id);
+    w.str(o.enterprise_name);
+    w.money(o.wholesale_price);
+}
+
+void read(Reader& r, ProductOffer& o) {
+    o.product_id = r.i32();
+    o.rank = r.i32();
+    o.enterprise_id = r.i32();
+    o.enterprise_name = r.str();
+    o.wholesale_price = r.money();
+}
+
+void write(Writer& w, const ImportOptions& o) {
+    w.str(o.rejectPath);
+    w.u8(static_cast<uint8_t>(o.delimiter));
+    w.u32(static_cast<uint32_t>(o.batchSize));
+    w.u32(o.workers);
+    w.u8(o.upsert);
+    w.u8(o.useCopy);
+}
+
+void read(Reader& r, ImportOptions& o) {
+    o.rejectPath = r.str();
+    o.delimiter = static_cast<char>(r.u8());
+    o.batchSize = r.u32();
+    o.workers = r.u32();
+    o.upsert = r.u8() != 0;
+    o.useCopy = r.u8() != 0;
+}
+
+void write(Writer& w, const ImportResult& res) {
+    w.u8(res.success);
+    w.i64(res.rowsRead);
+    w.i64(res.rowsLoaded);
+    w.i64(res.rowsSkipped);
+    w.i64(res.rowsRejected);
+    w.i64(res.batchesViaCopy);
+    w.i64(res.batchesViaInsert);
+}
+
+void read(Reader& r, ImportResult& res) {
+    res.success = r.u8() != 0;
+    res.rowsRead = r.i64();
+    res.rowsLoaded = r.i64();
+    res.rowsSkipped = r.i64();
+    res.rowsRejected = r.i64();
+    res.batchesViaCopy = r.i64();
+    res.batchesViaInsert = r.i64();
+}
+
+void write(Writer& w, const ExportOptions& o) {
+    w.u8(static_cast<uint8_t>(o.format));
+    w.u8(o.gzip);
+    w.u8(o.useCopy);
+    w.str(o.since);
+}
+
+void read(Reader& r, ExportOptions& o) {
+    o.format = (r.u8() == static_cast<uint8_t>(ExportFormat::JsonLines)) ? ExportFormat::JsonLines
+                                                                         : ExportFormat::Csv;
+    o.gzip = r.u8() != 0;
+    o.useCopy = r.u8() != 0;
+    o.since = r.str();
+}
+
+void write(Writer& w, const ChangeCursor& c) {
+    w.i64(c.txid);
+    w.i64(c.seq);
+}
+
+void read(Reader& r, ChangeCursor& c) {
+    c.txid = r.i64();
+    c.seq = r.i64();
+}
+
+// ==========================================
+// Кадры
+// ==========================================
+
+namespace {
+    bool readAll(int fd, char* data, size_t n) {
+        while (n > 0) {
+            ssize_t got = ::read(fd, data, n);
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) return false;
+            data += got;
+            n -= static_cast<size_t>(got);
+        }
+        return true;
+    }
+
+    bool writeAll(int fd, const char* data, size_t n) {
+        while (n > 0) {
+            // MSG_NOSIGNAL: отключившийся собеседник — ошибка записи, а не SIGPIPE
+            ssize_t put = ::send(fd, data, n, MSG_NOSIGNAL);
+            if (put < 0 && errno == EINTR) continue;
+            if (put <= 0) return false;
+            data += put;
+            n -= static_cast<size_t>(put);
+        }
+        return true;
+    }
+}
+
+bool readFrame(int fd, std::string& payload) {
+    unsigned char header[4];
+    if (!readAll(fd, reinterpret_cast<char*>(header), sizeof(header))) return false;
+    uint32_t size = header[0] | (header[1] << 8) | (header[2] << 16) | (static_cast<uint32_t>(header[3]) << 24);
+    if (size > MAX_FRAME) return false;
+    payload.resize(size);
+    return size == 0 || readAll(fd, &payload[0], size);
+}
+
+bool writeFrame(int fd, const std::string& payload) {
+    if (payload.size() > MAX_FRAME) return false;
+    // Длина и нагрузка уходят одной записью: маленький ответ — один сегмент
+    Writer header;
+    header.u32(static_cast<uint32_t>(payload.size()));
+    std::string frame;
+    frame.reserve(4 + payload.size());
+    frame += header.data();
+    frame += payload;
+    return writeAll(fd, frame.data(), frame.size());
+}
+
+} // namespace rpc
\ No newline at end of file
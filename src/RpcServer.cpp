@@ -0,0 +1,424 @@
+#include "RpcServer.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using rpc::Op;
+using rpc::Status;
+
+namespace {
+    // Операции, изменяющие данные: от снимка не выполняются
+    bool isWrite(Op op) {
+        switch (op) {
+            case Op::CreateEnterprise: case Op::UpdateEnterprise: case Op::DeleteEnterprise:
+            case Op::CreateProduct: case Op::UpdateProduct: case Op::DeleteProduct:
+            case Op::AddToAssortment: case Op::UpdateAssortmentPrice: case Op::RemoveFromAssortment:
+            case Op::CopyAssortment: case Op::Import:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // Файлы импорта и выгрузки открывает демон, у которого свой рабочий каталог
+    bool isServerPath(const std::string& path) {
+        return !path.empty() && path[0] == '/';
+    }
+
+    bool fillAddress(const std::string& path, sockaddr_un& addr) {
+        addr = sockaddr_un{};
+        addr.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(addr.sun_path)) return false;
+        std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+        return true;
+    }
+}
+
+RpcServer::RpcServer(RegistryService& registry)
+    : service(registry), listenFd(-1), wakePipe{-1, -1}, stopping(false) {
+    if (pipe2(wakePipe, O_CLOEXEC | O_NONBLOCK) != 0) wakePipe[0] = wakePipe[1] = -1;
+}
+
+RpcServer::~RpcServer() {
+    if (listenFd >= 0) ::close(listenFd);
+    if (wakePipe[0] >= 0) ::close(wakePipe[0]);
+    if (wakePipe[1] >= 0) ::close(wakePipe[1]);
+}
+
+bool RpcServer::listen(const std::string& path) {
+    sockaddr_un addr;
+    if (!fillAddress(path, addr)) {
+        std::cerr << "Ошибка: Неверный путь сокета: " << path << std::endl;
+        return false;
+    }
+    if (wakePipe[0] < 0) {
+        std::cerr << "Ошибка: pipe: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    // Файл мог остаться от аварийно завершённого демона. Если по нему отвечают —
+    // демон жив, второй запускать нельзя; иначе файл можно удалить.
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (probe >= 0) {
+        bool alive = connect(probe, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+        ::close(probe);
+        if (alive) {
+            std::cerr << "Ошибка: Демон уже запущен на " << path << std::endl;
+            return false;
+        }
+    }
+    ::unlink(path.c_str());
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) {
+        std::cerr << "Ошибка: socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    // Права задаются при создании файла, чтобы сокет ни мгновения не был доступен всем
+    mode_t oldMask = umask(0117);
+    bool bound = bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    umask(oldMask);
+    if (!bound || ::listen(listenFd, SOMAXCONN) != 0) {
+        std::cerr << "Ошибка: Не удалось открыть сокет " << path << ": " << std::strerror(errno) << std::endl;
+        ::close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    socketPath = path;
+    return true;
+}
+
+void RpcServer::stop() {
+    stopping.store(true);
+    char one = 1;
+    ssize_t ignored = ::write(wakePipe[1], &one, 1);
+    (void)ignored;
+}
+
+void RpcServer::run() {
+    if (listenFd < 0) return;
+
+    pollfd fds[2] = {{listenFd, POLLIN, 0}, {wakePipe[0], POLLIN, 0}};
+    while (!stopping.load()) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Ошибка: poll: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        if (!(fds[0].revents & POLLIN)) continue;
+
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) continue;
+        reapFinished();
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        clients.emplace_back();
+        Client& client = clients.back();
+        client.fd = fd;
+        client.thread = std::thread(&RpcServer::serve, this, std::ref(client));
+    }
+
+    // Новые подключения не принимаются; ждущие запроса клиенты получают обрыв,
+    // выполняющие операцию — завершают её и выходят при попытке ответить
+    ::close(listenFd);
+    listenFd = -1;
+    ::unlink(socketPath.c_str());
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        for (Client& c : clients) shutdown(c.fd, SHUT_RDWR);
+    }
+    for (Client& c : clients) c.thread.join();
+    for (Client& c : clients) ::close(c.fd);
+    clients.clear();
+}
+
+void RpcServer::reapFinished() {
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    for (auto it = clients.begin(); it != clients.end();) {
+        if (it->finished.load()) {
+            it->thread.join();
+            ::close(it->fd);
+            it = clients.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void RpcServer::serve(Client& client) {
+    std::string request;
+    while (rpc::readFrame(client.fd, request)) {
+        rpc::Writer result;
+        std::string message;
+        Status status = execute(request, result, message);
+
+        std::string response(1, static_cast<char>(status));
+        if (status == Status::Ok) {
+            response += result.data();
+        } else {
+            rpc::Writer error;
+            error.str(message);
+            response += error.data();
+        }
+        if (!rpc::writeFrame(client.fd, response)) break;
+    }
+    // Сокет закрывает поток приёма: номер дескриптора не должен освободиться,
+    // пока по нему может пройти shutdown при остановке
+    client.finished.store(true);
+}
+
+// ==========================================
+// Операции
+// ==========================================
+// Каждая ветка читает аргументы и проверяет in.done() до обращения к сервису:
+// запрос с лишними или недостающими байтами не выполняется вовсе.
+
+Status RpcServer::execute(const std::string& request, rpc::Writer& out, std::string& message) {
+    rpc::Reader in(request);
+    Op op = static_cast<Op>(in.u16());
+    if (isWrite(op) && service.isReadOnly()) {
+        message = "демон работает от снимка: изменения недоступны";
+        return Status::ReadOnly;
+    }
+    const std::string failed = "операция не выполнена (подробности в журнале демона)";
+
+    switch (op) {
+        case Op::Ping: {
+            if (!in.done()) break;
+            out.u32(rpc::PROTOCOL_VERSION);
+            out.u8(service.isReadOnly());
+            return Status::Ok;
+        }
+        case Op::RefreshCache: {
+            if (!in.done()) break;
+            service.refreshCache();
+            return Status::Ok;
+        }
+
+        case Op::GetEnterprise:
+        case Op::FindEnterpriseByInn: {
+            Enterprise e;
+            if (op == Op::GetEnterprise) {
+                int id = in.i32();
+                if (!in.done()) break;
+                e = service.getEnterpriseById(id);
+            } else {
+                std::string inn = in.str();
+                if (!in.done()) break;
+                e = service.findEnterpriseByInn(inn);
+            }
+            if (e.id == 0) {
+                message = "предприятие не найдено";
+                return Status::NotFound;
+            }
+            rpc::write(out, e);
+            return Status::Ok;
+        }
+        case Op::SearchEnterprises: {
+            std::string query = in.str();
+            uint32_t limit = in.u32();
+            if (!in.done()) break;
+            auto hits = service.searchEnterprises(query, limit);
+            out.u32(static_cast<uint32_t>(hits.size()));
+            for (const auto& hit : hits) {
+                rpc::write(out, hit.first);
+                out.f32(hit.second);
+            }
+            return Status::Ok;
+        }
+        case Op::CreateEnterprise: {
+            Enterprise e;
+            rpc::read(in, e);
+            if (!in.done()) break;
+            int id = service.createEnterprise(e);
+            if (id < 0) { message = failed; return Status::Failed; }
+            out.i32(id);
+            return Status::Ok;
+        }
+        case Op::UpdateEnterprise: {
+            Enterprise e;
+            rpc::read(in, e);
+            if (!in.done()) break;
+            if (!service.updateEnterprise(e)) { message = failed; return Status::Failed; }
+            return Status::Ok;
+        }
+        case Op::DeleteEnterprise: {
+            int id = in.i32();
+            if (!in.done()) break;
+            if (!service.deleteEnterprise(id)) { message = failed; return Status::Failed; }
+            return Status::Ok;
+        }
+
+        case Op::GetProduct: {
+            int id = in.i32();
+            if (!in.done()) break;
+            Product p = service.getProductById(id);
+            if (p.id == 0) {
+                message = "товар не найден";
+                return Status::NotFound;
+            }
+            rpc::write(out, p);
+            return Status::Ok;
+        }
+        case Op::SearchProducts: {
+            std::string query = in.str();
+            uint32_t limit = in.u32();
+            if (!in.done()) break;
+            auto hits = service.searchProducts(query, limit);
+            out.u32(static_cast<uint32_t>(hits.size()));
+            for (const auto& hit : hits) {
+                rpc::write(out, hit.first);
+                out.f32(hit.second);
+            }
+            return Status::Ok;
+        }
+        case Op::CreateProduct: {
+            Product p;
+            rpc::read(in, p);
+            if (!in.done()) break;
+            int id = service.createProduct(p);
+            if (id < 0) { message = failed; return Status::Failed; }
+            out.i32(id);
+            return Status::Ok;
+        }
+        case Op::UpdateProduct: {
+            Product p;
+            rpc::read(in, p);
+            if (!in.done()) break;
+            if (!service.updateProduct(p)) { message = failed; return Status::Failed; }
+            return Status::Ok;
+        }
+        case Op::DeleteProduct: {
+            int id = in.i32();
+            if (!in.done()) break;
+            if (!service.deleteProduct(id)) { message = failed; return Status::Failed; }
+            return Status::Ok;
+        }
+
+        case Op::GetAssortment: {
+            int id = in.i32();
+            if (!in.done()) break;
+            auto lines = service.getAssortmentForEnterprise(id);
+            out.u32(static_cast<uint32_t>(lines.size()));
+            for (const auto& line : lines) rpc::write(out, line);
+            return Status::Ok;
+        }
+        case Op::AddToAssortment:
+        case Op::UpdateAssortmentPrice: {
+            int enterpriseId = in.i32();
+            int productId = in.i32();
+            Money price = in.money();
+            if (!in.done()) break;
+            bool ok = (op == Op::AddToAssortment)
+                ? service.addProductToAssortment(enterpriseId, productId, price)
+                : service.updateProductPriceInAssortment(enterpriseId, productId, price);
+            if (!ok) { message = failed; return Status::Failed; }
+            return Status::Ok;
+        }
+        case Op::RemoveFromAssortment: {
+            int enterpriseId = in.i32();
+            int productId = in.i32();
+            if (!in.done()) break;
+            if (!service.removeProductFromAssortment(enterpriseId, productId)) {
+                message = failed;
+                return Status::Failed;
+            }
+            return Status::Ok;
+        }
+        case Op::CopyAssortment: {
+            int source = in.i32();
+            std::vector<int> targets = in.ids();
+            double multiplier = in.f64();
+            uint8_t policy = in.u8();
+            if (!in.done()) break;
+            long rows = service.copyAssortment(source, targets, multiplier,
+                                               policy ? AssortmentConflictPolicy::Overwrite
+                                                      : AssortmentConflictPolicy::Skip);
+            if (rows < 0) { message = failed; return Status::Failed; }
+            out.i64(rows);
+            return Status::Ok;
+        }
+        case Op::BestOffers: {
+            std::vector<int> ids = in.ids();
+            uint32_t top = in.u32();
+            if (!in.done()) break;
+            auto offers = service.getBestOffers(ids, top);
+            out.u32(static_cast<uint32_t>(offers.size()));
+            for (const ProductOffer& o : offers) rpc::write(out, o);
+            return Status::Ok;
+        }
+
+        case Op::Import: {
+            uint8_t entity = in.u8();
+            std::string path = in.str();
+            ImportOptions options;
+            rpc::read(in, options);
+            if (!in.done() || entity > static_cast<uint8_t>(ImportEntity::Assortment)) break;
+            if (!isServerPath(path) || (!options.rejectPath.empty() && !isServerPath(options.rejectPath))) {
+                message = "пути к файлам должны быть абсолютными";
+                return Status::BadRequest;
+            }
+            ImportResult r = service.importFromCsv(static_cast<ImportEntity>(entity), path, options);
+            rpc::write(out, r);
+            return Status::Ok;
+        }
+        case Op::Export: {
+            uint8_t dataset = in.u8();
+            std::string path = in.str();
+            ExportOptions options;
+            rpc::read(in, options);
+            if (!in.done() || dataset > static_cast<uint8_t>(ExportDataset::Deletions)) break;
+            if (!isServerPath(path)) {
+                message = "путь выгрузки должен быть абсолютным (stdout демона клиенту недоступен)";
+                return Status::BadRequest;
+            }
+            if (!options.since.empty() && !DataExporter::isTimestamp(options.since)) {
+                message = "неверная отметка времени: " + options.since;
+                return Status::BadRequest;
+            }
+            long long rows = service.exportToFile(static_cast<ExportDataset>(dataset), path, options);
+            if (rows < 0) { message = failed; return Status::Failed; }
+            out.i64(rows);
+            return Status::Ok;
+        }
+        case Op::ExportWatermark: {
+            if (!in.done()) break;
+            std::string watermark = service.getExportWatermark();
+            if (watermark.empty()) { message = failed; return Status::Failed; }
+            out.str(watermark);
+            return Status::Ok;
+        }
+        case Op::ChangeHead: {
+            if (!in.done()) break;
+            rpc::write(out, service.getChangeHead());
+            return Status::Ok;
+        }
+        case Op::ExportChanges: {
+            ChangeCursor since;
+            rpc::read(in, since);
+            int64_t limit = in.i64();
+            std::string path = in.str();
+            ExportOptions options;
+            rpc::read(in, options);
+            if (!in.done()) break;
+            if (!isServerPath(path)) {
+                message = "путь выгрузки должен быть абсолютным (stdout демона клиенту недоступен)";
+                return Status::BadRequest;
+            }
+            ChangeCursor last;
+            long long rows = service.exportChanges(since, limit, path, options, &last);
+            if (rows < 0) { message = failed; return Status::Failed; }
+            out.i64(rows);
+            rpc::write(out, last);
+            return Status::Ok;
+        }
+    }
+
+    message = "неизвестная операция или неверные аргументы";
+    return Status::BadRequest;
+}
\ No newline at end of file
@@ -22,25 +22,56 @@ void SalesDepartmentGateway::createTableIfNotExists() {
 
 std::vector<SalesDepartment> SalesDepartmentGateway::findAll() {
     std::vector<SalesDepartment> list;
-    if (!db->isConnected()) return list;
-
-    SQLHSTMT hStmt;
-    SQLAllocHandle(SQL_HANDLE_STMT, db->getHandle(), &hStmt);
+    if (streamAll([&list](const SalesDepartment& sd) { list.push_back(sd); return true; }) < 0) return {};
+    return list;
+}
 
+namespace {
     // JOIN с таблицей enterprise, чтобы получить название предприятия для отображения
-    std::string sql = R"(
+    const char* SALES_SELECT = R"(
         SELECT 
             sd.depart_id, sd.enterprise_id, e.name as ent_name,
             sd.phone, sd.fax, sd.email,
             sd.contact_last_name, sd.contact_first_name, sd.contact_patronymic
+    )";
+    const char* SALES_FROM = R"(
         FROM sales_department sd
         JOIN enterprise e ON sd.enterprise_id = e.enterprise_id
-        ORDER BY sd.depart_id
     )";
+}
 
-    SQLExecDirect(hStmt, (SQLCHAR*)sql.c_str(), SQL_NTS);
+const std::vector<CriteriaField>& SalesDepartmentGateway::criteriaFields() {
+    static const std::vector<CriteriaField> fields = {
+        {"id", "sd.depart_id", FieldType::Int},
+        {"enterprise_id", "sd.enterprise_id", FieldType::Int},
+        {"enterprise", "e.name", FieldType::Text},
+        {"phone", "sd.phone", FieldType::Text},
+        {"email", "sd.email", FieldType::Text},
+        {"contact_last_name", "sd.contact_last_name", FieldType::Text},
+        {"created_at", "sd.created_at", FieldType::Timestamp},
+        {"updated_at", "sd.updated_at", FieldType::Timestamp}
+    };
+    return fields;
+}
+
+std::vector<SalesDepartment> SalesDepartmentGateway::findWhere(const Criteria& criteria) {
+    std::vector<SalesDepartment> list;
+    if (streamWhere(criteria, [&list](const SalesDepartment& sd) { list.push_back(sd); return true; }) < 0) return {};
+    return list;
+}
+
+long long SalesDepartmentGateway::countWhere(const Criteria& criteria) {
+    return countQuery(SALES_FROM, criteria, criteriaFields());
+}
+
+long long SalesDepartmentGateway::streamWhere(const Criteria& criteria,
+                                              const RowCallback<SalesDepartment>& callback) {
+    SQLHSTMT hStmt = openQuery(std::string(SALES_SELECT) + SALES_FROM, criteria,
+                               criteriaFields(), "sd.depart_id");
+    if (hStmt == SQL_NULL_HSTMT) return -1;
 
     SalesDepartment sd;
+    long long count = 0;
     // Буферы для строк (размер с запасом)
     SQLCHAR ent_name[256], phone[128], fax[128], email[256];
     SQLCHAR last[256], first[256], patr[256];
@@ -49,7 +80,8 @@ std::vector<SalesDepartment> SalesDepartmentGateway::findAll() {
     // Примечание: драйвер ODBC может вернуть NULL, для надежности лучше проверять индикатор длины,
     // но для учебного примера допустимо полагаться на инициализацию.
     
-    while (SQLFetch(hStmt) == SQL_SUCCESS) {
+    SQLRETURN ret;
+    while (SQL_SUCCEEDED(ret = SQLFetch(hStmt))) {
         // Сброс буферов перед чтением новой строки
         ent_name[0] = phone[0] = fax[0] = email[0] = last[0] = first[0] = patr[0] = '\0';
 
@@ -71,10 +103,12 @@ std::vector<SalesDepartment> SalesDepartmentGateway::findAll() {
         sd.contact_first_name = (char*)first;
         sd.contact_patronymic = (char*)patr;
 
-        list.push_back(sd);
+        ++count;
+        if (!callback(sd)) break;
     }
+    bool complete = fetchCompleted(hStmt, ret);
     SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
-    return list;
+    return complete ? count : -1;
 }
 
 SalesDepartment SalesDepartmentGateway::findById(int id) {
@@ -172,4 +206,12 @@ bool SalesDepartmentGateway::remove(int id) {
     std::ostringstream oss;
     oss << "DELETE FROM sales_department WHERE depart_id=" << id;
     return db->executeQuery(oss.str());
+}
+
+SalesDepartment SalesDepartmentGateway::findByEnterprise(int enterprise_id) {
+    SalesDepartment sd{};
+    // enterprise_id уникален: отдел у предприятия один
+    streamWhere(Criteria().eq("enterprise_id", static_cast<long long>(enterprise_id)),
+                [&sd](const SalesDepartment& row) { sd = row; return false; });
+    return sd;
 }
\ No newline at end of file
@@ -0,0 +1,132 @@
+#include "SchemaMigrations.h"
+#include <string>
+
+namespace {
+    struct Migration {
+        int version;
+        const char* description;
+        const char* sql;
+    };
+
+    // Поля отслеживания изменений: created_at задаётся при вставке, updated_at —
+    // при вставке и каждом изменении строки (триггер, поэтому учитываются и
+    // изменения в обход шлюзов). Индекс по updated_at превращает выгрузку
+    // изменённых строк (export --since) в просмотр диапазона индекса.
+    // Уже существующие строки получают время применения миграции.
+    const char* TRACKING_COLUMNS = R"(
+        CREATE OR REPLACE FUNCTION touch_updated_at() RETURNS trigger AS $$
+        BEGIN
+            NEW.created_at := OLD.created_at;
+            NEW.updated_at := now();
+            RETURN NEW;
+        END;
+        $$ LANGUAGE plpgsql;
+
+        ALTER TABLE enterprise
+            ADD COLUMN created_at TIMESTAMPTZ NOT NULL DEFAULT now(),
+            ADD COLUMN updated_at TIMESTAMPTZ NOT NULL DEFAULT now();
+        ALTER TABLE product
+            ADD COLUMN created_at TIMESTAMPTZ NOT NULL DEFAULT now(),
+            ADD COLUMN updated_at TIMESTAMPTZ NOT NULL DEFAULT now();
+        ALTER TABLE enterprise_product
+            ADD COLUMN created_at TIMESTAMPTZ NOT NULL DEFAULT now(),
+            ADD COLUMN updated_at TIMESTAMPTZ NOT NULL DEFAULT now();
+        ALTER TABLE sales_department
+            ADD COLUMN created_at TIMESTAMPTZ NOT NULL DEFAULT now(),
+            ADD COLUMN updated_at TIMESTAMPTZ NOT NULL DEFAULT now();
+        ALTER TABLE bank_details
+            ADD COLUMN created_at TIMESTAMPTZ NOT NULL DEFAULT now(),
+            ADD COLUMN updated_at TIMESTAMPTZ NOT NULL DEFAULT now();
+
+        CREATE INDEX enterprise_updated_at_idx ON enterprise (updated_at);
+        CREATE INDEX product_updated_at_idx ON product (updated_at);
+        CREATE INDEX enterprise_product_updated_at_idx ON enterprise_product (updated_at);
+        CREATE INDEX sales_department_updated_at_idx ON sales_department (updated_at);
+        CREATE INDEX bank_details_updated_at_idx ON bank_details (updated_at);
+
+        CREATE TRIGGER enterprise_touch BEFORE UPDATE ON enterprise
+            FOR EACH ROW EXECUTE PROCEDURE touch_updated_at();
+        CREATE TRIGGER product_touch BEFORE UPDATE ON product
+            FOR EACH ROW EXECUTE PROCEDURE touch_updated_at();
+        CREATE TRIGGER enterprise_product_touch BEFORE UPDATE ON enterprise_product
+            FOR EACH ROW EXECUTE PROCEDURE touch_updated_at();
+        CREATE TRIGGER sales_department_touch BEFORE UPDATE ON sales_department
+            FOR EACH ROW EXECUTE PROCEDURE touch_updated_at();
+        CREATE TRIGGER bank_details_touch BEFORE UPDATE ON bank_details
+            FOR EACH ROW EXECUTE PROCEDURE touch_updated_at();
+    )";
+
+    const Migration MIGRATIONS[] = {
+        {1, "created_at/updated_at в таблицах реестра", TRACKING_COLUMNS}
+    };
+
+    // Ключ рекомендательной блокировки на время применения миграции
+    const char* MIGRATION_LOCK = "SELECT pg_advisory_xact_lock(7417001)";
+}
+
+bool SchemaMigrations::isApplied(int version) {
+    SQLHSTMT hStmt;
+    SQLRETURN ret = SQLAllocHandle(SQL_HANDLE_STMT, db->getHandle(), &hStmt);
+    if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) return false;
+
+    std::string sql = "SELECT COUNT(*) FROM schema_migrations WHERE version = " + std::to_string(version);
+    SQLINTEGER count = 0;
+    ret = SQLExecDirect(hStmt, (SQLCHAR*)sql.c_str(), SQL_NTS);
+    if ((ret == SQL_SUCCESS || ret == SQL_SUCCESS_WITH_INFO) && SQLFetch(hStmt) == SQL_SUCCESS) {
+        SQLGetData(hStmt, 1, SQL_C_LONG, &count, 0, nullptr);
+    }
+    SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+    return count > 0;
+}
+
+int SchemaMigrations::currentVersion() {
+    if (!db->isConnected()) return -1;
+
+    SQLHSTMT hStmt;
+    SQLRETURN ret = SQLAllocHandle(SQL_HANDLE_STMT, db->getHandle(), &hStmt);
+    if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) return -1;
+
+    SQLINTEGER version = -1;
+    ret = SQLExecDirect(hStmt, (SQLCHAR*)"SELECT COALESCE(MAX(version), 0) FROM schema_migrations", SQL_NTS);
+    if ((ret == SQL_SUCCESS || ret == SQL_SUCCESS_WITH_INFO) && SQLFetch(hStmt) == SQL_SUCCESS) {
+        SQLGetData(hStmt, 1, SQL_C_LONG, &version, 0, nullptr);
+    }
+    SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+    return version;
+}
+
+bool SchemaMigrations::apply() {
+    if (!db->isConnected()) return false;
+
+    db->executeQuery(R"(
+        CREATE TABLE IF NOT EXISTS schema_migrations (
+            version INTEGER PRIMARY KEY,
+            description TEXT NOT NULL,
+            applied_at TIMESTAMPTZ NOT NULL DEFAULT now()
+        );
+    )");
+
+    for (const Migration& m : MIGRATIONS) {
+        if (isApplied(m.version)) continue;
+
+        // Проверка повторяется под блокировкой: другая копия программы могла
+        // применить миграцию, пока мы ждали
+        if (!db->beginTransaction()) return false;
+        bool ok = db->executeQuery(MIGRATION_LOCK);
+        if (ok && isApplied(m.version)) {
+            db->commit();
+            continue;
+        }
+        ok = ok && db->executeQuery(m.sql)
+                && db->executeQuery("INSERT INTO schema_migrations (version, description) VALUES (" +
+                                    std::to_string(m.version) + ", '" + m.description + "')");
+        if (!ok || !db->commit()) {
+            db->rollback();
+            std::cerr << "Ошибка: Не удалось применить миграцию " << m.version
+                      << " (" << m.description << ")." << std::endl;
+            return false;
+        }
+        std::cout << "Применена миграция " << m.version << ": " << m.description << std::endl;
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,474 @@
+#include "Snapshot.h"
+#include "Gateways.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <iostream>
+#include <limits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+using namespace snapshot;
+
+namespace {
+    const char MAGIC[8] = {'R', 'E', 'G', 'S', 'N', 'A', 'P', '\0'};
+
+    // Записи пишутся и читаются как есть, поэтому формат совпадает с памятью
+    // только на little-endian машинах; на остальных снимок не поддерживается
+    bool hostIsLittleEndian() {
+        const uint16_t probe = 1;
+        unsigned char first;
+        std::memcpy(&first, &probe, 1);
+        return first == 1;
+    }
+
+    uint64_t align8(uint64_t n) {
+        return (n + 7) & ~uint64_t(7);
+    }
+
+    // Секция строк с дедупликацией: названия справочников, повторяющиеся
+    // в каждой записи, хранятся один раз
+    class StringPool {
+    private:
+        std::string data;
+        std::unordered_map<std::string, StrRef> index;
+        bool overflow = false;
+
+    public:
+        StrRef add(const std::string& s) {
+            if (s.empty()) return StrRef{0, 0};
+            auto it = index.find(s);
+            if (it != index.end()) return it->second;
+            if (data.size() + s.size() > std::numeric_limits<uint32_t>::max()) {
+                overflow = true;
+                return StrRef{0, 0};
+            }
+            StrRef ref{static_cast<uint32_t>(data.size()), static_cast<uint32_t>(s.size())};
+            data += s;
+            index.emplace(s, ref);
+            return ref;
+        }
+
+        const std::string& bytes() const { return data; }
+        bool overflowed() const { return overflow; }
+    };
+
+    bool writeAll(int fd, const void* buf, size_t len) {
+        const char* p = static_cast<const char*>(buf);
+        while (len > 0) {
+            ssize_t n = ::write(fd, p, len);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            p += n;
+            len -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    struct PendingSection {
+        Section kind;
+        uint32_t count;
+        const void* data;
+        size_t size;
+    };
+
+    template <class T>
+    PendingSection sectionOf(Section kind, const std::vector<T>& records) {
+        return PendingSection{kind, static_cast<uint32_t>(records.size()), records.data(), records.size() * sizeof(T)};
+    }
+
+    template <class T>
+    const T* findById(const Records<T>& records, int id) {
+        const T* it = std::lower_bound(records.begin(), records.end(), id,
+                                       [](const T& r, int key) { return r.id < key; });
+        return (it != records.end() && it->id == id) ? it : nullptr;
+    }
+
+    template <class T>
+    bool byId(const T& a, const T& b) { return a.id < b.id; }
+}
+
+Snapshot::Snapshot() : base(nullptr), length(0), created(0), strings(nullptr), stringsSize(0) {}
+
+Snapshot::~Snapshot() {
+    close();
+}
+
+// ==========================================
+// Чтение
+// ==========================================
+
+bool Snapshot::open(const std::string& path) {
+    close();
+    if (!hostIsLittleEndian()) {
+        std::cerr << "Ошибка: Снимки поддерживаются только на little-endian платформах." << std::endl;
+        return false;
+    }
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Ошибка: Не удалось открыть снимок " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+        std::cerr << "Ошибка: Файл " << path << " не является снимком реестра." << std::endl;
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Ошибка: mmap " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    base = static_cast<const char*>(mapped);
+    length = size;
+
+    const FileHeader* header = reinterpret_cast<const FileHeader*>(base);
+    bool valid = std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0
+                 && header->fileSize == length
+                 && sizeof(FileHeader) + uint64_t(header->sectionCount) * sizeof(SectionEntry) <= length;
+    if (valid && header->version != FORMAT_VERSION) {
+        std::cerr << "Ошибка: Версия снимка " << header->version << " не поддерживается (ожидается "
+                  << FORMAT_VERSION << ")." << std::endl;
+        close();
+        return false;
+    }
+
+    const SectionEntry* sections = reinterpret_cast<const SectionEntry*>(base + sizeof(FileHeader));
+    for (uint32_t i = 0; valid && i < header->sectionCount; ++i) {
+        const SectionEntry& s = sections[i];
+        if (s.offset % 8 != 0 || s.offset > length || s.size > length - s.offset) {
+            valid = false;
+            break;
+        }
+        const char* data = base + s.offset;
+
+        // Размер секции должен точно соответствовать числу записей
+        auto bind = [&](auto& records) {
+            using Rec = typename std::remove_const<typename std::remove_pointer<decltype(records.begin())>::type>::type;
+            if (s.size != uint64_t(s.count) * sizeof(Rec)) { valid = false; return; }
+            records = Records<Rec>(reinterpret_cast<const Rec*>(data), s.count);
+        };
+
+        switch (static_cast<Section>(s.kind)) {
+            case Section::Strings:
+                strings = data;
+                stringsSize = static_cast<size_t>(s.size);
+                break;
+            case Section::Enterprises:       bind(enterpriseRecs); break;
+            case Section::Products:          bind(productRecs); break;
+            case Section::Assortment:        bind(assortmentRecs); break;
+            case Section::SalesDepartments:  bind(salesRecs); break;
+            case Section::BankDetails:       bind(bankRecs); break;
+            case Section::LegalForms:        bind(dictionaryRecs[0]); break;
+            case Section::OwnershipForms:    bind(dictionaryRecs[1]); break;
+            case Section::ProductCategories: bind(dictionaryRecs[2]); break;
+            case Section::DeliveryTerms:     bind(dictionaryRecs[3]); break;
+            default: break; // Неизвестные секции пропускаются
+        }
+    }
+
+    if (!valid) {
+        std::cerr << "Ошибка: Снимок " << path << " повреждён." << std::endl;
+        close();
+        return false;
+    }
+    created = header->createdAt;
+    return true;
+}
+
+void Snapshot::close() {
+    if (base) munmap(const_cast<char*>(base), length);
+    base = nullptr;
+    length = 0;
+    created = 0;
+    enterpriseRecs = {};
+    productRecs = {};
+    assortmentRecs = {};
+    salesRecs = {};
+    bankRecs = {};
+    for (auto& d : dictionaryRecs) d = {};
+    strings = nullptr;
+    stringsSize = 0;
+}
+
+std::string_view Snapshot::str(StrRef ref) const {
+    if (uint64_t(ref.offset) + ref.length > stringsSize) return std::string_view();
+    return std::string_view(strings + ref.offset, ref.length);
+}
+
+Records<DictionaryRecord> Snapshot::dictionary(Dictionary dict) const {
+    return dictionaryRecs[static_cast<int>(dict)];
+}
+
+const EnterpriseRecord* Snapshot::findEnterprise(int id) const {
+    return findById(enterpriseRecs, id);
+}
+
+const ProductRecord* Snapshot::findProduct(int id) const {
+    return findById(productRecs, id);
+}
+
+const SalesDepartmentRecord* Snapshot::findSalesDepartment(int id) const {
+    return findById(salesRecs, id);
+}
+
+const BankDetailsRecord* Snapshot::findBankDetails(int id) const {
+    return findById(bankRecs, id);
+}
+
+Records<AssortmentRecord> Snapshot::assortmentOf(int enterpriseId) const {
+    const AssortmentRecord* first = std::lower_bound(assortmentRecs.begin(), assortmentRecs.end(), enterpriseId,
+        [](const AssortmentRecord& r, int key) { return r.enterpriseId < key; });
+    const AssortmentRecord* last = std::upper_bound(first, assortmentRecs.end(), enterpriseId,
+        [](int key, const AssortmentRecord& r) { return key < r.enterpriseId; });
+    return Records<AssortmentRecord>(first, static_cast<size_t>(last - first));
+}
+
+Enterprise Snapshot::toEnterprise(const EnterpriseRecord& r) const {
+    Enterprise e;
+    e.id = r.id;
+    e.legal_form_id = r.legalFormId;
+    e.ownership_form_id = r.ownershipFormId;
+    e.name = std::string(str(r.name));
+    e.legal_form_name = std::string(str(r.legalFormName));
+    e.ownership_form_name = std::string(str(r.ownershipFormName));
+    e.postal_address = std::string(str(r.postalAddress));
+    e.inn = std::string(str(r.inn));
+    return e;
+}
+
+Product Snapshot::toProduct(const ProductRecord& r) const {
+    Product p;
+    p.id = r.id;
+    p.category_id = r.categoryId;
+    p.shelf_life_days = r.shelfLifeDays;
+    p.delivery_terms_id = r.deliveryTermsId;
+    p.has_retail_price = r.retailPrice != NO_PRICE;
+    p.has_purchase_price = r.purchasePrice != NO_PRICE;
+    p.retail_price = Money::fromKopecks(p.has_retail_price ? r.retailPrice : 0);
+    p.purchase_price = Money::fromKopecks(p.has_purchase_price ? r.purchasePrice : 0);
+    p.name = std::string(str(r.name));
+    p.category_name = std::string(str(r.categoryName));
+    p.delivery_terms_description = std::string(str(r.deliveryTerms));
+    return p;
+}
+
+SalesDepartment Snapshot::toSalesDepartment(const SalesDepartmentRecord& r) const {
+    SalesDepartment sd;
+    sd.id = r.id;
+    sd.enterprise_id = r.enterpriseId;
+    sd.enterprise_name = std::string(str(r.enterpriseName));
+    sd.phone = std::string(str(r.phone));
+    sd.fax = std::string(str(r.fax));
+    sd.email = std::string(str(r.email));
+    sd.contact_last_name = std::string(str(r.contactLastName));
+    sd.contact_first_name = std::string(str(r.contactFirstName));
+    sd.contact_patronymic = std::string(str(r.contactPatronymic));
+    return sd;
+}
+
+BankDetails Snapshot::toBankDetails(const BankDetailsRecord& r) const {
+    BankDetails bd;
+    bd.id = r.id;
+    bd.enterprise_id = r.enterpriseId;
+    bd.enterprise_name = std::string(str(r.enterpriseName));
+    bd.bank_name = std::string(str(r.bankName));
+    bd.bank_city = std::string(str(r.bankCity));
+    bd.account_number = std::string(str(r.accountNumber));
+    return bd;
+}
+
+// ==========================================
+// Запись
+// ==========================================
+
+bool Snapshot::write(DatabaseConnection* db, const std::string& path, SnapshotStats* stats) {
+    if (!hostIsLittleEndian()) {
+        std::cerr << "Ошибка: Снимки поддерживаются только на little-endian платформах." << std::endl;
+        return false;
+    }
+    if (!db->isConnected()) return false;
+
+    StringPool pool;
+    std::vector<EnterpriseRecord> enterprises;
+    std::vector<ProductRecord> products;
+    std::vector<AssortmentRecord> assortment;
+    std::vector<SalesDepartmentRecord> sales;
+    std::vector<BankDetailsRecord> banks;
+    std::vector<DictionaryRecord> dictionaries[4];
+
+    // Все таблицы читаются в одной транзакции REPEATABLE READ — снимок согласован
+    db->beginTransaction();
+    bool ok = db->executeUpdate("SET TRANSACTION ISOLATION LEVEL REPEATABLE READ") >= 0;
+
+    const Dictionary dicts[4] = {Dictionary::LegalForm, Dictionary::OwnershipForm,
+                                 Dictionary::ProductCategory, Dictionary::DeliveryTerms};
+    DictionaryGateway dictionaryGateway(db);
+    for (int i = 0; ok && i < 4; ++i) {
+        for (const auto& entry : dictionaryGateway.findAll(dicts[i])) {
+            dictionaries[i].push_back(DictionaryRecord{entry.id, pool.add(entry.name)});
+        }
+    }
+
+    ok = ok && EnterpriseGateway(db).streamAll([&](const Enterprise& e) {
+        EnterpriseRecord r{};
+        r.id = e.id;
+        r.legalFormId = e.legal_form_id;
+        r.ownershipFormId = e.ownership_form_id;
+        r.name = pool.add(e.name);
+        r.legalFormName = pool.add(e.legal_form_name);
+        r.ownershipFormName = pool.add(e.ownership_form_name);
+        r.postalAddress = pool.add(e.postal_address);
+        r.inn = pool.add(e.inn);
+        enterprises.push_back(r);
+        return true;
+    }) >= 0;
+
+    ok = ok && ProductGateway(db).streamAll([&](const Product& p) {
+        ProductRecord r{};
+        r.id = p.id;
+        r.categoryId = p.category_id;
+        r.shelfLifeDays = p.shelf_life_days;
+        r.deliveryTermsId = p.delivery_terms_id;
+        r.retailPrice = p.has_retail_price ? p.retail_price.toKopecks() : NO_PRICE;
+        r.purchasePrice = p.has_purchase_price ? p.purchase_price.toKopecks() : NO_PRICE;
+        r.name = pool.add(p.name);
+        r.categoryName = pool.add(p.category_name);
+        r.deliveryTerms = pool.add(p.delivery_terms_description);
+        products.push_back(r);
+        return true;
+    }) >= 0;
+
+    ok = ok && EnterpriseProductGateway(db).streamAll([&](const EnterpriseProduct& ep) {
+        assortment.push_back(AssortmentRecord{ep.enterprise_id, ep.product_id,
+                                              ep.has_wholesale_price ? ep.wholesale_price.toKopecks() : NO_PRICE});
+        return true;
+    }) >= 0;
+
+    ok = ok && SalesDepartmentGateway(db).streamAll([&](const SalesDepartment& sd) {
+        SalesDepartmentRecord r{};
+        r.id = sd.id;
+        r.enterpriseId = sd.enterprise_id;
+        r.enterpriseName = pool.add(sd.enterprise_name);
+        r.phone = pool.add(sd.phone);
+        r.fax = pool.add(sd.fax);
+        r.email = pool.add(sd.email);
+        r.contactLastName = pool.add(sd.contact_last_name);
+        r.contactFirstName = pool.add(sd.contact_first_name);
+        r.contactPatronymic = pool.add(sd.contact_patronymic);
+        sales.push_back(r);
+        return true;
+    }) >= 0;
+
+    ok = ok && BankDetailsGateway(db).streamAll([&](const BankDetails& bd) {
+        BankDetailsRecord r{};
+        r.id = bd.id;
+        r.enterpriseId = bd.enterprise_id;
+        r.enterpriseName = pool.add(bd.enterprise_name);
+        r.bankName = pool.add(bd.bank_name);
+        r.bankCity = pool.add(bd.bank_city);
+        r.accountNumber = pool.add(bd.account_number);
+        banks.push_back(r);
+        return true;
+    }) >= 0;
+
+    db->rollback(); // Только чтение — фиксировать нечего
+
+    if (!ok) {
+        std::cerr << "Ошибка: Не удалось прочитать данные для снимка." << std::endl;
+        return false;
+    }
+    if (pool.overflowed()) {
+        std::cerr << "Ошибка: Строковые данные превышают 4 ГиБ — снимок не поддерживает такой объём." << std::endl;
+        return false;
+    }
+
+    // Двоичный поиск при чтении опирается на порядок записей
+    std::sort(enterprises.begin(), enterprises.end(), byId<EnterpriseRecord>);
+    std::sort(products.begin(), products.end(), byId<ProductRecord>);
+    std::sort(sales.begin(), sales.end(), byId<SalesDepartmentRecord>);
+    std::sort(banks.begin(), banks.end(), byId<BankDetailsRecord>);
+    std::sort(assortment.begin(), assortment.end(), [](const AssortmentRecord& a, const AssortmentRecord& b) {
+        return a.enterpriseId != b.enterpriseId ? a.enterpriseId < b.enterpriseId : a.productId < b.productId;
+    });
+    for (auto& d : dictionaries) std::sort(d.begin(), d.end(), byId<DictionaryRecord>);
+
+    std::vector<PendingSection> pending = {
+        PendingSection{Section::Strings, 0, pool.bytes().data(), pool.bytes().size()},
+        sectionOf(Section::Enterprises, enterprises),
+        sectionOf(Section::Products, products),
+        sectionOf(Section::Assortment, assortment),
+        sectionOf(Section::SalesDepartments, sales),
+        sectionOf(Section::BankDetails, banks),
+        sectionOf(Section::LegalForms, dictionaries[0]),
+        sectionOf(Section::OwnershipForms, dictionaries[1]),
+        sectionOf(Section::ProductCategories, dictionaries[2]),
+        sectionOf(Section::DeliveryTerms, dictionaries[3])
+    };
+
+    std::vector<SectionEntry> table;
+    uint64_t offset = align8(sizeof(FileHeader) + pending.size() * sizeof(SectionEntry));
+    for (const auto& p : pending) {
+        table.push_back(SectionEntry{static_cast<uint32_t>(p.kind), p.count, offset, p.size});
+        offset = align8(offset + p.size);
+    }
+
+    FileHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.sectionCount = static_cast<uint32_t>(pending.size());
+    header.createdAt = static_cast<int64_t>(std::time(nullptr));
+    header.fileSize = offset;
+
+    std::string tmpPath = path + ".tmp";
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "Ошибка: Не удалось создать " << tmpPath << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    static const char zeros[8] = {0};
+    uint64_t written = 0;
+    auto put = [&](const void* data, size_t len) {
+        if (!writeAll(fd, data, len)) return false;
+        written += len;
+        return true;
+    };
+    auto padTo = [&](uint64_t target) { return put(zeros, static_cast<size_t>(target - written)); };
+
+    bool writtenOk = put(&header, sizeof(header)) && put(table.data(), table.size() * sizeof(SectionEntry));
+    for (size_t i = 0; writtenOk && i < pending.size(); ++i) {
+        writtenOk = padTo(table[i].offset) && put(pending[i].data, pending[i].size);
+    }
+    writtenOk = writtenOk && padTo(offset) && fsync(fd) == 0;
+    if (::close(fd) != 0) writtenOk = false;
+
+    if (!writtenOk || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "Ошибка: Не удалось записать снимок " << path << ": " << std::strerror(errno) << std::endl;
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+
+    if (stats) {
+        stats->enterprises = static_cast<long long>(enterprises.size());
+        stats->products = static_cast<long long>(products.size());
+        stats->assortment = static_cast<long long>(assortment.size());
+        stats->salesDepartments = static_cast<long long>(sales.size());
+        stats->bankDetails = static_cast<long long>(banks.size());
+        stats->bytes = static_cast<long long>(offset);
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include "Gateways.h"
+
+namespace {
+    void printStatementError(SQLHSTMT hStmt, const char* what) {
+        SQLCHAR sqlState[6], message[512];
+        SQLINTEGER nativeError;
+        sqlState[0] = message[0] = '\0';
+        SQLGetDiagRec(SQL_HANDLE_STMT, hStmt, 1, sqlState, &nativeError, message, sizeof(message), nullptr);
+        std::cerr << what << ": " << message << " (SQLSTATE: " << sqlState << ")" << std::endl;
+    }
+}
+
+SQLHSTMT TableGateway::openQuery(const std::string& select, const Criteria& criteria,
+                                 const std::vector<CriteriaField>& fields, const std::string& keyOrder) {
+    if (!db->isConnected()) return SQL_NULL_HSTMT;
+
+    CompiledCriteria compiled;
+    if (!compiled.compile(criteria, fields, keyOrder)) return SQL_NULL_HSTMT;
+
+    SQLHSTMT hStmt;
+    SQLRETURN ret = SQLAllocHandle(SQL_HANDLE_STMT, db->getHandle(), &hStmt);
+    if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) return SQL_NULL_HSTMT;
+    if (!compiled.bind(hStmt)) {
+        SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+        return SQL_NULL_HSTMT;
+    }
+
+    // Параметры передаются при выполнении, после него буферы compiled не нужны
+    std::string sql = select + compiled.where + compiled.orderBy + compiled.limit;
+    ret = SQLExecDirect(hStmt, (SQLCHAR*)sql.c_str(), SQL_NTS);
+    if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) {
+        printStatementError(hStmt, "Ошибка выборки");
+        SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+        return SQL_NULL_HSTMT;
+    }
+    return hStmt;
+}
+
+long long TableGateway::countQuery(const std::string& from, const Criteria& criteria,
+                                   const std::vector<CriteriaField>& fields) {
+    if (!db->isConnected()) return -1;
+
+    CompiledCriteria compiled;
+    if (!compiled.compile(criteria, fields, "1")) return -1;
+
+    SQLHSTMT hStmt;
+    SQLRETURN ret = SQLAllocHandle(SQL_HANDLE_STMT, db->getHandle(), &hStmt);
+    if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) return -1;
+    if (!compiled.bind(hStmt)) {
+        SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+        return -1;
+    }
+
+    std::string sql = "SELECT COUNT(*) " + from + compiled.where;
+    ret = SQLExecDirect(hStmt, (SQLCHAR*)sql.c_str(), SQL_NTS);
+    if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) {
+        printStatementError(hStmt, "Ошибка подсчёта строк");
+        SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+        return -1;
+    }
+
+    SQLBIGINT count = -1;
+    if (SQLFetch(hStmt) == SQL_SUCCESS) SQLGetData(hStmt, 1, SQL_C_SBIGINT, &count, 0, nullptr);
+    SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+    return count;
+}
+
+bool TableGateway::fetchCompleted(SQLHSTMT hStmt, SQLRETURN rc) {
+    if (rc == SQL_NO_DATA || SQL_SUCCEEDED(rc)) return true;
+    printStatementError(hStmt, "Ошибка чтения выборки");
+    return false;
+}
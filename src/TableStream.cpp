@@ -0,0 +1,138 @@
+#include "TableStream.h"
+#include "Utf8.h"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sys/wait.h>
+#include <unistd.h>
+
+TableStream::TableStream(const std::string& tableTitle, const std::vector<std::string>& columns,
+                         size_t sampleSize, size_t maxWidth)
+    : title(tableTitle), headers(columns), widths(columns.size(), 0),
+      sampleRows(std::max<size_t>(sampleSize, 1)), maxColumnWidth(maxWidth), widthsFixed(false),
+      rows(0), pager(nullptr), fd(-1), broken(false), previousSigpipe(SIG_DFL) {}
+
+void TableStream::appendCell(std::string& out, const std::string& text, size_t textWidth, size_t width) {
+    if (textWidth <= width) {
+        out.append(text);
+        out.append(width - textWidth, ' ');
+        return;
+    }
+    size_t room = width >= 3 ? width - 3 : width;
+    size_t used;
+    out.append(text, 0, utf8::fitWidth(text.data(), text.size(), room, &used));
+    if (width >= 3) out.append("...");
+    out.append(room - used, ' ');   // Широкий символ на границе не поместился
+}
+
+bool TableStream::writeAll(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = ::write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+void TableStream::open() {
+    std::cout.flush();
+    std::fflush(stdout);
+    // Закрытый читателем канал — ошибка записи (EPIPE), а не завершение процесса
+    previousSigpipe = std::signal(SIGPIPE, SIG_IGN);
+    fd = STDOUT_FILENO;
+
+    const char* env = std::getenv("PAGER");
+    std::string command = env ? env : "less -SFX";
+    if (isatty(STDOUT_FILENO) && !command.empty()) {
+        pager = popen(command.c_str(), "w");
+        if (pager) fd = fileno(pager);
+        else std::cerr << "Ошибка: Не удалось запустить " << command << ": " << std::strerror(errno) << std::endl;
+    }
+}
+
+void TableStream::appendRule() {
+    size_t total = 0;
+    for (size_t w : widths) total += w;
+    if (widths.size() > 1) total += (widths.size() - 1) * 3;
+    buffer.append(total, '-');
+    buffer.push_back('\n');
+}
+
+void TableStream::appendRow(const std::vector<std::string>& cells) {
+    for (size_t i = 0; i < headers.size(); ++i) {
+        if (i > 0) buffer.append(" | ");
+        if (i < cells.size()) {
+            size_t width = utf8::displayWidth(cells[i]);
+            if (width > widths[i]) widths[i] = std::min(width, maxColumnWidth);
+            appendCell(buffer, cells[i], width, widths[i]);
+        } else {
+            buffer.append(widths[i], ' ');
+        }
+    }
+    buffer.push_back('\n');
+}
+
+void TableStream::fixWidths() {
+    widthsFixed = true;
+    for (size_t i = 0; i < headers.size(); ++i) widths[i] = std::min(utf8::displayWidth(headers[i]), maxColumnWidth);
+    for (const auto& cells : sample) {
+        for (size_t i = 0; i < headers.size() && i < cells.size(); ++i) {
+            widths[i] = std::max(widths[i], std::min(utf8::displayWidth(cells[i]), maxColumnWidth));
+        }
+    }
+
+    buffer.append("--- ").append(title).append(" ---\n");
+    appendRow(headers);
+    appendRule();
+    for (const auto& cells : sample) appendRow(cells);
+    sample.clear();
+    sample.shrink_to_fit();
+    flush();    // Первый экран — сразу, не дожидаясь заполнения буфера
+}
+
+bool TableStream::flush() {
+    if (!broken && !writeAll(fd, buffer.data(), buffer.size())) broken = true;
+    buffer.clear();
+    return !broken;
+}
+
+bool TableStream::row(const std::vector<std::string>& cells) {
+    if (broken || fd < 0) return false;
+    ++rows;
+    if (!widthsFixed) {
+        sample.push_back(cells);
+        if (sample.size() >= sampleRows) fixWidths();
+        return !broken;
+    }
+    appendRow(cells);
+    return buffer.size() < FLUSH_SIZE || flush();
+}
+
+void TableStream::close(bool complete) {
+    if (fd < 0) return;
+    if (!widthsFixed) fixWidths();
+    if (!broken) {
+        if (rows == 0) buffer.append("(нет данных)\n");
+        appendRule();
+        buffer.push_back('(');
+        buffer.append(std::to_string(rows)).append(rows != 1 ? " строки" : " строк");
+        buffer.append(complete ? ")\n" : ", выборка прервана ошибкой)\n");
+        flush();
+    }
+    if (pager) {
+        int status = pclose(pager);
+        pager = nullptr;
+        if (status != -1 && WIFEXITED(status) && WEXITSTATUS(status) == 127) {
+            std::cerr << "Ошибка: Программа просмотра не найдена; задайте PAGER." << std::endl;
+        }
+    }
+    std::signal(SIGPIPE, previousSigpipe);
+    fd = -1;
+}
\ No newline at end of file
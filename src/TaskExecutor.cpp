@@ -0,0 +1,106 @@
+#include "TaskExecutor.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+    // Пул и номер рабочего потока, в котором выполняется код (nullptr — не рабочий поток)
+    thread_local TaskExecutor* currentExecutor = nullptr;
+    thread_local size_t currentWorker = 0;
+}
+
+DatabaseConnection* TaskExecutor::TaskContext::connection() {
+    if (!worker->lease && executor->pool) worker->lease = executor->pool->acquire();
+    if (!worker->lease) std::cerr << "Ошибка: Нет соединения с БД для задачи." << std::endl;
+    return worker->lease.get();
+}
+
+TaskExecutor::TaskExecutor(size_t workerCount, ConnectionPool* connectionPool)
+    : pool(connectionPool), nextWorker(0), queued(0), stopping(false) {
+    if (workerCount == 0) workerCount = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < workerCount; ++i) workers.push_back(std::make_unique<Worker>());
+    // Потоки запускаются, когда все очереди уже созданы: поток сразу может красть из любой
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers[i]->thread = std::thread(&TaskExecutor::workerLoop, this, i);
+    }
+}
+
+TaskExecutor::~TaskExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& w : workers) w->thread.join();
+}
+
+void TaskExecutor::enqueue(Task task) {
+    size_t target = (currentExecutor == this) ? currentWorker
+                                              : nextWorker.fetch_add(1) % workers.size();
+    {
+        std::lock_guard<std::mutex> lock(workers[target]->mutex);
+        workers[target]->tasks.push_back(std::move(task));
+    }
+    // Счётчик растёт под sleepMutex: засыпающий поток не пропустит пробуждение
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        ++queued;
+    }
+    wake.notify_one();
+}
+
+bool TaskExecutor::takeTask(size_t index, Task& task) {
+    {
+        Worker& own = *workers[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            --queued;
+            return true;
+        }
+    }
+    for (size_t step = 1; step < workers.size(); ++step) {
+        Worker& victim = *workers[(index + step) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            --queued;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskExecutor::runTask(Worker& worker, Task& task) {
+    TaskContext ctx(this, &worker, &task.token);
+    task.run(ctx);
+}
+
+void TaskExecutor::workerLoop(size_t index) {
+    currentExecutor = this;
+    currentWorker = index;
+    Worker& self = *workers[index];
+
+    for (;;) {
+        Task task;
+        if (takeTask(index, task)) {
+            runTask(self, task);
+            continue;
+        }
+        // Работы нет: соединение нужнее другим пользователям пула
+        self.lease.release();
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this] { return queued > 0 || stopping; });
+        if (stopping && queued == 0) break;
+    }
+    self.lease.release();
+}
+
+bool TaskExecutor::runPending() {
+    if (currentExecutor != this) return false;
+    Task task;
+    if (!takeTask(currentWorker, task)) return false;
+    runTask(*workers[currentWorker], task);
+    return true;
+}
\ No newline at end of file
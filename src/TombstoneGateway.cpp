@@ -0,0 +1,89 @@
+#include "Gateways.h"
+
+namespace {
+    const char* TOMBSTONE_TABLE = R"(
+        CREATE TABLE IF NOT EXISTS deleted_row (
+            table_name TEXT NOT NULL,
+            row_key TEXT NOT NULL,
+            deleted_at TIMESTAMPTZ NOT NULL DEFAULT now()
+        );
+        CREATE INDEX IF NOT EXISTS deleted_row_time_idx ON deleted_row (deleted_at);
+
+        CREATE OR REPLACE FUNCTION tombstone_capture() RETURNS trigger AS $$
+        BEGIN
+            INSERT INTO deleted_row (table_name, row_key)
+            SELECT TG_TABLE_NAME, change_log_key(to_jsonb(o), TG_ARGV) FROM old_rows o;
+            RETURN NULL;
+        END;
+        $$ LANGUAGE plpgsql;
+    )";
+
+    // Таблица и её ключ — как у журнала изменений. Очистка таблицы (TRUNCATE)
+    // отметок не оставляет: после неё нужна полная выгрузка.
+    const char* TRACKED_TABLES[][2] = {
+        {"enterprise", "'enterprise_id'"},
+        {"product", "'product_id'"},
+        {"enterprise_product", "'enterprise_id', 'product_id'"},
+        {"sales_department", "'depart_id'"},
+        {"bank_details", "'bank_id'"}
+    };
+
+    std::string tombstoneTrigger(const char* table, const char* keys) {
+        std::string t = table;
+        return "DO $$ BEGIN "
+               "IF NOT EXISTS (SELECT 1 FROM pg_trigger WHERE tgname = '" + t + "_tombstone') THEN "
+               "CREATE TRIGGER " + t + "_tombstone AFTER DELETE ON " + t +
+               " REFERENCING OLD TABLE AS old_rows FOR EACH STATEMENT EXECUTE PROCEDURE tombstone_capture(" +
+               keys + "); "
+               "END IF; END $$;";
+    }
+}
+
+void TombstoneGateway::createTableIfNotExists() {
+    db->executeQuery(TOMBSTONE_TABLE);
+    for (const auto& table : TRACKED_TABLES) db->executeQuery(tombstoneTrigger(table[0], table[1]));
+}
+
+long long TombstoneGateway::streamSince(const std::string& since, const RowCallback<Tombstone>& callback) {
+    if (!db->isConnected()) return -1;
+
+    std::string sql = "SELECT table_name, row_key, "
+                      "to_char(deleted_at AT TIME ZONE 'UTC', 'YYYY-MM-DD\"T\"HH24:MI:SS.US\"Z\"') "
+                      "FROM deleted_row";
+    if (!since.empty()) sql += " WHERE deleted_at >= CAST(? AS TIMESTAMPTZ)";
+    sql += " ORDER BY deleted_at";
+
+    SQLHSTMT hStmt;
+    SQLRETURN ret = SQLAllocHandle(SQL_HANDLE_STMT, db->getHandle(), &hStmt);
+    if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) return -1;
+
+    SQLLEN sinceLen = SQL_NTS;
+    if (!since.empty()) {
+        SQLBindParameter(hStmt, 1, SQL_PARAM_INPUT, SQL_C_CHAR, SQL_VARCHAR, since.size(), 0,
+                         (SQLPOINTER)since.c_str(), 0, &sinceLen);
+    }
+    ret = SQLExecDirect(hStmt, (SQLCHAR*)sql.c_str(), SQL_NTS);
+    if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) {
+        std::cerr << "Ошибка чтения отметок об удалении." << std::endl;
+        SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+        return -1;
+    }
+
+    Tombstone t;
+    SQLCHAR table[64], key[128], deletedAt[40];
+    long long count = 0;
+    while (SQL_SUCCEEDED(ret = SQLFetch(hStmt))) {
+        table[0] = key[0] = deletedAt[0] = '\0';
+        SQLGetData(hStmt, 1, SQL_C_CHAR, table, sizeof(table), nullptr);
+        SQLGetData(hStmt, 2, SQL_C_CHAR, key, sizeof(key), nullptr);
+        SQLGetData(hStmt, 3, SQL_C_CHAR, deletedAt, sizeof(deletedAt), nullptr);
+        t.table = (char*)table;
+        t.key = (char*)key;
+        t.deleted_at = (char*)deletedAt;
+        ++count;
+        if (!callback(t)) break;
+    }
+    bool complete = fetchCompleted(hStmt, ret);
+    SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
+    return complete ? count : -1;
+}
\ No newline at end of file
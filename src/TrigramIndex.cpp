@@ -0,0 +1,202 @@
+#include "TrigramIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <queue>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+    // Следующий символ UTF-8 (неверные байты пропускаются как отдельные символы)
+    uint32_t nextCodepoint(const std::string& s, size_t& i) {
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        int extra = c < 0x80 ? 0 : c < 0xE0 ? 1 : c < 0xF0 ? 2 : 3;
+        if (c >= 0x80 && c < 0xC0) extra = 0;
+        if (i + extra >= s.size()) extra = 0;
+        uint32_t cp = (extra == 0) ? c : (extra == 1) ? (c & 0x1F) : (extra == 2) ? (c & 0x0F) : (c & 0x07);
+        for (int k = 1; k <= extra; ++k) cp = (cp << 6) | (static_cast<unsigned char>(s[i + k]) & 0x3F);
+        i += 1 + extra;
+        return cp;
+    }
+
+    // Нижний регистр и ё -> е; 0 — разделитель слов
+    uint32_t normalize(uint32_t cp) {
+        if (cp >= 'A' && cp <= 'Z') return cp + 32;
+        if ((cp >= 'a' && cp <= 'z') || (cp >= '0' && cp <= '9')) return cp;
+        if (cp < 0x80) return 0;
+        if (cp >= 0x0410 && cp <= 0x042F) return cp + 0x20;
+        if (cp == 0x0401 || cp == 0x0451) return 0x0435;
+        if (cp == 0xAB || cp == 0xBB || (cp >= 0x2000 && cp <= 0x206F)) return 0; // Кавычки «», тире, пробелы
+        return cp;
+    }
+
+    // 10-битный код символа: пробел — 0, остальное — сам символ или хеш
+    uint32_t charCode(uint32_t cp) {
+        if (cp == ' ') return 0;
+        if (cp < 0x400) return cp;
+        if (cp < 0x460) return cp - 0x400 + 0x380; // Кириллица на место редких символов Latin Extended
+        return 0x300 + (cp * 2654435761u >> 25);   // Прочие — в 128 кодов
+    }
+}
+
+std::vector<uint32_t> TrigramIndex::trigramsOf(const std::string& text) {
+    std::vector<uint32_t> result;
+    std::vector<uint32_t> word;
+
+    auto flushWord = [&]() {
+        if (word.empty()) return;
+        // Как в pg_trgm: два пробела в начале слова и один в конце
+        uint32_t a = 0, b = 0;
+        for (size_t i = 0; i <= word.size(); ++i) {
+            uint32_t c = i < word.size() ? charCode(word[i]) : 0;
+            result.push_back((a << 20) | (b << 10) | c);
+            a = b;
+            b = c;
+        }
+        word.clear();
+    };
+
+    size_t i = 0;
+    while (i < text.size()) {
+        uint32_t cp = normalize(nextCodepoint(text, i));
+        if (cp == 0) flushWord();
+        else word.push_back(cp);
+    }
+    flushWord();
+
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+void TrigramIndex::clear() {
+    docs.clear();
+    slotOf.clear();
+    postings.clear();
+    deadCount = 0;
+}
+
+void TrigramIndex::reserve(size_t documents) {
+    docs.reserve(documents);
+    slotOf.reserve(documents);
+}
+
+void TrigramIndex::add(int id, const std::string& text) {
+    remove(id);
+
+    std::vector<uint32_t> trigrams = trigramsOf(text);
+    if (trigrams.size() > UINT16_MAX) trigrams.resize(UINT16_MAX);
+
+    uint32_t slot = static_cast<uint32_t>(docs.size());
+    docs.push_back(Doc{id, static_cast<uint16_t>(trigrams.size()), true});
+    slotOf[id] = slot;
+    // Слоты только растут, поэтому списки остаются упорядоченными
+    for (uint32_t t : trigrams) postings[t].push_back(slot);
+}
+
+void TrigramIndex::remove(int id) {
+    auto it = slotOf.find(id);
+    if (it == slotOf.end()) return;
+    docs[it->second].alive = false;
+    slotOf.erase(it);
+    ++deadCount;
+    if (deadCount > 1024 && deadCount * 4 > docs.size()) compact();
+}
+
+void TrigramIndex::compact() {
+    // Новые номера слотов сохраняют порядок, поэтому списки остаются отсортированными
+    std::vector<uint32_t> remap(docs.size(), UINT32_MAX);
+    std::vector<Doc> alive;
+    alive.reserve(docs.size() - deadCount);
+    for (size_t i = 0; i < docs.size(); ++i) {
+        if (!docs[i].alive) continue;
+        remap[i] = static_cast<uint32_t>(alive.size());
+        alive.push_back(docs[i]);
+    }
+
+    for (auto it = postings.begin(); it != postings.end();) {
+        std::vector<uint32_t>& list = it->second;
+        size_t out = 0;
+        for (uint32_t slot : list) {
+            if (remap[slot] != UINT32_MAX) list[out++] = remap[slot];
+        }
+        list.resize(out);
+        if (list.empty()) it = postings.erase(it);
+        else ++it;
+    }
+
+    docs.swap(alive);
+    for (size_t i = 0; i < docs.size(); ++i) slotOf[docs[i].id] = static_cast<uint32_t>(i);
+    deadCount = 0;
+}
+
+std::vector<SearchHit> TrigramIndex::search(const std::string& query, size_t k, float minScore) const {
+    std::vector<SearchHit> hits;
+    std::vector<uint32_t> q = trigramsOf(query);
+    if (q.empty() || k == 0 || docs.empty()) return hits;
+    // Длинный запрос обрезается: счётчики должны помещаться в знаковые 16 бит
+    if (q.size() > 4096) q.resize(4096);
+
+    // 1. Число общих с запросом триграмм для каждого слота. Буфер переживает
+    //    вызов, чтобы не выделять память под счётчики на каждый поиск.
+    thread_local std::vector<uint16_t> counts;
+    counts.assign(docs.size(), 0);
+    for (uint32_t t : q) {
+        auto it = postings.find(t);
+        if (it == postings.end()) continue;
+        for (uint32_t slot : it->second) ++counts[slot];
+    }
+
+    // 2. Кандидаты: совпало не меньше minScore от триграмм запроса.
+    //    Оценка — в основном доля триграмм запроса, найденных в документе
+    //    (запрос — часть названия или адреса), плюс сходство Жаккара, чтобы
+    //    при равной полноте выше шли более короткие, точнее совпавшие записи.
+    const float qn = static_cast<float>(q.size());
+    const uint16_t minShared = static_cast<uint16_t>(std::max(1.0f, std::ceil(minScore * qn)));
+
+    auto worse = [](const SearchHit& a, const SearchHit& b) { return a.score > b.score; };
+    std::priority_queue<SearchHit, std::vector<SearchHit>, decltype(worse)> top(worse);
+
+    auto consider = [&](size_t slot) {
+        const Doc& d = docs[slot];
+        if (!d.alive) return;
+        float shared = counts[slot];
+        float score = 0.8f * (shared / qn) + 0.2f * (shared / (qn + d.trigrams - shared));
+        if (score < minScore) return;
+        if (top.size() < k) top.push(SearchHit{d.id, score});
+        else if (score > top.top().score) {
+            top.pop();
+            top.push(SearchHit{d.id, score});
+        }
+    };
+
+    size_t n = counts.size();
+    size_t i = 0;
+#if defined(__SSE2__)
+    // По 8 счётчиков за шаг: большинство слотов не совпало ни одной триграммой
+    // и отсекается одним сравнением
+    const __m128i threshold = _mm_set1_epi16(static_cast<short>(minShared - 1));
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&counts[i]));
+        // Счётчики не больше 4096, знаковое сравнение безопасно
+        int mask = _mm_movemask_epi8(_mm_cmpgt_epi16(v, threshold));
+        while (mask) {
+            int bit = __builtin_ctz(static_cast<unsigned>(mask));
+            consider(i + bit / 2);
+            mask &= ~(3 << bit);
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        if (counts[i] >= minShared) consider(i);
+    }
+
+    hits.reserve(top.size());
+    while (!top.empty()) {
+        hits.push_back(top.top());
+        top.pop();
+    }
+    std::reverse(hits.begin(), hits.end());
+    return hits;
+}
\ No newline at end of file
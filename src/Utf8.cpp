@@ -0,0 +1,486 @@
+#include "Utf8.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define UTF8_X86_SIMD 1
+#endif
+
+namespace {
+    const size_t NOT_PLAIN = static_cast<size_t>(-1);
+
+    // Наборы функций для одного набора инструкций
+    struct Kernels {
+        const char* name;
+        size_t block;   // Размер блока plainWidth
+        size_t (*validLength)(const unsigned char* s, size_t len);
+        size_t (*countCodePoints)(const unsigned char* s, size_t len);
+        // Ширина блока, если в нём только символы шириной 1 (ASCII и двухбайтовые,
+        // кроме U+0300–U+037F); иначе NOT_PLAIN. Блок может начинаться и
+        // заканчиваться внутри символа: символ считается по первому байту.
+        size_t (*plainWidth)(const unsigned char* s);
+        size_t (*findJsonSpecial)(const unsigned char* s, size_t len);
+        size_t (*findCsvSpecial)(const unsigned char* s, size_t len, unsigned char delimiter);
+    };
+
+    // Диапазоны кодовых точек шириной 2 (East Asian Wide и Fullwidth)
+    const uint32_t WIDE[][2] = {
+        {0x1100, 0x115F}, {0x231A, 0x231B}, {0x2329, 0x232A}, {0x23E9, 0x23EC}, {0x23F0, 0x23F0},
+        {0x23F3, 0x23F3}, {0x25FD, 0x25FE}, {0x2614, 0x2615}, {0x2648, 0x2653}, {0x267F, 0x267F},
+        {0x2693, 0x2693}, {0x26A1, 0x26A1}, {0x26AA, 0x26AB}, {0x26BD, 0x26BE}, {0x26C4, 0x26C5},
+        {0x26CE, 0x26CE}, {0x26D4, 0x26D4}, {0x26EA, 0x26EA}, {0x26F2, 0x26F3}, {0x26F5, 0x26F5},
+        {0x26FA, 0x26FA}, {0x26FD, 0x26FD}, {0x2705, 0x2705}, {0x270A, 0x270B}, {0x2728, 0x2728},
+        {0x274C, 0x274C}, {0x274E, 0x274E}, {0x2753, 0x2755}, {0x2757, 0x2757}, {0x2795, 0x2797},
+        {0x27B0, 0x27B0}, {0x27BF, 0x27BF}, {0x2B1B, 0x2B1C}, {0x2B50, 0x2B50}, {0x2B55, 0x2B55},
+        {0x2E80, 0x303E}, {0x3041, 0x4DBF}, {0x4E00, 0xA4CF}, {0xA960, 0xA97F}, {0xAC00, 0xD7A3},
+        {0xF900, 0xFAFF}, {0xFE10, 0xFE19}, {0xFE30, 0xFE6F}, {0xFF00, 0xFF60}, {0xFFE0, 0xFFE6},
+        {0x16FE0, 0x16FE4}, {0x17000, 0x18CFF}, {0x1B000, 0x1B2FF}, {0x1F004, 0x1F004},
+        {0x1F0CF, 0x1F0CF}, {0x1F18E, 0x1F18E}, {0x1F191, 0x1F19A}, {0x1F200, 0x1F251},
+        {0x1F300, 0x1F64F}, {0x1F680, 0x1F6FF}, {0x1F7E0, 0x1F7EB}, {0x1F900, 0x1F9FF},
+        {0x1FA70, 0x1FAFF}, {0x20000, 0x2FFFD}, {0x30000, 0x3FFFD}
+    };
+
+    // Диапазоны нулевой ширины: комбинируемые знаки и невидимые символы.
+    // Двухбайтовые — только U+0300–U+036F, на это рассчитан plainWidth.
+    const uint32_t ZERO[][2] = {
+        {0x0300, 0x036F}, {0x200B, 0x200F}, {0x202A, 0x202E}, {0x2060, 0x2064}, {0x20D0, 0x20FF},
+        {0xFE00, 0xFE0F}, {0xFE20, 0xFE2F}, {0xFEFF, 0xFEFF}, {0xE0100, 0xE01EF}
+    };
+
+    template <size_t N>
+    bool inRanges(const uint32_t (&ranges)[N][2], uint32_t cp) {
+        const uint32_t (*it)[2] = std::upper_bound(ranges, ranges + N, cp,
+            [](uint32_t value, const uint32_t (&range)[2]) { return value < range[0]; });
+        return it != ranges && cp <= (*(it - 1))[1];
+    }
+
+    // Кодовая точка с позиции i и её длина в байтах. Неверная или оборванная
+    // последовательность читается как U+FFFD длиной в один байт.
+    size_t decode(const unsigned char* s, size_t len, size_t i, uint32_t& cp) {
+        unsigned char c = s[i];
+        if (c < 0x80) {
+            cp = c;
+            return 1;
+        }
+        size_t n = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : 2;
+        if (c < 0xC0 || len - i < n) {
+            cp = 0xFFFD;
+            return 1;
+        }
+        cp = c & (0x7F >> n);
+        for (size_t k = 1; k < n; ++k) {
+            if ((s[i + k] & 0xC0) != 0x80) {
+                cp = 0xFFFD;
+                return 1;
+            }
+            cp = (cp << 6) | (s[i + k] & 0x3F);
+        }
+        return n;
+    }
+
+    // Длина корректной последовательности, начинающейся с не-ASCII байта s[i];
+    // 0 — последовательность неверна (Unicode, таблица 3-7)
+    size_t sequenceLength(const unsigned char* s, size_t len, size_t i) {
+        unsigned char c = s[i];
+        size_t n;
+        unsigned char lo = 0x80, hi = 0xBF;
+        if (c >= 0xC2 && c <= 0xDF) n = 2;
+        else if (c >= 0xE0 && c <= 0xEF) {
+            n = 3;
+            if (c == 0xE0) lo = 0xA0;           // Избыточная запись
+            else if (c == 0xED) hi = 0x9F;      // Суррогаты
+        } else if (c >= 0xF0 && c <= 0xF4) {
+            n = 4;
+            if (c == 0xF0) lo = 0x90;
+            else if (c == 0xF4) hi = 0x8F;      // Больше U+10FFFF
+        } else {
+            return 0;
+        }
+        if (len - i < n || s[i + 1] < lo || s[i + 1] > hi) return 0;
+        for (size_t k = 2; k < n; ++k) {
+            if ((s[i + k] & 0xC0) != 0x80) return 0;
+        }
+        return n;
+    }
+
+    // ==========================================
+    // Побайтовые варианты
+    // ==========================================
+
+    size_t scalarValidFrom(const unsigned char* s, size_t len, size_t i) {
+        while (i < len) {
+            if (s[i] < 0x80) {
+                ++i;
+                continue;
+            }
+            size_t n = sequenceLength(s, len, i);
+            if (n == 0) return i;
+            i += n;
+        }
+        return len;
+    }
+
+    size_t scalarValidLength(const unsigned char* s, size_t len) {
+        return scalarValidFrom(s, len, 0);
+    }
+
+    size_t scalarCount(const unsigned char* s, size_t len) {
+        size_t count = 0;
+        for (size_t i = 0; i < len; ++i) count += (s[i] & 0xC0) != 0x80;
+        return count;
+    }
+
+    size_t scalarFindJson(const unsigned char* s, size_t len) {
+        for (size_t i = 0; i < len; ++i) {
+            if (s[i] < 0x20 || s[i] == '"' || s[i] == '\\') return i;
+        }
+        return len;
+    }
+
+    size_t scalarFindCsv(const unsigned char* s, size_t len, unsigned char delimiter) {
+        for (size_t i = 0; i < len; ++i) {
+            if (s[i] == delimiter || s[i] == '"' || s[i] == '\n' || s[i] == '\r') return i;
+        }
+        return len;
+    }
+
+#ifdef UTF8_X86_SIMD
+    // ==========================================
+    // SSE2 (есть на любом x86-64)
+    // ==========================================
+
+    // Проверка побайтовая, но ASCII пропускается по 16 байт
+    size_t sse2ValidFrom(const unsigned char* s, size_t len, size_t i) {
+        while (i < len) {
+            if (s[i] < 0x80) {
+                while (len - i >= 16 &&
+                       _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i))) == 0) i += 16;
+                while (i < len && s[i] < 0x80) ++i;
+                continue;
+            }
+            size_t n = sequenceLength(s, len, i);
+            if (n == 0) return i;
+            i += n;
+        }
+        return len;
+    }
+
+    size_t sse2ValidLength(const unsigned char* s, size_t len) {
+        return sse2ValidFrom(s, len, 0);
+    }
+
+    size_t sse2Count(const unsigned char* s, size_t len) {
+        // Не байт продолжения: как знаковое число больше -65 (0xBF)
+        const __m128i bound = _mm_set1_epi8(-65);
+        size_t count = 0, i = 0;
+        for (; len - i >= 16; i += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+            count += static_cast<size_t>(__builtin_popcount(_mm_movemask_epi8(_mm_cmpgt_epi8(v, bound))));
+        }
+        return count + scalarCount(s + i, len - i);
+    }
+
+    size_t sse2PlainWidth(const unsigned char* s) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+        // Первые байты трёх- и четырёхбайтовых символов (>= 0xE0) и U+0300–U+037F (0xCC, 0xCD)
+        const __m128i lead3 = _mm_set1_epi8(static_cast<char>(0xE0));
+        __m128i wide = _mm_cmpeq_epi8(_mm_max_epu8(v, lead3), v);
+        __m128i combining = _mm_cmpeq_epi8(_mm_and_si128(v, _mm_set1_epi8(static_cast<char>(0xFE))),
+                                           _mm_set1_epi8(static_cast<char>(0xCC)));
+        if (_mm_movemask_epi8(_mm_or_si128(wide, combining)) != 0) return NOT_PLAIN;
+        return static_cast<size_t>(__builtin_popcount(_mm_movemask_epi8(_mm_cmpgt_epi8(v, _mm_set1_epi8(-65)))));
+    }
+
+    size_t sse2FindJson(const unsigned char* s, size_t len) {
+        const __m128i control = _mm_set1_epi8(0x1F);
+        size_t i = 0;
+        for (; len - i >= 16; i += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+            __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(_mm_max_epu8(v, control), control),
+                          _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))));
+            int mask = _mm_movemask_epi8(hit);
+            if (mask != 0) return i + static_cast<size_t>(__builtin_ctz(mask));
+        }
+        return i + scalarFindJson(s + i, len - i);
+    }
+
+    size_t sse2FindCsv(const unsigned char* s, size_t len, unsigned char delimiter) {
+        const __m128i d = _mm_set1_epi8(static_cast<char>(delimiter));
+        size_t i = 0;
+        for (; len - i >= 16; i += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+            __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, d), _mm_cmpeq_epi8(v, _mm_set1_epi8('"'))),
+                          _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+            int mask = _mm_movemask_epi8(hit);
+            if (mask != 0) return i + static_cast<size_t>(__builtin_ctz(mask));
+        }
+        return i + scalarFindCsv(s + i, len - i, delimiter);
+    }
+
+    // ==========================================
+    // AVX2
+    // ==========================================
+    // Проверка — по схеме Кейзера и Лемира ("Validating UTF-8 In Less Than One
+    // Instruction Per Byte"): ошибки пары соседних байтов находятся тремя
+    // табличными подстановками по полубайтам, обязательные второй и третий
+    // байты продолжения — по первым байтам двух предыдущих позиций.
+
+#define UTF8_AVX2 __attribute__((target("avx2")))
+
+    // Блок, сдвинутый на n байтов назад, с хвостом предыдущего блока в начале
+    UTF8_AVX2 inline __m256i prev1(__m256i in, __m256i prev) {
+        return _mm256_alignr_epi8(in, _mm256_permute2x128_si256(prev, in, 0x21), 15);
+    }
+    UTF8_AVX2 inline __m256i prev2(__m256i in, __m256i prev) {
+        return _mm256_alignr_epi8(in, _mm256_permute2x128_si256(prev, in, 0x21), 14);
+    }
+    UTF8_AVX2 inline __m256i prev3(__m256i in, __m256i prev) {
+        return _mm256_alignr_epi8(in, _mm256_permute2x128_si256(prev, in, 0x21), 13);
+    }
+
+    UTF8_AVX2 inline __m256i highNibble(__m256i v) {
+        return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F));
+    }
+
+    // Ненулевые байты результата — ошибки в блоке in (prev — предыдущий блок)
+    UTF8_AVX2 __m256i avx2BlockErrors(__m256i in, __m256i prev) {
+        const char TOO_SHORT = 1 << 0;      // 11______ 0_______ или 11______ 11______
+        const char TOO_LONG = 1 << 1;       // 0_______ 10______
+        const char OVERLONG_3 = 1 << 2;     // 11100000 100_____
+        const char TOO_LARGE = 1 << 3;      // 11110100 1001____ и выше
+        const char SURROGATE = 1 << 4;      // 11101101 101_____
+        const char OVERLONG_2 = 1 << 5;     // 1100000_ 10______
+        const char TOO_LARGE_1000 = 1 << 6; // 11110101 1000____ и выше
+        const char OVERLONG_4 = 1 << 6;     // 11110000 1000____
+        const char TWO_CONTS = static_cast<char>(1 << 7);   // 10______ 10______
+        const char CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+        __m256i p1 = prev1(in, prev);
+        __m256i byte1High = _mm256_shuffle_epi8(_mm256_setr_epi8(
+            TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+            TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+            TOO_SHORT | OVERLONG_2, TOO_SHORT, TOO_SHORT | OVERLONG_3 | SURROGATE,
+            TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4,
+            TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+            TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+            TOO_SHORT | OVERLONG_2, TOO_SHORT, TOO_SHORT | OVERLONG_3 | SURROGATE,
+            TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4), highNibble(p1));
+        __m256i byte1Low = _mm256_shuffle_epi8(_mm256_setr_epi8(
+            CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4, CARRY | OVERLONG_2, CARRY, CARRY,
+            CARRY | TOO_LARGE, CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+            CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4, CARRY | OVERLONG_2, CARRY, CARRY,
+            CARRY | TOO_LARGE, CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+            CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000),
+            _mm256_and_si256(p1, _mm256_set1_epi8(0x0F)));
+        __m256i byte2High = _mm256_shuffle_epi8(_mm256_setr_epi8(
+            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT), highNibble(in));
+        __m256i special = _mm256_and_si256(_mm256_and_si256(byte1High, byte1Low), byte2High);
+
+        // Третий и четвёртый байты символа: два и три байта назад стоит
+        // первый байт трёх- или четырёхбайтового символа
+        __m256i third = _mm256_subs_epu8(prev2(in, prev), _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+        __m256i fourth = _mm256_subs_epu8(prev3(in, prev), _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+        __m256i must23 = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8(static_cast<char>(0x80)));
+        return _mm256_xor_si256(must23, special);
+    }
+
+    UTF8_AVX2 size_t avx2ValidLength(const unsigned char* s, size_t len) {
+        // Блок, оканчивающийся незавершённым символом: последние байты не меньше
+        // первого байта символа, которому не хватает продолжения
+        const __m256i incomplete = _mm256_setr_epi8(
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1));
+        __m256i prev = _mm256_setzero_si256();
+        size_t i = 0;
+        for (; len - i >= 32; i += 32) {
+            __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+            __m256i errors = _mm256_movemask_epi8(in) == 0
+                ? _mm256_subs_epu8(prev, incomplete)
+                : avx2BlockErrors(in, prev);
+            if (!_mm256_testz_si256(errors, errors)) break;
+            prev = in;
+        }
+        // Всё до символа, начатого перед блоком i, корректно; с него остаток
+        // (хвост или блок с ошибкой, где нужна точная позиция) проверяется побайтово
+        size_t start = i;
+        for (size_t k = 1; k <= 3 && k <= i; ++k) {
+            unsigned char c = s[i - k];
+            if ((c & 0xC0) == 0x80) continue;
+            if (c >= 0xC0) start = i - k;
+            break;
+        }
+        return sse2ValidFrom(s, len, start);
+    }
+
+    UTF8_AVX2 size_t avx2Count(const unsigned char* s, size_t len) {
+        const __m256i bound = _mm256_set1_epi8(-65);
+        size_t count = 0, i = 0;
+        for (; len - i >= 32; i += 32) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+            uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(v, bound)));
+            count += static_cast<size_t>(__builtin_popcount(mask));
+        }
+        return count + sse2Count(s + i, len - i);
+    }
+
+    UTF8_AVX2 size_t avx2PlainWidth(const unsigned char* s) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s));
+        const __m256i lead3 = _mm256_set1_epi8(static_cast<char>(0xE0));
+        __m256i wide = _mm256_cmpeq_epi8(_mm256_max_epu8(v, lead3), v);
+        __m256i combining = _mm256_cmpeq_epi8(_mm256_and_si256(v, _mm256_set1_epi8(static_cast<char>(0xFE))),
+                                              _mm256_set1_epi8(static_cast<char>(0xCC)));
+        if (!_mm256_testz_si256(_mm256_or_si256(wide, combining), _mm256_or_si256(wide, combining))) return NOT_PLAIN;
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(-65))));
+        return static_cast<size_t>(__builtin_popcount(mask));
+    }
+
+    UTF8_AVX2 size_t avx2FindJson(const unsigned char* s, size_t len) {
+        const __m256i control = _mm256_set1_epi8(0x1F);
+        size_t i = 0;
+        for (; len - i >= 32; i += 32) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+            __m256i hit = _mm256_or_si256(_mm256_cmpeq_epi8(_mm256_max_epu8(v, control), control),
+                          _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')),
+                                          _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))));
+            uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+            if (mask != 0) return i + static_cast<size_t>(__builtin_ctz(mask));
+        }
+        return i + sse2FindJson(s + i, len - i);
+    }
+
+    UTF8_AVX2 size_t avx2FindCsv(const unsigned char* s, size_t len, unsigned char delimiter) {
+        const __m256i d = _mm256_set1_epi8(static_cast<char>(delimiter));
+        size_t i = 0;
+        for (; len - i >= 32; i += 32) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+            __m256i hit = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, d), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'))),
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+            uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+            if (mask != 0) return i + static_cast<size_t>(__builtin_ctz(mask));
+        }
+        return i + sse2FindCsv(s + i, len - i, delimiter);
+    }
+
+#undef UTF8_AVX2
+#endif
+
+    Kernels selectKernels() {
+        Kernels scalar{"scalar", 0, scalarValidLength, scalarCount, nullptr, scalarFindJson, scalarFindCsv};
+        const char* limit = std::getenv("REGENT_SIMD");
+        if (limit && std::strcmp(limit, "scalar") == 0) return scalar;
+#ifdef UTF8_X86_SIMD
+        Kernels sse2{"sse2", 16, sse2ValidLength, sse2Count, sse2PlainWidth, sse2FindJson, sse2FindCsv};
+        if (limit && std::strcmp(limit, "sse2") == 0) return sse2;
+        __builtin_cpu_init();
+        if (!__builtin_cpu_supports("avx2")) return sse2;
+        return Kernels{"avx2", 32, avx2ValidLength, avx2Count, avx2PlainWidth, avx2FindJson, avx2FindCsv};
+#else
+        return scalar;
+#endif
+    }
+
+    const Kernels& kernels() {
+        static const Kernels chosen = selectKernels();
+        return chosen;
+    }
+
+    // Ширина начала текста не более limit; возвращает длину начала в байтах.
+    // Блоки из одних символов ширины 1 считаются целиком, остальное — по символу.
+    size_t scanWidth(const unsigned char* s, size_t len, size_t limit, size_t& width) {
+        const Kernels& k = kernels();
+        size_t i = 0, w = 0;
+        size_t scalarUntil = 0;     // После неудачного блока — по символу до его конца
+        while (i < len) {
+            if (k.plainWidth && i >= scalarUntil && len - i >= k.block && limit - w >= k.block) {
+                size_t blockWidth = k.plainWidth(s + i);
+                if (blockWidth != NOT_PLAIN) {
+                    w += blockWidth;
+                    i += k.block;
+                    continue;
+                }
+                scalarUntil = i + k.block;
+            }
+            if ((s[i] & 0xC0) == 0x80) {    // Продолжение символа, посчитанного в блоке
+                ++i;
+                continue;
+            }
+            uint32_t cp;
+            size_t n = decode(s, len, i, cp);
+            size_t cw = static_cast<size_t>(utf8::codePointWidth(cp));
+            if (w + cw > limit) break;
+            w += cw;
+            i += n;
+        }
+        width = w;
+        return i;
+    }
+}
+
+namespace utf8 {
+
+const char* simdLevel() {
+    return kernels().name;
+}
+
+size_t validLength(const char* s, size_t len) {
+    return kernels().validLength(reinterpret_cast<const unsigned char*>(s), len);
+}
+
+size_t countCodePoints(const char* s, size_t len) {
+    return kernels().countCodePoints(reinterpret_cast<const unsigned char*>(s), len);
+}
+
+int codePointWidth(uint32_t cp) {
+    if (cp < 0x300) return 1;
+    if (inRanges(ZERO, cp)) return 0;
+    if (cp >= 0x1100 && inRanges(WIDE, cp)) return 2;
+    return 1;
+}
+
+size_t displayWidth(const char* s, size_t len) {
+    size_t width;
+    scanWidth(reinterpret_cast<const unsigned char*>(s), len, static_cast<size_t>(-1), width);
+    return width;
+}
+
+size_t fitWidth(const char* s, size_t len, size_t maxWidth, size_t* width) {
+    size_t w;
+    size_t bytes = scanWidth(reinterpret_cast<const unsigned char*>(s), len, maxWidth, w);
+    if (width) *width = w;
+    return bytes;
+}
+
+size_t findJsonSpecial(const char* s, size_t len) {
+    return kernels().findJsonSpecial(reinterpret_cast<const unsigned char*>(s), len);
+}
+
+size_t findCsvSpecial(const char* s, size_t len, char delimiter) {
+    return kernels().findCsvSpecial(reinterpret_cast<const unsigned char*>(s), len,
+                                    static_cast<unsigned char>(delimiter));
+}
+
+}
\ No newline at end of file
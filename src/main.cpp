@@ -1,9 +1,11 @@
 #include "CLIInterface.h"
 #include <iostream>
 
-int main() {
+int main(int argc, char* argv[]) {
     try {
         CLIInterface cli;
+        // С аргументами — неинтерактивная подкоманда (import и т.п.)
+        if (argc > 1) return cli.runCommand(std::vector<std::string>(argv + 1, argv + argc));
         cli.run();
     } catch (const std::exception& e) {
         std::cerr << "Ошибка: " << e.what() << std::endl;
@@ -0,0 +1,103 @@
+#include "HttpServer.h"
+#include "RegistryApi.h"
+#include "RegistryService.h"
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+// ==========================================
+// RegEnterpriseServer — HTTP/JSON API реестра
+// ==========================================
+
+namespace {
+    HttpServer* runningServer = nullptr;
+
+    void onSignal(int) {
+        if (runningServer) runningServer->stop();
+    }
+
+    void printUsage() {
+        std::cerr << "Использование: RegEnterpriseServer [--bind АДРЕС] [--port ПОРТ] [--workers N]\n"
+                     "                           [--snapshot ФАЙЛ] [--catalog]\n"
+                     "  --bind      адрес прослушивания (по умолчанию 127.0.0.1)\n"
+                     "  --port      порт (по умолчанию 8080)\n"
+                     "  --workers   потоков обработки и соединений с БД (по умолчанию по числу ядер)\n"
+                     "  --snapshot  обслуживать чтение из снимка, без БД (только чтение)\n"
+                     "  --catalog   загрузить колоночный каталог для отчётов при запуске" << std::endl;
+    }
+
+    bool parsePositive(const char* text, long max, long& out) {
+        char* end = nullptr;
+        long v = std::strtol(text, &end, 10);
+        if (*text == '\0' || *end != '\0' || v <= 0 || v > max) return false;
+        out = v;
+        return true;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string bind = "127.0.0.1";
+    long port = 8080;
+    long workers = std::max(2u, std::thread::hardware_concurrency());
+    std::string snapshotPath;
+    bool loadCatalog = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "--bind" && hasValue) {
+            bind = argv[++i];
+        } else if (arg == "--port" && hasValue) {
+            if (!parsePositive(argv[++i], 65535, port)) {
+                std::cerr << "Неверный порт: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--workers" && hasValue) {
+            if (!parsePositive(argv[++i], 1024, workers)) {
+                std::cerr << "Неверное число потоков: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--snapshot" && hasValue) {
+            snapshotPath = argv[++i];
+        } else if (arg == "--catalog") {
+            loadCatalog = true;
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    try {
+        RegistryService service;
+        // Соединений с БД столько же, сколько рабочих потоков: запрос не ждёт
+        // соединения, пока занятых потоков меньше, чем соединений
+        bool ready = snapshotPath.empty() ? service.initialize(static_cast<size_t>(workers))
+                                          : service.initializeFromSnapshot(snapshotPath);
+        if (!ready) return 1;
+        if (loadCatalog && !service.isReadOnly() && !service.loadCatalog()) {
+            std::cerr << "Каталог не загружен, отчёты будут выполняться сервером БД." << std::endl;
+        }
+
+        RegistryApi api(service);
+        HttpServer server([&api](const HttpRequest& req) { return api.handle(req); },
+                          static_cast<size_t>(workers));
+        if (!server.listen(bind, static_cast<int>(port))) return 1;
+
+        runningServer = &server;
+        std::signal(SIGINT, onSignal);
+        std::signal(SIGTERM, onSignal);
+
+        std::cout << "API реестра: http://" << bind << ":" << port << "/api/ ("
+                  << workers << " потоков" << (service.isReadOnly() ? ", только чтение" : "") << ")"
+                  << std::endl;
+        server.run();
+        runningServer = nullptr;
+        std::cout << "Сервер остановлен." << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Ошибка: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
\ No newline at end of file